@@ -0,0 +1,254 @@
+/* Copyright 2025 OppositeNor
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef __WBE_ALLOCATION_SAMPLER_HH__
+#define __WBE_ALLOCATION_SAMPLER_HH__
+
+#include "core/allocator/allocator.hh"
+#include "utils/defs.hh"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace WhiteBirdEngine {
+
+/**
+ * @class AllocationSampler
+ * @brief Sampling allocation profiler. Roughly one allocation is sampled every sample interval
+ * bytes, so larger allocations are more likely to be sampled. A sampled allocation records its
+ * backtrace, and is tracked until it is freed. The samples are aggregated per call site into a
+ * report of the estimated live bytes, which could be used to find leaks and heavy users.
+ * Unsampled allocations only cost a thread local subtraction, and unsampled deallocations a
+ * relaxed atomic load, so the sampler could be left on in release builds.
+ * @note Hooked into an allocator with HeapAllocatorSampled. Thread safe.
+ */
+class AllocationSampler final {
+public:
+    AllocationSampler() = delete;
+    ~AllocationSampler();
+    AllocationSampler(const AllocationSampler&) = delete;
+    AllocationSampler(AllocationSampler&&) = delete;
+    AllocationSampler& operator=(const AllocationSampler&) = delete;
+    AllocationSampler& operator=(AllocationSampler&&) = delete;
+
+    /**
+     * @brief The maximum number of frames recorded in a backtrace.
+     */
+    static constexpr size_t MAX_FRAMES = 16;
+
+    /**
+     * @brief The aggregated samples of a call site.
+     */
+    struct CallSiteReport {
+        /**
+         * @brief The symbols of the backtrace, innermost first.
+         */
+        std::vector<std::string> backtrace;
+        /**
+         * @brief The number of sampled allocations.
+         */
+        uint64_t sample_count = 0;
+        /**
+         * @brief The number of sampled allocations that are not freed yet.
+         */
+        uint64_t live_sample_count = 0;
+        /**
+         * @brief The estimated bytes allocated from the call site.
+         */
+        size_t allocated_bytes = 0;
+        /**
+         * @brief The estimated bytes allocated from the call site that are freed.
+         */
+        size_t freed_bytes = 0;
+
+        /**
+         * @brief Get the estimated bytes allocated from the call site that are still live.
+         *
+         * @return The estimated live bytes.
+         */
+        size_t get_live_bytes() const {
+            return allocated_bytes - freed_bytes;
+        }
+
+        operator std::string() const;
+    };
+
+    /**
+     * @brief Constructor.
+     *
+     * @param p_sample_interval The average number of bytes allocated between two samples.
+     * @param p_report_path The file to write the report to when the sampler is destructed.
+     * Empty for no report.
+     */
+    AllocationSampler(size_t p_sample_interval, const std::string& p_report_path = "");
+
+    /**
+     * @brief Called after an allocation. Samples the allocation if the sample countdown of the
+     * thread runs out.
+     *
+     * @param p_allocator The allocator that allocated the memory.
+     * @param p_mem The memory ID of the allocation.
+     * @param p_size The size of the allocation.
+     */
+    void on_allocate(const void* p_allocator, MemID p_mem, size_t p_size) {
+        if (p_mem == MEM_NULL) {
+            return;
+        }
+        // The countdown is counted in sample intervals, so that it could be shared by all the
+        // samplers used on the thread.
+        ThreadState& state = thread_state;
+        double step = static_cast<double>(p_size) * inverse_interval;
+        if (state.sample_countdown > step) {
+            state.sample_countdown -= step;
+            return;
+        }
+        record_allocation(p_allocator, p_mem, p_size);
+    }
+
+    /**
+     * @brief Called before a deallocation. Marks the sample of the allocation as freed if it is sampled.
+     *
+     * @param p_allocator The allocator that allocated the memory.
+     * @param p_mem The memory ID of the allocation.
+     */
+    void on_deallocate(const void* p_allocator, MemID p_mem) {
+        if (p_mem == MEM_NULL) {
+            return;
+        }
+        if (live_filter[get_filter_index(p_allocator, p_mem)].load(std::memory_order_relaxed) == 0) {
+            return;
+        }
+        record_deallocation(p_allocator, p_mem);
+    }
+
+    /**
+     * @brief Called when an allocator is cleared. Marks all the samples of the allocator as freed.
+     *
+     * @param p_allocator The allocator that is cleared.
+     */
+    void on_clear(const void* p_allocator);
+
+    /**
+     * @brief Get the report of the samples, one entry per call site, sorted by the estimated
+     * live bytes in descending order.
+     *
+     * @return The report.
+     */
+    std::vector<CallSiteReport> get_report() const;
+
+    /**
+     * @brief Write the report to a file in JSON.
+     *
+     * @param p_path The path of the file.
+     */
+    void write_report(const std::string& p_path) const;
+
+    /**
+     * @brief Get the average number of bytes allocated between two samples.
+     *
+     * @return The sample interval in bytes.
+     */
+    size_t get_sample_interval() const {
+        return sample_interval;
+    }
+
+    /**
+     * @brief Get the number of sampled allocations.
+     *
+     * @return The number of samples.
+     */
+    uint64_t get_sample_count() const;
+
+    /**
+     * @brief Get the number of sampled allocations that are not freed yet.
+     *
+     * @return The number of live samples.
+     */
+    uint64_t get_live_sample_count() const;
+
+    operator std::string() const;
+
+private:
+    static constexpr size_t FILTER_SIZE = 4096;
+
+    struct ThreadState {
+        // The number of sample intervals to allocate before the next sample.
+        double sample_countdown = 0.0;
+        uint64_t random_state = 0;
+    };
+
+    struct CallSite {
+        void* frames[MAX_FRAMES];
+        size_t frame_count;
+        uint64_t sample_count = 0;
+        uint64_t live_sample_count = 0;
+        double allocated_bytes = 0.0;
+        double freed_bytes = 0.0;
+    };
+
+    struct SampleKey {
+        const void* allocator;
+        MemID mem;
+
+        bool operator==(const SampleKey& p_other) const = default;
+    };
+
+    struct SampleKeyHash {
+        size_t operator()(const SampleKey& p_key) const {
+            return get_filter_hash(p_key.allocator, p_key.mem);
+        }
+    };
+
+    struct LiveSample {
+        CallSite* call_site;
+        // The number of bytes the sample stands for.
+        double weight;
+    };
+
+    static uint64_t get_filter_hash(const void* p_allocator, MemID p_mem) {
+        return (static_cast<uint64_t>(p_mem) ^ reinterpret_cast<uintptr_t>(p_allocator)) * 0x9E3779B97F4A7C15ull;
+    }
+
+    static size_t get_filter_index(const void* p_allocator, MemID p_mem) {
+        return get_filter_hash(p_allocator, p_mem) >> 52;
+    }
+    static_assert(FILTER_SIZE == (1ull << 12));
+
+    void record_allocation(const void* p_allocator, MemID p_mem, size_t p_size);
+    void record_deallocation(const void* p_allocator, MemID p_mem);
+    void release_sample(std::unordered_map<SampleKey, LiveSample, SampleKeyHash>::iterator p_sample);
+    static double draw_countdown(ThreadState& p_state);
+
+    const size_t sample_interval;
+    const double inverse_interval;
+    const std::string report_path;
+    // Counts the live samples by the hash of their keys, so that most deallocations skip the lock.
+    std::array<std::atomic<uint32_t>, FILTER_SIZE> live_filter{};
+
+    mutable std::mutex samples_mutex;
+    // Keyed by the raw bytes of the backtrace.
+    std::unordered_map<std::string, CallSite> call_sites;
+    std::unordered_map<SampleKey, LiveSample, SampleKeyHash> live_samples;
+
+    static thread_local ThreadState thread_state;
+};
+
+}
+
+#endif
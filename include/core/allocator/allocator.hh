@@ -60,6 +60,24 @@ concept AllocatorTraitConcept = requires {
     // the allocated resource.
     { bool(T::WILL_ADDR_MOVE) } -> std::same_as<bool>;
 };
+
+/**
+ * @brief Is the address of the memory allocated by the allocator guaranteed not to move,
+ * so that the pointer could be kept. Not satisfied if the allocator does not declare WILL_ADDR_MOVE.
+ *
+ * @tparam T The type of the allocator.
+ */
+template <typename T>
+concept AllocatorAddrStable = (!AllocatorTrait<T>::WILL_ADDR_MOVE);
+
+/**
+ * @brief Does the allocator declare that the memory it allocated could move, so that it could
+ * only be reached through its memory ID. Not satisfied if the allocator does not declare WILL_ADDR_MOVE.
+ *
+ * @tparam T The type of the allocator.
+ */
+template <typename T>
+concept AllocatorAddrMoves = AllocatorTrait<T>::WILL_ADDR_MOVE;
 }
 
 #endif
@@ -0,0 +1,245 @@
+/* Copyright 2025 OppositeNor
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef __WBE_ALLOCATOR_STATS_HH__
+#define __WBE_ALLOCATOR_STATS_HH__
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <type_traits>
+
+namespace WhiteBirdEngine {
+
+/**
+ * @brief A snapshot of the telemetry of an allocator.
+ */
+struct AllocatorStats {
+    /**
+     * @brief The number of successful allocations.
+     */
+    uint64_t allocation_count = 0;
+    /**
+     * @brief The number of deallocations.
+     */
+    uint64_t deallocation_count = 0;
+    /**
+     * @brief The number of allocations that failed because the allocator ran out of space.
+     */
+    uint64_t failed_allocation_count = 0;
+    /**
+     * @brief The bytes held by live allocations, including the padding and headers of the allocator.
+     */
+    size_t live_bytes = 0;
+    /**
+     * @brief The high-water mark of live_bytes.
+     */
+    size_t peak_bytes = 0;
+    /**
+     * @brief The total size of the idle memory.
+     */
+    size_t free_bytes = 0;
+    /**
+     * @brief The size of the largest idle block. Only meaningful if largest_free_block_tracked.
+     */
+    size_t largest_free_block = 0;
+    /**
+     * @brief Does the allocator track largest_free_block. Allocators that would have to walk
+     * their memory to find it leave it untracked, the implicit list and explicit list pools
+     * then provide get_largest_free_block.
+     */
+    bool largest_free_block_tracked = false;
+    /**
+     * @brief The total time spent waiting for the lock of the allocator, in nanoseconds.
+     */
+    uint64_t lock_wait_ns = 0;
+
+    /**
+     * @brief Get the external fragmentation ratio, the portion of the idle memory that is not
+     * in the largest idle block.
+     *
+     * @return The external fragmentation ratio, from 0 to 1. NaN if the largest idle block is
+     * not tracked and there is idle memory.
+     */
+    double get_external_fragmentation() const {
+        if (free_bytes == 0) {
+            return 0.0;
+        }
+        if (!largest_free_block_tracked) {
+            return std::numeric_limits<double>::quiet_NaN();
+        }
+        return 1.0 - static_cast<double>(largest_free_block) / static_cast<double>(free_bytes);
+    }
+
+    operator std::string() const;
+};
+
+/**
+ * @class AllocatorStatsTracker
+ * @brief Counters of the telemetry of an allocator, updated on each allocation and deallocation.
+ *
+ * @tparam IS_ATOMIC Should the counters be updated atomically. Not needed if the allocator
+ * updates them while holding its lock.
+ */
+template <bool IS_ATOMIC = false>
+class AllocatorStatsTracker final {
+public:
+    AllocatorStatsTracker() = default;
+    ~AllocatorStatsTracker() = default;
+    AllocatorStatsTracker(const AllocatorStatsTracker&) = delete;
+    AllocatorStatsTracker(AllocatorStatsTracker&&) = delete;
+    AllocatorStatsTracker& operator=(const AllocatorStatsTracker&) = delete;
+    AllocatorStatsTracker& operator=(AllocatorStatsTracker&&) = delete;
+
+    /**
+     * @brief Record a successful allocation.
+     *
+     * @param p_size The size taken from the allocator.
+     * @param p_count The number of allocations, if p_size is taken by a batch.
+     */
+    void on_allocate(size_t p_size, uint64_t p_count = 1) {
+        add(allocation_count, p_count);
+        update_peak(add(live_bytes, p_size));
+    }
+
+    /**
+     * @brief Record a deallocation.
+     *
+     * @param p_size The size returned to the allocator.
+     * @param p_count The number of deallocations, if p_size is returned by a batch.
+     */
+    void on_deallocate(size_t p_size, uint64_t p_count = 1) {
+        add(deallocation_count, p_count);
+        // Unsigned wrap around subtracts the size.
+        add(live_bytes, -static_cast<uint64_t>(p_size));
+    }
+
+    /**
+     * @brief Record an allocation that is resized in place.
+     *
+     * @param p_old_size The size taken from the allocator before the resize.
+     * @param p_new_size The size taken from the allocator after the resize.
+     */
+    void on_resize(size_t p_old_size, size_t p_new_size) {
+        // Unsigned wrap around handles shrinking.
+        update_peak(add(live_bytes, p_new_size - static_cast<uint64_t>(p_old_size)));
+    }
+
+    /**
+     * @brief Record an allocation that failed.
+     */
+    void on_failed_allocation() {
+        add(failed_allocation_count, 1);
+    }
+
+    /**
+     * @brief Record the time spent waiting for a lock.
+     *
+     * @param p_nanoseconds The time waited in nanoseconds.
+     */
+    void on_lock_wait(uint64_t p_nanoseconds) {
+        if (p_nanoseconds != 0) {
+            add(lock_wait_ns, p_nanoseconds);
+        }
+    }
+
+    /**
+     * @brief Record that the allocator is cleared. The counts and the peak are kept.
+     */
+    void on_clear() {
+        if constexpr (IS_ATOMIC) {
+            live_bytes.store(0, std::memory_order_relaxed);
+        }
+        else {
+            live_bytes = 0;
+        }
+    }
+
+    /**
+     * @brief Fill the counters into a snapshot. The fields about the idle memory are left untouched.
+     *
+     * @param r_stats The snapshot to fill.
+     */
+    void fill(AllocatorStats& r_stats) const {
+        r_stats.allocation_count = load(allocation_count);
+        r_stats.deallocation_count = load(deallocation_count);
+        r_stats.failed_allocation_count = load(failed_allocation_count);
+        r_stats.live_bytes = load(live_bytes);
+        r_stats.peak_bytes = load(peak_bytes);
+        r_stats.lock_wait_ns = load(lock_wait_ns);
+    }
+
+private:
+    using Counter = std::conditional_t<IS_ATOMIC, std::atomic<uint64_t>, uint64_t>;
+
+    Counter allocation_count = 0;
+    Counter deallocation_count = 0;
+    Counter failed_allocation_count = 0;
+    Counter live_bytes = 0;
+    Counter peak_bytes = 0;
+    Counter lock_wait_ns = 0;
+
+    static uint64_t add(Counter& p_counter, uint64_t p_value) {
+        if constexpr (IS_ATOMIC) {
+            return p_counter.fetch_add(p_value, std::memory_order_relaxed) + p_value;
+        }
+        else {
+            return p_counter += p_value;
+        }
+    }
+
+    void update_peak(uint64_t p_live) {
+        if constexpr (IS_ATOMIC) {
+            uint64_t peak = peak_bytes.load(std::memory_order_relaxed);
+            while (p_live > peak && !peak_bytes.compare_exchange_weak(peak, p_live, std::memory_order_relaxed)) {}
+        }
+        else if (p_live > peak_bytes) {
+            peak_bytes = p_live;
+        }
+    }
+
+    static uint64_t load(const Counter& p_counter) {
+        if constexpr (IS_ATOMIC) {
+            return p_counter.load(std::memory_order_relaxed);
+        }
+        else {
+            return p_counter;
+        }
+    }
+};
+
+/**
+ * @brief Acquire a lock, measuring the time spent waiting for it. The lock is tried first,
+ * so that an uncontended acquisition does not read the clock.
+ *
+ * @tparam LockType The type of the lock, e.g. boost::unique_lock.
+ * @param p_lock The lock to acquire, constructed with defer_lock.
+ * @return The time waited in nanoseconds.
+ */
+template <typename LockType>
+inline uint64_t lock_and_measure_wait(LockType& p_lock) {
+    if (p_lock.try_lock()) {
+        return 0;
+    }
+    auto start = std::chrono::steady_clock::now();
+    p_lock.lock();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+}
+
+#endif
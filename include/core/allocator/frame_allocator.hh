@@ -0,0 +1,252 @@
+/* Copyright 2025 OppositeNor
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef __WBE_FRAME_ALLOCATOR_HH__
+#define __WBE_FRAME_ALLOCATOR_HH__
+
+#include "core/allocator/allocator.hh"
+#include "utils/defs.hh"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace WhiteBirdEngine {
+
+template <>
+struct AllocatorTrait<class FrameAllocator> {
+    WBE_TRAIT(AllocatorTrait<FrameAllocator>);
+    static constexpr AllocatorType TYPE = AllocatorType::STACK_ALLOCATOR;
+    static constexpr bool IS_POOL = true;
+    static constexpr bool IS_GURANTEED_CONTINUOUS = false;
+    static constexpr bool IS_ALIGNABLE = true;
+    static constexpr bool IS_LIMITED_SIZE = true;
+    static constexpr bool IS_ALLOC_FIXED_SIZE = false;
+    static constexpr bool IS_ATOMIC = true;
+    static constexpr bool WILL_ADDR_MOVE = false;
+
+    WBE_TRAIT_REQUIRES(AllocatorTraitConcept);
+};
+
+/**
+ * @class FrameAllocator
+ * @brief Allocator for transient per-frame data. Each thread bumps through its own slice, so
+ * allocation never locks, and memory is never freed individually.
+ * Every slice has one buffer per frame in flight, used in turn. The buffer of a frame is reset
+ * the first time its thread allocates in the frame frame_count frames later, so the data
+ * allocated in a frame stays valid until frame_count - 1 more frames have ended.
+ * @note The slice of an exited thread is handed to the next new thread. Its buffers are
+ * still only reset when their frames come around again.
+ */
+class FrameAllocator final {
+public:
+    FrameAllocator() = delete;
+    ~FrameAllocator();
+    FrameAllocator(const FrameAllocator&) = delete;
+    FrameAllocator(FrameAllocator&&) = delete;
+    FrameAllocator& operator=(const FrameAllocator&) = delete;
+    FrameAllocator& operator=(FrameAllocator&&) = delete;
+
+    /**
+     * @brief The maximum number of frames in flight, i.e. triple buffering.
+     */
+    static constexpr uint32_t MAX_FRAME_COUNT = 3;
+
+    /**
+     * @brief Constructor.
+     *
+     * @param p_slice_size The size of the buffer of each thread for each frame.
+     * @param p_frame_count The number of frames in flight, from 1 to MAX_FRAME_COUNT.
+     */
+    FrameAllocator(size_t p_slice_size, uint32_t p_frame_count = 2);
+
+    /**
+     * @brief Allocate memory in the current frame from the slice of the calling thread.
+     *
+     * @param p_size The size to allocate.
+     * @param p_alignment The alignment of the allocation.
+     * @return The memory ID of the allocated memory, which is also its address.
+     */
+    MemID allocate(size_t p_size, size_t p_alignment = WBE_DEFAULT_ALIGNMENT);
+
+    /**
+     * @brief Get the pointer pointing to the memory with a specified memory id.
+     *
+     * @param p_id The ID of the memory to get.
+     * @return The pointer to the memory.
+     */
+    void* get(MemID p_id) const {
+        return reinterpret_cast<void*>(p_id);
+    }
+
+    /**
+     * @brief Get the pointer pointing to the object with a specified memory id.
+     *
+     * @tparam T The type of the object.
+     * @param p_id The memory ID.
+     * @return The pointer to the object.
+     */
+    template <typename T>
+    T* get_obj(MemID p_id) const {
+        return static_cast<T*>(get(p_id));
+    }
+
+    /**
+     * @brief End the current frame. The high-water marks are updated with the memory used
+     * in the frame.
+     * @note Should only be called by one thread, at the tick boundary.
+     */
+    void end_frame();
+
+    /**
+     * @brief Get the number of the current frame.
+     *
+     * @return The number of frames that have ended.
+     */
+    uint64_t get_frame_number() const {
+        return frame_number.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief Get the number of frames in flight.
+     *
+     * @return The number of frames in flight.
+     */
+    uint32_t get_frame_count() const {
+        return frame_count;
+    }
+
+    /**
+     * @brief Get the size of the buffer of each thread for each frame.
+     *
+     * @return The slice size in bytes.
+     */
+    size_t get_slice_size() const {
+        return slice_size;
+    }
+
+    /**
+     * @brief Get the memory used by all threads in the last frame that ended.
+     *
+     * @return The size in bytes.
+     */
+    size_t get_last_frame_size() const {
+        return last_frame_size;
+    }
+
+    /**
+     * @brief Get the largest memory used by all threads in a single frame.
+     *
+     * @return The high-water mark in bytes.
+     */
+    size_t get_frame_high_water_mark() const {
+        return frame_high_water_mark;
+    }
+
+    /**
+     * @brief Get the largest memory used by a single thread in a single frame. Should be kept
+     * below the slice size.
+     *
+     * @return The high-water mark in bytes.
+     */
+    size_t get_slice_high_water_mark() const;
+
+    /**
+     * @brief Get the number of thread slices that are created.
+     *
+     * @return The number of thread slices.
+     */
+    size_t get_thread_slice_count() const;
+
+    operator std::string() const;
+
+private:
+    static constexpr uint64_t NULL_FRAME = ~0ull;
+
+    struct ThreadSlice {
+        // frame_count buffers of slice_size bytes.
+        std::unique_ptr<char[]> memory;
+        // Only written by the owner thread, atomic so that end_frame can read them.
+        std::atomic<uint64_t> buffer_frames[MAX_FRAME_COUNT];
+        std::atomic<size_t> buffer_used[MAX_FRAME_COUNT];
+        std::atomic<size_t> high_water_mark = 0;
+        bool owned = true;
+    };
+
+    /**
+     * @brief Thread local table mapping allocator instances to the slices of the thread.
+     */
+    struct ThreadSliceTable {
+        ~ThreadSliceTable();
+        uint64_t last_instance_id = 0;
+        ThreadSlice* last_slice = nullptr;
+        std::vector<std::pair<uint64_t, ThreadSlice*>> entries;
+    };
+
+    ThreadSlice* get_thread_slice() {
+        ThreadSliceTable& table = thread_slice_table;
+        if (table.last_instance_id == instance_id) {
+            return table.last_slice;
+        }
+        return find_thread_slice(table);
+    }
+
+    ThreadSlice* find_thread_slice(ThreadSliceTable& p_table);
+    void release_thread_slice(ThreadSlice* p_slice);
+
+    const size_t slice_size;
+    const uint32_t frame_count;
+    uint64_t instance_id;
+    WBE_NO_FALSE_SHARING std::atomic<uint64_t> frame_number = 0;
+
+    size_t last_frame_size = 0;
+    size_t frame_high_water_mark = 0;
+
+    mutable std::mutex slices_mutex;
+    std::vector<std::unique_ptr<ThreadSlice>> slices;
+
+    static thread_local ThreadSliceTable thread_slice_table;
+    // Protects live_instances, and keeps an instance alive while an exiting thread releases its slice.
+    static std::mutex registry_mutex;
+    static std::unordered_map<uint64_t, FrameAllocator*> live_instances;
+    static std::atomic<uint64_t> next_instance_id;
+};
+
+/**
+ * @brief Create an object in the current frame. The destructor is never called, so the type
+ * must be trivially destructible.
+ *
+ * @tparam T The type of the object.
+ * @tparam Args The types of the constructor arguments.
+ * @param p_allocator The frame allocator.
+ * @param p_args The arguments of the constructor.
+ * @return The memory ID of the created object.
+ */
+template <typename T, typename... Args>
+MemID create_frame_obj(FrameAllocator& p_allocator, Args&&... p_args) {
+    static_assert(std::is_trivially_destructible_v<T>, "Objects in a frame allocator are never destructed.");
+    MemID result = p_allocator.allocate(sizeof(T), alignof(T));
+    new(p_allocator.get(result)) T(std::forward<Args>(p_args)...);
+    return result;
+}
+
+}
+
+#endif
@@ -0,0 +1,338 @@
+/* Copyright 2025 OppositeNor
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef __WBE_GROWABLE_BUFFER_HH__
+#define __WBE_GROWABLE_BUFFER_HH__
+
+#include "core/allocator/allocator.hh"
+#include "core/allocator/heap_allocator_aligned.hh"
+#include "utils/defs.hh"
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace WhiteBirdEngine {
+
+/**
+ * @class GrowableBuffer
+ * @brief A contiguous array that grows on demand, like std::vector, but asks the allocator to
+ * expand the memory in place first. The elements are only moved to a new allocation if the
+ * memory after the buffer is not idle.
+ *
+ * @tparam T The type of the elements.
+ * @tparam AllocType The type of the allocator, must be a HeapAllocatorAligned.
+ */
+template <typename T, typename AllocType>
+    requires std::derived_from<AllocType, HeapAllocatorAligned>
+class GrowableBuffer final {
+public:
+    GrowableBuffer() = delete;
+    GrowableBuffer(const GrowableBuffer&) = delete;
+    GrowableBuffer& operator=(const GrowableBuffer&) = delete;
+
+    /**
+     * @brief The minimum number of elements allocated on the first growth.
+     */
+    static constexpr size_t MIN_CAPACITY = 4;
+
+    /**
+     * @brief Constructor.
+     *
+     * @param p_allocator The allocator the buffer allocates from.
+     */
+    GrowableBuffer(AllocType* p_allocator)
+        : allocator(p_allocator) {}
+
+    ~GrowableBuffer() {
+        release();
+    }
+
+    GrowableBuffer(GrowableBuffer&& p_other) noexcept
+        : allocator(p_other.allocator), mem_id(p_other.mem_id), elem_count(p_other.elem_count), capacity(p_other.capacity) {
+        p_other.mem_id = MEM_NULL;
+        p_other.elem_count = 0;
+        p_other.capacity = 0;
+    }
+
+    GrowableBuffer& operator=(GrowableBuffer&& p_other) noexcept {
+        if (this == &p_other) {
+            return *this;
+        }
+        release();
+        allocator = p_other.allocator;
+        mem_id = p_other.mem_id;
+        elem_count = p_other.elem_count;
+        capacity = p_other.capacity;
+        p_other.mem_id = MEM_NULL;
+        p_other.elem_count = 0;
+        p_other.capacity = 0;
+        return *this;
+    }
+
+    /**
+     * @brief Make sure the buffer could hold at least p_capacity elements without growing.
+     *
+     * @param p_capacity The number of elements to hold.
+     */
+    void reserve(size_t p_capacity) {
+        if (p_capacity > capacity) {
+            reallocate(p_capacity);
+        }
+    }
+
+    /**
+     * @brief Construct an element at the end of the buffer.
+     *
+     * @tparam Args The types of the constructor arguments.
+     * @param p_args The arguments of the constructor.
+     * @return The element constructed.
+     */
+    template <typename... Args>
+    T& emplace_back(Args&&... p_args) {
+        if (elem_count == capacity) {
+            size_t new_capacity = std::max(capacity * 2, MIN_CAPACITY);
+            if (!expand_in_place(new_capacity)) {
+                // The arguments could refer to the elements, build the new element before the
+                // elements are moved, like std::vector.
+                MemID new_mem_id = allocate_storage(new_capacity);
+                T* result;
+                try {
+                    result = new(static_cast<T*>(allocator->get(new_mem_id)) + elem_count) T(std::forward<Args>(p_args)...);
+                }
+                catch (...) {
+                    allocator->deallocate(new_mem_id);
+                    throw;
+                }
+                relocate(new_mem_id);
+                ++elem_count;
+                return *result;
+            }
+        }
+        T* result = new(data() + elem_count) T(std::forward<Args>(p_args)...);
+        ++elem_count;
+        return *result;
+    }
+
+    /**
+     * @brief Add an element to the end of the buffer.
+     *
+     * @param p_value The element to add.
+     */
+    void push_back(const T& p_value) {
+        emplace_back(p_value);
+    }
+
+    /**
+     * @brief Add an element to the end of the buffer.
+     *
+     * @param p_value The element to add.
+     */
+    void push_back(T&& p_value) {
+        emplace_back(std::move(p_value));
+    }
+
+    /**
+     * @brief Remove the last element.
+     */
+    void pop_back() {
+        WBE_DEBUG_ASSERT(elem_count != 0);
+        --elem_count;
+        std::destroy_at(data() + elem_count);
+    }
+
+    /**
+     * @brief Resize the buffer. New elements are value initialized.
+     *
+     * @param p_size The new number of elements.
+     */
+    void resize(size_t p_size) {
+        reserve(p_size);
+        while (elem_count < p_size) {
+            emplace_back();
+        }
+        while (elem_count > p_size) {
+            pop_back();
+        }
+    }
+
+    /**
+     * @brief Destroy all the elements. The memory is kept.
+     */
+    void clear() {
+        std::destroy_n(data(), elem_count);
+        elem_count = 0;
+    }
+
+    /**
+     * @brief Release the memory that is not used by the elements, in place if the allocator
+     * could shrink the allocation.
+     */
+    void shrink_to_fit() {
+        if (elem_count == capacity) {
+            return;
+        }
+        if (elem_count == 0) {
+            release();
+            return;
+        }
+        reallocate(elem_count);
+    }
+
+    T* data() {
+        return mem_id == MEM_NULL ? nullptr : static_cast<T*>(allocator->get(mem_id));
+    }
+
+    const T* data() const {
+        return mem_id == MEM_NULL ? nullptr : static_cast<const T*>(allocator->get(mem_id));
+    }
+
+    T& operator[](size_t p_index) {
+        WBE_DEBUG_ASSERT(p_index < elem_count);
+        return data()[p_index];
+    }
+
+    const T& operator[](size_t p_index) const {
+        WBE_DEBUG_ASSERT(p_index < elem_count);
+        return data()[p_index];
+    }
+
+    T* begin() {
+        return data();
+    }
+
+    T* end() {
+        return data() + elem_count;
+    }
+
+    const T* begin() const {
+        return data();
+    }
+
+    const T* end() const {
+        return data() + elem_count;
+    }
+
+    size_t size() const {
+        return elem_count;
+    }
+
+    bool empty() const {
+        return elem_count == 0;
+    }
+
+    /**
+     * @brief Get the number of elements the buffer could hold without growing.
+     *
+     * @return The capacity of the buffer.
+     */
+    size_t get_capacity() const {
+        return capacity;
+    }
+
+    /**
+     * @brief Get the number of times the memory is resized in place.
+     *
+     * @return The number of in place resizes.
+     */
+    size_t get_in_place_resize_count() const {
+        return in_place_resize_count;
+    }
+
+    /**
+     * @brief Get the number of times the elements are moved to a new allocation.
+     *
+     * @return The number of moving resizes.
+     */
+    size_t get_moving_resize_count() const {
+        return moving_resize_count;
+    }
+
+private:
+    static constexpr size_t ALIGNMENT = std::max(alignof(T), (size_t)WBE_DEFAULT_ALIGNMENT);
+
+    AllocType* allocator;
+    MemID mem_id = MEM_NULL;
+    size_t elem_count = 0;
+    size_t capacity = 0;
+    size_t in_place_resize_count = 0;
+    size_t moving_resize_count = 0;
+
+    void reallocate(size_t p_capacity) {
+        WBE_DEBUG_ASSERT(p_capacity >= elem_count);
+        if (!expand_in_place(p_capacity)) {
+            relocate(allocate_storage(p_capacity));
+        }
+    }
+
+    bool expand_in_place(size_t p_capacity) {
+        check_capacity(p_capacity);
+        if (mem_id == MEM_NULL || !allocator->try_expand(mem_id, p_capacity * sizeof(T))) {
+            return false;
+        }
+        ++in_place_resize_count;
+        // The allocator could round the size up, use all of it.
+        capacity = allocator->get_allocated_data_size(mem_id) / sizeof(T);
+        return true;
+    }
+
+    MemID allocate_storage(size_t p_capacity) {
+        check_capacity(p_capacity);
+        return allocator->allocate(p_capacity * sizeof(T), ALIGNMENT);
+    }
+
+    // Move the elements to new storage and free the old one.
+    void relocate(MemID p_new_mem_id) {
+        T* new_data = static_cast<T*>(allocator->get(p_new_mem_id));
+        if constexpr (std::is_trivially_copyable_v<T>) {
+            if (elem_count != 0) {
+                std::memcpy(new_data, data(), elem_count * sizeof(T));
+            }
+        }
+        else {
+            std::uninitialized_move_n(data(), elem_count, new_data);
+            std::destroy_n(data(), elem_count);
+        }
+        if (mem_id != MEM_NULL) {
+            allocator->deallocate(mem_id);
+            ++moving_resize_count;
+        }
+        mem_id = p_new_mem_id;
+        capacity = allocator->get_allocated_data_size(mem_id) / sizeof(T);
+    }
+
+    static void check_capacity(size_t p_capacity) {
+        if (p_capacity > std::numeric_limits<size_t>::max() / sizeof(T)) {
+            throw std::runtime_error("Failed to grow buffer: capacity too large.");
+        }
+    }
+
+    void release() {
+        clear();
+        if (mem_id != MEM_NULL) {
+            allocator->deallocate(mem_id);
+            mem_id = MEM_NULL;
+        }
+        capacity = 0;
+    }
+};
+
+}
+
+#endif
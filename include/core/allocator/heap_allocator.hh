@@ -16,7 +16,9 @@
 #define __WBE_HEAP_ALLOCATOR_HH__
 
 #include "allocator.hh"
+#include "core/allocator/allocator_stats.hh"
 #include <sstream>
+#include <type_traits>
 
 namespace WhiteBirdEngine {
 
@@ -73,6 +75,15 @@ public:
      */
     virtual void clear() = 0;
 
+    /**
+     * @brief Get a snapshot of the telemetry of the allocator.
+     *
+     * @return The telemetry of the allocator. Empty if the allocator does not track it.
+     */
+    virtual AllocatorStats get_stats() const {
+        return AllocatorStats();
+    }
+
     /**
      * @brief Get the pointer pointing to the resource.
      *
@@ -104,6 +115,28 @@ public:
     }
 };
 
+/**
+ * @brief Get the pointer pointing to the resource. Dispatched at compile time through the
+ * trait of the allocator: if the allocator declares that the address will not move, the memory
+ * ID is the address, and the allocator is not called. Otherwise this calls get of the allocator,
+ * which is not virtual if the allocator is final.
+ *
+ * @tparam T The type of the resource.
+ * @tparam AllocType The type of the allocator.
+ * @param p_allocator The allocator that the resource is allocated from.
+ * @param p_id The memory ID of the resource.
+ * @return The pointer of the resource. nullptr if p_id is MEM_NULL.
+ */
+template <typename T, typename AllocType>
+inline T* access_obj(AllocType& p_allocator, MemID p_id) {
+    if constexpr (AllocatorAddrStable<std::remove_const_t<AllocType>>) {
+        return reinterpret_cast<T*>(p_id);
+    }
+    else {
+        return static_cast<T*>(p_allocator.get(p_id));
+    }
+}
+
 /**
  * @brief Create an object.
  *
@@ -113,10 +146,10 @@ public:
  * @param p_args The arguments of the constructor.
  * @return The memory ID of the created object.
  */
-template <typename T, typename... Args>
-inline MemID create_obj(HeapAllocator& p_allocator, Args&&... p_args) {
+template <typename T, typename AllocType, typename... Args>
+inline MemID create_obj(AllocType& p_allocator, Args&&... p_args) {
     MemID id = p_allocator.allocate(sizeof(T));
-    new(p_allocator.get(id)) T(std::forward<Args>(p_args)...);
+    new(access_obj<T>(p_allocator, id)) T(std::forward<Args>(p_args)...);
     return id;
 }
 
@@ -132,7 +165,7 @@ inline void destroy_obj(AllocType& p_allocator, MemID p_id) {
     if (p_id == MEM_NULL) {
         return;
     }
-    static_cast<T*>(p_allocator.get(p_id))->~T();
+    access_obj<T>(p_allocator, p_id)->~T();
     p_allocator.deallocate(p_id);
 }
 
@@ -168,7 +201,7 @@ inline void destroy_array(AllocType& p_allocator, MemID p_id, size_t p_num) {
     if (p_id == MEM_NULL) {
         return;
     }
-    T* begin = static_cast<T*>(p_allocator.get(p_id));
+    T* begin = access_obj<T>(p_allocator, p_id);
     for (size_t i = 0; i < p_num; ++i) {
         (begin + i)->~T();
     }
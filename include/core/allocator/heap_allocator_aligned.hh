@@ -17,7 +17,10 @@
 #include "core/allocator/allocator.hh"
 #include "core/allocator/heap_allocator.hh"
 #include "utils/defs.hh"
+#include <algorithm>
+#include <concepts>
 #include <cstddef>
+#include <cstring>
 #include <sstream>
 #include <string>
 
@@ -65,6 +68,43 @@ public:
      */
     virtual MemID allocate(size_t p_size, size_t p_alignment) = 0;
 
+    /**
+     * @brief Allocate multiple chunks of the same size. Pools carve the chunks next to each
+     * other when they could, and atomic pools hold the lock once for the whole batch.
+     * If the allocator cannot hold all of them, nothing is allocated and an exception is thrown.
+     *
+     * @param p_count The number of chunks to allocate.
+     * @param p_size The size of each chunk.
+     * @param p_alignment The alignment of each chunk.
+     * @param r_mem_ids The output array of the allocated memory IDs, must hold at least p_count elements.
+     */
+    virtual void allocate_batch(size_t p_count, size_t p_size, size_t p_alignment, MemID* r_mem_ids) {
+        for (size_t i = 0; i < p_count; ++i) {
+            try {
+                r_mem_ids[i] = allocate(p_size, p_alignment);
+            }
+            catch (...) {
+                // Roll back the chunks that are already allocated.
+                deallocate_batch(r_mem_ids, i);
+                throw;
+            }
+        }
+    }
+
+    /**
+     * @brief Deallocate multiple chunks. Atomic pools hold the lock once for the whole batch.
+     *
+     * @param p_mem_ids The memory IDs to deallocate. MEM_NULL entries are skipped.
+     * @param p_count The number of memory IDs.
+     */
+    virtual void deallocate_batch(const MemID* p_mem_ids, size_t p_count) {
+        for (size_t i = 0; i < p_count; ++i) {
+            if (p_mem_ids[i] != MEM_NULL) {
+                deallocate(p_mem_ids[i]);
+            }
+        }
+    }
+
     /**
      * @brief Get the size of an allocated memory.
      *
@@ -73,6 +113,47 @@ public:
      */
     virtual size_t get_allocated_data_size(MemID p_mem_id) const = 0;
 
+    /**
+     * @brief Try to resize an allocation in place, without moving it.
+     * @note Allocators that could not resize in place always return false.
+     *
+     * @param p_mem The memory ID of the allocation to resize.
+     * @param p_new_size The new size of the allocation, must not be 0.
+     * @return True if the allocation is resized, false if it is left untouched.
+     */
+    virtual bool try_expand(MemID p_mem, size_t p_new_size) {
+        (void)p_mem;
+        (void)p_new_size;
+        return false;
+    }
+
+    /**
+     * @brief Resize an allocation. It is resized in place if possible, otherwise the data is
+     * moved to a new allocation and the old one is deallocated.
+     *
+     * @param p_mem The memory ID of the allocation to resize. MEM_NULL to allocate new memory.
+     * @param p_new_size The new size of the allocation. 0 to deallocate the memory.
+     * @param p_alignment The alignment of the allocation. Should be the alignment it was
+     * allocated with.
+     * @return The memory ID of the resized allocation, which could be different from p_mem.
+     */
+    virtual MemID reallocate(MemID p_mem, size_t p_new_size, size_t p_alignment = WBE_DEFAULT_ALIGNMENT) {
+        if (p_mem == MEM_NULL) {
+            return allocate(p_new_size, p_alignment);
+        }
+        if (p_new_size == 0) {
+            deallocate(p_mem);
+            return MEM_NULL;
+        }
+        if (try_expand(p_mem, p_new_size)) {
+            return p_mem;
+        }
+        MemID result = allocate(p_new_size, p_alignment);
+        std::memcpy(get(result), get(p_mem), std::min(get_allocated_data_size(p_mem), p_new_size));
+        deallocate(p_mem);
+        return result;
+    }
+
     /**
      * @brief Get the pointer pointing to the resource.
      *
@@ -92,6 +173,59 @@ public:
     }
 };
 
+/**
+ * @brief Create multiple objects with one batch allocation, so that they land next to each
+ * other in memory when the allocator could carve them from one block.
+ * @note Only for HeapAllocatorAligned. HeapAllocatorPool and HeapAllocatorAtomicFixedSizePool
+ * are not aligned allocators and have their own allocate_batch and deallocate_batch.
+ *
+ * @tparam T The type of the objects.
+ * @tparam AllocType The type of the allocator.
+ * @tparam Args The types of the constructor arguments.
+ * @param p_allocator The allocator to allocate memory from.
+ * @param p_count The number of objects to create.
+ * @param r_mem_ids The output array of the memory IDs of the objects, must hold at least p_count elements.
+ * @param p_args The arguments passed to the constructor of each object.
+ */
+template <typename T, typename AllocType, typename... Args>
+    requires std::derived_from<AllocType, HeapAllocatorAligned>
+inline void create_obj_batch(AllocType& p_allocator, size_t p_count, MemID* r_mem_ids, Args&&... p_args) {
+    p_allocator.allocate_batch(p_count, sizeof(T), std::max(alignof(T), (size_t)WBE_DEFAULT_ALIGNMENT), r_mem_ids);
+    size_t i = 0;
+    try {
+        for (; i < p_count; ++i) {
+            new(access_obj<T>(p_allocator, r_mem_ids[i])) T(p_args...);
+        }
+    }
+    catch (...) {
+        for (size_t j = 0; j < i; ++j) {
+            access_obj<T>(p_allocator, r_mem_ids[j])->~T();
+        }
+        p_allocator.deallocate_batch(r_mem_ids, p_count);
+        throw;
+    }
+}
+
+/**
+ * @brief Destroy multiple objects and deallocate them with one batch deallocation.
+ *
+ * @tparam T The type of the objects.
+ * @tparam AllocType The type of the allocator.
+ * @param p_allocator The allocator that the objects are allocated from.
+ * @param p_mem_ids The memory IDs of the objects. MEM_NULL entries are skipped.
+ * @param p_count The number of memory IDs.
+ */
+template <typename T, typename AllocType>
+    requires std::derived_from<AllocType, HeapAllocatorAligned>
+inline void destroy_obj_batch(AllocType& p_allocator, const MemID* p_mem_ids, size_t p_count) {
+    for (size_t i = 0; i < p_count; ++i) {
+        if (p_mem_ids[i] != MEM_NULL) {
+            access_obj<T>(p_allocator, p_mem_ids[i])->~T();
+        }
+    }
+    p_allocator.deallocate_batch(p_mem_ids, p_count);
+}
+
 }
 
 #endif
@@ -17,6 +17,7 @@
 
 #include "core/allocator/allocator.hh"
 #include "core/allocator/heap_allocator_aligned.hh"
+#include "core/allocator/virtual_memory_range.hh"
 #include "utils/defs.hh"
 #include <cstddef>
 #include <cstdint>
@@ -41,6 +42,10 @@ struct AllocatorTrait<class HeapAllocatorAlignedPool> final : public AllocatorTr
 /**
  * @class HeapAllocatorAlignedPool
  * @brief Heap allocator pool with memory alignment support.
+ * The idle chunks are kept in an address ordered list, whose nodes are stored at the start of
+ * the idle chunks themselves, so the pool never allocates outside of its own memory.
+ * If constructed with a reserve size, the pool is growable: the memory is a reserved virtual
+ * range, and more pages are committed at the end of the pool when it runs out of space.
  *
  * @todo Test
  */
@@ -69,9 +74,22 @@ public:
     /**
      * @brief Constructor.
      *
-     * @param p_size The total size of the pool.
+     * @param p_size The total size of the pool. Rounded down to a multiple of HEADER_SIZE.
      */
-    HeapAllocatorAlignedPool(size_t p_size);
+    HeapAllocatorAlignedPool(size_t p_size)
+        : HeapAllocatorAlignedPool(p_size, 0) {}
+
+    /**
+     * @brief Constructor.
+     *
+     * @param p_size The initial size of the pool. Rounded down to a multiple of HEADER_SIZE,
+     * or up to the page size if growable.
+     * @param p_reserve_size The size of the virtual memory reserved for the pool to grow into.
+     * 0 for a fixed size pool.
+     * @param p_huge_pages Should try to back the pool with huge pages. The size of a fixed
+     * size pool is then rounded up to the huge page size.
+     */
+    HeapAllocatorAlignedPool(size_t p_size, size_t p_reserve_size, bool p_huge_pages = false);
 
     virtual MemID allocate(size_t p_size, size_t p_alignment = WBE_DEFAULT_ALIGNMENT) override;
 
@@ -89,17 +107,33 @@ public:
         return idle_list_head != nullptr && idle_list_head->size == size;
     }
 
+    /**
+     * @brief Clear the allocator. A growable pool keeps the memory it has committed.
+     */
     virtual void clear() override {
-        idle_list_head = std::make_unique<IdleListNode>();
+        idle_list_head = reinterpret_cast<IdleListNode*>(mem_chunk);
         idle_list_head->size = size;
-        idle_list_head->mem_start = mem_chunk;
         idle_list_head->next = nullptr;
+        idle_chunks_count = 1;
+        free_size = size;
+        stats.on_clear();
     }
 
     virtual size_t get_allocated_data_size(MemID p_mem_id) const override {
-        return *reinterpret_cast<Header*>((p_mem_id - HEADER_SIZE)) & MAX_TOTAL_SIZE;
+        return (*reinterpret_cast<Header*>((p_mem_id - HEADER_SIZE)) & MAX_TOTAL_SIZE) - HEADER_SIZE;
     }
 
+    /**
+     * @brief Try to resize an allocation in place. Shrinking always succeeds, and expanding
+     * succeeds if the chunk after the allocation is idle and large enough. A growable pool
+     * grows if the allocation is at its end.
+     *
+     * @param p_mem The memory ID of the allocation to resize.
+     * @param p_new_size The new size of the allocation, must not be 0.
+     * @return True if the allocation is resized, false if it is left untouched.
+     */
+    virtual bool try_expand(MemID p_mem, size_t p_new_size) override;
+
     /**
      * @brief Get the total size of the pool.
      *
@@ -109,12 +143,50 @@ public:
         return size;
     }
 
+    /**
+     * @brief Check if the pool grows when it runs out of space.
+     *
+     * @return True if the pool is growable, false otherwise.
+     */
+    bool is_growable() const {
+        return growable;
+    }
+
+    /**
+     * @brief Get the size of the memory backing the pool.
+     *
+     * @return The committed size in bytes.
+     */
+    size_t get_committed_size() const {
+        return size;
+    }
+
+    /**
+     * @brief Get the size the pool could grow to.
+     *
+     * @return The reserved size in bytes. The total size if not growable.
+     */
+    size_t get_reserved_size() const {
+        return is_growable() ? virtual_memory->get_reserved_size() : size;
+    }
+
+    /**
+     * @brief Get the kind of pages backing the pool.
+     *
+     * @return The page backing obtained.
+     */
+    PageBacking get_page_backing() const {
+        return virtual_memory != nullptr ? virtual_memory->get_page_backing() : PageBacking::NORMAL;
+    }
+
     /**
      * @brief Get the total size of the free chunkes.
      *
      * @return The total size of the free chunks.
      */
-    size_t get_remain_size() const;
+    size_t get_remain_size() const {
+        return free_size;
+    }
 
     /**
      * @brief Check if a memory id belongs in this pool.
@@ -124,6 +196,21 @@ public:
      */
     bool is_in_pool(MemID p_mem_id) const;
 
+    /**
+     * @brief Get a snapshot of the telemetry of the allocator, without walking the idle list.
+     * The largest idle block is not tracked, see get_largest_free_block.
+     *
+     * @return The telemetry of the allocator.
+     */
+    virtual AllocatorStats get_stats() const override;
+
+    /**
+     * @brief Get the size of the largest idle chunk. Walks the idle list.
+     *
+     * @return The size of the largest idle chunk.
+     */
+    size_t get_largest_free_block() const;
+
     virtual operator std::string() const override;
 
     size_t get_internal_fragmentation_tracker() const {
@@ -132,23 +219,34 @@ public:
 
 private:
 
+    /**
+     * @brief Stored at the start of every idle chunk. Chunk boundaries are kept at multiples of
+     * HEADER_SIZE, so every idle chunk is large enough to hold one.
+     */
     struct IdleListNode {
+        // The size of the idle chunk, including this node.
         size_t size;
-        char* mem_start;
-        std::unique_ptr<IdleListNode> next = nullptr;
+        // The next idle chunk in address order.
+        IdleListNode* next;
     };
+    static_assert(sizeof(IdleListNode) <= HEADER_SIZE);
 
-    void* acquire_memory(std::unique_ptr<IdleListNode>& p_node, char* p_mem_start, size_t p_mem_size);
-    void insert_free_memory(IdleListNode* p_node_before_insert, char* p_insert_start, size_t p_insert_size);
-    bool combine_idle_with_next(IdleListNode* p_node);
-    std::unique_ptr<IdleListNode>& get_idle_node_before(void* p_loc);
+    MemID find_valid_chunk(size_t p_aligned_size, size_t p_alignment);
+    void* acquire_memory(IdleListNode** p_link, char* p_mem_start, size_t p_mem_size);
+    void insert_free_memory(char* p_insert_start, size_t p_insert_size);
+    bool grow(size_t p_size);
 
     size_t size;
     char* mem_chunk;
     uint32_t idle_chunks_count;
-    std::unique_ptr<IdleListNode> idle_list_head;
+    IdleListNode* idle_list_head;
+    // The total size of the idle chunks.
+    size_t free_size = 0;
+    std::unique_ptr<VirtualMemoryRange> virtual_memory;
+    bool growable = false;
 
     size_t internal_fragmentation_tracker = 0;
+    AllocatorStatsTracker<> stats;
 };
 
 }
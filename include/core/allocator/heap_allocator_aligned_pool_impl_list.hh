@@ -17,15 +17,14 @@
 
 #include "core/allocator/allocator.hh"
 #include "core/allocator/heap_allocator_aligned.hh"
+#include "core/allocator/virtual_memory_range.hh"
 #include "utils/defs.hh"
 #include <cstddef>
 #include <cstdint>
 #include <limits>
+#include <memory>
 
-#define WBE_HAAPIL_GET_HEADER_SIZE(p_header) p_header & TOTAL_SIZE_MASK
-#define WBE_HAAPIL_GET_CHUNK_SIZE(p_chunk) WBE_HAAPIL_GET_HEADER_SIZE(*reinterpret_cast<Header*>(p_mem_chunk))
-#define WBE_HAAPIL_SET_HEADER(p_header, p_head_type, p_size) (*p_header = (((Header)(p_head_type) << 60) | (p_size)))
-#define WBE_HAAPIL_SET_CHUNK_HEADER(p_chunk, p_type, p_size) WBE_HAAPIL_SET_HEADER(reinterpret_cast<Header*>(p_chunk), (p_type), (p_size))
+#define WBE_HAAPIL_GET_HEADER_SIZE(p_header) ((p_header) & TOTAL_SIZE_MASK)
 
 
 namespace WhiteBirdEngine {
@@ -46,6 +45,11 @@ struct AllocatorTrait<class HeapAllocatorAlignedPoolImplicitList> final : public
 /**
  * @class HeapAllocatorAlignedPoolImplicitList
  * @brief Heap allocator pool with memory alignment support, with an implicit list.
+ * Idle chunks carry a footer with their size, and every header records whether the chunk
+ * before it is idle, so a deallocated chunk is merged with both neighbours immediately.
+ * Idle chunks are therefore never adjacent, and allocation never needs to coalesce.
+ * If constructed with a reserve size, the pool is growable: the memory is a reserved virtual
+ * range, and more pages are committed at the end of the pool when it runs out of space.
  */
 class HeapAllocatorAlignedPoolImplicitList final : public HeapAllocatorAligned {
 public:
@@ -72,14 +76,38 @@ public:
     /**
      * @brief Constructor.
      *
-     * @param p_size The total size of the pool.
+     * @param p_size The total size of the pool. Rounded down to a multiple of HEADER_SIZE.
      */
-    HeapAllocatorAlignedPoolImplicitList(size_t p_size);
+    HeapAllocatorAlignedPoolImplicitList(size_t p_size)
+        : HeapAllocatorAlignedPoolImplicitList(p_size, 0) {}
+
+    /**
+     * @brief Constructor.
+     *
+     * @param p_size The initial size of the pool. Rounded up to the page size if growable.
+     * @param p_reserve_size The size of the virtual memory reserved for the pool to grow into.
+     * 0 for a fixed size pool.
+     * @param p_huge_pages Should try to back the pool with huge pages. The size of a fixed
+     * size pool is then rounded up to the huge page size.
+     */
+    HeapAllocatorAlignedPoolImplicitList(size_t p_size, size_t p_reserve_size, bool p_huge_pages = false);
 
     virtual MemID allocate(size_t p_size, size_t p_alignment = HEADER_SIZE) override;
 
     virtual void deallocate(MemID p_mem) override;
 
+    /**
+     * @brief Allocate multiple chunks of the same size. The chunks are carved from one idle
+     * chunk if there is one large enough.
+     * If the pool cannot hold all of them, nothing is allocated.
+     *
+     * @param p_count The number of chunks to allocate.
+     * @param p_size The size of each chunk.
+     * @param p_alignment The alignment of each chunk.
+     * @param r_mem_ids The output array of the allocated memory IDs, must hold at least p_count elements.
+     */
+    virtual void allocate_batch(size_t p_count, size_t p_size, size_t p_alignment, MemID* r_mem_ids) override;
+
     virtual void* get(MemID p_id) const override {
         if (p_id == MEM_NULL) {
 
@@ -93,15 +121,31 @@ public:
         return get_remain_size() == size;
     }
 
+    /**
+     * @brief Clear the allocator. A growable pool keeps the memory it has committed.
+     */
     virtual void clear() override {
-        WBE_HAAPIL_SET_CHUNK_HEADER(mem_chunk, HeaderType::IDLE, size);
+        write_chunk(mem_chunk, HeaderType::IDLE, size, false);
         possible_valid = mem_chunk;
+        free_size = size;
+        stats.on_clear();
     }
 
     virtual size_t get_allocated_data_size(MemID p_mem_id) const override {
-        return WBE_HAAPIL_GET_HEADER_SIZE(*reinterpret_cast<Header*>((p_mem_id - HEADER_SIZE)));
+        return WBE_HAAPIL_GET_HEADER_SIZE(*reinterpret_cast<Header*>((p_mem_id - HEADER_SIZE))) - HEADER_SIZE;
     }
 
+    /**
+     * @brief Try to resize an allocation in place. Shrinking always succeeds, and the memory
+     * released is merged with the idle chunk after it. Expanding succeeds if the chunk after
+     * it is idle and large enough, and a growable pool grows if the allocation is at its end.
+     *
+     * @param p_mem The memory ID of the allocation to resize.
+     * @param p_new_size The new size of the allocation, must not be 0.
+     * @return True if the allocation is resized, false if it is left untouched.
+     */
+    virtual bool try_expand(MemID p_mem, size_t p_new_size) override;
+
     /**
      * @brief Get the total size of the allocator.
      *
@@ -111,6 +155,42 @@ public:
         return size;
     }
 
+    /**
+     * @brief Check if the pool grows when it runs out of space.
+     *
+     * @return True if the pool is growable, false otherwise.
+     */
+    bool is_growable() const {
+        return growable;
+    }
+
+    /**
+     * @brief Get the kind of pages backing the pool.
+     *
+     * @return The page backing obtained.
+     */
+    PageBacking get_page_backing() const {
+        return virtual_memory != nullptr ? virtual_memory->get_page_backing() : PageBacking::NORMAL;
+    }
+
+    /**
+     * @brief Get the size of the memory backing the pool.
+     *
+     * @return The committed size in bytes.
+     */
+    size_t get_committed_size() const {
+        return size;
+    }
+
+    /**
+     * @brief Get the size the pool could grow to.
+     *
+     * @return The reserved size in bytes. The total size if not growable.
+     */
+    size_t get_reserved_size() const {
+        return is_growable() ? virtual_memory->get_reserved_size() : size;
+    }
+
     /**
      * @brief Get the remaining size of the allocator.
      *
@@ -118,6 +198,22 @@ public:
      */
     size_t get_remain_size() const;
 
+    /**
+     * @brief Get a snapshot of the telemetry of the allocator, without walking the pool.
+     * The largest idle block is not tracked and left 0, see get_largest_free_block.
+     *
+     * @return The telemetry of the allocator.
+     */
+    virtual AllocatorStats get_stats() const override;
+
+    /**
+     * @brief Get the size of the largest idle chunk. Walks every chunk of the pool, meant for
+     * inspection rather than every frame.
+     *
+     * @return The size of the largest idle chunk.
+     */
+    size_t get_largest_free_block() const;
+
     virtual operator std::string() const override;
 
     /**
@@ -147,10 +243,18 @@ private:
     size_t size;
     char* mem_chunk;
     mutable char* possible_valid;
+    std::unique_ptr<VirtualMemoryRange> virtual_memory;
+    bool growable = false;
+    // If the last chunk of the pool is idle. There is no header after it to record that.
+    bool last_idle = true;
+    // The total size of the idle chunks, kept with the allocations so the stats do not walk the pool.
+    size_t free_size = 0;
 
     size_t internal_fragmentation_tracker = 0;
+    AllocatorStatsTracker<> stats;
 
     static constexpr Header HEADER_TYPE_MASK = (0b1ull << 60);
+    static constexpr Header PREV_IDLE_MASK = (0b1ull << 61);
     enum class HeaderType {
         // Occupied head
         OCCUPIED = 0,
@@ -158,25 +262,29 @@ private:
         IDLE = 1,
     };
 
-    template <bool COALESCE_ENABLED>
+    static void check_alignment(size_t p_alignment);
     MemID check_posible_free(size_t p_aligned_size, size_t p_alignment);
-    template <bool COALESCE_ENABLED>
     MemID find_valid_chunk(size_t p_aligned_size, size_t p_alignment);
-    template <bool CHECK_FIRST, bool COALESCE_ENABLED>
+    template <bool CHECK_FIRST>
     char* get_next_free_memory(char* p_from);
     void* acquire_memory(char* p_idle_chunk, char* p_mem_start, size_t p_mem_size);
     void insert_free_memory(char* p_insert_start, size_t p_insert_size);
+    bool grow(size_t p_size);
 
-    void coalesce_all() const;
-    void coalesce_chunk(char* p_chunk) const;
+    /**
+     * @brief Write the header of a chunk, the footer if idle, and the previous idle flag of the next chunk.
+     *
+     * @param p_chunk The start of the chunk.
+     * @param p_type The type of the chunk.
+     * @param p_size The size of the chunk.
+     * @param p_prev_idle If the chunk before is idle.
+     */
+    void write_chunk(char* p_chunk, HeaderType p_type, size_t p_size, bool p_prev_idle);
 };
 
 }
 
 #undef WBE_HAAPIL_GET_HEADER_SIZE
-#undef WBE_HAAPIL_GET_CHUNK_SIZE
-#undef WBE_HAAPIL_SET_HEADER
-#undef WBE_HAAPIL_SET_CHUNK_HEADER
 
 
 #endif
@@ -17,6 +17,7 @@
 
 #include "core/allocator/allocator.hh"
 #include "core/allocator/heap_allocator_aligned.hh"
+#include "core/allocator/virtual_memory_range.hh"
 #include <boost/thread/lock_types.hpp>
 #include <boost/thread/shared_mutex.hpp>
 #include <limits>
@@ -41,7 +42,9 @@ struct AllocatorTrait<class HeapAllocatorAtomicAlignedPool> final : public Alloc
 /**
  * @class HeapAllocatorAtomicAlignedPool
  * @brief Heap allocator aligned pool atomic version.
- *
+ * If constructed with a reserve size, the pool is growable: the memory is a reserved virtual
+ * range, and more pages are committed at the end of the pool, under the lock, when it runs
+ * out of space.
  */
 class HeapAllocatorAtomicAlignedPool final : public HeapAllocatorAligned {
 public:
@@ -71,12 +74,42 @@ public:
      *
      * @param p_size The total size of the pool.
      */
-    HeapAllocatorAtomicAlignedPool(size_t p_size);
+    HeapAllocatorAtomicAlignedPool(size_t p_size)
+        : HeapAllocatorAtomicAlignedPool(p_size, 0) {}
+
+    /**
+     * @brief Constructor.
+     *
+     * @param p_size The initial size of the pool. Rounded up to the page size if growable.
+     * @param p_reserve_size The size of the virtual memory reserved for the pool to grow into.
+     * 0 for a fixed size pool.
+     */
+    HeapAllocatorAtomicAlignedPool(size_t p_size, size_t p_reserve_size);
 
     virtual MemID allocate(size_t p_size, size_t p_alignment = WBE_DEFAULT_ALIGNMENT) override;
 
     virtual void deallocate(MemID p_mem) override;
 
+    /**
+     * @brief Allocate multiple chunks of the same size while holding the lock once. The chunks
+     * are carved from one idle block if there is one large enough.
+     * If the pool cannot hold all of them, nothing is allocated.
+     *
+     * @param p_count The number of chunks to allocate.
+     * @param p_size The size of each chunk.
+     * @param p_alignment The alignment of each chunk.
+     * @param r_mem_ids The output array of the allocated memory IDs, must hold at least p_count elements.
+     */
+    virtual void allocate_batch(size_t p_count, size_t p_size, size_t p_alignment, MemID* r_mem_ids) override;
+
+    /**
+     * @brief Deallocate multiple chunks while holding the lock once.
+     *
+     * @param p_mem_ids The memory IDs to deallocate. MEM_NULL entries are skipped.
+     * @param p_count The number of memory IDs.
+     */
+    virtual void deallocate_batch(const MemID* p_mem_ids, size_t p_count) override;
+
     virtual void* get(MemID p_id) const override {
         if (p_id == MEM_NULL) {
             return nullptr;
@@ -98,11 +131,14 @@ public:
         idle_list_head->size = size;
         idle_list_head->mem_start = mem_chunk;
         idle_list_head->next = nullptr;
+        free_size = size;
+        stats.on_clear();
     }
 
     virtual size_t get_allocated_data_size(MemID p_mem_id) const override {
-        boost::shared_lock lock(mutex);
-        return *reinterpret_cast<Header*>((p_mem_id - HEADER_SIZE)) & MAX_TOTAL_SIZE;
+        // The header of an allocated chunk is only modified when it is allocated, so reading it
+        // does not need to be protected by the lock.
+        return (*reinterpret_cast<Header*>((p_mem_id - HEADER_SIZE)) & MAX_TOTAL_SIZE) - HEADER_SIZE;
     }
 
     size_t get_total_size() const {
@@ -110,6 +146,33 @@ public:
         return size;
     }
 
+    /**
+     * @brief Check if the pool grows when it runs out of space.
+     *
+     * @return True if the pool is growable, false otherwise.
+     */
+    bool is_growable() const {
+        return virtual_memory != nullptr;
+    }
+
+    /**
+     * @brief Get the size of the memory backing the pool.
+     *
+     * @return The committed size in bytes.
+     */
+    size_t get_committed_size() const {
+        return get_total_size();
+    }
+
+    /**
+     * @brief Get the size the pool could grow to.
+     *
+     * @return The reserved size in bytes. The total size if not growable.
+     */
+    size_t get_reserved_size() const {
+        return is_growable() ? virtual_memory->get_reserved_size() : get_total_size();
+    }
+
     size_t get_remain_size() const;
 
 
@@ -125,6 +188,22 @@ public:
         return result;
     }
 
+    /**
+     * @brief Get a snapshot of the telemetry of the allocator, without walking the idle list.
+     * Lock wait time is measured on allocation and deallocation. The largest idle block is not
+     * tracked, see get_largest_free_block.
+     *
+     * @return The telemetry of the allocator.
+     */
+    virtual AllocatorStats get_stats() const override;
+
+    /**
+     * @brief Get the size of the largest idle chunk. Walks the idle list while holding the lock.
+     *
+     * @return The size of the largest idle chunk.
+     */
+    size_t get_largest_free_block() const;
+
     virtual operator std::string() const override;
 
     size_t get_internal_fragmentation_tracker() const {
@@ -141,6 +220,11 @@ private:
     };
 
     bool unguard_is_in_pool(MemID p_mem_id) const;
+    static void check_alignment(size_t p_alignment);
+    MemID unguard_allocate(size_t p_aligned_size, size_t p_alignment);
+    MemID find_valid_chunk(size_t p_aligned_size, size_t p_alignment);
+    void unguard_deallocate(MemID p_mem);
+    bool grow(size_t p_size);
 
     void* acquire_memory(std::unique_ptr<IdleListNode>& p_node, char* p_mem_start, size_t p_mem_size);
     void insert_free_memory(IdleListNode* p_node_before_insert, char* p_insert_start, size_t p_insert_size);
@@ -151,8 +235,14 @@ private:
     char* mem_chunk;
     uint32_t idle_chunks_count;
     std::unique_ptr<IdleListNode> idle_list_head;
+    // The total size of the idle chunks.
+    size_t free_size = 0;
+    // Only set for a growable pool.
+    std::unique_ptr<VirtualMemoryRange> virtual_memory;
 
     size_t internal_fragmentation_tracker = 0;
+    // Only updated while holding the unique lock.
+    AllocatorStatsTracker<> stats;
     mutable boost::shared_mutex mutex;
 };
 
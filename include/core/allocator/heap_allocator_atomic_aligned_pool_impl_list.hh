@@ -17,11 +17,13 @@
 
 #include "core/allocator/allocator.hh"
 #include "core/allocator/heap_allocator_aligned.hh"
+#include "core/allocator/virtual_memory_range.hh"
 #include "core/debug_utils/debug_mutex.hh"
 #include "utils/defs.hh"
 #include <cstddef>
 #include <cstdint>
 #include <limits>
+#include <memory>
 #include <boost/thread/lock_types.hpp>
 #include <boost/thread/shared_mutex.hpp>
 #include <string>
@@ -50,6 +52,9 @@ struct AllocatorTrait<class HeapAllocatorAtomicAlignedPoolImplicitList> final :
 /**
  * @class HeapAllocatorAtomicAlignedPoolImplicitList
  * @brief Heap allocator atomic pool with memory alignment support, with an implicit list.
+ * If constructed with a reserve size, the pool is growable: the memory is a reserved virtual
+ * range, and more pages are committed at the end of the pool, under the lock, when it runs
+ * out of space.
  */
 class HeapAllocatorAtomicAlignedPoolImplicitList final : public HeapAllocatorAligned {
 public:
@@ -78,12 +83,42 @@ public:
      *
      * @param p_size The total size of the pool.
      */
-    HeapAllocatorAtomicAlignedPoolImplicitList(size_t p_size);
+    HeapAllocatorAtomicAlignedPoolImplicitList(size_t p_size)
+        : HeapAllocatorAtomicAlignedPoolImplicitList(p_size, 0) {}
+
+    /**
+     * @brief Constructor.
+     *
+     * @param p_size The initial size of the pool. Rounded up to the page size if growable.
+     * @param p_reserve_size The size of the virtual memory reserved for the pool to grow into.
+     * 0 for a fixed size pool.
+     */
+    HeapAllocatorAtomicAlignedPoolImplicitList(size_t p_size, size_t p_reserve_size);
 
     virtual MemID allocate(size_t p_size, size_t p_alignment = HEADER_SIZE) override;
 
     virtual void deallocate(MemID p_mem) override;
 
+    /**
+     * @brief Allocate multiple chunks of the same size while holding the lock once. The chunks
+     * are carved from one idle block if there is one large enough.
+     * If the pool cannot hold all of them, nothing is allocated.
+     *
+     * @param p_count The number of chunks to allocate.
+     * @param p_size The size of each chunk.
+     * @param p_alignment The alignment of each chunk.
+     * @param r_mem_ids The output array of the allocated memory IDs, must hold at least p_count elements.
+     */
+    virtual void allocate_batch(size_t p_count, size_t p_size, size_t p_alignment, MemID* r_mem_ids) override;
+
+    /**
+     * @brief Deallocate multiple chunks while holding the lock once.
+     *
+     * @param p_mem_ids The memory IDs to deallocate. MEM_NULL entries are skipped.
+     * @param p_count The number of memory IDs.
+     */
+    virtual void deallocate_batch(const MemID* p_mem_ids, size_t p_count) override;
+
     virtual void* get(MemID p_id) const override {
         if (p_id == MEM_NULL) {
             return nullptr;
@@ -103,11 +138,13 @@ public:
         boost::unique_lock lock(mutex);
         WBE_HAAAPIL_SET_CHUNK_HEADER(mem_chunk, HeaderType::IDLE, size);
         possible_valid = mem_chunk;
+        free_size = size;
+        stats.on_clear();
     }
 
     virtual size_t get_allocated_data_size(MemID p_mem_id) const override {
         boost::shared_lock lock(mutex);
-        return WBE_HAAAPIL_GET_HEADER_SIZE(*reinterpret_cast<Header*>((p_mem_id - HEADER_SIZE)));
+        return (WBE_HAAAPIL_GET_HEADER_SIZE(*reinterpret_cast<Header*>((p_mem_id - HEADER_SIZE)))) - HEADER_SIZE;
     }
 
     /**
@@ -120,6 +157,33 @@ public:
         return size;
     }
 
+    /**
+     * @brief Check if the pool grows when it runs out of space.
+     *
+     * @return True if the pool is growable, false otherwise.
+     */
+    bool is_growable() const {
+        return virtual_memory != nullptr;
+    }
+
+    /**
+     * @brief Get the size of the memory backing the pool.
+     *
+     * @return The committed size in bytes.
+     */
+    size_t get_committed_size() const {
+        return get_total_size();
+    }
+
+    /**
+     * @brief Get the size the pool could grow to.
+     *
+     * @return The reserved size in bytes. The total size if not growable.
+     */
+    size_t get_reserved_size() const {
+        return is_growable() ? virtual_memory->get_reserved_size() : get_total_size();
+    }
+
     /**
      * @brief Get the remaining size of the allocator.
      *
@@ -127,6 +191,24 @@ public:
      */
     size_t get_remain_size() const;
 
+    /**
+     * @brief Get a snapshot of the telemetry of the allocator, without walking the pool. Lock
+     * wait time is measured on allocation and deallocation. The largest idle block is not
+     * tracked and left 0, see get_largest_free_block.
+     *
+     * @return The telemetry of the allocator.
+     */
+    virtual AllocatorStats get_stats() const override;
+
+    /**
+     * @brief Get the size of the largest idle block, adjacent idle chunks not coalesced yet
+     * count as one. Walks every chunk of the pool while holding the lock, meant for inspection
+     * rather than every frame.
+     *
+     * @return The size of the largest idle block.
+     */
+    size_t get_largest_free_block() const;
+
     virtual operator std::string() const override;
 
     /**
@@ -160,6 +242,8 @@ private:
     size_t size;
     char* mem_chunk;
     mutable char* possible_valid;
+    // Only set for a growable pool.
+    std::unique_ptr<VirtualMemoryRange> virtual_memory;
 #ifdef _DEBUG
     mutable DebugSharedMutex mutex;
 #else
@@ -167,6 +251,10 @@ private:
 #endif
 
     size_t internal_fragmentation_tracker = 0;
+    // The total size of the idle chunks. Only updated while holding the unique lock, like the stats.
+    size_t free_size = 0;
+    // Only updated while holding the unique lock.
+    AllocatorStatsTracker<> stats;
 
     static constexpr Header HEADER_TYPE_MASK = (0b1ull << 60);
     enum class HeaderType {
@@ -177,6 +265,9 @@ private:
     };
 
     void unguarded_check_broken() const;
+    static void check_alignment(size_t p_alignment);
+    MemID unguarded_allocate(size_t p_aligned_size, size_t p_alignment);
+    void unguarded_deallocate(MemID p_mem);
 
     template <bool COALESCE_ENABLED>
     MemID check_posible_free(size_t p_aligned_size, size_t p_alignment);
@@ -187,6 +278,7 @@ private:
     void* acquire_memory(char* p_idle_chunk, char* p_mem_start, size_t p_mem_size);
     void insert_free_memory(char* p_insert_start, size_t p_insert_size);
 
+    bool grow(size_t p_size);
     void coalesce_all() const;
     void coalesce_chunk(char* p_chunk) const;
     bool unguarded_is_in_pool(MemID p_mem_id) const;
@@ -0,0 +1,201 @@
+/* Copyright 2025 OppositeNor
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef __WBE_HEAP_ALLOCATOR_ATOMIC_FIXED_SIZE_POOL_HH__
+#define __WBE_HEAP_ALLOCATOR_ATOMIC_FIXED_SIZE_POOL_HH__
+
+#include "core/allocator/allocator.hh"
+#include "heap_allocator.hh"
+#include "utils/defs.hh"
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+
+namespace WhiteBirdEngine {
+
+template <>
+struct AllocatorTrait<class HeapAllocatorAtomicFixedSizePool> final : public AllocatorTrait<HeapAllocator> {
+    WBE_TRAIT(AllocatorTrait<HeapAllocatorAtomicFixedSizePool>);
+    static constexpr bool IS_POOL = true;
+    static constexpr bool IS_GURANTEED_CONTINUOUS = false;
+    static constexpr bool IS_ALIGNABLE = false;
+    static constexpr bool IS_LIMITED_SIZE = true;
+    static constexpr bool IS_ALLOC_FIXED_SIZE = true;
+    static constexpr bool IS_ATOMIC = true;
+    static constexpr bool WILL_ADDR_MOVE = false;
+
+    WBE_TRAIT_REQUIRES(AllocatorTraitConcept);
+};
+
+/**
+ * @class HeapAllocatorAtomicFixedSizePool
+ * @brief Fixed size pool that can be used from multiple threads without locking.
+ * Idle slots are kept in a lock-free stack. The head of the stack is a slot index tagged
+ * with a counter that increases on every change, so that a head popped and pushed back
+ * between a load and a compare exchange (ABA) will not be mistaken as unchanged.
+ * Unlike HeapAllocatorFixedSizePool, objects are never moved, and the memory ID is the
+ * address of the object.
+ */
+class HeapAllocatorAtomicFixedSizePool final : public HeapAllocator {
+public:
+    using SlotIndex = uint32_t;
+
+    /**
+     * @brief The maximum number of objects the pool can hold.
+     */
+    static constexpr uint32_t MAX_OBJ = std::numeric_limits<SlotIndex>::max() - 1;
+
+    /**
+     * @brief The alignment of every slot.
+     */
+    static constexpr size_t SLOT_ALIGNMENT = WBE_DEFAULT_ALIGNMENT;
+
+    virtual ~HeapAllocatorAtomicFixedSizePool() override;
+    HeapAllocatorAtomicFixedSizePool(const HeapAllocatorAtomicFixedSizePool&) = delete;
+    HeapAllocatorAtomicFixedSizePool(HeapAllocatorAtomicFixedSizePool&&) = delete;
+    HeapAllocatorAtomicFixedSizePool& operator=(const HeapAllocatorAtomicFixedSizePool&) = delete;
+    HeapAllocatorAtomicFixedSizePool& operator=(HeapAllocatorAtomicFixedSizePool&&) = delete;
+
+    /**
+     * @brief Constructor.
+     *
+     * @param p_element_size The size of each element.
+     * @param p_max_obj The maximum objects this allocator could hold. Up to MAX_OBJ maximum.
+     */
+    HeapAllocatorAtomicFixedSizePool(size_t p_element_size, uint32_t p_max_obj);
+
+    /**
+     * @brief Allocate a slot.
+     *
+     * @param p_size The size to allocate. Must not be larger than the element size.
+     * 0 for the element size.
+     * @return The memory ID of the allocated slot, which is also its address.
+     */
+    virtual MemID allocate(size_t p_size = 0) override;
+
+    virtual void deallocate(MemID p_mem) override;
+
+    /**
+     * @brief Allocate multiple slots, popped from the idle stack with a single compare exchange.
+     * The pool is not a HeapAllocatorAligned, so this is not the virtual of HeapAllocatorAligned
+     * and create_obj_batch does not apply. If the pool does not have enough idle slots, nothing
+     * is allocated and an exception is thrown.
+     *
+     * @param p_count The number of slots to allocate.
+     * @param r_mem_ids The output array of the allocated memory IDs, must hold at least p_count elements.
+     */
+    void allocate_batch(size_t p_count, MemID* r_mem_ids);
+
+    /**
+     * @brief Deallocate multiple slots, pushed to the idle stack with a single compare exchange.
+     *
+     * @param p_mem_ids The memory IDs to deallocate. MEM_NULL entries are skipped.
+     * @param p_count The number of memory IDs.
+     */
+    void deallocate_batch(const MemID* p_mem_ids, size_t p_count);
+
+    virtual void* get(MemID p_id) const override {
+        WBE_DEBUG_ASSERT(p_id == MEM_NULL || is_in_pool(p_id));
+        return reinterpret_cast<void*>(p_id);
+    }
+
+    virtual bool is_empty() const override {
+        return obj_count() == 0;
+    }
+
+    /**
+     * @brief Clear the allocator.
+     * @note Not atomic. Should not be called while other threads are using this allocator.
+     */
+    virtual void clear() override;
+
+    /**
+     * @brief Get number of allocated objects.
+     *
+     * @return The number of allocated objects.
+     */
+    uint32_t obj_count() const {
+        return alloc_obj_count.load(std::memory_order_relaxed);
+    }
+
+    size_t get_allocated_data_size(MemID) const {
+        return element_size;
+    }
+
+    size_t get_element_size() const {
+        return element_size;
+    }
+
+    uint32_t get_max_obj() const {
+        return max_obj;
+    }
+
+    /**
+     * @brief Check if a memory ID points to a slot of this pool.
+     *
+     * @param p_mem_id The memory ID to check.
+     * @return True if the memory ID points to the start of a slot, false otherwise.
+     */
+    bool is_in_pool(MemID p_mem_id) const {
+        MemID mem_start = reinterpret_cast<MemID>(mem_chunk);
+        return p_mem_id >= mem_start && p_mem_id < mem_start + slot_size * max_obj
+            && (p_mem_id - mem_start) % slot_size == 0;
+    }
+
+    virtual AllocatorStats get_stats() const override;
+
+    virtual operator std::string() const override;
+
+private:
+    // Index 0 is the end of the idle stack, slot i is stored at index i + 1.
+    static constexpr SlotIndex NULL_INDEX = 0;
+
+    static constexpr uint64_t make_head(uint64_t p_tag, SlotIndex p_index) {
+        return (p_tag << 32) | p_index;
+    }
+
+    static constexpr SlotIndex get_head_index(uint64_t p_head) {
+        return static_cast<SlotIndex>(p_head);
+    }
+
+    static constexpr uint64_t get_head_tag(uint64_t p_head) {
+        return p_head >> 32;
+    }
+
+    SlotIndex get_slot_index(MemID p_mem) const {
+        return static_cast<SlotIndex>((p_mem - reinterpret_cast<MemID>(mem_chunk)) / slot_size) + 1;
+    }
+
+    MemID get_slot_mem_id(SlotIndex p_index) const {
+        return reinterpret_cast<MemID>(mem_chunk + (p_index - 1) * slot_size);
+    }
+
+    const size_t element_size;
+    const size_t slot_size;
+    const uint32_t max_obj;
+    char* mem_chunk;
+    // The next index in the idle stack of each slot. Kept outside of the slots, so that a
+    // stale read of a slot that was just allocated does not race with the user's data.
+    std::unique_ptr<std::atomic<SlotIndex>[]> next_indices;
+
+    WBE_NO_FALSE_SHARING std::atomic<uint64_t> idle_head = 0;
+    WBE_NO_FALSE_SHARING std::atomic<uint32_t> alloc_obj_count = 0;
+    WBE_NO_FALSE_SHARING AllocatorStatsTracker<true> stats;
+};
+
+}
+
+#endif
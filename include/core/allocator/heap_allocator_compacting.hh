@@ -0,0 +1,228 @@
+/* Copyright 2025 OppositeNor
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef __WBE_HEAP_ALLOCATOR_COMPACTING_HH__
+#define __WBE_HEAP_ALLOCATOR_COMPACTING_HH__
+
+#include "core/allocator/allocator.hh"
+#include "core/allocator/allocator_stats.hh"
+#include "core/allocator/heap_allocator_aligned.hh"
+#include "utils/defs.hh"
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace WhiteBirdEngine {
+
+template <>
+struct AllocatorTrait<class HeapAllocatorCompacting> final : public AllocatorTrait<HeapAllocatorAligned> {
+    WBE_TRAIT(AllocatorTrait<HeapAllocatorCompacting>);
+    static constexpr bool IS_POOL = true;
+    static constexpr bool IS_GURANTEED_CONTINUOUS = false;
+    static constexpr bool IS_LIMITED_SIZE = true;
+    static constexpr bool IS_ALLOC_FIXED_SIZE = false;
+    static constexpr bool IS_ATOMIC = false;
+    static constexpr bool WILL_ADDR_MOVE = true;
+
+    WBE_TRAIT_REQUIRES(AllocatorTraitConcept);
+};
+
+/**
+ * @class HeapAllocatorCompacting
+ * @brief Variable size heap that could defragment itself. Memory IDs are handles into a table
+ * of chunk offsets, so the chunks could be slid towards the start of the pool while they are
+ * allocated. The compaction is incremental: each call to defragment moves a bounded number of
+ * bytes, so it could be run a little every frame without pauses.
+ * @note The data is moved with memmove, so only trivially relocatable objects should be stored,
+ * and pointers obtained from get are only valid until the next call to defragment.
+ * @note Every chunk is aligned to HEADER_SIZE. Larger alignments are not supported, since a
+ * chunk could not keep them when it is moved.
+ */
+class HeapAllocatorCompacting final : public HeapAllocatorAligned {
+public:
+    HeapAllocatorCompacting()
+        : HeapAllocatorCompacting(WBE_KiB(64)) {}
+    virtual ~HeapAllocatorCompacting() override;
+    HeapAllocatorCompacting(const HeapAllocatorCompacting&) = delete;
+    HeapAllocatorCompacting(HeapAllocatorCompacting&&) = delete;
+    HeapAllocatorCompacting& operator=(const HeapAllocatorCompacting&) = delete;
+    HeapAllocatorCompacting& operator=(HeapAllocatorCompacting&&) = delete;
+
+    /**
+     * @brief The size of the chunk header, which is also the alignment of every chunk.
+     */
+    static constexpr size_t HEADER_SIZE = WBE_DEFAULT_ALIGNMENT;
+
+    /**
+     * @brief Constructor.
+     *
+     * @param p_size The total size of the pool. Rounded down to a multiple of HEADER_SIZE.
+     */
+    HeapAllocatorCompacting(size_t p_size);
+
+    virtual MemID allocate(size_t p_size, size_t p_alignment = WBE_DEFAULT_ALIGNMENT) override;
+
+    virtual void deallocate(MemID p_mem) override;
+
+    virtual void* get(MemID p_id) const override {
+        if (p_id == MEM_NULL) {
+            return nullptr;
+        }
+        WBE_DEBUG_ASSERT(is_in_pool(p_id));
+        return mem_chunk + handle_offsets[p_id - 1] + HEADER_SIZE;
+    }
+
+    virtual bool is_empty() const override {
+        return obj_count == 0;
+    }
+
+    virtual void clear() override;
+
+    virtual size_t get_allocated_data_size(MemID p_mem_id) const override {
+        WBE_DEBUG_ASSERT(is_in_pool(p_mem_id));
+        return get_chunk_header(handle_offsets[p_mem_id - 1])->size - HEADER_SIZE;
+    }
+
+    /**
+     * @brief Run a step of the compaction. The allocated chunks are slid towards the start of
+     * the pool, closing the idle gaps between them, until p_budget bytes are moved.
+     * @note At least one chunk is moved if there is a gap, so that the compaction always makes
+     * progress. A chunk larger than the budget makes the step exceed it.
+     *
+     * @param p_budget The maximum number of bytes to move.
+     * @return The number of bytes moved.
+     */
+    size_t defragment(size_t p_budget);
+
+    /**
+     * @brief Is the pool compacted, i.e. all the idle memory is one block at the end of the pool.
+     *
+     * @return True if the pool is compacted, false otherwise.
+     */
+    bool is_compact() const {
+        return compact_cursor == top;
+    }
+
+    /**
+     * @brief Check if a memory id belongs in this pool.
+     *
+     * @param p_mem_id The memory ID to check.
+     * @return True if it belongs to this pool, false otherwise.
+     */
+    bool is_in_pool(MemID p_mem_id) const {
+        return p_mem_id != MEM_NULL && p_mem_id <= handle_offsets.size() && handle_offsets[p_mem_id - 1] != NULL_OFFSET;
+    }
+
+    /**
+     * @brief Get the total size of the pool.
+     *
+     * @return The total size of the pool.
+     */
+    size_t get_total_size() const {
+        return size;
+    }
+
+    /**
+     * @brief Get the size of the idle memory after the last allocated chunk.
+     *
+     * @return The size of the idle memory at the end of the pool.
+     */
+    size_t get_tail_size() const {
+        return size - top;
+    }
+
+    /**
+     * @brief Get the total number of bytes moved by defragment.
+     *
+     * @return The number of bytes moved.
+     */
+    size_t get_moved_bytes() const {
+        return moved_bytes;
+    }
+
+    /**
+     * @brief Get a snapshot of the telemetry of the allocator, without walking the pool. The
+     * largest idle block is only tracked while the pool is compact, when it is the tail,
+     * see get_largest_free_block otherwise.
+     *
+     * @return The telemetry of the allocator.
+     */
+    virtual AllocatorStats get_stats() const override;
+
+    /**
+     * @brief Get the size of the largest idle block, adjacent idle chunks not merged yet count
+     * as one. Walks the chunks after the compact cursor.
+     *
+     * @return The size of the largest idle block.
+     */
+    size_t get_largest_free_block() const;
+
+    virtual operator std::string() const override;
+
+private:
+    static constexpr size_t NULL_OFFSET = std::numeric_limits<size_t>::max();
+
+    /**
+     * @brief Stored at the start of every chunk.
+     */
+    struct ChunkHeader {
+        // The size of the chunk, including the header.
+        size_t size;
+        // The memory ID of the chunk, MEM_NULL if the chunk is idle.
+        MemID handle;
+    };
+    static_assert(sizeof(ChunkHeader) <= HEADER_SIZE);
+
+    ChunkHeader* get_chunk_header(size_t p_offset) const {
+        return reinterpret_cast<ChunkHeader*>(mem_chunk + p_offset);
+    }
+
+    void write_chunk(size_t p_offset, size_t p_size, MemID p_handle) {
+        ChunkHeader* header = get_chunk_header(p_offset);
+        header->size = p_size;
+        header->handle = p_handle;
+    }
+
+    /**
+     * @brief Merge the idle chunks following an idle chunk into it. Lowers the top if they
+     * reach it.
+     *
+     * @param p_offset The offset of the idle chunk.
+     * @return The size of the merged idle chunk. 0 if it is merged into the top.
+     */
+    size_t merge_idle(size_t p_offset);
+
+    MemID acquire_handle(size_t p_offset);
+
+    size_t size;
+    char* mem_chunk;
+    // The offset of the end of the last allocated chunk. The memory after it is idle and has no header.
+    size_t top = 0;
+    // The chunks before the cursor are packed without gaps.
+    size_t compact_cursor = 0;
+    uint64_t obj_count = 0;
+    // The total size of the idle chunks and the tail.
+    size_t free_size;
+    size_t moved_bytes = 0;
+    // Maps memory ID - 1 to the offset of the chunk. NULL_OFFSET if the handle is idle.
+    std::vector<size_t> handle_offsets;
+    std::vector<MemID> idle_handles;
+    AllocatorStatsTracker<> stats;
+};
+
+}
+
+#endif
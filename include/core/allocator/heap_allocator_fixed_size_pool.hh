@@ -16,20 +16,28 @@
 #define __WBE_HEAP_ALLOCATOR_FIXED_SIZE_POOL_HH__
 
 #include "core/allocator/allocator.hh"
+#include "core/logging/log.hh"
 #include "heap_allocator.hh"
 #include "utils/defs.hh"
+#include "utils/utils.hh"
+#include <concepts>
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
+#include <format>
 #include <limits>
+#include <sstream>
 #include <stdexcept>
 #include <vector>
 
 namespace WhiteBirdEngine {
 
-template <>
-struct AllocatorTrait<class HeapAllocatorFixedSizePool> final : public AllocatorTrait<HeapAllocator> {
-    WBE_TRAIT(AllocatorTrait<HeapAllocatorFixedSizePool>);
+template <std::unsigned_integral IndexType>
+class BasicHeapAllocatorFixedSizePool;
+
+template <std::unsigned_integral IndexType>
+struct AllocatorTrait<BasicHeapAllocatorFixedSizePool<IndexType>> final : public AllocatorTrait<HeapAllocator> {
+    WBE_TRAIT(AllocatorTrait<BasicHeapAllocatorFixedSizePool<IndexType>>);
     static constexpr bool IS_POOL = true;
     static constexpr bool IS_GURANTEED_CONTINUOUS = true;
     static constexpr bool IS_ALIGNABLE = false;
@@ -41,53 +49,109 @@ struct AllocatorTrait<class HeapAllocatorFixedSizePool> final : public Allocator
     WBE_TRAIT_REQUIRES(AllocatorTraitConcept);
 };
 
-class HeapAllocatorFixedSizePool final : public HeapAllocator {
+/**
+ * @class BasicHeapAllocatorFixedSizePool
+ * @brief Pool of fixed size objects that are kept densely packed. Deallocating an object moves
+ * the last object into its slot, and memory IDs are mapped to the data slots through an index.
+ *
+ * @tparam IndexType The type of the indices, which limits the maximum number of objects.
+ */
+template <std::unsigned_integral IndexType>
+class BasicHeapAllocatorFixedSizePool final : public HeapAllocator {
 public:
-    using DataIndex = uint16_t;
-    using InternalID = uint16_t;
+    using DataIndex = IndexType;
+    using InternalID = IndexType;
 
     /**
      * @brief The maximum number of objects the pool can hold.
      */
-    static constexpr uint32_t MAX_OBJ = std::numeric_limits<InternalID>::max() - 1;
+    static constexpr uint64_t MAX_OBJ = std::numeric_limits<InternalID>::max() - 1;
 
-    virtual ~HeapAllocatorFixedSizePool() override;
-    HeapAllocatorFixedSizePool(const HeapAllocatorFixedSizePool&) = delete;
-    HeapAllocatorFixedSizePool(HeapAllocatorFixedSizePool&&) = delete;
-    HeapAllocatorFixedSizePool& operator=(const HeapAllocatorFixedSizePool&) = delete;
-    HeapAllocatorFixedSizePool& operator=(HeapAllocatorFixedSizePool&&) = delete;
+    virtual ~BasicHeapAllocatorFixedSizePool() override {
+        if (obj_count() != 0) {
+            wbe_console_log(WBE_CHANNEL_GLOBAL)->warning("HeapAllocatorFixedSizePool not empty during destruction.");
+        }
+        free(mem_chunk);
+    }
+    BasicHeapAllocatorFixedSizePool(const BasicHeapAllocatorFixedSizePool&) = delete;
+    BasicHeapAllocatorFixedSizePool(BasicHeapAllocatorFixedSizePool&&) = delete;
+    BasicHeapAllocatorFixedSizePool& operator=(const BasicHeapAllocatorFixedSizePool&) = delete;
+    BasicHeapAllocatorFixedSizePool& operator=(BasicHeapAllocatorFixedSizePool&&) = delete;
 
     /**
      * @brief Constructor.
      *
      * @param p_max_obj The maximum objects this allocator could hold. Up to MAX_OBJ maximum.
      */
-    HeapAllocatorFixedSizePool(size_t p_element_size, uint32_t p_max_obj)
+    BasicHeapAllocatorFixedSizePool(size_t p_element_size, uint64_t p_max_obj)
         : max_obj(p_max_obj), alloc_obj_count(0), element_size(p_element_size) {
         if (p_max_obj > MAX_OBJ) {
             throw std::runtime_error("Failed to create allocator: allocator only allows a maximum of " + std::to_string(MAX_OBJ) + " objects");
         }
         static_assert(MAX_OBJ < std::numeric_limits<InternalID>::max());
         static_assert(MAX_OBJ < std::numeric_limits<DataIndex>::max());
-        // The memory chunk is separated by the "index space", "reverse index space" and the "address space".
+        // The memory chunk is separated by the "address space", "index space" and the "reverse index space".
         // index space maps MemID (casted to InternalID) to DataIndex, which represents the index of slot of the data it's referencing
-        // reverse index space maps DataIndex to InteralID.
+        // reverse index space maps DataIndex to InteralID. The first alloc_obj_count entries are the IDs of
+        // the allocated objects in data order, and the rest of them form the stack of idle IDs.
         // data space stores the data.
         // Notice that when DataIndex or InternalID is 0 it maps to MEM_NULL,
         // so for offseting, the true offset for the reverse data is internal id - 1.
-        mem_chunk = (char*)malloc(element_size * max_obj + sizeof(DataIndex) * max_obj + sizeof(InternalID) * max_obj);
+        index_offset = get_align_size(element_size * max_obj, alignof(DataIndex));
+        mem_chunk = (char*)malloc(index_offset + sizeof(DataIndex) * max_obj + sizeof(InternalID) * max_obj);
+        if (mem_chunk == nullptr) {
+            throw std::runtime_error("Failed to create pool: malloc failed.");
+        }
         clear_indices();
     }
 
-    virtual MemID allocate(size_t p_size = 0) override;
+    virtual MemID allocate(size_t p_size = 0) override {
+        if (p_size == 0) {
+            p_size = element_size;
+        }
+        if (p_size != element_size) {
+            throw std::runtime_error(std::format("Failed to allocate memory: size must be: {}", element_size));
+        }
+        if (alloc_obj_count >= max_obj) {
+            stats.on_failed_allocation();
+            throw std::runtime_error("Failed to allocate memory: not enough space for memory pool.");
+        }
+        // The top of the idle ID stack is right after the allocated IDs.
+        ++alloc_obj_count;
+        InternalID curr_id = get_internal_id(alloc_obj_count);
+        write_id(curr_id, alloc_obj_count);
+        stats.on_allocate(element_size);
+        return curr_id;
+    }
 
-    virtual void deallocate(MemID p_mem) override;
+    virtual void deallocate(MemID p_mem) override {
+        if (p_mem == MEM_NULL || p_mem > max_obj) {
+            throw std::runtime_error("Failed to deallocate memory: memory not allocated in this memory pool.");
+        }
+        InternalID id = static_cast<InternalID>(p_mem);
+        DataIndex data_index = get_data_index(id);
+        if (data_index == MEM_NULL) {
+            throw std::runtime_error("Failed to deallocate memory: memory not allocated in this memory pool.");
+        }
+        if (data_index != alloc_obj_count) {
+            void* data_loc = get_mem_loc_at_id(id);
+            InternalID copy_from_id = get_internal_id(alloc_obj_count);
+            void* copy_from = get_mem_loc_at_id(copy_from_id);
+            memcpy(data_loc, copy_from, element_size);
+            write_info(copy_from_id, data_index);
+        }
+        // Push the ID back to the idle ID stack.
+        write_info(id, MEM_NULL);
+        write_data_index(alloc_obj_count, id);
+        --alloc_obj_count;
+        stats.on_deallocate(element_size);
+    }
 
     virtual void* get(MemID p_id) const override {
         if (p_id == 0) {
             return nullptr;
         }
-        return get_mem_loc_at_id(p_id);
+        return get_mem_loc_at_id(static_cast<InternalID>(p_id));
     }
 
     /**
@@ -104,20 +168,48 @@ public:
      *
      * @return The number of allocated objects.
      */
-    uint32_t obj_count() const {
+    uint64_t obj_count() const {
         return alloc_obj_count;
     }
 
     std::vector<MemID> get_allocated() const {
         std::vector<MemID> result;
         result.reserve(alloc_obj_count);
-        for (uint32_t i = 0; i < alloc_obj_count; ++i) {
+        for (uint64_t i = 0; i < alloc_obj_count; ++i) {
             result.push_back(*(index_chunk_rev_start() + i));
         }
         return result;
     }
 
-    virtual operator std::string() const override;
+    virtual operator std::string() const override {
+        std::stringstream ss;
+        ss << "{";
+        ss << "\"type\":\"HeapAllocatorFixedSizePool\",";
+        ss << "\"size\":" << element_size << ",";
+        ss << "\"obj_count\":" << obj_count() << ",";
+        ss << "\"max_obj\":" << static_cast<uint64_t>(max_obj) << ",";
+        ss << "\"allocated\":[";
+        auto alloc_mems = get_allocated();
+        bool first = true;
+        for (auto alloc_mem : alloc_mems) {
+            if (!first) ss << ",";
+            first = false;
+            ss << alloc_mem;
+        }
+        ss << "]";
+        ss << "}";
+        return ss.str();
+    }
+
+    virtual AllocatorStats get_stats() const override {
+        AllocatorStats result;
+        stats.fill(result);
+        // The objects are densely packed, so the idle slots are always continuous.
+        result.free_bytes = (max_obj - alloc_obj_count) * element_size;
+        result.largest_free_block = result.free_bytes;
+        result.largest_free_block_tracked = true;
+        return result;
+    }
 
     const void* get_mem_start() const {
         return data_chunk_start();
@@ -131,10 +223,10 @@ public:
         return element_size;
     }
 
-    // TODO: Test
     virtual void clear() override {
         clear_indices();
         alloc_obj_count = 0;
+        stats.on_clear();
     }
 
     size_t get_element_size() const {
@@ -144,8 +236,10 @@ public:
 private:
     DataIndex max_obj;
     char* mem_chunk;
+    size_t index_offset;
     DataIndex alloc_obj_count;
     const size_t element_size;
+    AllocatorStatsTracker<> stats;
 
     DataIndex get_data_index(InternalID p_id) const {
         if (p_id > max_obj) {
@@ -161,14 +255,6 @@ private:
         return *((InternalID*)index_chunk_rev_start() + p_data_index - 1);
     }
 
-    void* get_mem_loc_at_id(InternalID p_id) {
-        if (p_id > max_obj) {
-            return nullptr;
-        }
-        uintptr_t offset = (get_data_index(p_id) - 1) * element_size;
-        return data_chunk_start() + offset;
-    }
-
     void* get_mem_loc_at_id(InternalID p_id) const {
         if (p_id > max_obj) {
             return nullptr;
@@ -187,29 +273,26 @@ private:
 
     void write_info(InternalID p_id, DataIndex p_data_index) {
         write_id(p_id, p_data_index);
-        write_data_index(p_data_index, p_id);
+        if (p_data_index != MEM_NULL) {
+            write_data_index(p_data_index, p_id);
+        }
     }
 
     void clear_indices() {
         memset(index_chunk_start(), MEM_NULL, max_obj * sizeof(DataIndex));
-        memset(index_chunk_rev_start(), MEM_NULL, max_obj * sizeof(InternalID));
-    }
-
-    InternalID retrieve_valid_index() {
-        for (InternalID id = 1; id <= max_obj; ++id) {
-            if (get_data_index(id) == MEM_NULL) {
-                return id;
-            }
+        // Every ID is idle, the smallest ones on the top of the stack.
+        InternalID* idle_ids = index_chunk_rev_start();
+        for (uint64_t i = 0; i < max_obj; ++i) {
+            idle_ids[i] = static_cast<InternalID>(i + 1);
         }
-        throw std::runtime_error("Failed to retrieve valid index: memory chunk is full.");
     }
 
     DataIndex* index_chunk_start() const {
-        return (DataIndex*)(mem_chunk + element_size * max_obj);
+        return (DataIndex*)(mem_chunk + index_offset);
     }
 
     InternalID* index_chunk_rev_start() const {
-        return (InternalID*)(mem_chunk + element_size * max_obj + max_obj * sizeof(DataIndex));
+        return (InternalID*)(mem_chunk + index_offset + max_obj * sizeof(DataIndex));
     }
 
     char* data_chunk_start() const {
@@ -218,6 +301,15 @@ private:
 
 };
 
+/**
+ * @brief Fixed size pool with 16 bits indices, holding up to 65534 objects.
+ */
+using HeapAllocatorFixedSizePool = BasicHeapAllocatorFixedSizePool<uint16_t>;
+
+/**
+ * @brief Fixed size pool with 32 bits indices.
+ */
+using HeapAllocatorFixedSizePool32 = BasicHeapAllocatorFixedSizePool<uint32_t>;
 
 }
 
@@ -16,10 +16,12 @@
 #define __WBE_HEAP_ALLOCATOR_POOL_HH__
 
 #include "core/allocator/allocator.hh"
+#include "core/allocator/virtual_memory_range.hh"
 #include "heap_allocator.hh"
 #include "utils/defs.hh"
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <limits>
 #include <memory>
 
@@ -42,7 +44,10 @@ struct AllocatorTrait<class HeapAllocatorPool> final : public AllocatorTrait<Hea
 /**
  * @class HeapAllocatorPool
  * @brief Pool allocator. Allocate from a continuous memory pool, to prevent memory fragmentation.
- *
+ * The idle chunks are kept in an address ordered list, whose nodes are stored at the start of
+ * the idle chunks themselves, so the pool never allocates outside of its own memory.
+ * If constructed with a reserve size, the pool is growable: the memory is a reserved virtual
+ * range, and more pages are committed at the end of the pool when it runs out of space.
  */
 class HeapAllocatorPool final : public HeapAllocator {
 public:
@@ -70,12 +75,42 @@ public:
      *
      * @param p_size The size of the pool in bytes.
      */
-    HeapAllocatorPool(size_t p_size);
+    HeapAllocatorPool(size_t p_size)
+        : HeapAllocatorPool(p_size, 0) {}
+
+    /**
+     * @brief Constructor.
+     *
+     * @param p_size The initial size of the pool in bytes. Rounded up to the page size if growable.
+     * @param p_reserve_size The size of the virtual memory reserved for the pool to grow into.
+     * 0 for a fixed size pool.
+     */
+    HeapAllocatorPool(size_t p_size, size_t p_reserve_size);
 
     virtual MemID allocate(size_t p_size) override;
 
     virtual void deallocate(MemID p_mem) override;
 
+    /**
+     * @brief Allocate multiple chunks of the same size, carved next to each other from one
+     * idle chunk when there is one large enough. The pool is not a HeapAllocatorAligned, so
+     * this is not the virtual of HeapAllocatorAligned and create_obj_batch does not apply.
+     * If the pool cannot hold all of them, nothing is allocated and an exception is thrown.
+     *
+     * @param p_count The number of chunks to allocate.
+     * @param p_size The size of each chunk.
+     * @param r_mem_ids The output array of the allocated memory IDs, must hold at least p_count elements.
+     */
+    void allocate_batch(size_t p_count, size_t p_size, MemID* r_mem_ids);
+
+    /**
+     * @brief Deallocate multiple chunks.
+     *
+     * @param p_mem_ids The memory IDs to deallocate. MEM_NULL entries are skipped.
+     * @param p_count The number of memory IDs.
+     */
+    void deallocate_batch(const MemID* p_mem_ids, size_t p_count);
+
     virtual void* get(MemID p_id) const override {
         if (p_id == MEM_NULL) {
             return nullptr;
@@ -83,27 +118,79 @@ public:
         return reinterpret_cast<void*>(p_id);
     }
 
+    /**
+     * @brief Get a snapshot of the telemetry of the allocator, without walking the idle list.
+     * The largest idle block is not tracked, see get_largest_free_block.
+     *
+     * @return The telemetry of the allocator.
+     */
+    virtual AllocatorStats get_stats() const override;
+
+    /**
+     * @brief Get the size of the largest idle chunk. Walks the idle list.
+     *
+     * @return The size of the largest idle chunk.
+     */
+    size_t get_largest_free_block() const;
+
     virtual operator std::string() const override;
 
     size_t get_allocated_data_size(MemID p_mem_id) const {
-        return *reinterpret_cast<size_t*>(p_mem_id - HEADER_SIZE) & MAX_TOTAL_SIZE;
+        // The header is not aligned for uint64_t, it is written with memcpy in find_valid_chunk.
+        uint64_t header;
+        std::memcpy(&header, reinterpret_cast<const char*>(p_mem_id - HEADER_SIZE), sizeof(header));
+        return header & MAX_TOTAL_SIZE;
     }
 
     size_t get_total_size() const {
         return size;
     }
 
-    size_t get_remain_size() const;
+    /**
+     * @brief Check if the pool grows when it runs out of space.
+     *
+     * @return True if the pool is growable, false otherwise.
+     */
+    bool is_growable() const {
+        return virtual_memory != nullptr;
+    }
+
+    /**
+     * @brief Get the size of the memory backing the pool.
+     *
+     * @return The committed size in bytes.
+     */
+    size_t get_committed_size() const {
+        return size;
+    }
+
+    /**
+     * @brief Get the size the pool could grow to.
+     *
+     * @return The reserved size in bytes. The total size if not growable.
+     */
+    size_t get_reserved_size() const {
+        return is_growable() ? virtual_memory->get_reserved_size() : size;
+    }
+
+    size_t get_remain_size() const {
+        return free_size;
+    }
 
     virtual bool is_empty() const override {
-        return idle_list_head != nullptr && idle_list_head->size == size;
+        return idle_list_head != nullptr && load_node(idle_list_head).size == size;
     }
 
+    /**
+     * @brief Clear the allocator. A growable pool keeps the memory it has committed.
+     */
     // TODO: Test
     virtual void clear() override {
-        idle_list_head->size = size;
-        idle_list_head->mem_start = mem_chunk;
-        idle_list_head->next = nullptr;
+        idle_list_head = mem_chunk;
+        store_node(idle_list_head, IdleListNode { size, nullptr });
+        idle_chunks_count = 1;
+        free_size = size;
+        stats.on_clear();
     }
 
     size_t get_max_data_size() const {
@@ -112,23 +199,51 @@ public:
 
 private:
     
+    /**
+     * @brief Stored at the start of every idle chunk. Chunks are not aligned in this pool, so
+     * the nodes are only accessed through load_node and store_node.
+     */
     struct IdleListNode {
+        // The size of the idle chunk, including this node.
         size_t size;
-        char* mem_start;
-        std::unique_ptr<IdleListNode> next = nullptr;
+        // The next idle chunk in address order.
+        char* next;
     };
 
-    void* acquire_memory(std::unique_ptr<IdleListNode>& p_node, size_t p_mem_size);
-    void insert_free_memory(IdleListNode* p_node_before_insert, char* p_insert_start, size_t p_insert_size);
-    bool combine_idle_with_next(IdleListNode* p_node);
-    std::unique_ptr<IdleListNode>& get_idle_node_before(void* p_loc);
+    /**
+     * @brief The minimum size of an idle chunk. Allocations that would leave a smaller idle
+     * chunk behind take the whole chunk instead.
+     */
+    static constexpr size_t MIN_IDLE_SIZE = sizeof(IdleListNode);
+    static_assert(MIN_IDLE_SIZE <= HEADER_SIZE);
+
+    static IdleListNode load_node(const char* p_chunk) {
+        IdleListNode result;
+        std::memcpy(&result, p_chunk, sizeof(IdleListNode));
+        return result;
+    }
+
+    static void store_node(char* p_chunk, const IdleListNode& p_node) {
+        std::memcpy(p_chunk, &p_node, sizeof(IdleListNode));
+    }
+
+    MemID find_valid_chunk(size_t p_chunk_size, uint64_t p_count = 1);
+    void* acquire_memory(char* p_prev, char* p_chunk, size_t p_mem_size);
+    void insert_free_memory(char* p_insert_start, size_t p_insert_size);
+    void set_next(char* p_prev, char* p_next);
+    bool grow(size_t p_size);
 
     size_t size;
     char* mem_chunk;
     uint32_t idle_chunks_count;
-    std::unique_ptr<IdleListNode> idle_list_head;
+    char* idle_list_head;
+    // The total size of the idle chunks.
+    size_t free_size = 0;
+    // Only set for a growable pool.
+    std::unique_ptr<VirtualMemoryRange> virtual_memory;
 
     size_t max_data_loc_tracker = 0;
+    AllocatorStatsTracker<> stats;
 };
 
 }
@@ -0,0 +1,163 @@
+/* Copyright 2025 OppositeNor
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef __WBE_HEAP_ALLOCATOR_SAMPLED_HH__
+#define __WBE_HEAP_ALLOCATOR_SAMPLED_HH__
+
+#include "core/allocator/allocation_sampler.hh"
+#include "core/allocator/allocator.hh"
+#include "core/allocator/heap_allocator_aligned.hh"
+#include "utils/defs.hh"
+#include <concepts>
+#include <cstddef>
+#include <sstream>
+#include <string>
+
+namespace WhiteBirdEngine {
+
+template <typename AllocType>
+    requires std::derived_from<AllocType, HeapAllocatorAligned>
+class HeapAllocatorSampled;
+
+template <typename AllocType>
+struct AllocatorTrait<HeapAllocatorSampled<AllocType>> final : public AllocatorTrait<HeapAllocatorAligned> {
+    WBE_TRAIT(AllocatorTrait<HeapAllocatorSampled<AllocType>>);
+    static constexpr bool IS_POOL = AllocatorTrait<AllocType>::IS_POOL;
+    static constexpr bool IS_GURANTEED_CONTINUOUS = AllocatorTrait<AllocType>::IS_GURANTEED_CONTINUOUS;
+    static constexpr bool IS_LIMITED_SIZE = AllocatorTrait<AllocType>::IS_LIMITED_SIZE;
+    static constexpr bool IS_ALLOC_FIXED_SIZE = AllocatorTrait<AllocType>::IS_ALLOC_FIXED_SIZE;
+    static constexpr bool IS_ATOMIC = AllocatorTrait<AllocType>::IS_ATOMIC;
+    static constexpr bool WILL_ADDR_MOVE = AllocatorTrait<AllocType>::WILL_ADDR_MOVE;
+
+    WBE_TRAIT_REQUIRES(AllocatorTraitConcept);
+};
+
+/**
+ * @class HeapAllocatorSampled
+ * @brief Front-end that hooks an AllocationSampler into an allocator. Every call is forwarded
+ * to the backing allocator, and the allocations and deallocations are reported to the sampler.
+ * Allocators that are not wrapped pay nothing for the sampling.
+ * @note In place resizes are not reported, the samples keep their original sizes.
+ *
+ * @tparam AllocType The type of the backing allocator.
+ */
+template <typename AllocType>
+    requires std::derived_from<AllocType, HeapAllocatorAligned>
+class HeapAllocatorSampled final : public HeapAllocatorAligned {
+public:
+    HeapAllocatorSampled() = delete;
+    virtual ~HeapAllocatorSampled() override {}
+    HeapAllocatorSampled(const HeapAllocatorSampled&) = delete;
+    HeapAllocatorSampled(HeapAllocatorSampled&&) = delete;
+    HeapAllocatorSampled& operator=(const HeapAllocatorSampled&) = delete;
+    HeapAllocatorSampled& operator=(HeapAllocatorSampled&&) = delete;
+
+    /**
+     * @brief Constructor.
+     *
+     * @param p_allocator The backing allocator.
+     * @param p_sampler The sampler to report to. Could be shared by multiple allocators.
+     */
+    HeapAllocatorSampled(AllocType* p_allocator, AllocationSampler* p_sampler)
+        : allocator(p_allocator), sampler(p_sampler) {
+        WBE_DEBUG_ASSERT(p_allocator != nullptr);
+        WBE_DEBUG_ASSERT(p_sampler != nullptr);
+    }
+
+    virtual MemID allocate(size_t p_size, size_t p_alignment = WBE_DEFAULT_ALIGNMENT) override {
+        MemID result = allocator->allocate(p_size, p_alignment);
+        sampler->on_allocate(this, result, p_size);
+        return result;
+    }
+
+    virtual void deallocate(MemID p_mem) override {
+        // Report first, so that the memory ID could not be reused before the sample is released.
+        sampler->on_deallocate(this, p_mem);
+        allocator->deallocate(p_mem);
+    }
+
+    virtual void allocate_batch(size_t p_count, size_t p_size, size_t p_alignment, MemID* r_mem_ids) override {
+        allocator->allocate_batch(p_count, p_size, p_alignment, r_mem_ids);
+        for (size_t i = 0; i < p_count; ++i) {
+            sampler->on_allocate(this, r_mem_ids[i], p_size);
+        }
+    }
+
+    virtual void deallocate_batch(const MemID* p_mem_ids, size_t p_count) override {
+        for (size_t i = 0; i < p_count; ++i) {
+            sampler->on_deallocate(this, p_mem_ids[i]);
+        }
+        allocator->deallocate_batch(p_mem_ids, p_count);
+    }
+
+    virtual void* get(MemID p_id) const override {
+        return allocator->get(p_id);
+    }
+
+    virtual bool is_empty() const override {
+        return allocator->is_empty();
+    }
+
+    virtual void clear() override {
+        sampler->on_clear(this);
+        allocator->clear();
+    }
+
+    virtual size_t get_allocated_data_size(MemID p_mem_id) const override {
+        return allocator->get_allocated_data_size(p_mem_id);
+    }
+
+    virtual bool try_expand(MemID p_mem, size_t p_new_size) override {
+        return allocator->try_expand(p_mem, p_new_size);
+    }
+
+    virtual AllocatorStats get_stats() const override {
+        return allocator->get_stats();
+    }
+
+    /**
+     * @brief Get the backing allocator.
+     *
+     * @return The backing allocator.
+     */
+    AllocType* get_allocator() const {
+        return allocator;
+    }
+
+    /**
+     * @brief Get the sampler the allocations are reported to.
+     *
+     * @return The sampler.
+     */
+    AllocationSampler* get_sampler() const {
+        return sampler;
+    }
+
+    virtual operator std::string() const override {
+        std::stringstream ss;
+        ss << "{";
+        ss << "\"type\":\"HeapAllocatorSampled\",";
+        ss << "\"allocator\":" << static_cast<std::string>(*allocator);
+        ss << "}";
+        return ss.str();
+    }
+
+private:
+    AllocType* allocator;
+    AllocationSampler* sampler;
+};
+
+}
+
+#endif
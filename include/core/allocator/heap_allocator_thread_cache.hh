@@ -0,0 +1,238 @@
+/* Copyright 2025 OppositeNor
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef __WBE_HEAP_ALLOCATOR_THREAD_CACHE_HH__
+#define __WBE_HEAP_ALLOCATOR_THREAD_CACHE_HH__
+
+#include "core/allocator/allocator.hh"
+#include "core/allocator/heap_allocator_aligned.hh"
+#include "core/allocator/heap_allocator_atomic_aligned_pool.hh"
+#include "utils/defs.hh"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace WhiteBirdEngine {
+
+template <>
+struct AllocatorTrait<class HeapAllocatorThreadCache> final : public AllocatorTrait<HeapAllocatorAligned> {
+    WBE_TRAIT(AllocatorTrait<HeapAllocatorThreadCache>);
+    static constexpr bool IS_POOL = true;
+    static constexpr bool IS_GURANTEED_CONTINUOUS = false;
+    static constexpr bool IS_LIMITED_SIZE = true;
+    static constexpr bool IS_ALLOC_FIXED_SIZE = false;
+    static constexpr bool IS_ATOMIC = true;
+    static constexpr bool WILL_ADDR_MOVE = false;
+
+    WBE_TRAIT_REQUIRES(AllocatorTraitConcept);
+};
+
+/**
+ * @class HeapAllocatorThreadCache
+ * @brief Per-thread caching front-end of a HeapAllocatorAtomicAlignedPool.
+ * Small allocations are served from thread local size class bins without locking.
+ * The bins are refilled from, and flushed to the backing pool in batches, so the
+ * backing pool is only locked on a cache miss or when a bin overflows.
+ * Allocations that are larger than MAX_CACHED_SIZE or aligned more than
+ * WBE_DEFAULT_ALIGNMENT go to the backing pool directly.
+ * @note Memory freed by another thread goes to the bins of the freeing thread.
+ * The cache of a thread is flushed when the thread exits.
+ */
+class HeapAllocatorThreadCache final : public HeapAllocatorAligned {
+public:
+    HeapAllocatorThreadCache() = delete;
+    virtual ~HeapAllocatorThreadCache() override;
+    HeapAllocatorThreadCache(const HeapAllocatorThreadCache&) = delete;
+    HeapAllocatorThreadCache(HeapAllocatorThreadCache&&) = delete;
+    HeapAllocatorThreadCache& operator=(const HeapAllocatorThreadCache&) = delete;
+    HeapAllocatorThreadCache& operator=(HeapAllocatorThreadCache&&) = delete;
+
+    /**
+     * @brief The sizes of the size classes.
+     */
+    static constexpr size_t SIZE_CLASSES[] = {
+        16, 32, 48, 64, 80, 96, 112, 128,
+        160, 192, 224, 256, 320, 384, 448, 512,
+        640, 768, 896, 1024
+    };
+
+    /**
+     * @brief The number of size classes.
+     */
+    static constexpr size_t SIZE_CLASS_COUNT = sizeof(SIZE_CLASSES) / sizeof(size_t);
+
+    /**
+     * @brief The maximum size of allocation that is cached.
+     */
+    static constexpr size_t MAX_CACHED_SIZE = SIZE_CLASSES[SIZE_CLASS_COUNT - 1];
+
+    /**
+     * @brief The maximum number of chunks moved between a bin and the backing pool at once.
+     */
+    static constexpr size_t MAX_BATCH_COUNT = 32;
+
+    /**
+     * @brief Constructor.
+     *
+     * @param p_backing_pool The pool to allocate from on cache misses. Must outlive this allocator.
+     */
+    HeapAllocatorThreadCache(HeapAllocatorAtomicAlignedPool* p_backing_pool);
+
+    virtual MemID allocate(size_t p_size, size_t p_alignment = WBE_DEFAULT_ALIGNMENT) override;
+
+    virtual void deallocate(MemID p_mem) override;
+
+    virtual void* get(MemID p_id) const override {
+        return backing_pool->get(p_id);
+    }
+
+    virtual bool is_empty() const override;
+
+    /**
+     * @brief Clear the allocator and the backing pool. All thread caches are dropped.
+     * @note Should not be called while other threads are allocating from this allocator.
+     */
+    virtual void clear() override;
+
+    virtual size_t get_allocated_data_size(MemID p_mem_id) const override {
+        return backing_pool->get_allocated_data_size(p_mem_id);
+    }
+
+    /**
+     * @brief Get the telemetry of the backing pool. The chunks cached in the bins count as live.
+     *
+     * @return The telemetry of the backing pool.
+     */
+    virtual AllocatorStats get_stats() const override {
+        return backing_pool->get_stats();
+    }
+
+    /**
+     * @brief Return all the memory cached by the calling thread to the backing pool.
+     */
+    void flush();
+
+    /**
+     * @brief Return all the memory cached by all threads to the backing pool.
+     * @note Should not be called while other threads are allocating from this allocator.
+     */
+    void flush_all();
+
+    /**
+     * @brief Get the total size of the chunks cached in the thread caches.
+     *
+     * @return The total cached size in bytes.
+     */
+    size_t get_cached_size() const;
+
+    /**
+     * @brief Get the number of thread caches that are created.
+     *
+     * @return The number of thread caches.
+     */
+    size_t get_thread_cache_count() const;
+
+    /**
+     * @brief Get the backing pool.
+     *
+     * @return The backing pool.
+     */
+    HeapAllocatorAtomicAlignedPool* get_backing_pool() const {
+        return backing_pool;
+    }
+
+    /**
+     * @brief Get the size class index of a size.
+     *
+     * @param p_size The size to get the class of. Must not be larger than MAX_CACHED_SIZE.
+     * @return The index of the smallest size class that can hold p_size.
+     */
+    static size_t get_size_class(size_t p_size);
+
+    /**
+     * @brief Get the number of chunks moved between a bin and the backing pool at once.
+     *
+     * @param p_size_class The size class index.
+     * @return The batch count of the size class.
+     */
+    static constexpr size_t get_batch_count(size_t p_size_class) {
+        size_t count = WBE_KiB(4) / SIZE_CLASSES[p_size_class];
+        return count < 2 ? 2 : (count > MAX_BATCH_COUNT ? MAX_BATCH_COUNT : count);
+    }
+
+    virtual operator std::string() const override;
+
+private:
+
+    struct Bin {
+        // Free chunks are linked through their first bytes.
+        void* head = nullptr;
+        size_t count = 0;
+    };
+
+    struct ThreadCache {
+        Bin bins[SIZE_CLASS_COUNT];
+        // Only written by the owner thread, atomic so that other threads can read them.
+        std::atomic<int64_t> allocated_count = 0;
+        std::atomic<size_t> cached_size = 0;
+    };
+
+    /**
+     * @brief Thread local table mapping allocator instances to the caches of the thread.
+     */
+    struct ThreadCacheTable {
+        ~ThreadCacheTable();
+        uint64_t last_instance_id = 0;
+        ThreadCache* last_cache = nullptr;
+        std::vector<std::pair<uint64_t, ThreadCache*>> entries;
+    };
+
+    ThreadCache* get_thread_cache() {
+        ThreadCacheTable& table = thread_cache_table;
+        if (table.last_instance_id == instance_id) {
+            return table.last_cache;
+        }
+        return find_thread_cache(table);
+    }
+
+    ThreadCache* find_thread_cache(ThreadCacheTable& p_table);
+    void refill_bin(ThreadCache* p_cache, size_t p_size_class);
+    void flush_bin(ThreadCache* p_cache, size_t p_size_class, size_t p_count);
+    void flush_cache(ThreadCache* p_cache);
+    void release_thread_cache(ThreadCache* p_cache);
+
+    HeapAllocatorAtomicAlignedPool* backing_pool;
+    uint64_t instance_id;
+
+    mutable std::mutex caches_mutex;
+    std::vector<std::unique_ptr<ThreadCache>> caches;
+    // Allocation count left by the caches of exited threads.
+    int64_t detached_allocated_count = 0;
+
+    static thread_local ThreadCacheTable thread_cache_table;
+    // Protects live_instances, and keeps an instance alive while an exiting thread releases its cache.
+    static std::mutex registry_mutex;
+    static std::unordered_map<uint64_t, HeapAllocatorThreadCache*> live_instances;
+    static std::atomic<uint64_t> next_instance_id;
+};
+
+}
+
+#endif
@@ -0,0 +1,335 @@
+/* Copyright 2025 OppositeNor
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef __WBE_HEAP_ALLOCATOR_TLSF_HH__
+#define __WBE_HEAP_ALLOCATOR_TLSF_HH__
+
+#include "core/allocator/allocator.hh"
+#include "core/allocator/heap_allocator_aligned.hh"
+#include "core/allocator/virtual_memory_range.hh"
+#include "utils/defs.hh"
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace WhiteBirdEngine {
+
+template <>
+struct AllocatorTrait<class HeapAllocatorTLSF> final : public AllocatorTrait<HeapAllocatorAligned> {
+    WBE_TRAIT(AllocatorTrait<HeapAllocatorTLSF>);
+    static constexpr bool IS_POOL = true;
+    static constexpr bool IS_GURANTEED_CONTINUOUS = false;
+    static constexpr bool IS_LIMITED_SIZE = true;
+    static constexpr bool IS_ALLOC_FIXED_SIZE = false;
+    static constexpr bool IS_ATOMIC = false;
+    static constexpr bool WILL_ADDR_MOVE = false;
+
+    WBE_TRAIT_REQUIRES(AllocatorTraitConcept);
+};
+
+/**
+ * @class HeapAllocatorTLSF
+ * @brief Heap allocator pool with memory alignment support, using two-level segregated fit
+ * (TLSF) free lists. Free chunks are indexed by a first level (power of two) and a second
+ * level (linear subdivision) size class, and the non-empty classes are tracked by bitmaps,
+ * so both allocation and deallocation run in bounded O(1) time regardless of fragmentation.
+ * If constructed with a reserve size, the pool is growable: the memory is a reserved virtual
+ * range, and more pages are committed at the end of the pool when it runs out of space.
+ */
+class HeapAllocatorTLSF final : public HeapAllocatorAligned {
+public:
+    HeapAllocatorTLSF()
+        : HeapAllocatorTLSF(WBE_KiB(64)) {}
+    virtual ~HeapAllocatorTLSF() override;
+    HeapAllocatorTLSF(const HeapAllocatorTLSF&) = delete;
+    HeapAllocatorTLSF(HeapAllocatorTLSF&&) = delete;
+    HeapAllocatorTLSF& operator=(const HeapAllocatorTLSF&) = delete;
+    HeapAllocatorTLSF& operator=(HeapAllocatorTLSF&&) = delete;
+
+    /**
+     * @brief The size of the allocated memory header.
+     */
+    static constexpr size_t HEADER_SIZE = WBE_DEFAULT_ALIGNMENT;
+
+    /**
+     * @brief log2 of the number of second level subdivisions.
+     */
+    static constexpr size_t SL_INDEX_COUNT_LOG2 = 4;
+
+    /**
+     * @brief The number of second level subdivisions of each first level.
+     */
+    static constexpr size_t SL_INDEX_COUNT = 1ull << SL_INDEX_COUNT_LOG2;
+
+    /**
+     * @brief log2 of the smallest size handled by the second first level list.
+     */
+    static constexpr size_t FL_INDEX_SHIFT = SL_INDEX_COUNT_LOG2 + std::countr_zero(HEADER_SIZE);
+
+    /**
+     * @brief Chunks smaller than this size are all stored in the first first-level list,
+     * linearly subdivided by the second level.
+     */
+    static constexpr size_t SMALL_CHUNK_SIZE = 1ull << FL_INDEX_SHIFT;
+
+    /**
+     * @brief The exclusive upper bound of the log2 of the chunk size.
+     */
+    static constexpr size_t FL_INDEX_MAX = 38;
+
+    /**
+     * @brief The number of first level lists.
+     */
+    static constexpr size_t FL_INDEX_COUNT = FL_INDEX_MAX - FL_INDEX_SHIFT + 1;
+
+    /**
+     * @brief The minimum size of a chunk. A free chunk stores its free list links right after
+     * the header.
+     */
+    static constexpr size_t MIN_CHUNK_SIZE = HEADER_SIZE + 2 * sizeof(void*);
+
+    /**
+     * @brief The maximum total size that the allocator can contain.
+     */
+    static constexpr size_t MAX_TOTAL_SIZE = (1ull << FL_INDEX_MAX) - 1;
+
+    /**
+     * @brief Constructor.
+     *
+     * @param p_size The total size of the pool. Rounded down to a multiple of HEADER_SIZE.
+     */
+    HeapAllocatorTLSF(size_t p_size)
+        : HeapAllocatorTLSF(p_size, 0) {}
+
+    /**
+     * @brief Constructor.
+     *
+     * @param p_size The initial size of the pool. Rounded down to a multiple of HEADER_SIZE,
+     * or up to the page size if growable.
+     * @param p_reserve_size The size of the virtual memory reserved for the pool to grow into.
+     * 0 for a fixed size pool.
+     * @param p_huge_pages Should try to back the pool with huge pages. The size of a fixed
+     * size pool is then rounded up to the huge page size.
+     */
+    HeapAllocatorTLSF(size_t p_size, size_t p_reserve_size, bool p_huge_pages = false);
+
+    virtual MemID allocate(size_t p_size, size_t p_alignment = HEADER_SIZE) override;
+
+    virtual void deallocate(MemID p_mem) override;
+
+    /**
+     * @brief Allocate multiple chunks of the same size. The chunks are carved from one free
+     * chunk if there is one large enough.
+     * If the pool cannot hold all of them, nothing is allocated.
+     *
+     * @param p_count The number of chunks to allocate.
+     * @param p_size The size of each chunk.
+     * @param p_alignment The alignment of each chunk.
+     * @param r_mem_ids The output array of the allocated memory IDs, must hold at least p_count elements.
+     */
+    virtual void allocate_batch(size_t p_count, size_t p_size, size_t p_alignment, MemID* r_mem_ids) override;
+
+    virtual void* get(MemID p_id) const override {
+        if (p_id == MEM_NULL) {
+            return nullptr;
+        }
+        WBE_DEBUG_ASSERT(is_in_pool(p_id));
+        return reinterpret_cast<void*>(p_id);
+    }
+
+    virtual bool is_empty() const override {
+        return used_size == 0;
+    }
+
+    /**
+     * @brief Clear the allocator. A growable pool keeps the memory it has committed.
+     */
+    virtual void clear() override;
+
+    virtual size_t get_allocated_data_size(MemID p_mem_id) const override {
+        return get_chunk_size(get_chunk(p_mem_id)) - HEADER_SIZE;
+    }
+
+    /**
+     * @brief Try to resize an allocation in place. Shrinking always succeeds, and the memory
+     * released is merged with the idle chunk after it if large enough to form a chunk.
+     * Expanding succeeds if the chunk after it is idle and large enough, and a growable pool
+     * grows if the allocation is at its end.
+     *
+     * @param p_mem The memory ID of the allocation to resize.
+     * @param p_new_size The new size of the allocation, must not be 0.
+     * @return True if the allocation is resized, false if it is left untouched.
+     */
+    virtual bool try_expand(MemID p_mem, size_t p_new_size) override;
+
+    /**
+     * @brief Check if the pool grows when it runs out of space.
+     *
+     * @return True if the pool is growable, false otherwise.
+     */
+    bool is_growable() const {
+        return growable;
+    }
+
+    /**
+     * @brief Get the kind of pages backing the pool.
+     *
+     * @return The page backing obtained.
+     */
+    PageBacking get_page_backing() const {
+        return virtual_memory != nullptr ? virtual_memory->get_page_backing() : PageBacking::NORMAL;
+    }
+
+    /**
+     * @brief Get the size of the memory backing the pool.
+     *
+     * @return The committed size in bytes.
+     */
+    size_t get_committed_size() const {
+        return size;
+    }
+
+    /**
+     * @brief Get the size the pool could grow to.
+     *
+     * @return The reserved size in bytes. The total size if not growable.
+     */
+    size_t get_reserved_size() const {
+        return is_growable() ? virtual_memory->get_reserved_size() : size;
+    }
+
+    /**
+     * @brief Get the total size of the allocator.
+     *
+     * @return The total size of the allocator.
+     */
+    size_t get_total_size() const {
+        return size;
+    }
+
+    /**
+     * @brief Get the remaining size of the allocator, including the headers of the free chunks.
+     *
+     * @return The remaining size of the allocator.
+     */
+    size_t get_remain_size() const {
+        return size - used_size;
+    }
+
+    /**
+     * @brief Get the size of the largest free chunk.
+     *
+     * @note This is not a guarantee that an allocation of this size succeeds, the alignment
+     * padding and the header of the request could still make it exceed the chunk.
+     *
+     * @return The size of the largest free chunk, excluding its header. 0 if there are no free chunks.
+     */
+    size_t get_max_free_size() const;
+
+    /**
+     * @brief Check if a memory id belongs in this pool.
+     *
+     * @param p_mem_id The memory ID to check.
+     * @return True if it belongs to this pool, false otherwise.
+     */
+    bool is_in_pool(MemID p_mem_id) const;
+
+    /**
+     * @brief Check if the pool is broken. Will throw if broken.
+     */
+    void check_broken() const;
+
+    virtual AllocatorStats get_stats() const override;
+
+    virtual operator std::string() const override;
+
+private:
+
+    /**
+     * @brief Chunk header. The free list links are only valid when the chunk is idle,
+     * and overlap the data of occupied chunks.
+     */
+    struct Chunk {
+        // The physically previous chunk. nullptr for the first chunk.
+        Chunk* prev_phys;
+        // The size of the chunk including header. The lowest bit is set if the chunk is idle.
+        size_t size_and_flag;
+        // Next chunk in the free list.
+        Chunk* next_free;
+        // Previous chunk in the free list.
+        Chunk* prev_free;
+    };
+    static_assert(sizeof(Chunk) == MIN_CHUNK_SIZE);
+
+    static constexpr size_t CHUNK_IDLE_BIT = 1;
+
+    size_t size;
+    char* mem_chunk;
+    size_t used_size = 0;
+    // The physically last chunk, which is extended when the pool grows.
+    Chunk* last_phys = nullptr;
+    std::unique_ptr<VirtualMemoryRange> virtual_memory;
+    bool growable = false;
+    AllocatorStatsTracker<> stats;
+
+    uint32_t fl_bitmap = 0;
+    uint32_t sl_bitmap[FL_INDEX_COUNT] = {};
+    Chunk* free_lists[FL_INDEX_COUNT][SL_INDEX_COUNT] = {};
+
+    static Chunk* get_chunk(MemID p_mem_id) {
+        return reinterpret_cast<Chunk*>(p_mem_id - HEADER_SIZE);
+    }
+
+    static MemID get_mem_id(const Chunk* p_chunk) {
+        return reinterpret_cast<MemID>(p_chunk) + HEADER_SIZE;
+    }
+
+    static size_t get_chunk_size(const Chunk* p_chunk) {
+        return p_chunk->size_and_flag & ~CHUNK_IDLE_BIT;
+    }
+
+    static bool is_chunk_idle(const Chunk* p_chunk) {
+        return p_chunk->size_and_flag & CHUNK_IDLE_BIT;
+    }
+
+    static void set_chunk(Chunk* p_chunk, size_t p_size, bool p_idle) {
+        p_chunk->size_and_flag = p_size | (p_idle ? CHUNK_IDLE_BIT : 0);
+    }
+
+    Chunk* get_next_phys(const Chunk* p_chunk) const {
+        char* next = reinterpret_cast<char*>(const_cast<Chunk*>(p_chunk)) + get_chunk_size(p_chunk);
+        return next < mem_chunk + size ? reinterpret_cast<Chunk*>(next) : nullptr;
+    }
+
+    static void check_alignment(size_t p_alignment);
+    static size_t get_chunk_size_for(size_t p_size);
+    Chunk* acquire_chunk(size_t p_chunk_size, size_t p_alignment);
+
+    static void mapping_insert(size_t p_size, size_t& r_fl, size_t& r_sl);
+    static bool mapping_search(size_t p_size, size_t& r_fl, size_t& r_sl);
+
+    Chunk* find_free_chunk(size_t p_size);
+    bool grow(size_t p_size);
+    void insert_free_chunk(Chunk* p_chunk);
+    void remove_free_chunk(Chunk* p_chunk);
+    Chunk* split_chunk(Chunk* p_chunk, size_t p_size);
+    Chunk* merge_with_prev(Chunk* p_chunk);
+    void merge_with_next(Chunk* p_chunk);
+};
+
+}
+
+#endif
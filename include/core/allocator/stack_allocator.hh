@@ -16,6 +16,7 @@
 #define __WBE_STACK_ALLOCATOR_HH__
 
 #include "allocator.hh"
+#include "core/allocator/virtual_memory_range.hh"
 #include "utils/defs.hh"
 #include "utils/utils.hh"
 #include <bit>
@@ -59,10 +60,20 @@ public:
      * @brief Constructor.
      *
      * @param p_size The size of the allocated buffer in bytes.
+     * @param p_huge_pages Should try to back the buffer with huge pages. The size is then
+     * rounded up to the huge page size.
      */
-    StackAllocator(size_t p_size)
-        : total_size(p_size), stack_pointer(0),
-        mem_chunk(std::make_unique<char[]>(total_size)) {
+    StackAllocator(size_t p_size, bool p_huge_pages = false)
+        : total_size(p_size), stack_pointer(0) {
+        if (p_huge_pages) {
+            virtual_memory = std::make_unique<VirtualMemoryRange>(p_size, p_size, true);
+            mem_buffer = virtual_memory->get_data();
+            total_size = virtual_memory->get_committed_size();
+        }
+        else {
+            mem_chunk = std::make_unique<char[]>(total_size);
+            mem_buffer = mem_chunk.get();
+        }
     }
 
     /**
@@ -72,7 +83,7 @@ public:
      * @return 
      */
     MemID allocate(size_t p_size) {
-        void* result = mem_chunk.get() + stack_pointer;
+        void* result = mem_buffer + stack_pointer;
         stack_pointer += get_align_size(p_size, WBE_DEFAULT_ALIGNMENT);
         return std::bit_cast<MemID>(result);
     }
@@ -86,8 +97,8 @@ public:
         if (p_id == MEM_NULL) {
             return nullptr;
         }
-        WBE_DEBUG_ASSERT(std::bit_cast<void*>(p_id) >= mem_chunk.get());
-        WBE_DEBUG_ASSERT(std::bit_cast<void*>(p_id) <= (mem_chunk.get() + stack_pointer));
+        WBE_DEBUG_ASSERT(std::bit_cast<void*>(p_id) >= mem_buffer);
+        WBE_DEBUG_ASSERT(std::bit_cast<void*>(p_id) <= (mem_buffer + stack_pointer));
         return std::bit_cast<void*>(p_id);
     }
 
@@ -97,7 +108,7 @@ public:
      * @param p_id The ID of the memory to get.
      */
     void* get(MemID p_id) const {
-        WBE_DEBUG_ASSERT(std::bit_cast<void*>(p_id) < (mem_chunk.get() + stack_pointer));
+        WBE_DEBUG_ASSERT(std::bit_cast<void*>(p_id) < (mem_buffer + stack_pointer));
         return std::bit_cast<void*>(p_id);
     }
 
@@ -110,7 +121,7 @@ public:
      */
     template <typename T>
     T* get_obj(MemID p_id) const {
-        WBE_DEBUG_ASSERT(std::bit_cast<void*>(p_id) < (mem_chunk.get() + stack_pointer));
+        WBE_DEBUG_ASSERT(std::bit_cast<void*>(p_id) < (mem_buffer + stack_pointer));
         return std::bit_cast<T*>(p_id);
     }
 
@@ -121,7 +132,7 @@ public:
      */
     void* pop_stack(size_t p_size) {
         stack_pointer -= get_align_size(p_size, WBE_DEFAULT_ALIGNMENT);
-        return mem_chunk.get() + stack_pointer;
+        return mem_buffer + stack_pointer;
     }
 
     /**
@@ -149,18 +160,30 @@ public:
         return total_size;
     }
 
+    /**
+     * @brief Get the kind of pages backing the allocator.
+     *
+     * @return The page backing obtained.
+     */
+    PageBacking get_page_backing() const {
+        return virtual_memory != nullptr ? virtual_memory->get_page_backing() : PageBacking::NORMAL;
+    }
+
     operator std::string() const {
         std::stringstream ss;
         ss << "{\"type\":\"StackAllocator\",\"total_size\":" << total_size
            << ",\"stack_pointer\":" << stack_pointer
-           << ",\"available\":" << (total_size - stack_pointer) << "}";
+           << ",\"available\":" << (total_size - stack_pointer)
+           << ",\"page_backing\":\"" << get_page_backing_name(get_page_backing()) << "\"}";
         return ss.str();
     }
 
 private:
     size_t total_size;
     size_t stack_pointer;
+    char* mem_buffer;
     std::unique_ptr<char[]> mem_chunk;
+    std::unique_ptr<VirtualMemoryRange> virtual_memory;
 };
 
 template <typename T, typename... Args>
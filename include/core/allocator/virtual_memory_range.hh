@@ -0,0 +1,139 @@
+/* Copyright 2025 OppositeNor
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef __WBE_VIRTUAL_MEMORY_RANGE_HH__
+#define __WBE_VIRTUAL_MEMORY_RANGE_HH__
+
+#include <cstddef>
+#include <string>
+
+namespace WhiteBirdEngine {
+
+/**
+ * @brief The kind of pages backing a range of memory.
+ */
+enum class PageBacking {
+    // Regular pages.
+    NORMAL = 0,
+    // Huge pages reserved from the huge page pool.
+    HUGE_TLB,
+    // Transparent huge pages, promoted by the kernel when possible.
+    TRANSPARENT_HUGE
+};
+
+/**
+ * @brief Get the name of a page backing.
+ *
+ * @param p_page_backing The page backing.
+ * @return The name of the page backing.
+ */
+constexpr const char* get_page_backing_name(PageBacking p_page_backing) {
+    switch (p_page_backing) {
+    case PageBacking::NORMAL:
+        return "NORMAL";
+    case PageBacking::HUGE_TLB:
+        return "HUGE_TLB";
+    case PageBacking::TRANSPARENT_HUGE:
+        return "TRANSPARENT_HUGE";
+    }
+    return "UNKNOWN";
+}
+
+/**
+ * @class VirtualMemoryRange
+ * @brief A range of virtual memory that is reserved up front and committed on demand.
+ * The reserved range is mapped without access, and pages are made accessible as the
+ * committed size grows. The start of the range never moves, so pools built on top of it
+ * could grow without invalidating the addresses handed out.
+ * With huge pages requested, a fully committed range first tries explicit huge pages, and
+ * otherwise falls back to transparent huge pages on a range aligned to the huge page size.
+ */
+class VirtualMemoryRange final {
+public:
+    VirtualMemoryRange() = delete;
+    ~VirtualMemoryRange();
+    VirtualMemoryRange(const VirtualMemoryRange&) = delete;
+    VirtualMemoryRange(VirtualMemoryRange&&) = delete;
+    VirtualMemoryRange& operator=(const VirtualMemoryRange&) = delete;
+    VirtualMemoryRange& operator=(VirtualMemoryRange&&) = delete;
+
+    /**
+     * @brief Constructor.
+     *
+     * @param p_reserve_size The size of the virtual memory to reserve. Rounded up to the page size,
+     * or the huge page size if p_huge_pages is set.
+     * @param p_commit_size The size to commit initially. Rounded up to the page size.
+     * @param p_huge_pages Should try to back the range with huge pages.
+     */
+    VirtualMemoryRange(size_t p_reserve_size, size_t p_commit_size, bool p_huge_pages = false);
+
+    /**
+     * @brief Commit memory so that at least p_size bytes from the start are accessible.
+     *
+     * @param p_size The size that should be committed. Rounded up to the page size.
+     * @return True if committed, false if p_size exceeds the reserved size.
+     */
+    bool commit(size_t p_size);
+
+    /**
+     * @brief Get the start of the range.
+     *
+     * @return The start of the range.
+     */
+    char* get_data() const {
+        return data;
+    }
+
+    /**
+     * @brief Get the size of the memory that is accessible.
+     *
+     * @return The committed size in bytes.
+     */
+    size_t get_committed_size() const {
+        return committed_size;
+    }
+
+    /**
+     * @brief Get the size of the virtual memory reserved.
+     *
+     * @return The reserved size in bytes.
+     */
+    size_t get_reserved_size() const {
+        return reserved_size;
+    }
+
+    /**
+     * @brief Get the kind of pages backing the range.
+     *
+     * @return The page backing obtained.
+     */
+    PageBacking get_page_backing() const {
+        return page_backing;
+    }
+
+    operator std::string() const;
+
+private:
+    char* data;
+    size_t reserved_size;
+    size_t committed_size = 0;
+    PageBacking page_backing = PageBacking::NORMAL;
+
+    bool try_map_huge_tlb();
+    void map_aligned(size_t p_alignment);
+};
+
+}
+
+#endif
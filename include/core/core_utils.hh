@@ -17,8 +17,11 @@
 
 #include "core/allocator/allocator.hh"
 #include "core/allocator/heap_allocator_aligned_pool_impl_list.hh"
+#include "core/allocator/heap_allocator_tlsf.hh"
+#include "core/memory/reference_intrusive.hh"
 #include "core/memory/reference_strong.hh"
 #include "core/memory/reference_weak.hh"
+#include <concepts>
 #include <stdexcept>
 #include <string>
 namespace WhiteBirdEngine {
@@ -47,6 +50,22 @@ public:
         this_ref = p_ref_of_this;
     }
 
+    /**
+     * @brief Get a strong reference to this instance. If T counts its references intrusively,
+     * the reference is made from the object itself and set_ref_of_this is not needed.
+     *
+     * @return The reference to this instance, RefIntrusive<T> if T derives from RefCounted,
+     * Ref<T> otherwise.
+     */
+    auto get_this_ref() {
+        if constexpr (std::derived_from<T, RefCounted>) {
+            return RefIntrusive<T>(static_cast<T*>(this));
+        }
+        else {
+            return this_ref.lock();
+        }
+    }
+
 protected:
     RefWeak<T> this_ref;
 };
@@ -75,7 +94,11 @@ RefWeak<T> requires_valid(const std::string& p_name, RefWeak<T> p_ref) {
     return p_ref;
 }
 
+#ifdef WBE_DEFAULT_ALLOCATOR_TLSF
+using HeapAllocatorDefault = HeapAllocatorTLSF;
+#else
 using HeapAllocatorDefault = HeapAllocatorAlignedPoolImplicitList;
+#endif
 
 }
 
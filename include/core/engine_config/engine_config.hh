@@ -50,20 +50,42 @@ struct WBE_META(WBE_CONFIG_OPTION) EngineConfigOptions final : public Serializab
     const uint32_t version_patch = 1;
 
     /**
-     * @brief The size of the tick stack.
+     * @brief The size of the tick stack of each thread.
      */
     WBE_META(WBE_REFLECT)
     size_t single_tick_stack_size = WBE_KiB(64);
+    /**
+     * @brief The number of ticks the contents of the tick stack stay valid for, up to 3.
+     */
+    WBE_META(WBE_REFLECT)
+    uint32_t single_tick_frame_count = 2;
     /**
      * @brief The size of the global memory pool.
      */
     WBE_META(WBE_REFLECT)
     size_t global_mem_pool_size = WBE_KiB(128);
+    /**
+     * @brief The size of the virtual memory reserved for the global memory pool to grow into.
+     * 0 for a fixed size global memory pool.
+     */
+    WBE_META(WBE_REFLECT)
+    size_t global_mem_pool_reserve_size = 0;
+    /**
+     * @brief Should try to back the global memory pool with huge pages.
+     */
+    WBE_META(WBE_REFLECT)
+    bool global_mem_pool_huge_pages = false;
     /**
      * @brief The size of the thread memory pool.
      */
     WBE_META(WBE_REFLECT)
     size_t thread_mem_pool_size = WBE_KiB(16);
+    /**
+     * @brief The time in microseconds the end of each tick could spend destroying the objects
+     * whose destruction is deferred on the main thread.
+     */
+    WBE_META(WBE_REFLECT)
+    uint64_t ref_destruction_budget_us = 1000;
 
     /**
      * @brief The utility name while running the program.
@@ -14,8 +14,8 @@
 */
 #ifndef __WBE_ENGINE_CORE_HH__
 #define __WBE_ENGINE_CORE_HH__
-#include "core/allocator/heap_allocator_aligned_pool_impl_list.hh"
-#include "core/allocator/stack_allocator.hh"
+#include "core/allocator/frame_allocator.hh"
+#include "core/core_utils.hh"
 #include "core/engine_config/engine_config.hh"
 #include "core/clock/clock.hh"
 #include "core/logging/log_stream.hh"
@@ -62,6 +62,11 @@ public:
         return singleton;
     }
 
+    /**
+     * @brief End the current tick. Should be called by the main loop at every tick boundary.
+     */
+    void end_tick();
+
     /**
      * @brief The global clock starts recording when the engine core is constructed.
      */
@@ -76,13 +81,14 @@ public:
      */
     EngineConfig* engine_config = nullptr;
     /**
-     * @brief Single tick stack allocator. Contents will be cleared every time a tick ends.
+     * @brief Single tick allocator, with a slice for each thread. Contents stay valid for
+     * single_tick_frame_count ticks.
      */
-    StackAllocator* single_tick_allocator = nullptr;
+    FrameAllocator* single_tick_allocator = nullptr;
     /**
      * @brief Global pool allocator.
      */
-    HeapAllocatorAlignedPoolImplicitList* pool_allocator = nullptr;
+    HeapAllocatorDefault* pool_allocator = nullptr;
     /**
      * @brief Manager for logs.
      */
@@ -111,7 +117,7 @@ private:
  *
  * @return The global allocator;
  */
-inline HeapAllocatorAlignedPoolImplicitList* global_allocator() {
+inline HeapAllocatorDefault* global_allocator() {
     return EngineCore::get_singleton()->pool_allocator;
 }
 
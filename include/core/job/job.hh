@@ -15,8 +15,55 @@
 #ifndef __WBE_JOB_HH__
 #define __WBE_JOB_HH__
 
+#include <atomic>
+#include <concepts>
+#include <cstddef>
+
 namespace WhiteBirdEngine {
 
+/**
+ * @class JobCounter
+ * @brief Counts the scheduled jobs that are not finished yet, for waiting on a group of jobs.
+ */
+class JobCounter final {
+public:
+    JobCounter() {}
+    ~JobCounter() {}
+    JobCounter(const JobCounter&) = delete;
+    JobCounter(JobCounter&&) = delete;
+    JobCounter& operator=(const JobCounter&) = delete;
+    JobCounter& operator=(JobCounter&&) = delete;
+
+    /**
+     * @brief Add jobs to wait for.
+     *
+     * @param p_count The number of jobs.
+     */
+    void add(size_t p_count = 1) {
+        pending.fetch_add(p_count, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Mark a job as finished.
+     */
+    void done() {
+        pending.fetch_sub(1, std::memory_order_release);
+    }
+
+    /**
+     * @brief Are all the jobs finished. The results of the finished jobs are visible to the
+     * caller when this returns true.
+     *
+     * @return true if all the jobs are finished, false otherwise.
+     */
+    bool is_done() const {
+        return pending.load(std::memory_order_acquire) == 0;
+    }
+
+private:
+    std::atomic<size_t> pending = 0;
+};
+
 /**
  * @class Job
  * @brief A job.
@@ -26,6 +73,17 @@ template <typename ChildT>
 struct Job {
     Job() {}
     virtual ~Job() {}
+
+    // Signaled when the job is finished, set by the scheduler.
+    JobCounter* counter = nullptr;
+};
+
+/**
+ * @brief A job that could be run by the JobScheduler.
+ */
+template <typename T>
+concept JobConcept = std::derived_from<T, Job<T>> && requires(T* p_job) {
+    p_job->perform();
 };
 
 }
@@ -44,7 +44,7 @@ public:
      * @param p_job The job to add to the buffer.
      */
     void add_job(Ref<JobType> p_job) {
-        return static_cast<ChildT*>(this)->add_job();
+        return static_cast<ChildT*>(this)->add_job(p_job);
     }
 };
 
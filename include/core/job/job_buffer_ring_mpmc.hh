@@ -0,0 +1,280 @@
+/* Copyright 2025 OppositeNor
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef __WBE_JOB_BUFFER_RING_MPMC_HH__
+#define __WBE_JOB_BUFFER_RING_MPMC_HH__
+
+#include "core/core_utils.hh"
+#include "core/memory/reference_strong.hh"
+#include "global/stl_allocator.hh"
+#include "job_buffer.hh"
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+
+namespace WhiteBirdEngine {
+
+/**
+ * @class JobBufferRingMPMC
+ *
+ * @tparam JobT The type of the job.
+ * @brief Job buffer, bounded mpmc ring buffer version.
+ *
+ * Every slot has a sequence number telling whether it is ready to be written or read in the
+ * current lap, so the producers and the consumers only contend on their own position.
+ * try_add and try_retrieve never block. add_job waits for room instead of throwing on
+ * overflow, wait_retrieve_job waits for a job until the buffer is closed. retrieve_job does
+ * not block, like the other job buffers.
+ */
+template <typename JobT>
+class JobBufferRingMPMC final : public JobBuffer<JobBufferRingMPMC<JobT>, JobT> {
+public:
+    // The type of the job this buffer is holding.
+    using JobType = JobT;
+
+    virtual ~JobBufferRingMPMC() override;
+    JobBufferRingMPMC(const JobBufferRingMPMC&) = delete;
+    JobBufferRingMPMC(JobBufferRingMPMC&&) = delete;
+    JobBufferRingMPMC& operator=(const JobBufferRingMPMC&) = delete;
+    JobBufferRingMPMC& operator=(JobBufferRingMPMC&&) = delete;
+
+    /**
+     * @brief Constructor.
+     *
+     * @param p_allocator The allocator this buffer uses.
+     * @param p_buffer_size The number of jobs the buffer could hold, rounded up to a power of 2.
+     */
+    JobBufferRingMPMC(HeapAllocatorDefault* p_allocator, size_t p_buffer_size);
+
+    /**
+     * @brief Add a job if there is room.
+     *
+     * @param p_job The job to add to the buffer.
+     * @return true if the job is added, false if the buffer is full.
+     */
+    bool try_add(const Ref<JobType>& p_job);
+
+    /**
+     * @brief Retrieve the oldest job if there is one.
+     *
+     * @return The job, MEM_NULL if the buffer is empty.
+     */
+    Ref<JobType> try_retrieve();
+
+    /**
+     * @brief Add a job, waiting for room if the buffer is full.
+     *
+     * @param p_job The job to add to the buffer.
+     */
+    void add_job(Ref<JobType> p_job);
+
+    /**
+     * @brief Retrieve the oldest job without waiting.
+     *
+     * @return The job, MEM_NULL if the buffer is empty.
+     */
+    Ref<JobType> retrieve_job() {
+        return try_retrieve();
+    }
+
+    /**
+     * @brief Retrieve the oldest job, waiting for one if the buffer is empty.
+     *
+     * @return The job, MEM_NULL if the buffer is closed and empty.
+     */
+    Ref<JobType> wait_retrieve_job();
+
+    /**
+     * @brief Close the buffer, the threads waiting in wait_retrieve_job return once the
+     * buffer is empty. Adding is not affected.
+     */
+    void close();
+
+    /**
+     * @brief Get the number of jobs the buffer could hold.
+     *
+     * @return The capacity.
+     */
+    size_t get_capacity() const {
+        return buffer.size();
+    }
+
+private:
+    struct Slot {
+        // The position the slot is ready to be written at, or that position plus 1 once the
+        // job is written and ready to be read.
+        std::atomic<size_t> sequence;
+        // A detached reference, owned by the slot while it is ready to be read.
+        void* job = nullptr;
+    };
+
+    // Bump an epoch and wake a thread waiting on it, only if there is one.
+    static void signal(std::atomic<uint32_t>& r_epoch, const std::atomic<uint32_t>& p_waiter_count);
+
+    vector<Slot> buffer;
+    size_t mask;
+    WBE_NO_FALSE_SHARING std::atomic<size_t> enqueue_pos;
+    WBE_NO_FALSE_SHARING std::atomic<size_t> dequeue_pos;
+    // Waited on by the consumers for a job, and by the producers for room.
+    WBE_NO_FALSE_SHARING std::atomic<uint32_t> job_epoch;
+    std::atomic<uint32_t> job_waiter_count;
+    std::atomic<uint32_t> room_epoch;
+    std::atomic<uint32_t> room_waiter_count;
+    std::atomic<bool> closed;
+};
+
+template <typename JobType>
+JobBufferRingMPMC<JobType>::JobBufferRingMPMC(HeapAllocatorDefault* p_allocator, size_t p_buffer_size)
+    : buffer(std::bit_ceil(p_buffer_size), typename vector<Slot>::allocator_type(p_allocator)), mask(buffer.size() - 1),
+    enqueue_pos(0), dequeue_pos(0), job_epoch(0), job_waiter_count(0), room_epoch(0), room_waiter_count(0), closed(false) {
+    if (p_buffer_size <= 1) {
+        throw std::runtime_error("Buffer has to be at least size 2.");
+    }
+    for (size_t i = 0; i < buffer.size(); ++i) {
+        buffer[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+template <typename JobType>
+JobBufferRingMPMC<JobType>::~JobBufferRingMPMC() {
+    // Release the jobs left in the buffer.
+    while (!try_retrieve().is_null()) {}
+}
+
+template <typename JobType>
+bool JobBufferRingMPMC<JobType>::try_add(const Ref<JobType>& p_job) {
+    WBE_DEBUG_ASSERT(!p_job.is_null());
+    size_t pos = enqueue_pos.load(std::memory_order_relaxed);
+    Slot* slot;
+    while (true) {
+        slot = &buffer[pos & mask];
+        size_t sequence = slot->sequence.load(std::memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+        if (diff == 0) {
+            if (enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        }
+        else if (diff < 0) {
+            // The slot still holds the job of the last lap.
+            return false;
+        }
+        else {
+            // Another producer took the position.
+            pos = enqueue_pos.load(std::memory_order_relaxed);
+        }
+    }
+    slot->job = Ref<JobType>(p_job).detach();
+    slot->sequence.store(pos + 1, std::memory_order_release);
+    signal(job_epoch, job_waiter_count);
+    return true;
+}
+
+template <typename JobType>
+Ref<JobType> JobBufferRingMPMC<JobType>::try_retrieve() {
+    size_t pos = dequeue_pos.load(std::memory_order_relaxed);
+    Slot* slot;
+    while (true) {
+        slot = &buffer[pos & mask];
+        size_t sequence = slot->sequence.load(std::memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1);
+        if (diff == 0) {
+            if (dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        }
+        else if (diff < 0) {
+            // The slot is not written in this lap yet.
+            return MEM_NULL;
+        }
+        else {
+            // Another consumer took the position.
+            pos = dequeue_pos.load(std::memory_order_relaxed);
+        }
+    }
+    void* job = slot->job;
+    slot->job = nullptr;
+    // Ready to be written in the next lap.
+    slot->sequence.store(pos + mask + 1, std::memory_order_release);
+    signal(room_epoch, room_waiter_count);
+    return Ref<JobType>::attach(job);
+}
+
+template <typename JobType>
+void JobBufferRingMPMC<JobType>::add_job(Ref<JobType> p_job) {
+    while (!try_add(p_job)) {
+        // Announce the wait before checking again, pairs with the fence in signal.
+        room_waiter_count.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        uint32_t epoch = room_epoch.load(std::memory_order_acquire);
+        bool added = try_add(p_job);
+        if (!added) {
+            room_epoch.wait(epoch, std::memory_order_acquire);
+        }
+        room_waiter_count.fetch_sub(1, std::memory_order_relaxed);
+        if (added) {
+            return;
+        }
+    }
+}
+
+template <typename JobType>
+Ref<JobType> JobBufferRingMPMC<JobType>::wait_retrieve_job() {
+    while (true) {
+        Ref<JobType> job = try_retrieve();
+        if (!job.is_null()) {
+            return job;
+        }
+        // Announce the wait before checking again, pairs with the fence in signal.
+        job_waiter_count.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        uint32_t epoch = job_epoch.load(std::memory_order_acquire);
+        job = try_retrieve();
+        if (job.is_null() && !closed.load(std::memory_order_acquire)) {
+            job_epoch.wait(epoch, std::memory_order_acquire);
+        }
+        job_waiter_count.fetch_sub(1, std::memory_order_relaxed);
+        if (!job.is_null()) {
+            return job;
+        }
+        if (closed.load(std::memory_order_acquire)) {
+            // A job added before the close is still handed out.
+            return try_retrieve();
+        }
+    }
+}
+
+template <typename JobType>
+void JobBufferRingMPMC<JobType>::close() {
+    closed.store(true, std::memory_order_release);
+    job_epoch.fetch_add(1, std::memory_order_release);
+    job_epoch.notify_all();
+}
+
+template <typename JobType>
+void JobBufferRingMPMC<JobType>::signal(std::atomic<uint32_t>& r_epoch, const std::atomic<uint32_t>& p_waiter_count) {
+    // Either the waiter sees the new job or room, or this sees the waiter.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (p_waiter_count.load(std::memory_order_relaxed) == 0) {
+        return;
+    }
+    r_epoch.fetch_add(1, std::memory_order_release);
+    r_epoch.notify_one();
+}
+
+}
+
+#endif
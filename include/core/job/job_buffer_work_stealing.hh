@@ -0,0 +1,185 @@
+/* Copyright 2025 OppositeNor
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef __WBE_JOB_BUFFER_WORK_STEALING_HH__
+#define __WBE_JOB_BUFFER_WORK_STEALING_HH__
+
+#include "core/core_utils.hh"
+#include "core/memory/reference_strong.hh"
+#include "global/stl_allocator.hh"
+#include "job_buffer.hh"
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+
+namespace WhiteBirdEngine {
+
+/**
+ * @class JobBufferWorkStealing
+ *
+ * @tparam JobT The type of the job.
+ * @brief Job buffer, Chase-Lev work stealing deque version.
+ *
+ * The owner thread adds and retrieves the jobs at the bottom, newest first, so the jobs it
+ * just spawned are still hot in its cache. Other threads steal the oldest jobs from the top
+ * with steal_job. Only the owner could call add_job and retrieve_job.
+ * The capacity is fixed at construction, so the allocator is never touched by the other threads.
+ */
+template <typename JobT>
+class JobBufferWorkStealing final : public JobBuffer<JobBufferWorkStealing<JobT>, JobT> {
+public:
+    // The type of the job this buffer is holding.
+    using JobType = JobT;
+
+    virtual ~JobBufferWorkStealing() override;
+    JobBufferWorkStealing(const JobBufferWorkStealing&) = delete;
+    JobBufferWorkStealing(JobBufferWorkStealing&&) = delete;
+    JobBufferWorkStealing& operator=(const JobBufferWorkStealing&) = delete;
+    JobBufferWorkStealing& operator=(JobBufferWorkStealing&&) = delete;
+
+    /**
+     * @brief Constructor.
+     *
+     * @param p_allocator The allocator this buffer uses.
+     * @param p_buffer_size The number of jobs the buffer could hold, rounded up to a power of 2.
+     */
+    JobBufferWorkStealing(HeapAllocatorDefault* p_allocator, size_t p_buffer_size);
+
+    /**
+     * @brief Retrieve the newest job. Owner only.
+     *
+     * @return The job, MEM_NULL if the buffer is empty.
+     */
+    Ref<JobType> retrieve_job();
+
+    /**
+     * @brief Add a job at the bottom. Owner only.
+     *
+     * @throws std::runtime_error If buffer overflow.
+     * @param p_job The job to add to the buffer.
+     */
+    void add_job(Ref<JobType> p_job);
+
+    /**
+     * @brief Steal the oldest job. Could be called by any thread.
+     *
+     * @return The job, MEM_NULL if the buffer is empty or another thread took the job first.
+     */
+    Ref<JobType> steal_job();
+
+    /**
+     * @brief Is the buffer full. Exact for the owner, the thieves could only make room.
+     *
+     * @return true if the next add_job would overflow, false otherwise.
+     */
+    bool is_full() const {
+        return bottom.load(std::memory_order_relaxed) - top.load(std::memory_order_acquire) >= static_cast<int64_t>(buffer.size());
+    }
+
+    /**
+     * @brief Is the buffer empty. Only a hint when the other threads are using the buffer.
+     *
+     * @return true if there is no job in the buffer, false otherwise.
+     */
+    bool is_empty() const {
+        return bottom.load(std::memory_order_acquire) <= top.load(std::memory_order_acquire);
+    }
+
+private:
+    // The slots hold detached references, a thief could read a slot only as a whole pointer.
+    vector<std::atomic<void*>> buffer;
+    size_t mask;
+    // The index of the oldest job, advanced by the thieves and by the owner taking the last job.
+    WBE_NO_FALSE_SHARING std::atomic<int64_t> top;
+    // The index after the newest job, only written by the owner.
+    WBE_NO_FALSE_SHARING std::atomic<int64_t> bottom;
+};
+
+template <typename JobType>
+JobBufferWorkStealing<JobType>::JobBufferWorkStealing(HeapAllocatorDefault* p_allocator, size_t p_buffer_size)
+    : buffer(std::bit_ceil(p_buffer_size), typename vector<std::atomic<void*>>::allocator_type(p_allocator)), mask(buffer.size() - 1), top(0), bottom(0) {
+    if (p_buffer_size == 0) {
+        throw std::runtime_error("Buffer has to be at least size 1.");
+    }
+}
+
+template <typename JobType>
+JobBufferWorkStealing<JobType>::~JobBufferWorkStealing() {
+    // Release the jobs left in the buffer.
+    for (int64_t i = top.load(std::memory_order_relaxed); i < bottom.load(std::memory_order_relaxed); ++i) {
+        Ref<JobType>::attach(buffer[i & mask].load(std::memory_order_relaxed));
+    }
+}
+
+template <typename JobType>
+Ref<JobType> JobBufferWorkStealing<JobType>::retrieve_job() {
+    int64_t bottom_l = bottom.load(std::memory_order_relaxed) - 1;
+    bottom.store(bottom_l, std::memory_order_relaxed);
+    // Publish the claim on the bottom job before looking at the top, pairs with the fence in steal_job.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t top_l = top.load(std::memory_order_relaxed);
+    if (top_l > bottom_l) {
+        // Empty.
+        bottom.store(bottom_l + 1, std::memory_order_relaxed);
+        return MEM_NULL;
+    }
+    void* job = buffer[bottom_l & mask].load(std::memory_order_relaxed);
+    if (top_l == bottom_l) {
+        // The last job, race the thieves for it.
+        if (!top.compare_exchange_strong(top_l, top_l + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            job = nullptr;
+        }
+        bottom.store(bottom_l + 1, std::memory_order_relaxed);
+    }
+    if (job == nullptr) {
+        return MEM_NULL;
+    }
+    return Ref<JobType>::attach(job);
+}
+
+template <typename JobType>
+void JobBufferWorkStealing<JobType>::add_job(Ref<JobType> p_job) {
+    WBE_DEBUG_ASSERT(!p_job.is_null());
+    int64_t bottom_l = bottom.load(std::memory_order_relaxed);
+    int64_t top_l = top.load(std::memory_order_acquire);
+    if (bottom_l - top_l >= static_cast<int64_t>(buffer.size())) {
+        throw std::runtime_error("Buffer overflow.");
+    }
+    buffer[bottom_l & mask].store(p_job.detach(), std::memory_order_relaxed);
+    // The job is visible to a thief that sees the new bottom.
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom.store(bottom_l + 1, std::memory_order_relaxed);
+}
+
+template <typename JobType>
+Ref<JobType> JobBufferWorkStealing<JobType>::steal_job() {
+    int64_t top_l = top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t bottom_l = bottom.load(std::memory_order_acquire);
+    if (top_l >= bottom_l) {
+        return MEM_NULL;
+    }
+    // Only a pointer is read before the job is claimed, the reference is not touched.
+    void* job = buffer[top_l & mask].load(std::memory_order_relaxed);
+    if (!top.compare_exchange_strong(top_l, top_l + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+        return MEM_NULL;
+    }
+    return Ref<JobType>::attach(job);
+}
+
+}
+
+#endif
@@ -0,0 +1,343 @@
+/* Copyright 2025 OppositeNor
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef __WBE_JOB_SCHEDULER_HH__
+#define __WBE_JOB_SCHEDULER_HH__
+
+#include "core/core_utils.hh"
+#include "core/memory/ref_destruction_queue.hh"
+#include "core/memory/reference_strong.hh"
+#include "job.hh"
+#include "job_buffer_work_stealing.hh"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace WhiteBirdEngine {
+
+/**
+ * @class JobScheduler
+ * @brief Runs jobs on a fixed pool of worker threads that steal work from each other.
+ *
+ * Every worker owns a JobBufferWorkStealing. The jobs scheduled by a worker go to its own
+ * buffer, the jobs scheduled by the other threads go to a shared queue. A worker runs its own
+ * newest job first, then takes from the shared queue, then steals the oldest job of another
+ * worker. A worker that finds nothing parks on a condition variable until a job is scheduled.
+ * Before parking, a worker drains the RefDestructionQueue of its thread within a budget, in
+ * case its jobs turned deferring on. The thread that waits for a JobCounter runs the jobs
+ * meanwhile instead of blocking. The jobs still queued when the scheduler is destroyed are run
+ * by the destroying thread, so their counters are signaled.
+ *
+ * @note The jobs are released on the worker threads, allocate them with a thread safe allocator.
+ * Jobs must not throw.
+ *
+ * @tparam JobT The type of the job.
+ */
+template <typename JobT>
+class JobScheduler final {
+    // Checked here rather than on the parameter, so a job could point to its scheduler.
+    static_assert(JobConcept<JobT>, "The job type has to derive from Job and have perform().");
+public:
+    using JobType = JobT;
+
+    /**
+     * @brief The number of jobs the buffer of a worker could hold. When it is full, the job
+     * is run in place.
+     */
+    static constexpr size_t WORKER_BUFFER_SIZE = 1024;
+
+    /**
+     * @brief Destructor. Stops the workers, then runs the jobs left in the queues on the
+     * calling thread, including the jobs they schedule.
+     */
+    ~JobScheduler();
+    JobScheduler(const JobScheduler&) = delete;
+    JobScheduler(JobScheduler&&) = delete;
+    JobScheduler& operator=(const JobScheduler&) = delete;
+    JobScheduler& operator=(JobScheduler&&) = delete;
+
+    /**
+     * @brief Constructor. Starts the workers.
+     *
+     * @param p_allocator The allocator of the buffers of the workers.
+     * @param p_worker_count The number of worker threads. 0 is allowed, the jobs are then only
+     * run by the waiting threads.
+     */
+    JobScheduler(HeapAllocatorDefault* p_allocator, size_t p_worker_count = get_default_worker_count());
+
+    /**
+     * @brief Get the default number of workers, one less than the CPU count to leave a core
+     * for the main thread, which helps while waiting.
+     *
+     * @return The default number of workers.
+     */
+    static size_t get_default_worker_count() {
+        size_t cpu_count = std::thread::hardware_concurrency();
+        return cpu_count > 1 ? cpu_count - 1 : 1;
+    }
+
+    /**
+     * @brief Schedule a job.
+     *
+     * @param p_job The job. Could not be scheduled again before it is finished.
+     * @param r_counter The counter signaled when the job is finished. Could be nullptr.
+     */
+    void schedule(Ref<JobType> p_job, JobCounter* r_counter = nullptr);
+
+    /**
+     * @brief Run the scheduled jobs until all the jobs of a counter are finished.
+     *
+     * @param p_counter The counter to wait for.
+     */
+    void wait(const JobCounter& p_counter);
+
+    /**
+     * @brief Get the number of worker threads.
+     *
+     * @return The number of workers.
+     */
+    size_t get_worker_count() const {
+        return workers.size();
+    }
+
+private:
+    // Rounds of searching before a worker parks.
+    static constexpr size_t SPIN_COUNT = 64;
+    // The time an idle worker spends destroying the objects released on its thread, before it
+    // searches again.
+    static constexpr std::chrono::microseconds DESTRUCTION_BUDGET{100};
+
+    struct Worker {
+        Worker(JobScheduler* p_scheduler, HeapAllocatorDefault* p_allocator, size_t p_index)
+            : scheduler(p_scheduler), buffer(p_allocator, WORKER_BUFFER_SIZE), index(p_index) {}
+        JobScheduler* scheduler;
+        JobBufferWorkStealing<JobType> buffer;
+        size_t index;
+        std::thread thread;
+    };
+
+    void worker_main(size_t p_index);
+    void run(Ref<JobType> p_job);
+    // Find a job for a thread, the worker of the thread is checked first if it has one.
+    Ref<JobType> find_job(Worker* p_self);
+    void wake_one();
+
+    // The worker of this scheduler running on the calling thread, nullptr for the other threads.
+    Worker* get_current_worker() const {
+        return current_worker != nullptr && current_worker->scheduler == this ? current_worker : nullptr;
+    }
+
+    std::vector<std::unique_ptr<Worker>> workers;
+
+    std::mutex shared_mutex;
+    std::deque<Ref<JobType>> shared_jobs;
+    std::atomic<size_t> shared_count = 0;
+
+    std::mutex park_mutex;
+    std::condition_variable park_condition;
+    // Bumped under the lock for each wake up, a worker only parks if it did not change since
+    // the worker last searched.
+    uint64_t park_epoch = 0;
+    std::atomic<size_t> parked_count = 0;
+    bool stopping = false;
+
+    // The worker running on the calling thread, of any scheduler of the job type.
+    inline static thread_local Worker* current_worker = nullptr;
+};
+
+template <typename JobType>
+JobScheduler<JobType>::JobScheduler(HeapAllocatorDefault* p_allocator, size_t p_worker_count) {
+    workers.reserve(p_worker_count);
+    for (size_t i = 0; i < p_worker_count; ++i) {
+        workers.push_back(std::make_unique<Worker>(this, p_allocator, i));
+    }
+    // Start after all the buffers exist, the workers steal from each other.
+    for (size_t i = 0; i < p_worker_count; ++i) {
+        workers[i]->thread = std::thread(&JobScheduler::worker_main, this, i);
+    }
+}
+
+template <typename JobType>
+JobScheduler<JobType>::~JobScheduler() {
+    {
+        std::lock_guard lock(park_mutex);
+        stopping = true;
+    }
+    park_condition.notify_all();
+    for (std::unique_ptr<Worker>& worker : workers) {
+        worker->thread.join();
+    }
+    // A thread could be waiting for the counters of the leftover jobs. Their buffers could
+    // still be stolen from after the owners exit, and the jobs they schedule go to the shared queue.
+    for (Ref<JobType> job = find_job(nullptr); !job.is_null(); job = find_job(nullptr)) {
+        run(std::move(job));
+    }
+}
+
+template <typename JobType>
+void JobScheduler<JobType>::schedule(Ref<JobType> p_job, JobCounter* r_counter) {
+    WBE_DEBUG_ASSERT(!p_job.is_null());
+    p_job->counter = r_counter;
+    if (r_counter != nullptr) {
+        r_counter->add();
+    }
+    Worker* self = get_current_worker();
+    if (self != nullptr) {
+        if (self->buffer.is_full()) {
+            run(std::move(p_job));
+            return;
+        }
+        self->buffer.add_job(std::move(p_job));
+    }
+    else {
+        std::lock_guard lock(shared_mutex);
+        shared_jobs.push_back(std::move(p_job));
+        shared_count.fetch_add(1, std::memory_order_relaxed);
+    }
+    wake_one();
+}
+
+template <typename JobType>
+void JobScheduler<JobType>::wait(const JobCounter& p_counter) {
+    while (!p_counter.is_done()) {
+        Ref<JobType> job = find_job(get_current_worker());
+        if (job.is_null()) {
+            // The remaining jobs are running on the other threads.
+            std::this_thread::yield();
+            continue;
+        }
+        run(std::move(job));
+    }
+}
+
+template <typename JobType>
+void JobScheduler<JobType>::worker_main(size_t p_index) {
+    Worker* self = workers[p_index].get();
+    current_worker = self;
+    size_t idle_rounds = 0;
+    while (true) {
+        Ref<JobType> job = find_job(self);
+        if (!job.is_null()) {
+            run(std::move(job));
+            idle_rounds = 0;
+            continue;
+        }
+        if (++idle_rounds < SPIN_COUNT) {
+            std::this_thread::yield();
+            continue;
+        }
+        idle_rounds = 0;
+        // A parked worker would keep the deferred objects alive until its thread exits.
+        RefDestructionQueue& destruction_queue = RefDestructionQueue::get_thread_queue();
+        if (destruction_queue.get_pending_count() != 0) {
+            destruction_queue.drain(DESTRUCTION_BUDGET);
+            continue;
+        }
+        // Announce the parking before the last search, so a job scheduled after the search
+        // sees the parked worker and bumps the epoch.
+        parked_count.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        uint64_t epoch;
+        {
+            std::lock_guard lock(park_mutex);
+            epoch = park_epoch;
+        }
+        job = find_job(self);
+        if (job.is_null()) {
+            std::unique_lock lock(park_mutex);
+            park_condition.wait(lock, [&] { return stopping || park_epoch != epoch; });
+            if (stopping) {
+                parked_count.fetch_sub(1, std::memory_order_relaxed);
+                return;
+            }
+        }
+        parked_count.fetch_sub(1, std::memory_order_relaxed);
+        if (!job.is_null()) {
+            run(std::move(job));
+        }
+    }
+}
+
+template <typename JobType>
+void JobScheduler<JobType>::run(Ref<JobType> p_job) {
+    JobCounter* counter = p_job->counter;
+    p_job->perform();
+    // Release the job before signaling, the waiter could destroy what the job references.
+    p_job = MEM_NULL;
+    if (counter != nullptr) {
+        counter->done();
+    }
+}
+
+template <typename JobType>
+Ref<JobType> JobScheduler<JobType>::find_job(Worker* p_self) {
+    if (p_self != nullptr) {
+        Ref<JobType> job = p_self->buffer.retrieve_job();
+        if (!job.is_null()) {
+            return job;
+        }
+    }
+    if (shared_count.load(std::memory_order_relaxed) != 0) {
+        std::lock_guard lock(shared_mutex);
+        if (!shared_jobs.empty()) {
+            Ref<JobType> job = std::move(shared_jobs.front());
+            shared_jobs.pop_front();
+            shared_count.fetch_sub(1, std::memory_order_relaxed);
+            return job;
+        }
+    }
+    if (workers.empty()) {
+        return MEM_NULL;
+    }
+    // Start from a different victim on each thread, so the thieves do not pile on one buffer.
+    size_t start = p_self != nullptr ? p_self->index + 1 : std::hash<std::thread::id>{}(std::this_thread::get_id());
+    for (size_t i = 0; i < workers.size(); ++i) {
+        Worker* victim = workers[(start + i) % workers.size()].get();
+        if (victim == p_self) {
+            continue;
+        }
+        Ref<JobType> job = victim->buffer.steal_job();
+        if (!job.is_null()) {
+            return job;
+        }
+    }
+    return MEM_NULL;
+}
+
+template <typename JobType>
+void JobScheduler<JobType>::wake_one() {
+    // Pairs with the announcement in worker_main, either the worker finds the job or this sees the worker.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (parked_count.load(std::memory_order_relaxed) == 0) {
+        return;
+    }
+    {
+        std::lock_guard lock(park_mutex);
+        ++park_epoch;
+    }
+    park_condition.notify_one();
+}
+
+}
+
+#endif
@@ -0,0 +1,136 @@
+/* Copyright 2025 OppositeNor
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef __WBE_REF_DESTRUCTION_QUEUE_HH__
+#define __WBE_REF_DESTRUCTION_QUEUE_HH__
+
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+namespace WhiteBirdEngine {
+
+/**
+ * @class RefDestructionQueue
+ * @brief Per thread queue of objects whose last reference is released, destroyed later in
+ * batches at a safe point instead of in the middle of the code that released them.
+ *
+ * Deferring is opt-in per thread with set_deferred. While it is on, releasing the last Ref
+ * of an object on this thread queues the object, and drain destroys the queued objects, such
+ * as at the end of the tick. Objects released by the destructors during a drain are queued
+ * behind, so a large object graph is torn down over several drains rather than as one
+ * recursive cascade.
+ * @note The queue only defers the destruction, the object could no longer be referenced, and
+ * weak references to it are already invalid. Drain the queue before the allocators of the
+ * queued objects are destroyed. The remaining objects are destroyed when the thread exits.
+ */
+class RefDestructionQueue final {
+public:
+    /**
+     * @brief Function that destroys a queued object.
+     */
+    using DestroyFunc = void (*)(void* p_obj);
+
+    RefDestructionQueue() {}
+    ~RefDestructionQueue();
+    RefDestructionQueue(const RefDestructionQueue&) = delete;
+    RefDestructionQueue(RefDestructionQueue&&) = delete;
+    RefDestructionQueue& operator=(const RefDestructionQueue&) = delete;
+    RefDestructionQueue& operator=(RefDestructionQueue&&) = delete;
+
+    /**
+     * @brief Get the queue of the calling thread.
+     *
+     * @return The queue of the calling thread.
+     */
+    static RefDestructionQueue& get_thread_queue() {
+        return thread_queue;
+    }
+
+    /**
+     * @brief Should the objects released on the calling thread be queued.
+     *
+     * @return true if deferring is on for the calling thread, false otherwise.
+     */
+    static bool is_thread_deferred() {
+        return thread_queue.deferred;
+    }
+
+    /**
+     * @brief Turn deferring on or off for the thread of this queue. Turning it off does not
+     * destroy the objects already queued.
+     *
+     * @param p_deferred Should the released objects be queued.
+     */
+    void set_deferred(bool p_deferred) {
+        deferred = p_deferred;
+    }
+
+    /**
+     * @brief Queue an object to be destroyed.
+     *
+     * @param p_obj The object to destroy.
+     * @param p_destroy The function that destroys the object.
+     */
+    void push(void* p_obj, DestroyFunc p_destroy) {
+        entries.push_back(Entry{ p_obj, p_destroy });
+    }
+
+    /**
+     * @brief Destroy the queued objects in order until the queue is empty or the budget is
+     * spent. At least one batch is destroyed if the queue is not empty.
+     *
+     * @param p_budget The time to spend.
+     * @return The number of destroyed objects.
+     */
+    size_t drain(std::chrono::nanoseconds p_budget);
+
+    /**
+     * @brief Destroy all the queued objects, including those queued during the drain.
+     *
+     * @return The number of destroyed objects.
+     */
+    size_t drain_all();
+
+    /**
+     * @brief Get the number of objects waiting to be destroyed.
+     *
+     * @return The number of queued objects.
+     */
+    size_t get_pending_count() const {
+        return entries.size() - head;
+    }
+
+private:
+    // The clock is read once per batch.
+    static constexpr size_t DRAIN_BATCH_SIZE = 32;
+
+    struct Entry {
+        void* obj;
+        DestroyFunc destroy;
+    };
+
+    size_t drain_batch();
+
+    static thread_local RefDestructionQueue thread_queue;
+
+    std::vector<Entry> entries;
+    // Index of the first queued entry, the entries before are destroyed.
+    size_t head = 0;
+    bool deferred = false;
+};
+
+}
+
+#endif
@@ -0,0 +1,208 @@
+/* Copyright 2025 OppositeNor
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef __WBE_REFERENCE_ATOMIC_HH__
+#define __WBE_REFERENCE_ATOMIC_HH__
+
+#include "core/allocator/heap_allocator.hh"
+#include "reference_strong.hh"
+#include "utils/defs.hh"
+#include <atomic>
+#include <cstdint>
+
+namespace WhiteBirdEngine {
+
+/**
+ * @class AtomicRef
+ * @brief A reference that could be loaded, stored and exchanged by multiple threads at the
+ * same time, such as a published config snapshot that many threads read.
+ *
+ * The references are split counted. The stored control block comes with a reserve of strong
+ * references, and the number of them handed out to readers is kept in the high bits of the
+ * stored pointer. A load is one atomic add on the AtomicRef and does not touch the control
+ * block, except for refilling the reserve once in a long while. Replacing the reference gives
+ * the unused part of the reserve back to the control block. Every operation is lock free.
+ *
+ * @tparam T The type of the resource.
+ * @tparam AllocType The type of the allocator.
+ */
+template <typename T, typename AllocType = HeapAllocator>
+class AtomicRef final {
+public:
+    using RefType = Ref<T, AllocType, RefPolicyAtomic>;
+
+    AtomicRef()
+        : packed(0) {}
+    ~AtomicRef() {
+        release(packed.load(std::memory_order_acquire));
+    }
+    AtomicRef(const AtomicRef&) = delete;
+    AtomicRef(AtomicRef&&) = delete;
+    AtomicRef& operator=(const AtomicRef&) = delete;
+    AtomicRef& operator=(AtomicRef&&) = delete;
+
+    /**
+     * @brief Constructor.
+     *
+     * @param p_ref The initial reference.
+     */
+    AtomicRef(RefType p_ref)
+        : packed(take(std::move(p_ref))) {}
+
+    /**
+     * @brief Get the stored reference.
+     *
+     * @return The stored reference.
+     */
+    RefType load() const {
+        uint64_t curr = packed.fetch_add(LOCAL_ONE, std::memory_order_acquire);
+        ControlBlock* control_block = get_control_block(curr);
+        if (control_block == nullptr) {
+            // The count of a NULL reference is never read, it is only cleared by the next store.
+            return RefType();
+        }
+        if (get_local_count(curr) + 1 >= REFILL_THRESHOLD) {
+            refill(control_block);
+        }
+        // The reference is taken from the reserve.
+        return RefType(control_block, typename RefType::AdoptTag());
+    }
+
+    /**
+     * @brief Replace the stored reference.
+     *
+     * @param p_ref The reference to store.
+     */
+    void store(RefType p_ref) {
+        release(packed.exchange(take(std::move(p_ref)), std::memory_order_acq_rel));
+    }
+
+    /**
+     * @brief Replace the stored reference.
+     *
+     * @param p_ref The reference to store.
+     * @return The reference stored before.
+     */
+    RefType exchange(RefType p_ref) {
+        return give(packed.exchange(take(std::move(p_ref)), std::memory_order_acq_rel));
+    }
+
+    /**
+     * @brief Replace the stored reference if it is referencing the same object as the expected one.
+     *
+     * @param r_expected The expected reference. Set to a reference loaded after the failure if
+     * the exchange fails.
+     * @param p_desired The reference to store.
+     * @return true if the reference is replaced, false otherwise.
+     */
+    bool compare_exchange(RefType& r_expected, RefType p_desired) {
+        uint64_t desired = take(std::move(p_desired));
+        uint64_t curr = packed.load(std::memory_order_relaxed);
+        while (get_control_block(curr) == r_expected.control_block) {
+            // The local count could change under us, retry while the reference is the same.
+            if (packed.compare_exchange_weak(curr, desired, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+                release(curr);
+                return true;
+            }
+        }
+        release(desired);
+        r_expected = load();
+        return false;
+    }
+
+    operator RefType() const {
+        return load();
+    }
+
+    AtomicRef& operator=(RefType p_ref) {
+        store(std::move(p_ref));
+        return *this;
+    }
+
+private:
+    using ControlBlock = typename RefType::ControlBlock;
+
+    static_assert(sizeof(void*) == sizeof(uint64_t), "AtomicRef packs the pointer into 64 bits.");
+    // The user space addresses fit in the lower 48 bits.
+    static constexpr uint64_t PTR_BITS = 48;
+    static constexpr uint64_t PTR_MASK = (uint64_t(1) << PTR_BITS) - 1;
+    static constexpr uint64_t LOCAL_ONE = uint64_t(1) << PTR_BITS;
+    // More than the local count could hold, so the readers never take more than the reserve.
+    static constexpr uint64_t RESERVE = uint64_t(1) << (64 - PTR_BITS);
+    static constexpr uint64_t REFILL_THRESHOLD = RESERVE / 4;
+
+    static ControlBlock* get_control_block(uint64_t p_packed) {
+        return reinterpret_cast<ControlBlock*>(p_packed & PTR_MASK);
+    }
+
+    static uint64_t get_local_count(uint64_t p_packed) {
+        return p_packed >> PTR_BITS;
+    }
+
+    // Take over the reference and add the reserve to it.
+    static uint64_t take(RefType&& p_ref) {
+        ControlBlock* control_block = p_ref.control_block;
+        if (control_block == nullptr) {
+            return 0;
+        }
+        p_ref.control_block = nullptr;
+        WBE_DEBUG_ASSERT((reinterpret_cast<uint64_t>(control_block) & ~PTR_MASK) == 0);
+        control_block->strong_ref_counter.fetch_add(RESERVE - 1, std::memory_order_relaxed);
+        return reinterpret_cast<uint64_t>(control_block);
+    }
+
+    // Release what is left of the reserve of a replaced value.
+    static void release(uint64_t p_packed) {
+        release_refs(get_control_block(p_packed), RESERVE - get_local_count(p_packed));
+    }
+
+    // Turn what is left of the reserve of a replaced value into one reference.
+    static RefType give(uint64_t p_packed) {
+        ControlBlock* control_block = get_control_block(p_packed);
+        if (control_block == nullptr) {
+            return RefType();
+        }
+        release_refs(control_block, RESERVE - get_local_count(p_packed) - 1);
+        return RefType(control_block, typename RefType::AdoptTag());
+    }
+
+    static void release_refs(ControlBlock* p_control_block, uint64_t p_count) {
+        if (p_control_block == nullptr || p_count == 0) {
+            return;
+        }
+        if (p_control_block->strong_ref_counter.fetch_sub(p_count, std::memory_order_acq_rel) == p_count) {
+            RefType::on_released(p_control_block);
+        }
+    }
+
+    // Move the references taken by the readers from the reserve to the control block.
+    void refill(ControlBlock* p_control_block) const {
+        uint64_t curr = packed.load(std::memory_order_relaxed);
+        while (get_control_block(curr) == p_control_block && get_local_count(curr) >= REFILL_THRESHOLD) {
+            uint64_t local_count = get_local_count(curr);
+            p_control_block->strong_ref_counter.fetch_add(local_count, std::memory_order_relaxed);
+            if (packed.compare_exchange_weak(curr, reinterpret_cast<uint64_t>(p_control_block), std::memory_order_relaxed, std::memory_order_relaxed)) {
+                return;
+            }
+            // The caller holds a reference, the count could not drop to 0.
+            p_control_block->strong_ref_counter.fetch_sub(local_count, std::memory_order_relaxed);
+        }
+    }
+
+    mutable std::atomic<uint64_t> packed;
+};
+
+}
+
+#endif
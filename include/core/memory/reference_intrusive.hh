@@ -0,0 +1,547 @@
+/* Copyright 2025 OppositeNor
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef __WBE_REFERENCE_INTRUSIVE_HH__
+#define __WBE_REFERENCE_INTRUSIVE_HH__
+
+#include "core/allocator/allocator.hh"
+#include "core/allocator/heap_allocator.hh"
+#include "utils/defs.hh"
+#include <algorithm>
+#include <atomic>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+
+namespace WhiteBirdEngine {
+
+template <typename T>
+class RefIntrusive;
+
+template <typename T>
+class RefIntrusiveWeak;
+
+/**
+ * @brief The operations on the allocator that owns a reference counted object, with the type
+ * of the allocator erased.
+ */
+struct RefCountedAllocatorOps {
+    MemID (*allocate)(void* p_allocator, size_t p_size, size_t p_alignment);
+    void (*deallocate)(void* p_allocator, MemID p_mem);
+};
+
+template <typename AllocType>
+inline constexpr RefCountedAllocatorOps REF_COUNTED_ALLOCATOR_OPS = {
+    [](void* p_allocator, size_t p_size, size_t p_alignment) -> MemID {
+        AllocType* allocator = static_cast<AllocType*>(p_allocator);
+        if constexpr (requires { allocator->allocate(p_size, p_alignment); }) {
+            return allocator->allocate(p_size, std::max(p_alignment, static_cast<size_t>(WBE_DEFAULT_ALIGNMENT)));
+        }
+        else {
+            WBE_DEBUG_ASSERT(p_alignment <= WBE_DEFAULT_ALIGNMENT);
+            return allocator->allocate(p_size);
+        }
+    },
+    [](void* p_allocator, MemID p_mem) {
+        AllocType* allocator = static_cast<AllocType*>(p_allocator);
+        // Allocators without deallocate, such as frame allocators, free their memory as a whole.
+        if constexpr (requires { allocator->deallocate(p_mem); }) {
+            allocator->deallocate(p_mem);
+        }
+    }
+};
+
+/**
+ * @class RefCounted
+ * @brief Base of the objects that keep their reference count inside themselves, referenced
+ * by RefIntrusive. Copying a reference only touches the count on the object, and a reference
+ * to this could always be made from the object itself.
+ * @note The object is destroyed and freed when the count drops to 0 if it is created by
+ * make_ref_intrusive. Otherwise it is not owned by the references, and is never destroyed by
+ * them. Do not let a reference to this be released in the constructor, the object is not
+ * owned by the allocator until the constructor returns.
+ */
+class RefCounted {
+    template <typename T>
+    friend class RefIntrusive;
+
+    template <typename T>
+    friend class RefIntrusiveWeak;
+
+    friend class RefCountedWeak;
+
+    template <typename T, typename AllocType, typename... Args>
+    friend RefIntrusive<T> make_ref_intrusive(AllocType* p_allocator, Args&&... p_args);
+public:
+    RefCounted() {}
+    virtual ~RefCounted() {}
+    // The count and the owner belong to the instance, they are not copied.
+    RefCounted(const RefCounted&) {}
+    RefCounted& operator=(const RefCounted&) {
+        return *this;
+    }
+
+    /**
+     * @brief Get the number of strong references to this object.
+     *
+     * @return The reference count.
+     */
+    uint32_t get_ref_count() const {
+        return ref_count.load(std::memory_order_relaxed);
+    }
+
+private:
+    void add_ref() const {
+        ref_count.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void release() const {
+        if (ref_count.fetch_sub(1, std::memory_order_acq_rel) != 1 || allocator == nullptr) {
+            return;
+        }
+        // The allocators do not move their memory, so the address of the most derived object is the memory ID.
+        MemID mem = reinterpret_cast<MemID>(dynamic_cast<const void*>(this));
+        void* owner = allocator;
+        const RefCountedAllocatorOps* owner_ops = allocator_ops;
+        const_cast<RefCounted*>(this)->~RefCounted();
+        owner_ops->deallocate(owner, mem);
+    }
+
+    mutable std::atomic<uint32_t> ref_count = 0;
+    // The allocator the object is allocated from, nullptr if the object is not owned by the references.
+    void* allocator = nullptr;
+    const RefCountedAllocatorOps* allocator_ops = nullptr;
+};
+
+/**
+ * @class RefCountedWeak
+ * @brief RefCounted with support of weak references. The weak references share a flag that
+ * is allocated from the allocator of the object when the first weak reference is made, so
+ * objects that are never weakly referenced only pay for a pointer.
+ */
+class RefCountedWeak : public RefCounted {
+    template <typename T>
+    friend class RefIntrusiveWeak;
+public:
+    RefCountedWeak() {}
+    virtual ~RefCountedWeak() override {
+        WeakFlag* flag = weak_flag.load(std::memory_order_acquire);
+        if (flag == nullptr) {
+            return;
+        }
+        {
+            // The weak references lock the flag before touching the count of the object.
+            std::lock_guard lock(flag->mutex);
+            flag->object = nullptr;
+        }
+        release_flag(flag);
+    }
+    RefCountedWeak(const RefCountedWeak& p_other)
+        : RefCounted(p_other) {}
+    RefCountedWeak& operator=(const RefCountedWeak&) {
+        return *this;
+    }
+
+private:
+    struct WeakFlag {
+        std::atomic<uint32_t> ref_count = 1;
+        std::mutex mutex;
+        RefCountedWeak* object;
+        void* allocator;
+        const RefCountedAllocatorOps* allocator_ops;
+    };
+
+    WeakFlag* acquire_flag() {
+        WeakFlag* flag = weak_flag.load(std::memory_order_acquire);
+        if (flag == nullptr) {
+            if (allocator == nullptr) {
+                throw std::runtime_error("Failed to create weak reference: the object is not owned by an allocator.");
+            }
+            MemID mem = allocator_ops->allocate(allocator, sizeof(WeakFlag), alignof(WeakFlag));
+            if (mem == MEM_NULL) {
+                throw std::runtime_error("Failed to create weak reference: allocation failed.");
+            }
+            WeakFlag* new_flag = new(reinterpret_cast<void*>(mem)) WeakFlag();
+            new_flag->object = this;
+            new_flag->allocator = allocator;
+            new_flag->allocator_ops = allocator_ops;
+            if (weak_flag.compare_exchange_strong(flag, new_flag, std::memory_order_acq_rel, std::memory_order_acquire)) {
+                flag = new_flag;
+            }
+            else {
+                // Another thread made the flag first.
+                new_flag->~WeakFlag();
+                allocator_ops->deallocate(allocator, mem);
+            }
+        }
+        flag->ref_count.fetch_add(1, std::memory_order_relaxed);
+        return flag;
+    }
+
+    static void release_flag(WeakFlag* p_flag) {
+        if (p_flag->ref_count.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+            return;
+        }
+        void* owner = p_flag->allocator;
+        const RefCountedAllocatorOps* owner_ops = p_flag->allocator_ops;
+        p_flag->~WeakFlag();
+        owner_ops->deallocate(owner, reinterpret_cast<MemID>(p_flag));
+    }
+
+    std::atomic<WeakFlag*> weak_flag = nullptr;
+};
+
+/**
+ * @class RefIntrusive
+ * @brief Strong reference to an object that counts its references itself. The reference is
+ * a single pointer, and copying it is one atomic operation on the object.
+ *
+ * @tparam T The type of the object. Should derive from RefCounted.
+ */
+template <typename T>
+class RefIntrusive {
+    template <typename T1>
+    friend class RefIntrusive;
+
+    template <typename T1>
+    friend class RefIntrusiveWeak;
+public:
+    using ObjType = T;
+
+    RefIntrusive()
+        : obj(nullptr) {}
+    ~RefIntrusive() {
+        release();
+    }
+    RefIntrusive(const RefIntrusive& p_other)
+        : obj(p_other.obj) {
+        add_ref();
+    }
+    RefIntrusive(RefIntrusive&& p_other) noexcept
+        : obj(p_other.obj) {
+        p_other.obj = nullptr;
+    }
+    RefIntrusive& operator=(const RefIntrusive& p_other) {
+        // Reference first, in case both refer to the same object.
+        p_other.add_ref();
+        release();
+        obj = p_other.obj;
+        return *this;
+    }
+    RefIntrusive& operator=(RefIntrusive&& p_other) noexcept {
+        if (this == &p_other) {
+            return *this;
+        }
+        release();
+        obj = p_other.obj;
+        p_other.obj = nullptr;
+        return *this;
+    }
+
+    RefIntrusive(std::nullptr_t)
+        : obj(nullptr) {}
+
+    /**
+     * @brief Reference an object, such as this in a member function of the object.
+     *
+     * @param p_obj The object to reference.
+     */
+    explicit RefIntrusive(T* p_obj)
+        : obj(p_obj) {
+        add_ref();
+    }
+
+    template <typename T1>
+        requires std::convertible_to<T1*, T*>
+    RefIntrusive(const RefIntrusive<T1>& p_other)
+        : obj(p_other.obj) {
+        add_ref();
+    }
+    template <typename T1>
+        requires std::convertible_to<T1*, T*>
+    RefIntrusive(RefIntrusive<T1>&& p_other)
+        : obj(p_other.obj) {
+        p_other.obj = nullptr;
+    }
+    template <typename T1>
+        requires std::convertible_to<T1*, T*>
+    RefIntrusive& operator=(const RefIntrusive<T1>& p_other) {
+        p_other.add_ref();
+        release();
+        obj = p_other.obj;
+        return *this;
+    }
+    template <typename T1>
+        requires std::convertible_to<T1*, T*>
+    RefIntrusive& operator=(RefIntrusive<T1>&& p_other) {
+        release();
+        obj = p_other.obj;
+        p_other.obj = nullptr;
+        return *this;
+    }
+
+    RefIntrusive& operator=(std::nullptr_t) {
+        release();
+        obj = nullptr;
+        return *this;
+    }
+
+    T* operator->() const {
+        WBE_DEBUG_ASSERT(obj != nullptr);
+        return obj;
+    }
+
+    T& operator*() const {
+        WBE_DEBUG_ASSERT(obj != nullptr);
+        return *obj;
+    }
+
+    /**
+     * @brief Get the object pointer.
+     *
+     * @return The pointer to the object. nullptr if the reference is NULL.
+     */
+    T* get() const {
+        return obj;
+    }
+
+    /**
+     * @brief Dynamic cast to a different type of reference.
+     *
+     * @tparam T1 The type to cast to.
+     * @return The casted reference. NULL if the cast fails.
+     */
+    template <typename T1>
+    RefIntrusive<T1> dynamic_cast_ref() const {
+        return RefIntrusive<T1>(dynamic_cast<T1*>(obj));
+    }
+
+    template <typename T1>
+    bool operator==(const RefIntrusive<T1>& p_other) const {
+        return obj == p_other.obj;
+    }
+
+    bool operator==(std::nullptr_t) const {
+        return is_null();
+    }
+
+    template <typename T1>
+    bool operator!=(const T1& p_obj) const {
+        return !(*this == p_obj);
+    }
+
+    /**
+     * @brief Is the reference NULL.
+     *
+     * @return true if the reference is NULL, false otherwise.
+     */
+    bool is_null() const {
+        return obj == nullptr;
+    }
+
+private:
+    struct AdoptTag {};
+
+    // Take over a reference that is already counted.
+    RefIntrusive(T* p_obj, AdoptTag)
+        : obj(p_obj) {}
+
+    void add_ref() const {
+        if (obj != nullptr) {
+            static_cast<const RefCounted*>(obj)->add_ref();
+        }
+    }
+
+    void release() {
+        if (obj != nullptr) {
+            static_cast<const RefCounted*>(obj)->release();
+            obj = nullptr;
+        }
+    }
+
+    T* obj;
+};
+
+/**
+ * @class RefIntrusiveWeak
+ * @brief Weak reference to an object that derives from RefCountedWeak.
+ *
+ * @tparam T The type of the object.
+ */
+template <typename T>
+class RefIntrusiveWeak {
+public:
+    using ObjType = T;
+
+    RefIntrusiveWeak()
+        : obj(nullptr), flag(nullptr) {}
+    ~RefIntrusiveWeak() {
+        release();
+    }
+    RefIntrusiveWeak(const RefIntrusiveWeak& p_other)
+        : obj(p_other.obj), flag(p_other.flag) {
+        if (flag != nullptr) {
+            flag->ref_count.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    RefIntrusiveWeak(RefIntrusiveWeak&& p_other) noexcept
+        : obj(p_other.obj), flag(p_other.flag) {
+        p_other.obj = nullptr;
+        p_other.flag = nullptr;
+    }
+    RefIntrusiveWeak& operator=(const RefIntrusiveWeak& p_other) {
+        if (p_other.flag != nullptr) {
+            p_other.flag->ref_count.fetch_add(1, std::memory_order_relaxed);
+        }
+        release();
+        obj = p_other.obj;
+        flag = p_other.flag;
+        return *this;
+    }
+    RefIntrusiveWeak& operator=(RefIntrusiveWeak&& p_other) noexcept {
+        if (this == &p_other) {
+            return *this;
+        }
+        release();
+        obj = p_other.obj;
+        flag = p_other.flag;
+        p_other.obj = nullptr;
+        p_other.flag = nullptr;
+        return *this;
+    }
+
+    /**
+     * @brief Weakly reference the object of a strong reference.
+     *
+     * @param p_ref The strong reference.
+     */
+    template <typename T1>
+        requires std::convertible_to<T1*, T*>
+    RefIntrusiveWeak(const RefIntrusive<T1>& p_ref)
+        : obj(p_ref.get()), flag(nullptr) {
+        static_assert(std::derived_from<T, RefCountedWeak>, "Weak references require the object to derive from RefCountedWeak.");
+        if (obj != nullptr) {
+            flag = static_cast<RefCountedWeak*>(obj)->acquire_flag();
+        }
+    }
+
+    /**
+     * @brief Get a strong reference to the object.
+     *
+     * @return The strong reference. NULL if the object is destroyed.
+     */
+    RefIntrusive<T> lock() const {
+        if (flag == nullptr) {
+            return RefIntrusive<T>();
+        }
+        std::lock_guard lock(flag->mutex);
+        if (flag->object == nullptr) {
+            return RefIntrusive<T>();
+        }
+        // The object could be released concurrently, only reference it if it is still referenced.
+        std::atomic<uint32_t>& ref_count = static_cast<RefCounted*>(flag->object)->ref_count;
+        uint32_t count = ref_count.load(std::memory_order_relaxed);
+        while (count != 0) {
+            if (ref_count.compare_exchange_weak(count, count + 1, std::memory_order_acquire, std::memory_order_relaxed)) {
+                return RefIntrusive<T>(obj, typename RefIntrusive<T>::AdoptTag());
+            }
+        }
+        return RefIntrusive<T>();
+    }
+
+    /**
+     * @brief Is the object still alive.
+     *
+     * @return true if the object is referenced, false otherwise.
+     */
+    bool is_valid() const {
+        if (flag == nullptr) {
+            return false;
+        }
+        std::lock_guard lock(flag->mutex);
+        return flag->object != nullptr && static_cast<RefCounted*>(flag->object)->get_ref_count() != 0;
+    }
+
+private:
+    using WeakFlag = RefCountedWeak::WeakFlag;
+
+    void release() {
+        if (flag != nullptr) {
+            RefCountedWeak::release_flag(flag);
+            flag = nullptr;
+        }
+        obj = nullptr;
+    }
+
+    T* obj;
+    WeakFlag* flag;
+};
+
+/**
+ * @brief Make an intrusively counted object with given constructor arguments.
+ *
+ * @tparam T The type of the object. Should derive from RefCounted.
+ * @tparam AllocType The type of the allocator. Its memory should not move.
+ * @tparam Args The argument types of the constructor.
+ * @param p_allocator The allocator to allocate the object.
+ * @param p_args The arguments of the constructor.
+ * @return The reference to the created object.
+ */
+template <typename T, typename AllocType, typename... Args>
+RefIntrusive<T> make_ref_intrusive(AllocType* p_allocator, Args&&... p_args) {
+    static_assert(std::derived_from<T, RefCounted>, "Intrusive references require the object to derive from RefCounted.");
+    static_assert(AllocatorAddrStable<AllocType>, "Intrusive references require an allocator whose memory does not move.");
+    if (p_allocator == nullptr) {
+        throw std::runtime_error("Allocator cannot be nullptr.");
+    }
+    const RefCountedAllocatorOps* ops = &REF_COUNTED_ALLOCATOR_OPS<AllocType>;
+    MemID mem = ops->allocate(p_allocator, sizeof(T), alignof(T));
+    if (mem == MEM_NULL) {
+        throw std::runtime_error("Failed to make reference: allocation failed.");
+    }
+    T* obj;
+    try {
+        obj = new(access_obj<void>(*p_allocator, mem)) T(std::forward<Args>(p_args)...);
+    }
+    catch (...) {
+        ops->deallocate(p_allocator, mem);
+        throw;
+    }
+    RefCounted* counted = obj;
+    counted->allocator = p_allocator;
+    counted->allocator_ops = ops;
+    return RefIntrusive<T>(obj);
+}
+
+}
+
+namespace std {
+/**
+ * @brief Hash function for intrusive reference.
+ *
+ * @tparam T The type of the reference.
+ */
+template <typename T>
+struct hash<::WhiteBirdEngine::RefIntrusive<T>> {
+    size_t operator()(const ::WhiteBirdEngine::RefIntrusive<T>& p_ref) const {
+        return std::hash<T*>{}(p_ref.get());
+    }
+};
+}
+
+#endif
@@ -182,22 +182,22 @@ public:
 
     T* operator->() {
         WBE_DEBUG_ASSERT(allocator != nullptr);
-        return static_cast<T*>(allocator->get(mem_id));
+        return access_obj<T>(*allocator, mem_id);
     }
 
     const T* operator->() const {
         WBE_DEBUG_ASSERT(allocator != nullptr);
-        return static_cast<T*>(allocator->get(mem_id));
+        return access_obj<T>(*allocator, mem_id);
     }
 
     T& operator*() {
         WBE_DEBUG_ASSERT(allocator != nullptr);
-        return *static_cast<T*>(allocator->get(mem_id));
+        return *access_obj<T>(*allocator, mem_id);
     }
 
     const T& operator*() const {
         WBE_DEBUG_ASSERT(allocator != nullptr);
-        return *static_cast<T*>(allocator->get(mem_id));
+        return *access_obj<T>(*allocator, mem_id);
     }
 
     /**
@@ -212,7 +212,7 @@ public:
         if (p_index >= num) {
             throw std::runtime_error(std::format("Failed to get instance at index: {}, index out of bounds.", p_index));
         }
-        return &(static_cast<T*>(allocator->get(mem_id))[p_index]);
+        return &(access_obj<T>(*allocator, mem_id)[p_index]);
     }
 
     /**
@@ -227,7 +227,7 @@ public:
         if (p_index >= num) {
             throw std::runtime_error(std::format("Failed to get instance at index: {}, index out of bounds.", p_index));
         }
-        return &(static_cast<const T*>(allocator->get(mem_id))[p_index]);
+        return &(access_obj<const T>(*allocator, mem_id)[p_index]);
     }
 
     template <typename T1, typename AllocType1>
@@ -265,7 +265,7 @@ public:
         if (p_index >= num) {
             throw std::runtime_error(std::format("Failed to get instance at index: {}, index out of bounds.", p_index));
         }
-        return static_cast<T*>(allocator->get(mem_id))[p_index];
+        return access_obj<T>(*allocator, mem_id)[p_index];
     }
 
     const T& operator[](size_t p_index) const {
@@ -275,7 +275,7 @@ public:
         if (p_index >= num) {
             throw std::runtime_error(std::format("Failed to get instance at index: {}, index out of bounds.", p_index));
         }
-        return static_cast<const T*>(allocator->get(mem_id))[p_index];
+        return access_obj<const T>(*allocator, mem_id)[p_index];
     }
 
     /**
@@ -17,30 +17,111 @@
 
 #include "core/allocator/allocator.hh"
 #include "core/allocator/heap_allocator.hh"
+#include "core/memory/ref_destruction_queue.hh"
 #include "utils/defs.hh"
+#include "utils/utils.hh"
+#include <algorithm>
 #include <atomic>
+#include <concepts>
 #include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <stdexcept>
 
 namespace WhiteBirdEngine {
 
+template <typename T, typename AllocType>
+class AtomicRef;
+
+/**
+ * @brief Reference counting of references that could be shared between threads.
+ */
+struct RefPolicyAtomic {
+    using Counter = std::atomic<uint64_t>;
+
+    static void increment(Counter& r_counter) {
+        // A new reference is always made from an existing one, nothing to synchronize with.
+        r_counter.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    static uint64_t decrement(Counter& r_counter) {
+        return r_counter.fetch_sub(1, std::memory_order_acq_rel);
+    }
+
+    static uint64_t load(const Counter& p_counter) {
+        return p_counter.load(std::memory_order_acquire);
+    }
+
+    static bool increment_if_not_zero(Counter& r_counter) {
+        uint64_t count = r_counter.load(std::memory_order_relaxed);
+        while (count != 0) {
+            if (r_counter.compare_exchange_weak(count, count + 1, std::memory_order_acquire, std::memory_order_relaxed)) {
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+/**
+ * @brief Reference counting of references that never leave the thread that created them.
+ */
+struct RefPolicyNonAtomic {
+    using Counter = uint64_t;
+
+    static void increment(Counter& r_counter) {
+        ++r_counter;
+    }
+
+    static uint64_t decrement(Counter& r_counter) {
+        return r_counter--;
+    }
+
+    static uint64_t load(const Counter& p_counter) {
+        return p_counter;
+    }
+
+    static bool increment_if_not_zero(Counter& r_counter) {
+        if (r_counter == 0) {
+            return false;
+        }
+        ++r_counter;
+        return true;
+    }
+};
+
+template <typename T>
+concept RefPolicyConcept = requires(typename T::Counter& r_counter, const typename T::Counter& p_counter) {
+    T::increment(r_counter);
+    { T::decrement(r_counter) } -> std::same_as<uint64_t>;
+    { T::load(p_counter) } -> std::same_as<uint64_t>;
+    { T::increment_if_not_zero(r_counter) } -> std::same_as<bool>;
+};
+
 /**
  * @class Ref
  * @brief The reference to a memory resource.
  *
+ * The strong references together hold one weak reference to the control block, so copying
+ * and releasing a strong reference only touches the strong counter. The weak counter is only
+ * touched by the weak references and when the last strong reference is released.
+ *
  * @tparam T The type of the resource.
  * @tparam AllocType The type of the allocator.
+ * @tparam ThreadPolicy How the references are counted, RefPolicyAtomic or RefPolicyNonAtomic.
  */
-template <typename T, typename AllocType = HeapAllocator>
+template <typename T, typename AllocType = HeapAllocator, RefPolicyConcept ThreadPolicy = RefPolicyAtomic>
 class Ref {
-    template <typename T1, typename AllocType1>
+    template <typename T1, typename AllocType1, RefPolicyConcept ThreadPolicy1>
     friend class Ref;
 
-    template <typename T1, typename AllocTYpe1>
+    template <typename T1, typename AllocType1, RefPolicyConcept ThreadPolicy1>
     friend class RefWeak;
 
-    friend struct ::std::hash<Ref<T, AllocType>>;
+    template <typename T1, typename AllocType1>
+    friend class AtomicRef;
+
+    friend struct ::std::hash<Ref<T, AllocType, ThreadPolicy>>;
 
     struct ControlBlock;
 public:
@@ -91,19 +172,19 @@ public:
 
     template <typename T1, typename AllocType1>
         requires std::convertible_to<T1*, T*> && std::convertible_to<AllocType1*, AllocType*>
-    Ref(const Ref<T1, AllocType1>& p_other) {
+    Ref(const Ref<T1, AllocType1, ThreadPolicy>& p_other) {
         p_other.ref();
         control_block = reinterpret_cast<ControlBlock*>(p_other.control_block);
     }
     template <typename T1, typename AllocType1>
         requires std::convertible_to<T1*, T*> && std::convertible_to<AllocType1*, AllocType*>
-    Ref(Ref<T1, AllocType1>&& p_other) {
+    Ref(Ref<T1, AllocType1, ThreadPolicy>&& p_other) {
         control_block = reinterpret_cast<ControlBlock*>(p_other.control_block);
         p_other.control_block = nullptr;
     }
     template <typename T1, typename AllocType1>
         requires std::convertible_to<T1*, T*> && std::convertible_to<AllocType1*, AllocType*>
-    Ref& operator=(const Ref<T1, AllocType1>& p_other) {
+    Ref& operator=(const Ref<T1, AllocType1, ThreadPolicy>& p_other) {
         if (*this == p_other) {
             return *this;
         }
@@ -114,7 +195,7 @@ public:
     }
     template <typename T1, typename AllocType1>
         requires std::convertible_to<T1*, T*> && std::convertible_to<AllocType1*, AllocType*>
-    Ref& operator=(Ref<T1, AllocType1>&& p_other) {
+    Ref& operator=(Ref<T1, AllocType1, ThreadPolicy>&& p_other) {
         if (*this == p_other) {
             return *this;
         }
@@ -147,19 +228,32 @@ public:
     /**
      * @brief Create a reference with a given allocator and memory ID.
      *
+     * @note Allocators that declare moving addresses are rejected, the control block is
+     * referenced by its address.
+     *
      * @param p_allocator The allocator that allocated the memory for memory ID.
      * @param p_mem_id The memory ID.
      */
-    Ref(AllocType* p_allocator, MemID p_mem_id) {
+    Ref(AllocType* p_allocator, MemID p_mem_id)
+        requires (!AllocatorAddrMoves<AllocType>) {
         WBE_DEBUG_ASSERT(p_allocator != nullptr);
         MemID control_block_mem_id = create_obj<ControlBlock>(*(p_allocator), p_allocator, p_mem_id);
-        control_block = p_allocator->template get_obj<ControlBlock>(control_block_mem_id);
+        control_block = access_obj<ControlBlock>(*p_allocator, control_block_mem_id);
         control_block->control_block_mem_id = control_block_mem_id;
+        if constexpr (AllocatorAddrStable<AllocType>) {
+            // The object never moves, skip the allocator on access.
+            control_block->obj_ptr = access_obj<void>(*p_allocator, p_mem_id);
+        }
         ref();
     }
 
     /**
-     * @brief Make a reference with given constructor arguments.
+     * @brief Make a reference with given constructor arguments. If the allocator does not move
+     * addresses, the control block and the object are allocated in one block, and freed together
+     * when both the strong and the weak references are gone. Otherwise they are allocated apart,
+     * and the object is reached through the allocator.
+     * @note Allocators that declare moving addresses are rejected, the control block is
+     * referenced by its address.
      *
      * @tparam Args The argument types of the constructor.
      * @param p_allocator The allocator to allocate the object.
@@ -167,32 +261,94 @@ public:
      * @return The created reference.
      */
     template <typename... Args>
-    static Ref<T, AllocType> make_ref(AllocType* p_allocator, Args&&... p_args) {
-        return Ref(p_allocator, create_obj<T>(*p_allocator, std::forward<Args>(p_args)...));
+    static Ref make_ref(AllocType* p_allocator, Args&&... p_args)
+        requires (!AllocatorAddrMoves<AllocType>) {
+        WBE_DEBUG_ASSERT(p_allocator != nullptr);
+        if constexpr (!AllocatorAddrStable<AllocType>) {
+            // The address of the object could not be kept, the control block only holds its memory ID.
+            MemID obj_mem_id = allocate_for(p_allocator, sizeof(T), alignof(T));
+            try {
+                new(access_obj<T>(*p_allocator, obj_mem_id)) T(std::forward<Args>(p_args)...);
+            }
+            catch (...) {
+                p_allocator->deallocate(obj_mem_id);
+                throw;
+            }
+            try {
+                return Ref(p_allocator, obj_mem_id);
+            }
+            catch (...) {
+                destroy_obj<T>(*p_allocator, obj_mem_id);
+                throw;
+            }
+        }
+        else {
+            return make_fused_ref(p_allocator, std::forward<Args>(p_args)...);
+        }
     }
 
+private:
+    template <typename... Args>
+    static Ref make_fused_ref(AllocType* p_allocator, Args&&... p_args) {
+        constexpr size_t FUSED_OBJ_OFFSET = get_align_size(sizeof(ControlBlock), alignof(T));
+        constexpr size_t FUSED_BLOCK_SIZE = FUSED_OBJ_OFFSET + sizeof(T);
+        constexpr size_t FUSED_BLOCK_ALIGNMENT = std::max({alignof(ControlBlock), alignof(T), (size_t)WBE_DEFAULT_ALIGNMENT});
+        MemID block_mem_id = allocate_for(p_allocator, FUSED_BLOCK_SIZE, FUSED_BLOCK_ALIGNMENT);
+        char* block = access_obj<char>(*p_allocator, block_mem_id);
+        // The allocator never moves the block, so the pointer to the object could be kept.
+        ControlBlock* fused_control_block = new(block) ControlBlock(p_allocator, block_mem_id);
+        fused_control_block->control_block_mem_id = block_mem_id;
+        fused_control_block->obj_ptr = block + FUSED_OBJ_OFFSET;
+        fused_control_block->is_fused = true;
+        try {
+            new(block + FUSED_OBJ_OFFSET) T(std::forward<Args>(p_args)...);
+        }
+        catch (...) {
+            p_allocator->deallocate(block_mem_id);
+            throw;
+        }
+        return Ref(fused_control_block);
+    }
+
+    // Allocate the memory of a reference, aligned if the allocator supports it.
+    static MemID allocate_for(AllocType* p_allocator, size_t p_size, size_t p_alignment) {
+        MemID result;
+        if constexpr (requires { p_allocator->allocate(p_size, p_alignment); }) {
+            result = p_allocator->allocate(p_size, p_alignment);
+        }
+        else {
+            result = p_allocator->allocate(p_size);
+        }
+        if (result == MEM_NULL) {
+            throw std::runtime_error("Failed to make reference: allocation failed.");
+        }
+        return result;
+    }
+
+public:
+
     T* operator->() {
         WBE_DEBUG_ASSERT(control_block != nullptr);
         WBE_DEBUG_ASSERT(control_block->allocator != nullptr);
-        return static_cast<T*>(control_block->allocator->get(control_block->mem_id));
+        return get_obj_ptr();
     }
 
     const T* operator->() const {
         WBE_DEBUG_ASSERT(control_block != nullptr);
         WBE_DEBUG_ASSERT(control_block->allocator != nullptr);
-        return static_cast<T*>(control_block->allocator->get(control_block->mem_id));
+        return get_obj_ptr();
     }
 
     T& operator*() {
         WBE_DEBUG_ASSERT(control_block != nullptr);
         WBE_DEBUG_ASSERT(control_block->allocator != nullptr);
-        return *static_cast<T*>(control_block->allocator->get(control_block->mem_id));
+        return *get_obj_ptr();
     }
 
     const T& operator*() const {
         WBE_DEBUG_ASSERT(control_block != nullptr);
         WBE_DEBUG_ASSERT(control_block->allocator != nullptr);
-        return *static_cast<const T*>(control_block->allocator->get(control_block->mem_id));
+        return *get_obj_ptr();
     }
 
     /**
@@ -205,7 +361,7 @@ public:
             return nullptr;
         }
         WBE_DEBUG_ASSERT(control_block->allocator != nullptr);
-        return static_cast<T*>(control_block->allocator->get(control_block->mem_id));
+        return get_obj_ptr();
     }
 
     /**
@@ -218,7 +374,7 @@ public:
             return nullptr;
         }
         WBE_DEBUG_ASSERT(control_block->allocator != nullptr);
-        return static_cast<T*>(control_block->allocator->get(control_block->mem_id));
+        return get_obj_ptr();
     }
 
     /**
@@ -229,20 +385,20 @@ public:
      * @return The casted reference. MEM_NULL if the cast fails.
      */
     template <typename T1>
-    Ref<T1, AllocType> dynamic_cast_ref() const {
+    Ref<T1, AllocType, ThreadPolicy> dynamic_cast_ref() const {
         if (control_block == nullptr || control_block->allocator == nullptr) {
-            return Ref<T1, AllocType>(nullptr);
+            return Ref<T1, AllocType, ThreadPolicy>(nullptr);
         }
-        T1* casted_ptr = dynamic_cast<T1*>(static_cast<T*>(control_block->allocator->get(control_block->mem_id)));
+        T1* casted_ptr = dynamic_cast<T1*>(get_obj_ptr());
         if (casted_ptr == nullptr) {
             return MEM_NULL;
         }
-        return Ref<T1, AllocType>(reinterpret_cast<typename Ref<T1, AllocType>::ControlBlock*>(control_block));
+        return Ref<T1, AllocType, ThreadPolicy>(reinterpret_cast<typename Ref<T1, AllocType, ThreadPolicy>::ControlBlock*>(control_block));
     }
 
 
     template <typename T1, typename AllocType1>
-    bool operator==(const Ref<T1, AllocType1>& p_other) const {
+    bool operator==(const Ref<T1, AllocType1, ThreadPolicy>& p_other) const {
         return control_block == reinterpret_cast<decltype(control_block)>(p_other.control_block);
     }
 
@@ -278,6 +434,29 @@ public:
         return control_block == nullptr || control_block->mem_id == MEM_NULL;
     }
 
+    /**
+     * @brief Give up the reference as an opaque handle, for the lock-free containers that
+     * could only store a pointer atomically. The reference becomes NULL.
+     *
+     * @return The handle, nullptr if the reference is NULL. Has to be taken back exactly once
+     * with attach.
+     */
+    void* detach() {
+        ControlBlock* result = control_block;
+        control_block = nullptr;
+        return result;
+    }
+
+    /**
+     * @brief Take back a reference given up by detach.
+     *
+     * @param p_handle The handle returned by detach.
+     * @return The reference.
+     */
+    static Ref attach(void* p_handle) {
+        return Ref(static_cast<ControlBlock*>(p_handle), AdoptTag{});
+    }
+
 private:
 
     Ref(ControlBlock* p_control_block)
@@ -285,75 +464,119 @@ private:
         ref();
     }
 
+    struct AdoptTag {};
+
+    // Take over a strong reference that is already counted.
+    Ref(ControlBlock* p_control_block, AdoptTag)
+        : control_block(p_control_block) {}
+
     struct ControlBlock {
         ControlBlock(AllocType* p_alloc_type, MemID p_mem_id)
-            : mem_id(p_mem_id), allocator(p_alloc_type) {
-            weak_ref_counter.store(0, std::memory_order_release);
-            strong_ref_counter.store(0, std::memory_order_release);
-        }
+            : mem_id(p_mem_id), allocator(p_alloc_type) {}
         MemID control_block_mem_id;
+        // The memory ID of the object, or of the whole block if the object is fused.
         MemID mem_id;
         AllocType* allocator;
-        std::atomic<uint64_t> weak_ref_counter;
-        std::atomic<uint64_t> strong_ref_counter;
+        // The pointer to the object if its address never moves, nullptr otherwise.
+        void* obj_ptr = nullptr;
+        // The weak references, plus one held by all the strong references together.
+        typename ThreadPolicy::Counter weak_ref_counter = 1;
+        typename ThreadPolicy::Counter strong_ref_counter = 0;
+        // Is the object allocated in the same block after the control block.
+        bool is_fused = false;
     };
 
+    T* get_obj_ptr() const {
+        if constexpr (AllocatorAddrStable<AllocType>) {
+            // Always cached, the access is a plain load.
+            return static_cast<T*>(control_block->obj_ptr);
+        }
+        else {
+            if (control_block->obj_ptr != nullptr) {
+                return static_cast<T*>(control_block->obj_ptr);
+            }
+            return static_cast<T*>(control_block->allocator->get(control_block->mem_id));
+        }
+    }
+
     void ref() const {
         if (control_block == nullptr) {
             return;
         }
-        control_block->strong_ref_counter.fetch_add(1, std::memory_order_release);
-        // For all strong reference, create a hidden weak reference, since only weak reference could destruct control block.
-        control_block->weak_ref_counter.fetch_add(1, std::memory_order_release);
+        ThreadPolicy::increment(control_block->strong_ref_counter);
     }
 
     void deref() const {
         if (control_block == nullptr) {
             return;
         }
-        if (control_block->strong_ref_counter.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        if (ThreadPolicy::decrement(control_block->strong_ref_counter) == 1) {
             // If all the references of the control block is freed, destroy the object.
-            destroy_obj<T>(*(control_block->allocator), control_block->mem_id);
+            on_released(control_block);
         }
-        // Dereference the hidden weak reference.
-        weak_deref();
         control_block = nullptr;
     }
 
-    void weak_deref() const {
-        uint32_t weak_ref_count = control_block->weak_ref_counter.fetch_sub(1, std::memory_order_acq_rel);
-        if (weak_ref_count == 1 && control_block->strong_ref_counter.load(std::memory_order_acquire) == 0) {
-            // If this is the last weak reference referencing this, and no strong reference is referencing this, destroy the control block.
-            destroy_obj<typename Ref<T>::ControlBlock>(*(control_block->allocator), control_block->control_block_mem_id);
+    // Called when the last strong reference of a control block is released.
+    static void on_released(ControlBlock* p_control_block) {
+        if (RefDestructionQueue::is_thread_deferred()) {
+            // Destroyed at the next drain of this thread, weak references are already invalid.
+            RefDestructionQueue::get_thread_queue().push(p_control_block, &Ref::destroy);
+        }
+        else {
+            destroy(p_control_block);
+        }
+    }
+
+    // Destroy the object of a control block no strong reference is referencing.
+    static void destroy(void* p_control_block) {
+        ControlBlock* block = static_cast<ControlBlock*>(p_control_block);
+        if (block->is_fused) {
+            // The memory is freed with the control block.
+            static_cast<T*>(block->obj_ptr)->~T();
+        }
+        else {
+            destroy_obj<T>(*(block->allocator), block->mem_id);
+        }
+        // Release the weak reference held by the strong references.
+        if (ThreadPolicy::decrement(block->weak_ref_counter) == 1) {
+            // If this is the last weak reference, no strong reference is left either, destroy the control block.
+            destroy_obj<ControlBlock>(*(block->allocator), block->control_block_mem_id);
         }
-        control_block = nullptr;
     }
 
     mutable ControlBlock* control_block;
 };
 
-template <typename T>
-concept ThisRefAsignable = requires(T* p_ins, Ref<T> p_ref) {
+template <typename T, typename RefType = Ref<T>>
+concept ThisRefAsignable = requires(T* p_ins, RefType p_ref) {
     p_ins->set_ref_of_this(p_ref);
 };
 
+/**
+ * @brief Reference that is only used by one thread, counted without atomic operations.
+ */
+template <typename T, typename AllocType = HeapAllocator>
+using RefLocal = Ref<T, AllocType, RefPolicyNonAtomic>;
+
 /**
  * @brief Make a reference with given constructor arguments.
  *
  * @tparam T The type that is created.
+ * @tparam ThreadPolicy How the references are counted.
  * @tparam Args The argument types of the constructor.
  * @param p_allocator The allocator to allocate the object.
  * @param p_args The arguments of the constructor.
  * @return The created reference.
  */
-template <typename T, typename AllocType = HeapAllocator, typename... Args>
-Ref<T, AllocType> make_ref(AllocType* p_allocator, Args&&... p_args) {
+template <typename T, typename AllocType = HeapAllocator, RefPolicyConcept ThreadPolicy = RefPolicyAtomic, typename... Args>
+    requires (!AllocatorAddrMoves<AllocType>)
+Ref<T, AllocType, ThreadPolicy> make_ref(AllocType* p_allocator, Args&&... p_args) {
     if (p_allocator == nullptr) {
         throw std::runtime_error("Allocator cannot be nullptr.");
     }
-    MemID id = create_obj<T>(*p_allocator, std::forward<Args>(p_args)...);
-    Ref<T, AllocType> result(p_allocator, id);
-    if constexpr (ThisRefAsignable<T>) {
+    Ref<T, AllocType, ThreadPolicy> result = Ref<T, AllocType, ThreadPolicy>::make_ref(p_allocator, std::forward<Args>(p_args)...);
+    if constexpr (ThisRefAsignable<T, Ref<T, AllocType, ThreadPolicy>>) {
         result->set_ref_of_this(result);
     }
     return result;
@@ -369,9 +592,9 @@ namespace std {
  * @param p_ref The reference to hash.
  * @return 
  */
-template <typename T, typename AllocType>
-struct hash<::WhiteBirdEngine::Ref<T, AllocType>> {
-    size_t operator()(const ::WhiteBirdEngine::Ref<T, AllocType>& p_ref) const {
+template <typename T, typename AllocType, typename ThreadPolicy>
+struct hash<::WhiteBirdEngine::Ref<T, AllocType, ThreadPolicy>> {
+    size_t operator()(const ::WhiteBirdEngine::Ref<T, AllocType, ThreadPolicy>& p_ref) const {
         if (p_ref.is_null()) {
             return WhiteBirdEngine::MEM_NULL;
         }
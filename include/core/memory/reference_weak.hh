@@ -22,8 +22,20 @@
 
 namespace WhiteBirdEngine {
 
-template <typename T, typename AllocType = HeapAllocator>
+/**
+ * @class RefWeak
+ * @brief Weak reference to a memory resource referenced by Ref.
+ *
+ * @tparam T The type of the resource.
+ * @tparam AllocType The type of the allocator.
+ * @tparam ThreadPolicy How the references are counted, the same as the strong references.
+ */
+template <typename T, typename AllocType = HeapAllocator, RefPolicyConcept ThreadPolicy = RefPolicyAtomic>
 class RefWeak {
+    template <typename T1, typename AllocType1, RefPolicyConcept ThreadPolicy1>
+    friend class RefWeak;
+
+    friend struct ::std::hash<RefWeak<T, AllocType, ThreadPolicy>>;
 public:
     using ObjType = T;
 
@@ -32,17 +44,17 @@ public:
     ~RefWeak() {
         deref();
     }
-    RefWeak(const RefWeak<T, AllocType>& p_other) {
+    RefWeak(const RefWeak<T, AllocType, ThreadPolicy>& p_other) {
         WBE_DEBUG_ASSERT(p_other.control_block != nullptr);
         p_other.ref();
         control_block = p_other.control_block;
     }
-    RefWeak(RefWeak<T, AllocType>&& p_other) {
+    RefWeak(RefWeak<T, AllocType, ThreadPolicy>&& p_other) {
         WBE_DEBUG_ASSERT(p_other.control_block != nullptr);
         control_block = p_other.control_block;
         p_other.control_block = nullptr;
     }
-    RefWeak& operator=(const RefWeak<T, AllocType>& p_other) {
+    RefWeak& operator=(const RefWeak<T, AllocType, ThreadPolicy>& p_other) {
         WBE_DEBUG_ASSERT(p_other.control_block != nullptr);
         if (*this == p_other) {
             return *this;
@@ -52,7 +64,7 @@ public:
         control_block = p_other.control_block;
         return *this;
     }
-    RefWeak& operator=(RefWeak<T, AllocType>&& p_other) {
+    RefWeak& operator=(RefWeak<T, AllocType, ThreadPolicy>&& p_other) {
         WBE_DEBUG_ASSERT(p_other.control_block != nullptr);
         if (*this == p_other) {
             return *this;
@@ -62,12 +74,12 @@ public:
         p_other.control_block = nullptr;
         return *this;
     }
-    RefWeak(const Ref<T, AllocType>& p_ref) {
+    RefWeak(const Ref<T, AllocType, ThreadPolicy>& p_ref) {
         WBE_DEBUG_ASSERT(p_ref.control_block != nullptr);
         control_block = p_ref.control_block;
         ref();
     }
-    RefWeak& operator=(const Ref<T, AllocType>& p_ref) {
+    RefWeak& operator=(const Ref<T, AllocType, ThreadPolicy>& p_ref) {
         WBE_DEBUG_ASSERT(p_ref.control_block != nullptr);
         deref();
         control_block = p_ref.control_block;
@@ -77,7 +89,7 @@ public:
 
     template <typename T1, typename AllocType1>
         requires std::convertible_to<T1*, T*> && std::convertible_to<AllocType1*, AllocType*>
-    RefWeak(const RefWeak<T1, AllocType1>& p_other) {
+    RefWeak(const RefWeak<T1, AllocType1, ThreadPolicy>& p_other) {
         WBE_DEBUG_ASSERT(p_other.control_block != nullptr);
         p_other.ref();
         control_block = reinterpret_cast<decltype(control_block)>(p_other.control_block);
@@ -85,7 +97,7 @@ public:
 
     template <typename T1, typename AllocType1>
         requires std::convertible_to<T1*, T*> && std::convertible_to<AllocType1*, AllocType*>
-    RefWeak(RefWeak<T1, AllocType1>&& p_other) {
+    RefWeak(RefWeak<T1, AllocType1, ThreadPolicy>&& p_other) {
         WBE_DEBUG_ASSERT(p_other.control_block != nullptr);
         control_block = reinterpret_cast<decltype(control_block)>(p_other.control_block);
         p_other.control_block = nullptr;
@@ -93,7 +105,7 @@ public:
 
     template <typename T1, typename AllocType1>
         requires std::convertible_to<T1*, T*> && std::convertible_to<AllocType1*, AllocType*>
-    RefWeak(const Ref<T1, AllocType1>& p_ref) {
+    RefWeak(const Ref<T1, AllocType1, ThreadPolicy>& p_ref) {
         WBE_DEBUG_ASSERT(p_ref.control_block != nullptr);
         control_block = reinterpret_cast<decltype(control_block)>(p_ref.control_block);
         ref();
@@ -101,7 +113,7 @@ public:
 
     template <typename T1, typename AllocType1>
         requires std::convertible_to<T1*, T*> && std::convertible_to<AllocType1*, AllocType*>
-    RefWeak& operator=(const RefWeak<T1, AllocType1>& p_other) {
+    RefWeak& operator=(const RefWeak<T1, AllocType1, ThreadPolicy>& p_other) {
         WBE_DEBUG_ASSERT(p_other.control_block != nullptr);
         if (*this == p_other) {
             return *this;
@@ -113,7 +125,7 @@ public:
     }
     template <typename T1, typename AllocType1>
         requires std::convertible_to<T1*, T*> && std::convertible_to<AllocType1*, AllocType*>
-    RefWeak& operator=(RefWeak<T1, AllocType1>&& p_other) {
+    RefWeak& operator=(RefWeak<T1, AllocType1, ThreadPolicy>&& p_other) {
         WBE_DEBUG_ASSERT(p_other.control_block != nullptr);
         if (*this == p_other) {
             return *this;
@@ -126,7 +138,7 @@ public:
 
     template <typename T1, typename AllocType1>
         requires std::convertible_to<T1*, T*> && std::convertible_to<AllocType1*, AllocType*>
-    RefWeak& operator=(const Ref<T1, AllocType1>& p_ref) {
+    RefWeak& operator=(const Ref<T1, AllocType1, ThreadPolicy>& p_ref) {
         WBE_DEBUG_ASSERT(p_ref.control_block != nullptr);
         deref();
         control_block = reinterpret_cast<decltype(control_block)>(p_ref.control_block);
@@ -134,18 +146,20 @@ public:
         return *this;
     }
 
-    Ref<T> lock() {
-        if (!is_valid()) {
-            return Ref<T>(nullptr);
+    Ref<T, AllocType, ThreadPolicy> lock() {
+        // Only reference the object if it is still referenced, it could be released concurrently.
+        if (control_block == nullptr || !ThreadPolicy::increment_if_not_zero(control_block->strong_ref_counter)) {
+            return Ref<T, AllocType, ThreadPolicy>(nullptr);
         }
-        return Ref<T>(control_block);
+        return Ref<T, AllocType, ThreadPolicy>(control_block, typename Ref<T, AllocType, ThreadPolicy>::AdoptTag());
     }
 
-    Ref<const T> lock() const {
-        if (!is_valid()) {
-            return Ref<const T>(nullptr);
+    Ref<const T, AllocType, ThreadPolicy> lock() const {
+        using ConstRef = Ref<const T, AllocType, ThreadPolicy>;
+        if (control_block == nullptr || !ThreadPolicy::increment_if_not_zero(control_block->strong_ref_counter)) {
+            return ConstRef(nullptr);
         }
-        return Ref<const T>(control_block);
+        return ConstRef(reinterpret_cast<typename ConstRef::ControlBlock*>(control_block), typename ConstRef::AdoptTag());
     }
 
     /**
@@ -154,11 +168,11 @@ public:
      * @return True if the reference is valid, false otherwise.
      */
     bool is_valid() const {
-        return control_block != nullptr && control_block->strong_ref_counter.load(std::memory_order_acquire) != 0;
+        return control_block != nullptr && ThreadPolicy::load(control_block->strong_ref_counter) != 0;
     }
 
-    template <typename T1>
-    bool operator==(const RefWeak<T1>& p_other) const {
+    template <typename T1, typename AllocType1>
+    bool operator==(const RefWeak<T1, AllocType1, ThreadPolicy>& p_other) const {
         return control_block == reinterpret_cast<decltype(control_block)>(p_other.control_block);
     }
 
@@ -172,23 +186,22 @@ public:
     }
 
 private:
-    mutable Ref<T>::ControlBlock* control_block;
+    mutable Ref<T, AllocType, ThreadPolicy>::ControlBlock* control_block;
 
     void ref() const {
         if (control_block == nullptr) {
             return;
         }
-        control_block->weak_ref_counter.fetch_add(1, std::memory_order_release);
+        ThreadPolicy::increment(control_block->weak_ref_counter);
     }
 
     void deref() const {
         if (control_block == nullptr) {
             return;
         }
-        uint32_t weak_ref_count = control_block->weak_ref_counter.fetch_sub(1, std::memory_order_acq_rel);
-        if (weak_ref_count == 1 && control_block->strong_ref_counter.load(std::memory_order_acquire) == 0) {
-            // If this is the last weak reference referencing this, and no strong reference is referencing this, destroy the control block.
-            destroy_obj<typename Ref<T>::ControlBlock>(*(control_block->allocator), control_block->control_block_mem_id);
+        if (ThreadPolicy::decrement(control_block->weak_ref_counter) == 1) {
+            // If this is the last weak reference, no strong reference is left either, destroy the control block.
+            destroy_obj<typename Ref<T, AllocType, ThreadPolicy>::ControlBlock>(*(control_block->allocator), control_block->control_block_mem_id);
         }
         control_block = nullptr;
     }
@@ -204,9 +217,9 @@ namespace std {
  * @param p_ref The reference to hash.
  * @return 
  */
-template <typename T, typename AllocType>
-struct hash<::WhiteBirdEngine::RefWeak<T, AllocType>> {
-    size_t operator()(const ::WhiteBirdEngine::RefWeak<T, AllocType>& p_ref) {
+template <typename T, typename AllocType, typename ThreadPolicy>
+struct hash<::WhiteBirdEngine::RefWeak<T, AllocType, ThreadPolicy>> {
+    size_t operator()(const ::WhiteBirdEngine::RefWeak<T, AllocType, ThreadPolicy>& p_ref) const {
         if (p_ref.is_null()) {
             return WhiteBirdEngine::MEM_NULL;
         }
@@ -0,0 +1,309 @@
+/* Copyright 2025 OppositeNor
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef __WBE_SLOT_MAP_HH__
+#define __WBE_SLOT_MAP_HH__
+
+#include "core/core_utils.hh"
+#include "global/stl_allocator.hh"
+#include "utils/defs.hh"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+namespace WhiteBirdEngine {
+
+/**
+ * @brief Handle to an element of a SlotMap. The generation tells apart the elements that
+ * used the same slot, so a handle to an erased element never reaches a newer one.
+ */
+struct SlotMapHandle {
+    uint32_t index = 0;
+    // Generation 0 is never used by a slot, the default handle is NULL.
+    uint32_t generation = 0;
+
+    bool operator==(const SlotMapHandle&) const = default;
+
+    /**
+     * @brief Is the handle NULL.
+     *
+     * @return true if the handle is NULL, false otherwise.
+     */
+    bool is_null() const {
+        return generation == 0;
+    }
+};
+
+/**
+ * @class SlotMap
+ * @brief Container of elements referenced by generational handles, with the elements kept
+ * densely packed for iteration. Like HeapAllocatorFixedSizePool, erasing an element moves the
+ * last element into its place, and the handles are mapped to the elements through an index.
+ *
+ * Insertion, erasure and lookup are O(1). Iterating visits the elements in their packed order,
+ * which changes when elements are erased.
+ *
+ * @tparam T The type of the elements.
+ * @tparam AllocType The type of the allocator of the storage.
+ */
+template <typename T, typename AllocType = HeapAllocatorDefault>
+class SlotMap final {
+public:
+    using Handle = SlotMapHandle;
+    using iterator = T*;
+    using const_iterator = const T*;
+
+    /**
+     * @brief The maximum number of elements the map can hold.
+     */
+    static constexpr uint64_t MAX_OBJ = std::numeric_limits<uint32_t>::max() - 1;
+
+    ~SlotMap() {}
+    SlotMap(const SlotMap&) = delete;
+    SlotMap(SlotMap&&) = delete;
+    SlotMap& operator=(const SlotMap&) = delete;
+    SlotMap& operator=(SlotMap&&) = delete;
+
+    /**
+     * @brief Constructor.
+     *
+     * @param p_allocator The allocator of the storage.
+     */
+    SlotMap(AllocType* p_allocator)
+        : data(p_allocator), data_slots(p_allocator), slots(p_allocator) {}
+
+    /**
+     * @brief Insert an element constructed in place.
+     *
+     * @tparam Args The argument types of the constructor.
+     * @param p_args The arguments of the constructor.
+     * @return The handle to the element.
+     */
+    template <typename... Args>
+    Handle emplace(Args&&... p_args) {
+        if (data.size() >= MAX_OBJ) {
+            throw std::runtime_error("Failed to insert element: slot map only allows a maximum of " + std::to_string(MAX_OBJ) + " elements.");
+        }
+        bool is_new_slot = free_head == FREE_END;
+        uint32_t slot_index = is_new_slot ? static_cast<uint32_t>(slots.size()) : free_head;
+        if (is_new_slot) {
+            slots.push_back(Slot{ FREE_END, 1 });
+        }
+        data_slots.push_back(slot_index);
+        try {
+            data.emplace_back(std::forward<Args>(p_args)...);
+        }
+        catch (...) {
+            data_slots.pop_back();
+            if (is_new_slot) {
+                slots.pop_back();
+            }
+            throw;
+        }
+        Slot& slot = slots[slot_index];
+        if (!is_new_slot) {
+            // Pop the slot from the free list, the index of a free slot links to the next one.
+            free_head = slot.data_index;
+        }
+        slot.data_index = static_cast<uint32_t>(data.size() - 1);
+        return Handle{ slot_index, slot.generation };
+    }
+
+    Handle insert(const T& p_value) {
+        return emplace(p_value);
+    }
+
+    Handle insert(T&& p_value) {
+        return emplace(std::move(p_value));
+    }
+
+    /**
+     * @brief Erase an element. The last element is moved into its place.
+     *
+     * @param p_handle The handle to the element.
+     * @return true if the element is erased, false if the handle is stale or NULL.
+     */
+    bool erase(Handle p_handle) {
+        if (!contains(p_handle)) {
+            return false;
+        }
+        Slot& slot = slots[p_handle.index];
+        uint32_t data_index = slot.data_index;
+        uint32_t last_index = static_cast<uint32_t>(data.size() - 1);
+        if (data_index != last_index) {
+            data[data_index] = std::move(data[last_index]);
+            uint32_t moved_slot = data_slots[last_index];
+            data_slots[data_index] = moved_slot;
+            slots[moved_slot].data_index = data_index;
+        }
+        data.pop_back();
+        data_slots.pop_back();
+        // Invalidate the handles to the slot, skipping the NULL generation when it wraps.
+        if (++slot.generation == 0) {
+            slot.generation = 1;
+        }
+        slot.data_index = free_head;
+        free_head = p_handle.index;
+        return true;
+    }
+
+    /**
+     * @brief Is the handle referencing an element of the map.
+     *
+     * @param p_handle The handle.
+     * @return true if the element exists, false if the handle is stale or NULL.
+     */
+    bool contains(Handle p_handle) const {
+        // The generation of a free slot is never handed out, a matching generation means the slot is used.
+        return p_handle.index < slots.size() && slots[p_handle.index].generation == p_handle.generation
+            && !p_handle.is_null();
+    }
+
+    /**
+     * @brief Get an element.
+     *
+     * @param p_handle The handle to the element.
+     * @return The pointer to the element. nullptr if the handle is stale or NULL. Invalidated
+     * by the next insertion or erasure.
+     */
+    T* get(Handle p_handle) {
+        return contains(p_handle) ? &data[slots[p_handle.index].data_index] : nullptr;
+    }
+
+    /**
+     * @brief Get an element.
+     *
+     * @param p_handle The handle to the element.
+     * @return The pointer to the element. nullptr if the handle is stale or NULL. Invalidated
+     * by the next insertion or erasure.
+     */
+    const T* get(Handle p_handle) const {
+        return contains(p_handle) ? &data[slots[p_handle.index].data_index] : nullptr;
+    }
+
+    T& operator[](Handle p_handle) {
+        WBE_DEBUG_ASSERT(contains(p_handle));
+        return data[slots[p_handle.index].data_index];
+    }
+
+    const T& operator[](Handle p_handle) const {
+        WBE_DEBUG_ASSERT(contains(p_handle));
+        return data[slots[p_handle.index].data_index];
+    }
+
+    /**
+     * @brief Get the handle of an element by its index in the packed order.
+     *
+     * @param p_index The index of the element.
+     * @return The handle to the element.
+     */
+    Handle get_handle_by_index(size_t p_index) const {
+        WBE_DEBUG_ASSERT(p_index < data.size());
+        uint32_t slot_index = data_slots[p_index];
+        return Handle{ slot_index, slots[slot_index].generation };
+    }
+
+    /**
+     * @brief Reserve the storage for a number of elements.
+     *
+     * @param p_count The number of elements.
+     */
+    void reserve(size_t p_count) {
+        data.reserve(p_count);
+        data_slots.reserve(p_count);
+        slots.reserve(p_count);
+    }
+
+    /**
+     * @brief Erase all the elements. The handles to them become stale.
+     */
+    void clear() {
+        for (uint32_t slot_index : data_slots) {
+            Slot& slot = slots[slot_index];
+            if (++slot.generation == 0) {
+                slot.generation = 1;
+            }
+            slot.data_index = free_head;
+            free_head = slot_index;
+        }
+        data.clear();
+        data_slots.clear();
+    }
+
+    size_t size() const {
+        return data.size();
+    }
+
+    bool empty() const {
+        return data.empty();
+    }
+
+    T* get_data() {
+        return data.data();
+    }
+
+    const T* get_data() const {
+        return data.data();
+    }
+
+    iterator begin() {
+        return data.data();
+    }
+
+    iterator end() {
+        return data.data() + data.size();
+    }
+
+    const_iterator begin() const {
+        return data.data();
+    }
+
+    const_iterator end() const {
+        return data.data() + data.size();
+    }
+
+private:
+    static constexpr uint32_t FREE_END = std::numeric_limits<uint32_t>::max();
+
+    struct Slot {
+        // The index of the element if the slot is used, the next free slot otherwise.
+        uint32_t data_index;
+        uint32_t generation;
+    };
+
+    vector<T, AllocType> data;
+    // Maps the index of an element to its slot.
+    vector<uint32_t, AllocType> data_slots;
+    vector<Slot, AllocType> slots;
+    uint32_t free_head = FREE_END;
+};
+
+}
+
+namespace std {
+/**
+ * @brief Hash function for slot map handle.
+ */
+template <>
+struct hash<::WhiteBirdEngine::SlotMapHandle> {
+    size_t operator()(const ::WhiteBirdEngine::SlotMapHandle& p_handle) const {
+        return std::hash<uint64_t>{}((static_cast<uint64_t>(p_handle.generation) << 32) | p_handle.index);
+    }
+};
+}
+
+#endif
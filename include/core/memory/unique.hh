@@ -91,7 +91,7 @@ public:
      * @return The unique instnace.
      */
     template <typename... Args>
-    static Unique<T> make_unique(AllocType* p_allocator, Args&&... p_args) {
+    static Unique<T, AllocType> make_unique(AllocType* p_allocator, Args&&... p_args) {
         return Unique(p_allocator, create_obj<T>(*p_allocator, std::forward<Args>(p_args)...));
     }
 
@@ -104,7 +104,7 @@ public:
         if (allocator == nullptr) {
             return nullptr;
         }
-        return allocator->template get_obj<T>(mem_id);
+        return access_obj<T>(*allocator, mem_id);
     }
 
     /**
@@ -116,7 +116,7 @@ public:
         if (allocator == nullptr) {
             return nullptr;
         }
-        return allocator->template get_obj<T>(mem_id);
+        return access_obj<T>(*allocator, mem_id);
     }
 
     /**
@@ -130,19 +130,19 @@ public:
     }
 
     T* operator->() {
-        return static_cast<T*>(allocator->get(mem_id));
+        return access_obj<T>(*allocator, mem_id);
     }
 
     const T* operator->() const {
-        return static_cast<T*>(allocator->get(mem_id));
+        return access_obj<T>(*allocator, mem_id);
     }
 
     T& operator*() {
-        return *static_cast<T*>(allocator->get(mem_id));
+        return *access_obj<T>(*allocator, mem_id);
     }
 
     const T& operator*() const {
-        return *static_cast<T*>(allocator->get(mem_id));
+        return *access_obj<T>(*allocator, mem_id);
     }
 
     bool operator==(MemID p_mem_id) {
@@ -187,10 +187,10 @@ private:
  * @return The unique instnace.
  */
 template <typename T, typename AllocType = HeapAllocator,  typename... Args>
-Unique<T> make_unique(AllocType* p_allocator, Args&&... p_args) {
+Unique<T, AllocType> make_unique(AllocType* p_allocator, Args&&... p_args) {
     WBE_DEBUG_ASSERT(p_allocator != nullptr);
     MemID id = create_obj<T>(*p_allocator, std::forward<Args>(p_args)...);
-    return Unique<T>(p_allocator, id);
+    return Unique<T, AllocType>(p_allocator, id);
 }
 
 }
@@ -16,11 +16,22 @@
 #define __WBE_STL_ALLOCATOR_HH__
 
 #include "core/allocator/allocator.hh"
+#include "core/allocator/heap_allocator.hh"
 #include "core/core_utils.hh"
+#include "utils/defs.hh"
+#include <algorithm>
+#include <bit>
+#include <cstddef>
 #include <deque>
+#include <forward_list>
+#include <list>
+#include <map>
+#include <memory_resource>
+#include <new>
 #include <set>
 #include <string>
 #include <type_traits>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 namespace WhiteBirdEngine {
@@ -154,6 +165,158 @@ using string = std::basic_string<char, std::char_traits<char>, STLAllocator<char
 template <typename T, typename AllocType = HeapAllocatorDefault>
 using deque = std::deque<T, STLAllocator<T, AllocType, false, true, false>>;
 
+/**
+ * @brief STL list that uses a custom allocator.
+ *
+ * @tparam T The type of the values in the list.
+ * @tparam AllocType The type of the allocator. HeapAllocatorDefault by default.
+ */
+template <typename T, typename AllocType = HeapAllocatorDefault>
+using list = std::list<T, STLAllocator<T, AllocType, false, true, false>>;
+
+/**
+ * @brief STL map that uses a custom allocator.
+ *
+ * @tparam K The type of the keys in the map.
+ * @tparam V The type of the values in the map.
+ * @tparam AllocType The type of the allocator. HeapAllocatorDefault by default.
+ */
+template <typename K, typename V, typename AllocType = HeapAllocatorDefault>
+using map = std::map<K, V, std::less<K>, STLAllocator<std::pair<const K, V>, AllocType, false, true, false>>;
+
+/**
+ * @brief STL unordered map that uses a custom allocator.
+ *
+ * @tparam K The type of the keys in the map.
+ * @tparam V The type of the values in the map.
+ * @tparam AllocType The type of the allocator. HeapAllocatorDefault by default.
+ */
+template <typename K, typename V, typename AllocType = HeapAllocatorDefault>
+using unordered_map = std::unordered_map<K, V, std::hash<K>, std::equal_to<K>, STLAllocator<std::pair<const K, V>, AllocType, false, true, false>>;
+
+/**
+ * @class STLMemoryResource
+ * @brief Adapter of an engine allocator to std::pmr::memory_resource. Unlike STLAllocator, the
+ * containers only store a pointer to the resource, and containers of different value types
+ * and allocators share the same types, so they could be passed around freely.
+ * @note Allocation failures of the allocator are thrown as they are. Thread safe if the
+ * allocator is. Allocators without deallocate, such as FrameAllocator, ignore deallocations.
+ *
+ * @tparam AllocType The type of the allocator.
+ */
+template <typename AllocType>
+    requires (!(AllocatorTrait<AllocType>::WILL_ADDR_MOVE))
+class STLMemoryResource final : public std::pmr::memory_resource {
+public:
+    STLMemoryResource() = delete;
+    virtual ~STLMemoryResource() override {}
+    STLMemoryResource(const STLMemoryResource&) = delete;
+    STLMemoryResource(STLMemoryResource&&) = delete;
+    STLMemoryResource& operator=(const STLMemoryResource&) = delete;
+    STLMemoryResource& operator=(STLMemoryResource&&) = delete;
+
+    /**
+     * @brief Constructor.
+     *
+     * @param p_allocator The allocator that this memory resource uses.
+     */
+    STLMemoryResource(AllocType* p_allocator)
+        : allocator(p_allocator) {
+        WBE_DEBUG_ASSERT(p_allocator != nullptr);
+    }
+
+    /**
+     * @brief Get the allocator that this memory resource uses.
+     *
+     * @return The allocator.
+     */
+    AllocType* get_allocator() const {
+        return allocator;
+    }
+
+protected:
+    virtual void* do_allocate(size_t p_bytes, size_t p_alignment) override {
+        // The allocators do not allocate 0 bytes, and most require at least the default alignment.
+        size_t size = std::max(p_bytes, static_cast<size_t>(1));
+        MemID result;
+        if constexpr (requires { allocator->allocate(size, p_alignment); }) {
+            result = allocator->allocate(size, std::max(p_alignment, static_cast<size_t>(WBE_DEFAULT_ALIGNMENT)));
+        }
+        else {
+            if (p_alignment > WBE_DEFAULT_ALIGNMENT) {
+                throw std::bad_alloc();
+            }
+            result = allocator->allocate(size);
+        }
+        if (result == MEM_NULL) {
+            throw std::bad_alloc();
+        }
+        return access_obj<void>(*allocator, result);
+    }
+
+    virtual void do_deallocate(void* p_ptr, size_t, size_t) override {
+        if constexpr (requires { allocator->deallocate(MEM_NULL); }) {
+            // The address does not move, so it is the memory ID.
+            allocator->deallocate(std::bit_cast<MemID>(p_ptr));
+        }
+    }
+
+    virtual bool do_is_equal(const std::pmr::memory_resource& p_other) const noexcept override {
+        return this == &p_other;
+    }
+
+private:
+    AllocType* allocator;
+};
+
+/**
+ * @brief Containers that allocate from a std::pmr::memory_resource, such as STLMemoryResource.
+ */
+namespace pmr {
+
+template <typename T>
+using vector = std::pmr::vector<T>;
+
+template <typename T>
+using deque = std::pmr::deque<T>;
+
+template <typename T>
+using list = std::pmr::list<T>;
+
+template <typename T>
+using forward_list = std::pmr::forward_list<T>;
+
+template <typename T, typename Compare = std::less<T>>
+using set = std::pmr::set<T, Compare>;
+
+template <typename T, typename Compare = std::less<T>>
+using multiset = std::pmr::multiset<T, Compare>;
+
+template <typename K, typename V, typename Compare = std::less<K>>
+using map = std::pmr::map<K, V, Compare>;
+
+template <typename K, typename V, typename Compare = std::less<K>>
+using multimap = std::pmr::multimap<K, V, Compare>;
+
+template <typename T, typename Hash = std::hash<T>, typename Equal = std::equal_to<T>>
+using unordered_set = std::pmr::unordered_set<T, Hash, Equal>;
+
+template <typename T, typename Hash = std::hash<T>, typename Equal = std::equal_to<T>>
+using unordered_multiset = std::pmr::unordered_multiset<T, Hash, Equal>;
+
+template <typename K, typename V, typename Hash = std::hash<K>, typename Equal = std::equal_to<K>>
+using unordered_map = std::pmr::unordered_map<K, V, Hash, Equal>;
+
+template <typename K, typename V, typename Hash = std::hash<K>, typename Equal = std::equal_to<K>>
+using unordered_multimap = std::pmr::unordered_multimap<K, V, Hash, Equal>;
+
+template <typename CharT, typename Traits = std::char_traits<CharT>>
+using basic_string = std::pmr::basic_string<CharT, Traits>;
+
+using string = std::pmr::string;
+
+}
+
 /**
  * @brief Short name for stl allocator that uses HeapAllocatorDefault.
  *
@@ -17,6 +17,8 @@
 
 #include <bitset>
 #include <cstddef>
+#include <string>
+#include <vector>
 #ifdef __unix__
 #include <sys/types.h>
 #include <sched.h>
@@ -64,6 +66,12 @@ public:
         PRIVATE,
         // Map to an anonymous file.
         ANON,
+        // Do not reserve swap space for the mapping, so that a large range could be reserved
+        // and only backed when used.
+        NORESERVE,
+        // Back the mapping with huge pages from the huge page pool. The length must be a
+        // multiple of the huge page size.
+        HUGETLB,
         // Used for tracking total types.
         TOTAL_MMAP_FLAGS
     };
@@ -77,6 +85,16 @@ public:
         TOTAL_FILE_OPEN_FLAGS
     };
 
+    /**
+     * @brief Advices on how mapped memory is going to be used.
+     */
+    enum class MemoryAdvice {
+        // No special treatment.
+        NORMAL = 0,
+        // Back the memory with transparent huge pages if possible.
+        HUGE_PAGE
+    };
+
     using MMapFlags = std::bitset<(int)MMapFlagBit::TOTAL_MMAP_FLAGS>;
     using FileOpenFlags = std::bitset<(int)FileOpenFlagBit::TOTAL_FILE_OPEN_FLAGS>;
 
@@ -143,6 +161,38 @@ public:
      */
     static void* memory_map(void* p_start, size_t p_length, MMapProt p_prot, MMapFlags p_flags, FileDescrip p_fd, off_t p_offset);
 
+    /**
+     * @brief Change the protocol of mapped memory.
+     *
+     * @param p_start The start of the memory. Must be aligned to the page size.
+     * @param p_length The length of the memory in bytes.
+     * @param p_prot The new protocol of the memory. Empty for no access.
+     */
+    static void memory_protect(void* p_start, size_t p_length, MMapProt p_prot);
+
+    /**
+     * @brief Advise the system on how mapped memory is going to be used.
+     *
+     * @param p_start The start of the memory. Must be aligned to the page size.
+     * @param p_length The length of the memory in bytes.
+     * @param p_advice The advice.
+     */
+    static void memory_advise(void* p_start, size_t p_length, MemoryAdvice p_advice);
+
+    /**
+     * @brief Get the size of a memory page.
+     *
+     * @return The size of a memory page in bytes.
+     */
+    static size_t get_page_size();
+
+    /**
+     * @brief Get the size of a huge page.
+     *
+     * @return The default size of a huge page in bytes.
+     */
+    static size_t get_huge_page_size();
+
     /**
      * @brief Open file and get a file description.
      *
@@ -166,6 +216,25 @@ public:
      * @param p_length The length of the memory to be unmapped.
      */
     static void memory_unmap(void* p_start, size_t p_length);
+
+    /**
+     * @brief Capture the return addresses of the calling thread's stack.
+     *
+     * @param r_frames The output array of the return addresses, must hold at least p_max_frames elements.
+     * @param p_max_frames The maximum number of frames to capture.
+     * @param p_skip The number of innermost frames to skip, not counting this function.
+     * @return The number of frames captured.
+     */
+    static size_t capture_backtrace(void** r_frames, size_t p_max_frames, size_t p_skip = 0);
+
+    /**
+     * @brief Resolve return addresses to readable symbol names.
+     *
+     * @param p_frames The return addresses.
+     * @param p_frame_count The number of return addresses.
+     * @return The symbol name of each address, or the address itself if it could not be resolved.
+     */
+    static std::vector<std::string> get_backtrace_symbols(void* const* p_frames, size_t p_frame_count);
 };
 
 }
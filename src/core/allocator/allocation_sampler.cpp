@@ -0,0 +1,225 @@
+/* Copyright 2025 OppositeNor
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#include "core/allocator/allocation_sampler.hh"
+#include "platform/os/os.hh"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace WhiteBirdEngine {
+
+thread_local AllocationSampler::ThreadState AllocationSampler::thread_state;
+
+static std::string escape_json(const std::string& p_str) {
+    std::string result;
+    result.reserve(p_str.size());
+    for (char c : p_str) {
+        if (c == '"' || c == '\\') {
+            result.push_back('\\');
+        }
+        result.push_back(c);
+    }
+    return result;
+}
+
+AllocationSampler::AllocationSampler(size_t p_sample_interval, const std::string& p_report_path)
+    : sample_interval(p_sample_interval), inverse_interval(1.0 / static_cast<double>(p_sample_interval)), report_path(p_report_path) {
+    if (p_sample_interval == 0) {
+        throw std::runtime_error("Failed to create allocation sampler: sample interval must not be 0.");
+    }
+}
+
+AllocationSampler::~AllocationSampler() {
+    if (report_path.empty()) {
+        return;
+    }
+    // Never throw from the destructor, a report that could not be written is dropped.
+    std::ofstream file(report_path);
+    if (file.is_open()) {
+        file << static_cast<std::string>(*this);
+    }
+}
+
+void AllocationSampler::on_clear(const void* p_allocator) {
+    std::lock_guard lock(samples_mutex);
+    for (auto it = live_samples.begin(); it != live_samples.end();) {
+        if (it->first.allocator == p_allocator) {
+            auto next = std::next(it);
+            release_sample(it);
+            it = next;
+        }
+        else {
+            ++it;
+        }
+    }
+}
+
+std::vector<AllocationSampler::CallSiteReport> AllocationSampler::get_report() const {
+    std::vector<CallSiteReport> result;
+    {
+        std::lock_guard lock(samples_mutex);
+        result.reserve(call_sites.size());
+        for (const auto& [key, call_site] : call_sites) {
+            CallSiteReport report;
+            report.backtrace = OS::get_backtrace_symbols(call_site.frames, call_site.frame_count);
+            report.sample_count = call_site.sample_count;
+            report.live_sample_count = call_site.live_sample_count;
+            report.allocated_bytes = static_cast<size_t>(std::llround(call_site.allocated_bytes));
+            report.freed_bytes = std::min(report.allocated_bytes, static_cast<size_t>(std::llround(call_site.freed_bytes)));
+            result.push_back(std::move(report));
+        }
+    }
+    std::sort(result.begin(), result.end(), [](const CallSiteReport& p_a, const CallSiteReport& p_b) {
+        return p_a.get_live_bytes() > p_b.get_live_bytes();
+    });
+    return result;
+}
+
+void AllocationSampler::write_report(const std::string& p_path) const {
+    std::ofstream file(p_path);
+    if (!file.is_open()) {
+        throw std::runtime_error("Failed to write allocation report: cannot open file: " + p_path + ".");
+    }
+    file << static_cast<std::string>(*this);
+}
+
+uint64_t AllocationSampler::get_sample_count() const {
+    std::lock_guard lock(samples_mutex);
+    uint64_t result = 0;
+    for (const auto& [key, call_site] : call_sites) {
+        result += call_site.sample_count;
+    }
+    return result;
+}
+
+uint64_t AllocationSampler::get_live_sample_count() const {
+    std::lock_guard lock(samples_mutex);
+    return live_samples.size();
+}
+
+void AllocationSampler::record_allocation(const void* p_allocator, MemID p_mem, size_t p_size) {
+    ThreadState& state = thread_state;
+    if (state.random_state == 0) {
+        // The first allocation of the thread starts the countdown instead of being sampled.
+        state.random_state = (reinterpret_cast<uintptr_t>(&state) ^ std::chrono::steady_clock::now().time_since_epoch().count()) | 1;
+        state.sample_countdown = draw_countdown(state);
+        double step = static_cast<double>(p_size) * inverse_interval;
+        if (state.sample_countdown > step) {
+            state.sample_countdown -= step;
+            return;
+        }
+    }
+    state.sample_countdown = draw_countdown(state);
+    void* frames[MAX_FRAMES];
+    // Only this function is skipped. The hook could be inlined into the caller, so its frames
+    // are kept rather than risking to drop the frame of the caller.
+    size_t frame_count = OS::capture_backtrace(frames, MAX_FRAMES, 1);
+    // The allocation is sampled with the probability of 1 - e^(-size / interval).
+    double weight = static_cast<double>(p_size) / -std::expm1(-static_cast<double>(p_size) / static_cast<double>(sample_interval));
+    std::lock_guard lock(samples_mutex);
+    std::string call_site_key(reinterpret_cast<const char*>(frames), frame_count * sizeof(void*));
+    auto [call_site_it, is_new] = call_sites.try_emplace(std::move(call_site_key));
+    CallSite& call_site = call_site_it->second;
+    if (is_new) {
+        std::copy_n(frames, frame_count, call_site.frames);
+        call_site.frame_count = frame_count;
+    }
+    ++call_site.sample_count;
+    ++call_site.live_sample_count;
+    call_site.allocated_bytes += weight;
+    auto [sample_it, is_new_sample] = live_samples.try_emplace(SampleKey{ p_allocator, p_mem }, LiveSample{ &call_site, weight });
+    if (!is_new_sample) {
+        // The memory is reused without the deallocation being reported, count the old sample as freed.
+        release_sample(sample_it);
+        live_samples.emplace(SampleKey{ p_allocator, p_mem }, LiveSample{ &call_site, weight });
+    }
+    live_filter[get_filter_index(p_allocator, p_mem)].fetch_add(1, std::memory_order_relaxed);
+}
+
+void AllocationSampler::record_deallocation(const void* p_allocator, MemID p_mem) {
+    std::lock_guard lock(samples_mutex);
+    auto it = live_samples.find(SampleKey{ p_allocator, p_mem });
+    if (it != live_samples.end()) {
+        release_sample(it);
+    }
+}
+
+void AllocationSampler::release_sample(std::unordered_map<SampleKey, LiveSample, SampleKeyHash>::iterator p_sample) {
+    CallSite* call_site = p_sample->second.call_site;
+    --call_site->live_sample_count;
+    call_site->freed_bytes += p_sample->second.weight;
+    live_filter[get_filter_index(p_sample->first.allocator, p_sample->first.mem)].fetch_sub(1, std::memory_order_relaxed);
+    live_samples.erase(p_sample);
+}
+
+double AllocationSampler::draw_countdown(ThreadState& p_state) {
+    // xorshift64*
+    p_state.random_state ^= p_state.random_state >> 12;
+    p_state.random_state ^= p_state.random_state << 25;
+    p_state.random_state ^= p_state.random_state >> 27;
+    uint64_t random = p_state.random_state * 0x2545F4914F6CDD1Dull;
+    // Uniform in (0, 1].
+    double uniform = static_cast<double>((random >> 11) + 1) * 0x1.0p-53;
+    // Exponentially distributed, so that every byte is equally likely to be sampled.
+    return -std::log(uniform);
+}
+
+AllocationSampler::CallSiteReport::operator std::string() const {
+    std::stringstream ss;
+    ss << "{";
+    ss << "\"live_bytes\":" << get_live_bytes() << ",";
+    ss << "\"allocated_bytes\":" << allocated_bytes << ",";
+    ss << "\"freed_bytes\":" << freed_bytes << ",";
+    ss << "\"sample_count\":" << sample_count << ",";
+    ss << "\"live_sample_count\":" << live_sample_count << ",";
+    ss << "\"backtrace\":[";
+    bool first = true;
+    for (const auto& symbol : backtrace) {
+        if (!first) ss << ",";
+        first = false;
+        ss << "\"" << escape_json(symbol) << "\"";
+    }
+    ss << "]";
+    ss << "}";
+    return ss.str();
+}
+
+AllocationSampler::operator std::string() const {
+    std::vector<CallSiteReport> report = get_report();
+    size_t live_bytes = 0;
+    for (const auto& call_site : report) {
+        live_bytes += call_site.get_live_bytes();
+    }
+    std::stringstream ss;
+    ss << "{";
+    ss << "\"type\":\"AllocationSampler\",";
+    ss << "\"sample_interval\":" << sample_interval << ",";
+    ss << "\"live_bytes\":" << live_bytes << ",";
+    ss << "\"call_sites\":[";
+    bool first = true;
+    for (const auto& call_site : report) {
+        if (!first) ss << ",";
+        first = false;
+        ss << static_cast<std::string>(call_site);
+    }
+    ss << "]";
+    ss << "}";
+    return ss.str();
+}
+
+}
@@ -0,0 +1,48 @@
+/* Copyright 2025 OppositeNor
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#include "core/allocator/allocator_stats.hh"
+#include <sstream>
+
+namespace WhiteBirdEngine {
+
+AllocatorStats::operator std::string() const {
+    std::stringstream ss;
+    ss << "{";
+    ss << "\"type\":\"AllocatorStats\",";
+    ss << "\"allocation_count\":" << allocation_count << ",";
+    ss << "\"deallocation_count\":" << deallocation_count << ",";
+    ss << "\"failed_allocation_count\":" << failed_allocation_count << ",";
+    ss << "\"live_bytes\":" << live_bytes << ",";
+    ss << "\"peak_bytes\":" << peak_bytes << ",";
+    ss << "\"free_bytes\":" << free_bytes << ",";
+    // null if untracked, NaN is not valid JSON.
+    if (largest_free_block_tracked) {
+        ss << "\"largest_free_block\":" << largest_free_block << ",";
+    }
+    else {
+        ss << "\"largest_free_block\":null,";
+    }
+    if (largest_free_block_tracked || free_bytes == 0) {
+        ss << "\"external_fragmentation\":" << get_external_fragmentation() << ",";
+    }
+    else {
+        ss << "\"external_fragmentation\":null,";
+    }
+    ss << "\"lock_wait_ns\":" << lock_wait_ns;
+    ss << "}";
+    return ss.str();
+}
+
+}
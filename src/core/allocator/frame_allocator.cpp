@@ -0,0 +1,182 @@
+/* Copyright 2025 OppositeNor
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#include "core/allocator/frame_allocator.hh"
+#include "utils/utils.hh"
+#include <algorithm>
+#include <format>
+#include <sstream>
+#include <stdexcept>
+
+namespace WhiteBirdEngine {
+
+thread_local FrameAllocator::ThreadSliceTable FrameAllocator::thread_slice_table;
+std::mutex FrameAllocator::registry_mutex;
+std::unordered_map<uint64_t, FrameAllocator*> FrameAllocator::live_instances;
+std::atomic<uint64_t> FrameAllocator::next_instance_id = 1;
+
+FrameAllocator::FrameAllocator(size_t p_slice_size, uint32_t p_frame_count)
+    : slice_size(get_align_size(p_slice_size, WBE_DEFAULT_ALIGNMENT)), frame_count(p_frame_count),
+    instance_id(next_instance_id.fetch_add(1, std::memory_order_relaxed)) {
+    if (p_slice_size == 0) {
+        throw std::runtime_error("Failed to create frame allocator: slice size must not be 0.");
+    }
+    if (p_frame_count == 0 || p_frame_count > MAX_FRAME_COUNT) {
+        throw std::runtime_error(std::format("Failed to create frame allocator: frame count must be from 1 to {}.", MAX_FRAME_COUNT));
+    }
+    std::lock_guard lock(registry_mutex);
+    live_instances[instance_id] = this;
+}
+
+FrameAllocator::~FrameAllocator() {
+    // After this, exiting threads will no longer release their slices to this instance.
+    std::lock_guard lock(registry_mutex);
+    live_instances.erase(instance_id);
+}
+
+MemID FrameAllocator::allocate(size_t p_size, size_t p_alignment) {
+    if (p_alignment == 0) {
+        throw std::runtime_error("Failed to allocate resource: allocation alignment must not be 0.");
+    }
+    if (p_size == 0) {
+        return MEM_NULL;
+    }
+    ThreadSlice* slice = get_thread_slice();
+    uint64_t frame = frame_number.load(std::memory_order_acquire);
+    size_t buffer_index = frame % frame_count;
+    // The first allocation of the thread in this frame resets the buffer used frame_count frames ago.
+    if (slice->buffer_frames[buffer_index].load(std::memory_order_relaxed) != frame) {
+        slice->buffer_frames[buffer_index].store(frame, std::memory_order_relaxed);
+        slice->buffer_used[buffer_index].store(0, std::memory_order_relaxed);
+    }
+    char* buffer = slice->memory.get() + buffer_index * slice_size;
+    size_t used = slice->buffer_used[buffer_index].load(std::memory_order_relaxed);
+    size_t start = get_align_size(reinterpret_cast<uintptr_t>(buffer) + used, p_alignment) - reinterpret_cast<uintptr_t>(buffer);
+    if (start + p_size > slice_size) {
+        throw std::runtime_error(std::format("Failed to allocate memory: not enough space in the frame slice.\n"
+                                             "Trying to allocate: {} bytes, {} of {} bytes used.", p_size, used, slice_size));
+    }
+    used = start + p_size;
+    slice->buffer_used[buffer_index].store(used, std::memory_order_relaxed);
+    if (used > slice->high_water_mark.load(std::memory_order_relaxed)) {
+        slice->high_water_mark.store(used, std::memory_order_relaxed);
+    }
+    return reinterpret_cast<MemID>(buffer + start);
+}
+
+void FrameAllocator::end_frame() {
+    uint64_t frame = frame_number.load(std::memory_order_relaxed);
+    size_t buffer_index = frame % frame_count;
+    size_t frame_size = 0;
+    {
+        std::lock_guard lock(slices_mutex);
+        for (const auto& slice : slices) {
+            if (slice->buffer_frames[buffer_index].load(std::memory_order_relaxed) == frame) {
+                frame_size += slice->buffer_used[buffer_index].load(std::memory_order_relaxed);
+            }
+        }
+    }
+    last_frame_size = frame_size;
+    frame_high_water_mark = std::max(frame_high_water_mark, frame_size);
+    frame_number.store(frame + 1, std::memory_order_release);
+}
+
+size_t FrameAllocator::get_slice_high_water_mark() const {
+    std::lock_guard lock(slices_mutex);
+    size_t result = 0;
+    for (const auto& slice : slices) {
+        result = std::max(result, slice->high_water_mark.load(std::memory_order_relaxed));
+    }
+    return result;
+}
+
+size_t FrameAllocator::get_thread_slice_count() const {
+    std::lock_guard lock(slices_mutex);
+    return slices.size();
+}
+
+FrameAllocator::ThreadSlice* FrameAllocator::find_thread_slice(ThreadSliceTable& p_table) {
+    for (auto& entry : p_table.entries) {
+        if (entry.first == instance_id) {
+            p_table.last_instance_id = entry.first;
+            p_table.last_slice = entry.second;
+            return entry.second;
+        }
+    }
+    {
+        // Drop the entries of the destructed instances.
+        std::lock_guard lock(registry_mutex);
+        std::erase_if(p_table.entries, [](const auto& p_entry) {
+            return !live_instances.contains(p_entry.first);
+        });
+    }
+    ThreadSlice* result = nullptr;
+    {
+        std::lock_guard lock(slices_mutex);
+        // Take over the slice of an exited thread if any.
+        for (auto& slice : slices) {
+            if (!slice->owned) {
+                slice->owned = true;
+                result = slice.get();
+                break;
+            }
+        }
+        if (result == nullptr) {
+            std::unique_ptr<ThreadSlice> slice = std::make_unique<ThreadSlice>();
+            slice->memory = std::make_unique_for_overwrite<char[]>(slice_size * frame_count);
+            for (uint32_t i = 0; i < MAX_FRAME_COUNT; ++i) {
+                slice->buffer_frames[i].store(NULL_FRAME, std::memory_order_relaxed);
+                slice->buffer_used[i].store(0, std::memory_order_relaxed);
+            }
+            result = slice.get();
+            slices.push_back(std::move(slice));
+        }
+    }
+    p_table.entries.emplace_back(instance_id, result);
+    p_table.last_instance_id = instance_id;
+    p_table.last_slice = result;
+    return result;
+}
+
+void FrameAllocator::release_thread_slice(ThreadSlice* p_slice) {
+    std::lock_guard lock(slices_mutex);
+    p_slice->owned = false;
+}
+
+FrameAllocator::ThreadSliceTable::~ThreadSliceTable() {
+    std::lock_guard lock(registry_mutex);
+    for (auto& entry : entries) {
+        auto it = live_instances.find(entry.first);
+        if (it != live_instances.end()) {
+            it->second->release_thread_slice(entry.second);
+        }
+    }
+}
+
+FrameAllocator::operator std::string() const {
+    std::stringstream ss;
+    ss << "{";
+    ss << "\"type\":\"FrameAllocator\",";
+    ss << "\"slice_size\":" << slice_size << ",";
+    ss << "\"frame_count\":" << frame_count << ",";
+    ss << "\"frame_number\":" << get_frame_number() << ",";
+    ss << "\"thread_slice_count\":" << get_thread_slice_count() << ",";
+    ss << "\"last_frame_size\":" << last_frame_size << ",";
+    ss << "\"frame_high_water_mark\":" << frame_high_water_mark << ",";
+    ss << "\"slice_high_water_mark\":" << get_slice_high_water_mark();
+    ss << "}";
+    return ss.str();
+}
+
+}
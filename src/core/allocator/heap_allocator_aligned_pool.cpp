@@ -24,6 +24,7 @@
 #include <format>
 #include <iostream>
 #include <memory>
+#include <numeric>
 #include <stdexcept>
 #include <string>
 
@@ -32,29 +33,47 @@
 
 namespace WhiteBirdEngine {
 
-HeapAllocatorAlignedPool::HeapAllocatorAlignedPool(size_t p_size)
-    : size(p_size) {
-    if (p_size > MAX_TOTAL_SIZE) {
-        throw std::runtime_error("Failed to create pool: size: " + std::to_string(p_size) + " exceeds maximum: " + std::to_string(MAX_TOTAL_SIZE) + ".");
-    }
-    mem_chunk = static_cast<char*>(malloc(p_size));
-    if (mem_chunk == nullptr) {
-        throw std::runtime_error("Failed to create pool: malloc failed.");
-    }
-    // Trigger page fault to mmap from MMU.
-    memset(mem_chunk, 0, p_size);
-    idle_list_head = std::make_unique<IdleListNode>();
-    idle_list_head->size = p_size;
-    idle_list_head->next = nullptr;
-    idle_list_head->mem_start = mem_chunk;
-    idle_chunks_count = 1;
+HeapAllocatorAlignedPool::HeapAllocatorAlignedPool(size_t p_size, size_t p_reserve_size, bool p_huge_pages)
+    : size(p_size - p_size % HEADER_SIZE) {
+    if (std::max(p_size, p_reserve_size) > MAX_TOTAL_SIZE) {
+        throw std::runtime_error("Failed to create pool: size: " + std::to_string(std::max(p_size, p_reserve_size)) + " exceeds maximum: " + std::to_string(MAX_TOTAL_SIZE) + ".");
+    }
+    if (size < HEADER_SIZE) {
+        throw std::runtime_error(std::format("Failed to create pool: size: {} is less than minimum: {}.", p_size, HEADER_SIZE));
+    }
+    if (p_reserve_size != 0) {
+        if (p_reserve_size < p_size) {
+            throw std::runtime_error(std::format("Failed to create pool: reserve size: {} is less than size: {}.",
+                                                 p_reserve_size, p_size));
+        }
+        virtual_memory = std::make_unique<VirtualMemoryRange>(p_reserve_size, p_size, p_huge_pages);
+        growable = true;
+    }
+    else if (p_huge_pages) {
+        virtual_memory = std::make_unique<VirtualMemoryRange>(p_size, p_size, true);
+    }
+    if (virtual_memory != nullptr) {
+        mem_chunk = virtual_memory->get_data();
+        size = virtual_memory->get_committed_size();
+    }
+    else {
+        mem_chunk = static_cast<char*>(aligned_alloc(HEADER_SIZE, size));
+        if (mem_chunk == nullptr) {
+            throw std::runtime_error("Failed to create pool: malloc failed.");
+        }
+        // Trigger page fault to mmap from MMU.
+        memset(mem_chunk, 0, size);
+    }
+    clear();
 }
 
 HeapAllocatorAlignedPool::~HeapAllocatorAlignedPool() {
     if (!is_empty()) {
         wbe_console_log(WBE_CHANNEL_GLOBAL)->warning("Non-empty allocator destructed.");
     }
-    free(mem_chunk);
+    if (virtual_memory == nullptr) {
+        free(mem_chunk);
+    }
     mem_chunk = nullptr;
 }
 
@@ -68,153 +87,198 @@ MemID HeapAllocatorAlignedPool::allocate(size_t p_size, size_t p_alignment) {
     if (p_size == 0) {
         return MEM_NULL;
     }
-    std::unique_ptr<IdleListNode>* valid_idle_node = &idle_list_head;
+    // Chunk boundaries are always kept at multiples of HEADER_SIZE, so that every idle chunk
+    // could hold a node. The requested alignment is combined with it.
+    size_t alignment = std::lcm(p_alignment, HEADER_SIZE);
     // Clamp the padding size to the default alignment.
     size_t aligned_size = get_align_size(p_size, WBE_DEFAULT_ALIGNMENT) + HEADER_SIZE;
-    while (*valid_idle_node != nullptr) {
-        // Find the aligned starting point.
-        uintptr_t proxy_mem_start_addr = reinterpret_cast<uintptr_t>((*valid_idle_node)->mem_start) + HEADER_SIZE;
-        char* idle_node_mem_start = reinterpret_cast<char*>(
-            (proxy_mem_start_addr / p_alignment) * p_alignment == proxy_mem_start_addr ?
-                proxy_mem_start_addr : (proxy_mem_start_addr / p_alignment + 1) * p_alignment
-        ) - HEADER_SIZE;
-        // If idle node valid, insert.
-        if (idle_node_mem_start + aligned_size <= (*valid_idle_node)->mem_start + (*valid_idle_node)->size) {
-            void* result_loc = acquire_memory(*valid_idle_node, idle_node_mem_start, aligned_size);
-            MemID result_id = reinterpret_cast<MemID>(result_loc) + HEADER_SIZE;
-            *static_cast<Header*>(result_loc) = aligned_size;
-            internal_fragmentation_tracker = std::max(internal_fragmentation_tracker, (size_t)result_loc + aligned_size - (size_t)mem_chunk);
-            return result_id;
-        }
-        valid_idle_node = &((*valid_idle_node)->next);
+    MemID result = find_valid_chunk(aligned_size, alignment);
+    // The aligned start could be at most alignment - HEADER_SIZE after the start of an idle chunk.
+    if (result == MEM_NULL && is_growable() && grow(aligned_size + alignment)) {
+        result = find_valid_chunk(aligned_size, alignment);
+    }
+    if (result != MEM_NULL) {
+        stats.on_allocate(aligned_size);
+        return result;
     }
+    stats.on_failed_allocation();
     std::string err_msg = "Failed to allocate memory: not enough space for memory pool.\n"
         "Trying to allocate: " + std::to_string(aligned_size) + " bytes.\n"
         "Pool status: " + static_cast<std::string>(*this);
     throw std::runtime_error(err_msg);
 }
 
+MemID HeapAllocatorAlignedPool::find_valid_chunk(size_t p_aligned_size, size_t p_alignment) {
+    IdleListNode** link = &idle_list_head;
+    while (*link != nullptr) {
+        char* node_start = reinterpret_cast<char*>(*link);
+        // Find the aligned starting point.
+        char* idle_node_mem_start = reinterpret_cast<char*>(
+            get_align_size(reinterpret_cast<uintptr_t>(node_start) + HEADER_SIZE, p_alignment)) - HEADER_SIZE;
+        // If idle node valid, insert.
+        if (idle_node_mem_start + p_aligned_size <= node_start + (*link)->size) {
+            void* result_loc = acquire_memory(link, idle_node_mem_start, p_aligned_size);
+            *static_cast<Header*>(result_loc) = p_aligned_size;
+            internal_fragmentation_tracker = std::max(internal_fragmentation_tracker, (size_t)result_loc + p_aligned_size - (size_t)mem_chunk);
+            return reinterpret_cast<MemID>(result_loc) + HEADER_SIZE;
+        }
+        link = &(*link)->next;
+    }
+    return MEM_NULL;
+}
+
 void HeapAllocatorAlignedPool::deallocate(MemID p_mem) {
     WBE_DEBUG_ASSERT(is_in_pool(p_mem));
     // The first 64 bits are used to store the header.
     char* data_loc = reinterpret_cast<char*>(p_mem - HEADER_SIZE);
     size_t data_size = WBE_GET_ALLOCATED_DATA_SIZE(p_mem);
-    if (idle_list_head == nullptr || idle_list_head->mem_start > data_loc) {
-        insert_free_memory(nullptr, data_loc, data_size);
-        return;
-    }
-    IdleListNode* insert_pos = get_idle_node_before(data_loc).get();
-    insert_free_memory(insert_pos, data_loc, data_size);
+    insert_free_memory(data_loc, data_size);
+    stats.on_deallocate(data_size);
 }
 
-void* HeapAllocatorAlignedPool::acquire_memory(std::unique_ptr<IdleListNode>& p_node, char* p_mem_start, size_t p_mem_size) {
-    WBE_DEBUG_ASSERT(p_mem_start >= p_node->mem_start);
-    WBE_DEBUG_ASSERT(p_mem_start + p_mem_size <= p_node->mem_start + p_node->size);
-    if (p_node->mem_start == p_mem_start) {
-        p_node->size -= p_mem_size;
-        void* node_mem_start = p_node->mem_start;
-        if (p_node->size == 0) {
-            --idle_chunks_count;
-            if (p_node->next == nullptr) {
-                p_node = nullptr;
-                return node_mem_start;
-            }
-            p_node->size = p_node->next->size;
-            p_node->mem_start = p_node->next->mem_start;
-            p_node->next = std::move(p_node->next->next);
-        }
-        else {
-            p_node->mem_start += p_mem_size;
-        }
-        return node_mem_start;
+bool HeapAllocatorAlignedPool::try_expand(MemID p_mem, size_t p_new_size) {
+    WBE_DEBUG_ASSERT(is_in_pool(p_mem));
+    if (p_new_size == 0) {
+        return false;
     }
-    else {
-        int node_size_diff = p_mem_start - p_node->mem_start;
-        if (p_mem_start + p_mem_size != p_node->mem_start + p_node->size) {
-            std::unique_ptr<IdleListNode> node_next = std::make_unique<IdleListNode>();
-            node_next->mem_start = p_mem_start + p_mem_size;
-            node_next->size = p_node->size - node_size_diff - p_mem_size;
-            node_next->next = std::move(p_node->next);
-            p_node->next = std::move(node_next);
+    char* chunk = reinterpret_cast<char*>(p_mem - HEADER_SIZE);
+    size_t chunk_size = WBE_GET_CHUNK_SIZE(chunk);
+    size_t new_chunk_size = get_align_size(p_new_size, WBE_DEFAULT_ALIGNMENT) + HEADER_SIZE;
+    if (new_chunk_size <= chunk_size) {
+        if (new_chunk_size != chunk_size) {
+            *reinterpret_cast<Header*>(chunk) = new_chunk_size;
+            insert_free_memory(chunk + new_chunk_size, chunk_size - new_chunk_size);
+            stats.on_resize(chunk_size, new_chunk_size);
         }
-        p_node->size = node_size_diff;
-        return p_mem_start;
+        return true;
     }
+    char* chunk_end = chunk + chunk_size;
+    IdleListNode** link = &idle_list_head;
+    while (*link != nullptr && reinterpret_cast<char*>(*link) < chunk_end) {
+        link = &(*link)->next;
+    }
+    bool next_idle = reinterpret_cast<char*>(*link) == chunk_end;
+    size_t available_size = chunk_size + (next_idle ? (*link)->size : 0);
+    // An allocation at the end of a growable pool could expand into the newly committed memory.
+    if (available_size < new_chunk_size && is_growable() && chunk + available_size == mem_chunk + size
+        && grow(new_chunk_size - available_size)) {
+        // The committed memory is merged into the idle chunk after the allocation, or linked there.
+        WBE_DEBUG_ASSERT(reinterpret_cast<char*>(*link) == chunk_end);
+        next_idle = true;
+        available_size = chunk_size + (*link)->size;
+    }
+    if (!next_idle || available_size < new_chunk_size) {
+        return false;
+    }
+    acquire_memory(link, chunk_end, new_chunk_size - chunk_size);
+    *reinterpret_cast<Header*>(chunk) = new_chunk_size;
+    internal_fragmentation_tracker = std::max(internal_fragmentation_tracker, (size_t)(chunk + new_chunk_size - mem_chunk));
+    stats.on_resize(chunk_size, new_chunk_size);
+    return true;
 }
 
-void HeapAllocatorAlignedPool::insert_free_memory(IdleListNode* p_node_before_insert, char* p_insert_start, size_t p_insert_size) {
-    if (idle_list_head == nullptr) {
-        idle_list_head = std::make_unique<IdleListNode>();
+void* HeapAllocatorAlignedPool::acquire_memory(IdleListNode** p_link, char* p_mem_start, size_t p_mem_size) {
+    IdleListNode* node = *p_link;
+    char* node_start = reinterpret_cast<char*>(node);
+    char* node_end = node_start + node->size;
+    char* mem_end = p_mem_start + p_mem_size;
+    WBE_DEBUG_ASSERT(p_mem_start >= node_start);
+    WBE_DEBUG_ASSERT(mem_end <= node_end);
+    IdleListNode* next = node->next;
+    free_size -= p_mem_size;
+    // Keep the idle memory after the acquired memory.
+    if (mem_end != node_end) {
+        IdleListNode* after = reinterpret_cast<IdleListNode*>(mem_end);
+        after->size = node_end - mem_end;
+        after->next = next;
+        next = after;
         ++idle_chunks_count;
-        idle_list_head->mem_start = p_insert_start;
-        idle_list_head->size = p_insert_size;
-        return;
     }
+    // Keep the idle memory before the acquired memory.
+    if (p_mem_start != node_start) {
+        node->size = p_mem_start - node_start;
+        node->next = next;
+    }
+    else {
+        *p_link = next;
+        --idle_chunks_count;
+    }
+    return p_mem_start;
+}
 
-    std::unique_ptr<IdleListNode> insert_node = std::make_unique<IdleListNode>();
+void HeapAllocatorAlignedPool::insert_free_memory(char* p_insert_start, size_t p_insert_size) {
+    // Find the idle chunks right before and after the inserted memory.
+    IdleListNode* prev = nullptr;
+    IdleListNode* next = idle_list_head;
+    while (next != nullptr && reinterpret_cast<char*>(next) < p_insert_start) {
+        prev = next;
+        next = next->next;
+    }
+    IdleListNode* node = reinterpret_cast<IdleListNode*>(p_insert_start);
+    node->size = p_insert_size;
+    node->next = next;
     ++idle_chunks_count;
-    insert_node->mem_start = p_insert_start;
-    insert_node->size = p_insert_size;
-    if (p_node_before_insert == nullptr) {
-        insert_node->next = std::move(idle_list_head);
-        idle_list_head = std::move(insert_node);
-        combine_idle_with_next(idle_list_head.get());
-        return;
+    free_size += p_insert_size;
+    if (next != nullptr && p_insert_start + p_insert_size == reinterpret_cast<char*>(next)) {
+        node->size += next->size;
+        node->next = next->next;
+        --idle_chunks_count;
     }
-
-    insert_node->next = std::move(p_node_before_insert->next);
-    p_node_before_insert->next = std::move(insert_node);
-    if (combine_idle_with_next(p_node_before_insert)) {
-        combine_idle_with_next(p_node_before_insert);
+    if (prev == nullptr) {
+        idle_list_head = node;
     }
-    else if (p_node_before_insert->next != nullptr) {
-        combine_idle_with_next(p_node_before_insert->next.get());
+    else if (reinterpret_cast<char*>(prev) + prev->size == p_insert_start) {
+        prev->size += node->size;
+        prev->next = node->next;
+        --idle_chunks_count;
+    }
+    else {
+        prev->next = node;
     }
 }
 
-bool HeapAllocatorAlignedPool::combine_idle_with_next(IdleListNode* p_node) {
-    WBE_DEBUG_ASSERT(p_node != nullptr);
-    if (p_node->next == nullptr || p_node->mem_start + p_node->size != p_node->next->mem_start) {
+bool HeapAllocatorAlignedPool::grow(size_t p_size) {
+    size_t reserved_size = virtual_memory->get_reserved_size();
+    if (size >= reserved_size) {
         return false;
     }
-    p_node->size += p_node->next->size;
-    p_node->next = std::move(p_node->next->next);
-    --idle_chunks_count;
+    // Grow by at least the current size to amortize the commits.
+    size_t new_size = std::min(size + std::max(p_size, size), reserved_size);
+    virtual_memory->commit(new_size);
+    new_size = std::min(virtual_memory->get_committed_size(), reserved_size);
+    char* new_chunk = mem_chunk + size;
+    size_t new_chunk_size = new_size - size;
+    size = new_size;
+    // Merged with the idle chunk at the end of the pool, if any.
+    insert_free_memory(new_chunk, new_chunk_size);
     return true;
 }
 
-std::unique_ptr<HeapAllocatorAlignedPool::IdleListNode>& HeapAllocatorAlignedPool::get_idle_node_before(void* p_loc) {
-    std::unique_ptr<IdleListNode>* curr = &idle_list_head;
-    while (curr != nullptr) {
-        if ((*curr)->next == nullptr || (*curr)->next->mem_start > p_loc) {
-            return *curr;
-        }
-        curr = &((*curr)->next);
-    }
-    throw std::runtime_error("Unreachable code.");
+AllocatorStats HeapAllocatorAlignedPool::get_stats() const {
+    AllocatorStats result;
+    stats.fill(result);
+    result.free_bytes = free_size;
+    return result;
 }
 
-
-size_t HeapAllocatorAlignedPool::get_remain_size() const {
-    IdleListNode* node = idle_list_head.get();
-    size_t total = 0;
-    while (node != nullptr) {
-        total += node->size;
-        node = node->next.get();
+size_t HeapAllocatorAlignedPool::get_largest_free_block() const {
+    size_t result = 0;
+    for (const IdleListNode* node = idle_list_head; node != nullptr; node = node->next) {
+        result = std::max(result, node->size);
     }
-    return total;
+    return result;
 }
 
 bool HeapAllocatorAlignedPool::is_in_pool(MemID p_mem_id) const {
-    const IdleListNode* curr = idle_list_head.get();
+    const IdleListNode* curr = idle_list_head;
     char* tracker = mem_chunk;
     while (tracker < mem_chunk + size) {
         if (reinterpret_cast<MemID>(tracker) > p_mem_id) {
             return false;
         }
-        if (curr != nullptr && curr->mem_start == tracker) {
+        if (curr != nullptr && reinterpret_cast<const char*>(curr) == tracker) {
             tracker += curr->size;
-            curr = curr->next.get();
+            curr = curr->next;
         }
         else if (p_mem_id == reinterpret_cast<MemID>(tracker) + HEADER_SIZE) {
             return true;
@@ -234,16 +298,16 @@ HeapAllocatorAlignedPool::operator std::string() const {
     ss << "\"type\":\"HeapAllocatorAlignedPool\",";
     ss << "\"total_size\":" << get_total_size() << ",";
     ss << "\"free_chunk_layout\":[";
-    IdleListNode* node = idle_list_head.get();
+    const IdleListNode* node = idle_list_head;
     bool first = true;
     while (node != nullptr) {
         if (!first) ss << ",";
         first = false;
         ss << "{"
-            << "\"begin\":" << (node->mem_start - mem_chunk) << ","
+            << "\"begin\":" << (reinterpret_cast<const char*>(node) - mem_chunk) << ","
             << "\"size\":" << node->size
             << "}";
-        node = node->next.get();
+        node = node->next;
     }
     ss << "]";
     ss << "}";
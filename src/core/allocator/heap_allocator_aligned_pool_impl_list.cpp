@@ -22,6 +22,7 @@
 #include <cstdint>
 #include <format>
 #include <iostream>
+#include <numeric>
 #include <stdexcept>
 #include <string>
 
@@ -34,6 +35,10 @@
 #define WBE_HAAPIL_SET_HEADER(p_header, p_head_type, p_size) (*p_header = (((Header)(p_head_type) << 60) | (p_size)))
 #define WBE_HAAPIL_SET_CHUNK_HEADER(p_chunk, p_type, p_size) WBE_HAAPIL_SET_HEADER(reinterpret_cast<Header*>(p_chunk), (p_type), (p_size))
 
+#define WBE_HAAPIL_IS_PREV_IDLE(p_chunk) ((*reinterpret_cast<Header*>(p_chunk) & PREV_IDLE_MASK) != 0)
+#define WBE_HAAPIL_GET_FOOTER(p_chunk, p_size) reinterpret_cast<Header*>((p_chunk) + (p_size) - sizeof(Header))
+#define WBE_HAAPIL_GET_PREV_CHUNK_SIZE(p_chunk) (*reinterpret_cast<Header*>((p_chunk) - sizeof(Header)))
+
 #define WBE_HAAPIL_UPDATE_POSIBLE_VALID(update_to)\
     /*If possible_valid did not contain a data, could be updated.*/\
     if(possible_valid == nullptr\
@@ -47,19 +52,43 @@
 
 namespace WhiteBirdEngine {
 
-HeapAllocatorAlignedPoolImplicitList::HeapAllocatorAlignedPoolImplicitList(size_t p_size)
+HeapAllocatorAlignedPoolImplicitList::HeapAllocatorAlignedPoolImplicitList(size_t p_size, size_t p_reserve_size, bool p_huge_pages)
     : size(p_size) {
-    if (p_size > TOTAL_SIZE_MASK) {
+    if (std::max(p_size, p_reserve_size) > TOTAL_SIZE_MASK) {
         throw std::runtime_error(std::format("Failed to create pool: size: {}  exceeds maximum: {}.",
-                                             p_size, TOTAL_SIZE_MASK));
+                                             std::max(p_size, p_reserve_size), TOTAL_SIZE_MASK));
+    }
+    if (p_reserve_size != 0) {
+        if (p_reserve_size < p_size) {
+            throw std::runtime_error(std::format("Failed to create pool: reserve size: {} is less than size: {}.",
+                                                 p_reserve_size, p_size));
+        }
+        virtual_memory = std::make_unique<VirtualMemoryRange>(p_reserve_size, p_size, p_huge_pages);
+        growable = true;
     }
-    mem_chunk = static_cast<char*>(aligned_alloc(HEADER_SIZE, p_size));
-    if (mem_chunk == nullptr) {
-        throw std::runtime_error("Failed to create pool: malloc failed.");
+    else if (p_huge_pages) {
+        virtual_memory = std::make_unique<VirtualMemoryRange>(p_size, p_size, true);
+    }
+    if (virtual_memory != nullptr) {
+        mem_chunk = virtual_memory->get_data();
+        // The committed pages are zero filled, and only backed by physical memory when touched.
+        size = virtual_memory->get_committed_size();
+    }
+    else {
+        // Keep every chunk a multiple of HEADER_SIZE, so that an idle chunk could hold both its header and footer.
+        size = p_size / HEADER_SIZE * HEADER_SIZE;
+        if (size == 0) {
+            throw std::runtime_error(std::format("Failed to create pool: size: {} is less than the header size: {}.", p_size, HEADER_SIZE));
+        }
+        mem_chunk = static_cast<char*>(aligned_alloc(HEADER_SIZE, size));
+        if (mem_chunk == nullptr) {
+            throw std::runtime_error("Failed to create pool: malloc failed.");
+        }
+        memset(mem_chunk, 0, size);
     }
-    memset(mem_chunk, 0, p_size);
-    WBE_HAAPIL_SET_CHUNK_HEADER(mem_chunk, HeaderType::IDLE, size);
+    write_chunk(mem_chunk, HeaderType::IDLE, size, false);
     possible_valid = mem_chunk;
+    free_size = size;
 }
 
 HeapAllocatorAlignedPoolImplicitList::~HeapAllocatorAlignedPoolImplicitList() {
@@ -67,48 +96,82 @@ HeapAllocatorAlignedPoolImplicitList::~HeapAllocatorAlignedPoolImplicitList() {
         wbe_console_log(WBE_CHANNEL_GLOBAL)->warning(std::format("Non-empty allocator destructed. Allocator status: {}",
                                                                  static_cast<std::string>(*this)));
     }
-    free(mem_chunk);
+    if (virtual_memory == nullptr) {
+        free(mem_chunk);
+    }
     mem_chunk = nullptr;
 }
 
 MemID HeapAllocatorAlignedPoolImplicitList::allocate(size_t p_size, size_t p_alignment) {
     WBE_DEBUG(check_broken();)
-    if (p_alignment == 0) {
-        throw std::runtime_error("Allocation alignment must not be 0");
-    }
-    if (p_alignment % alignof(Header) != 0) {
-        throw std::runtime_error(std::format("Allocation alignment must be a multiple of {}", alignof(Header)));
-    }
+    check_alignment(p_alignment);
     if (p_size == 0) {
         return MEM_NULL;
     }
     // Clamp the padding size to the default alignment.
     size_t aligned_size = get_align_size(p_size, HEADER_SIZE) + HEADER_SIZE;
-    MemID result = find_valid_chunk<false>(aligned_size, p_alignment);
-    if (result == MEM_NULL) {
-        result = find_valid_chunk<true>(aligned_size, p_alignment);
-        if (result != MEM_NULL) {
-            WBE_DEBUG(check_broken();)
-            return result;
-        }
+    // Chunks start at multiples of HEADER_SIZE, so that the padding before an aligned chunk could become an idle chunk.
+    size_t alignment = std::lcm(p_alignment, HEADER_SIZE);
+    MemID result = find_valid_chunk(aligned_size, alignment);
+    // The aligned start could be at most alignment - HEADER_SIZE after the start of an idle chunk.
+    if (result == MEM_NULL && is_growable() && grow(aligned_size + alignment)) {
+        result = find_valid_chunk(aligned_size, alignment);
     }
-    else {
+    if (result != MEM_NULL) {
+        free_size -= aligned_size;
+        stats.on_allocate(aligned_size);
         WBE_DEBUG(check_broken();)
         return result;
     }
+    stats.on_failed_allocation();
     std::string err_msg = "Failed to allocate memory: not enough space for memory pool.\n"
         "Trying to allocate: " + std::to_string(aligned_size) + " bytes.\n"
         "Pool status: " + static_cast<std::string>(*this);
     throw std::runtime_error(err_msg);
 }
 
-template <bool COALESCE_ENABLED>
-MemID HeapAllocatorAlignedPoolImplicitList::check_posible_free(size_t p_aligned_size, size_t p_alignment) {
-    if constexpr (COALESCE_ENABLED) {
-        if (possible_valid != nullptr) {
-            coalesce_chunk(possible_valid);
+void HeapAllocatorAlignedPoolImplicitList::allocate_batch(size_t p_count, size_t p_size, size_t p_alignment, MemID* r_mem_ids) {
+    WBE_DEBUG(check_broken();)
+    check_alignment(p_alignment);
+    if (p_size == 0 || p_count == 0) {
+        std::fill(r_mem_ids, r_mem_ids + p_count, MEM_NULL);
+        return;
+    }
+    size_t aligned_size = get_align_size(p_size, HEADER_SIZE) + HEADER_SIZE;
+    size_t alignment = std::lcm(p_alignment, HEADER_SIZE);
+    // Carve the chunks from one block if every chunk stays aligned.
+    MemID block = MEM_NULL;
+    if (aligned_size % alignment == 0 && p_count <= TOTAL_SIZE_MASK / aligned_size) {
+        block = find_valid_chunk(aligned_size * p_count, alignment);
+        if (block == MEM_NULL && is_growable() && grow(aligned_size * p_count + alignment)) {
+            block = find_valid_chunk(aligned_size * p_count, alignment);
         }
     }
+    if (block == MEM_NULL) {
+        HeapAllocatorAligned::allocate_batch(p_count, p_size, p_alignment, r_mem_ids);
+        return;
+    }
+    char* chunk = reinterpret_cast<char*>(block - HEADER_SIZE);
+    bool prev_idle = WBE_HAAPIL_IS_PREV_IDLE(chunk);
+    for (size_t i = 0; i < p_count; ++i) {
+        write_chunk(chunk + i * aligned_size, HeaderType::OCCUPIED, aligned_size, i == 0 && prev_idle);
+        r_mem_ids[i] = block + i * aligned_size;
+    }
+    free_size -= aligned_size * p_count;
+    stats.on_allocate(aligned_size * p_count, p_count);
+    WBE_DEBUG(check_broken();)
+}
+
+void HeapAllocatorAlignedPoolImplicitList::check_alignment(size_t p_alignment) {
+    if (p_alignment == 0) {
+        throw std::runtime_error("Allocation alignment must not be 0");
+    }
+    if (p_alignment % alignof(Header) != 0) {
+        throw std::runtime_error(std::format("Allocation alignment must be a multiple of {}", alignof(Header)));
+    }
+}
+
+MemID HeapAllocatorAlignedPoolImplicitList::check_posible_free(size_t p_aligned_size, size_t p_alignment) {
     WBE_DEBUG_ASSERT(possible_valid == nullptr || WBE_HAAPIL_GET_CHUNK_TYPE(possible_valid) == HeaderType::IDLE);
     if (possible_valid == nullptr) {
         return MEM_NULL;
@@ -124,20 +187,18 @@ MemID HeapAllocatorAlignedPoolImplicitList::check_posible_free(size_t p_aligned_
     if (idle_mem_start + p_aligned_size <= possible_valid + WBE_HAAPIL_GET_CHUNK_SIZE(possible_valid)) {
         void* result_loc = acquire_memory(possible_valid, idle_mem_start, p_aligned_size);
         MemID result_id = reinterpret_cast<MemID>(result_loc) + HEADER_SIZE;
-        *static_cast<Header*>(result_loc) = p_aligned_size;
         internal_fragmentation_tracker = std::max(internal_fragmentation_tracker, (size_t)result_loc + p_aligned_size - (size_t)mem_chunk);
         return result_id;
     }
     return MEM_NULL;
 }
 
-template <bool COALESCE_ENABLED>
 MemID HeapAllocatorAlignedPoolImplicitList::find_valid_chunk(size_t p_aligned_size, size_t p_alignment) {
-    MemID possible_result = check_posible_free<COALESCE_ENABLED>(p_aligned_size, p_alignment);
+    MemID possible_result = check_posible_free(p_aligned_size, p_alignment);
     if (possible_result != MEM_NULL) {
         return possible_result;
     }
-    char* free_memory = get_next_free_memory<true, COALESCE_ENABLED>(mem_chunk);
+    char* free_memory = get_next_free_memory<true>(mem_chunk);
     while (free_memory != nullptr) {
         // Find the aligned starting point.
         uintptr_t proxy_mem_start_addr = reinterpret_cast<uintptr_t>(free_memory) + HEADER_SIZE;
@@ -149,11 +210,10 @@ MemID HeapAllocatorAlignedPoolImplicitList::find_valid_chunk(size_t p_aligned_si
         if (idle_mem_start + p_aligned_size <= free_memory + WBE_HAAPIL_GET_CHUNK_SIZE(free_memory)) {
             void* result_loc = acquire_memory(free_memory, idle_mem_start, p_aligned_size);
             MemID result_id = reinterpret_cast<MemID>(result_loc) + HEADER_SIZE;
-            *static_cast<Header*>(result_loc) = p_aligned_size;
             internal_fragmentation_tracker = std::max(internal_fragmentation_tracker, (size_t)result_loc + p_aligned_size - (size_t)mem_chunk);
             return result_id;
         }
-        free_memory = get_next_free_memory<false, COALESCE_ENABLED>(free_memory);
+        free_memory = get_next_free_memory<false>(free_memory);
     }
     // If not found, return null.
     return MEM_NULL;
@@ -168,14 +228,60 @@ void HeapAllocatorAlignedPoolImplicitList::deallocate(MemID p_mem) {
     char* data_loc = reinterpret_cast<char*>(p_mem - HEADER_SIZE);
     size_t data_size = WBE_HAAPIL_GET_HEADER_SIZE(*reinterpret_cast<Header*>((p_mem - HEADER_SIZE)));
     insert_free_memory(data_loc, data_size);
+    free_size += data_size;
+    stats.on_deallocate(data_size);
     WBE_DEBUG(check_broken();)
 }
 
-template <bool CHECK_FIRST, bool COALESCE_ENABLED>
-char* HeapAllocatorAlignedPoolImplicitList::get_next_free_memory(char* p_from) {
-    if constexpr (COALESCE_ENABLED) {
-        coalesce_chunk(p_from);
+bool HeapAllocatorAlignedPoolImplicitList::try_expand(MemID p_mem, size_t p_new_size) {
+    WBE_DEBUG(check_broken();)
+    WBE_DEBUG_ASSERT(is_in_pool(p_mem));
+    if (p_new_size == 0) {
+        return false;
+    }
+    char* chunk = reinterpret_cast<char*>(p_mem - HEADER_SIZE);
+    size_t chunk_size = WBE_HAAPIL_GET_CHUNK_SIZE(chunk);
+    size_t new_chunk_size = get_align_size(p_new_size, HEADER_SIZE) + HEADER_SIZE;
+    bool prev_idle = WBE_HAAPIL_IS_PREV_IDLE(chunk);
+    if (new_chunk_size <= chunk_size) {
+        if (new_chunk_size != chunk_size) {
+            write_chunk(chunk, HeaderType::OCCUPIED, new_chunk_size, prev_idle);
+            insert_free_memory(chunk + new_chunk_size, chunk_size - new_chunk_size);
+            free_size += chunk_size - new_chunk_size;
+            stats.on_resize(chunk_size, new_chunk_size);
+        }
+        WBE_DEBUG(check_broken();)
+        return true;
+    }
+    char* next_chunk = chunk + chunk_size;
+    bool next_idle = next_chunk < mem_chunk + size && WBE_HAAPIL_GET_CHUNK_TYPE(next_chunk) == HeaderType::IDLE;
+    size_t available_size = chunk_size + (next_idle ? WBE_HAAPIL_GET_CHUNK_SIZE(next_chunk) : 0);
+    // An allocation at the end of a growable pool could expand into the newly committed memory.
+    if (available_size < new_chunk_size && is_growable() && chunk + available_size == mem_chunk + size
+        && grow(new_chunk_size - available_size)) {
+        next_idle = true;
+        available_size = chunk_size + WBE_HAAPIL_GET_CHUNK_SIZE(next_chunk);
+    }
+    if (available_size < new_chunk_size) {
+        return false;
+    }
+    size_t idle_after_size = available_size - new_chunk_size;
+    write_chunk(chunk, HeaderType::OCCUPIED, new_chunk_size, prev_idle);
+    if (idle_after_size != 0) {
+        write_chunk(chunk + new_chunk_size, HeaderType::IDLE, idle_after_size, false);
     }
+    if (possible_valid == next_chunk) {
+        possible_valid = idle_after_size != 0 ? chunk + new_chunk_size : nullptr;
+    }
+    internal_fragmentation_tracker = std::max(internal_fragmentation_tracker, (size_t)(chunk + new_chunk_size - mem_chunk));
+    free_size -= new_chunk_size - chunk_size;
+    stats.on_resize(chunk_size, new_chunk_size);
+    WBE_DEBUG(check_broken();)
+    return true;
+}
+
+template <bool CHECK_FIRST>
+char* HeapAllocatorAlignedPoolImplicitList::get_next_free_memory(char* p_from) {
     if constexpr (CHECK_FIRST) {
         while (WBE_HAAPIL_GET_CHUNK_TYPE(p_from) != HeaderType::IDLE) {
             p_from += WBE_HAAPIL_GET_CHUNK_SIZE(p_from);
@@ -200,35 +306,90 @@ void* HeapAllocatorAlignedPoolImplicitList::acquire_memory(char* p_idle_chunk, c
     WBE_DEBUG_ASSERT(WBE_HAAPIL_GET_CHUNK_TYPE(p_idle_chunk) == HeaderType::IDLE);
     size_t idle_chunk_size = WBE_HAAPIL_GET_CHUNK_SIZE(p_idle_chunk);
     size_t idle_before_size = p_mem_start - p_idle_chunk;
-    // Get the inserted memory.
-    WBE_HAAPIL_SET_CHUNK_HEADER(p_mem_start, HeaderType::OCCUPIED, p_mem_size);
-    char* next_chunk = p_idle_chunk + p_mem_size;
+    size_t idle_after_size = idle_chunk_size - idle_before_size - p_mem_size;
+    // An idle chunk is never next to another idle chunk, so the chunk before it is occupied.
+    write_chunk(p_mem_start, HeaderType::OCCUPIED, p_mem_size, idle_before_size != 0);
     // Insert the idle memory before the acquired memory chunk.
-    if (p_idle_chunk != p_mem_start) {
-        WBE_HAAPIL_SET_CHUNK_HEADER(p_idle_chunk, HeaderType::IDLE, idle_before_size);
-        WBE_HAAPIL_UPDATE_POSIBLE_VALID(p_idle_chunk);
+    if (idle_before_size != 0) {
+        write_chunk(p_idle_chunk, HeaderType::IDLE, idle_before_size, false);
     }
     // Insert the idle memory after the acquired memory chunk.
-    if (p_mem_start + p_mem_size < p_idle_chunk + idle_chunk_size) {
-        // The memory after the acquired should be size: idle_chunk_size - idle_size_before - inserted_memory_size
-        WBE_HAAPIL_SET_CHUNK_HEADER(p_mem_start + p_mem_size, HeaderType::IDLE, idle_chunk_size - idle_before_size - p_mem_size);
-        WBE_HAAPIL_UPDATE_POSIBLE_VALID(p_mem_start + p_mem_size);
+    if (idle_after_size != 0) {
+        write_chunk(p_mem_start + p_mem_size, HeaderType::IDLE, idle_after_size, false);
     }
     // If this acquire uses up the possible_valid,
-    if (possible_valid == nullptr || WBE_HAAPIL_GET_CHUNK_TYPE(possible_valid) == HeaderType::OCCUPIED) {
-        if (next_chunk < mem_chunk + size && WBE_HAAPIL_GET_CHUNK_TYPE(next_chunk) == HeaderType::IDLE) {
-            possible_valid = next_chunk;
-        }
-        else {
-            possible_valid = nullptr;
-        }
+    if (possible_valid == p_idle_chunk && idle_before_size == 0) {
+        possible_valid = nullptr;
+    }
+    if (idle_before_size != 0) {
+        WBE_HAAPIL_UPDATE_POSIBLE_VALID(p_idle_chunk);
+    }
+    if (idle_after_size != 0) {
+        WBE_HAAPIL_UPDATE_POSIBLE_VALID(p_mem_start + p_mem_size);
     }
     return p_mem_start;
 }
 
+bool HeapAllocatorAlignedPoolImplicitList::grow(size_t p_size) {
+    size_t reserved_size = virtual_memory->get_reserved_size();
+    if (size >= reserved_size) {
+        return false;
+    }
+    // Grow by at least the current size to amortize the commits.
+    size_t new_size = std::min(size + std::max(p_size, size), reserved_size);
+    virtual_memory->commit(new_size);
+    new_size = std::min(virtual_memory->get_committed_size(), reserved_size);
+    char* new_chunk = mem_chunk + size;
+    size_t new_chunk_size = new_size - size;
+    // Merge the new chunk with the idle chunk at the end of the pool, if any.
+    if (last_idle) {
+        size_t last_chunk_size = WBE_HAAPIL_GET_PREV_CHUNK_SIZE(new_chunk);
+        new_chunk -= last_chunk_size;
+        new_chunk_size += last_chunk_size;
+    }
+    free_size += new_size - size;
+    size = new_size;
+    write_chunk(new_chunk, HeaderType::IDLE, new_chunk_size, false);
+    WBE_HAAPIL_UPDATE_POSIBLE_VALID(new_chunk);
+    return true;
+}
+
 void HeapAllocatorAlignedPoolImplicitList::insert_free_memory(char* p_insert_start, size_t p_insert_size) {
-    WBE_HAAPIL_SET_CHUNK_HEADER(p_insert_start, HeaderType::IDLE, p_insert_size);
-    coalesce_chunk(p_insert_start);
+    char* next_chunk = p_insert_start + p_insert_size;
+    if (next_chunk < mem_chunk + size && WBE_HAAPIL_GET_CHUNK_TYPE(next_chunk) == HeaderType::IDLE) {
+        p_insert_size += WBE_HAAPIL_GET_CHUNK_SIZE(next_chunk);
+    }
+    if (WBE_HAAPIL_IS_PREV_IDLE(p_insert_start)) {
+        size_t prev_chunk_size = WBE_HAAPIL_GET_PREV_CHUNK_SIZE(p_insert_start);
+        p_insert_start -= prev_chunk_size;
+        p_insert_size += prev_chunk_size;
+    }
+    write_chunk(p_insert_start, HeaderType::IDLE, p_insert_size, false);
+    // The merged next chunk could be possible_valid.
+    if (possible_valid == next_chunk) {
+        possible_valid = p_insert_start;
+    }
+    WBE_HAAPIL_UPDATE_POSIBLE_VALID(p_insert_start);
+}
+
+void HeapAllocatorAlignedPoolImplicitList::write_chunk(char* p_chunk, HeaderType p_type, size_t p_size, bool p_prev_idle) {
+    WBE_HAAPIL_SET_CHUNK_HEADER(p_chunk, p_type, p_size);
+    if (p_prev_idle) {
+        *reinterpret_cast<Header*>(p_chunk) |= PREV_IDLE_MASK;
+    }
+    if (p_type == HeaderType::IDLE) {
+        *WBE_HAAPIL_GET_FOOTER(p_chunk, p_size) = p_size;
+    }
+    char* next_chunk = p_chunk + p_size;
+    if (next_chunk >= mem_chunk + size) {
+        last_idle = p_type == HeaderType::IDLE;
+    }
+    else if (p_type == HeaderType::IDLE) {
+        *reinterpret_cast<Header*>(next_chunk) |= PREV_IDLE_MASK;
+    }
+    else {
+        *reinterpret_cast<Header*>(next_chunk) &= ~PREV_IDLE_MASK;
+    }
 }
 
 size_t HeapAllocatorAlignedPoolImplicitList::get_remain_size() const {
@@ -243,6 +404,23 @@ size_t HeapAllocatorAlignedPoolImplicitList::get_remain_size() const {
     return total;
 }
 
+AllocatorStats HeapAllocatorAlignedPoolImplicitList::get_stats() const {
+    AllocatorStats result;
+    stats.fill(result);
+    result.free_bytes = free_size;
+    return result;
+}
+
+size_t HeapAllocatorAlignedPoolImplicitList::get_largest_free_block() const {
+    size_t result = 0;
+    for (char* curr = mem_chunk; curr < mem_chunk + size; curr += WBE_HAAPIL_GET_CHUNK_SIZE(curr)) {
+        if (WBE_HAAPIL_GET_CHUNK_TYPE(curr) == HeaderType::IDLE) {
+            result = std::max(result, WBE_HAAPIL_GET_CHUNK_SIZE(curr));
+        }
+    }
+    return result;
+}
+
 bool HeapAllocatorAlignedPoolImplicitList::is_in_pool(MemID p_mem_id) const {
     char* curr = mem_chunk;
     char* mem_ptr = reinterpret_cast<char*>(p_mem_id);
@@ -260,36 +438,38 @@ void HeapAllocatorAlignedPoolImplicitList::check_broken() const {
     if (possible_valid != nullptr && WBE_HAAPIL_GET_CHUNK_TYPE(possible_valid) != HeaderType::IDLE) {
         throw std::runtime_error("Broken possible_valid.");
     }
+    bool prev_idle = false;
+    size_t idle_size = 0;
     while (curr < mem_chunk + size) {
-        if (WBE_HAAPIL_GET_CHUNK_SIZE(curr) == 0) {
+        size_t chunk_size = WBE_HAAPIL_GET_CHUNK_SIZE(curr);
+        if (chunk_size == 0) {
             throw std::runtime_error("Size is 0.");
         }
-        curr += WBE_HAAPIL_GET_CHUNK_SIZE(curr);
+        if (WBE_HAAPIL_IS_PREV_IDLE(curr) != prev_idle) {
+            throw std::runtime_error("Broken previous idle flag.");
+        }
+        bool idle = WBE_HAAPIL_GET_CHUNK_TYPE(curr) == HeaderType::IDLE;
+        if (idle && prev_idle) {
+            throw std::runtime_error("Adjacent idle chunks not merged.");
+        }
+        if (idle && *WBE_HAAPIL_GET_FOOTER(curr, chunk_size) != chunk_size) {
+            throw std::runtime_error("Broken footer.");
+        }
+        if (idle) {
+            idle_size += chunk_size;
+        }
+        prev_idle = idle;
+        curr += chunk_size;
     }
     if (curr != mem_chunk + size) {
         throw std::runtime_error("Bad pool.");
     }
-}
-
-void HeapAllocatorAlignedPoolImplicitList::coalesce_all() const {
-    char* curr = mem_chunk;
-    do {
-        coalesce_chunk(curr);
-        curr += WBE_HAAPIL_GET_CHUNK_SIZE(curr);
-    } while (curr < mem_chunk + size);
-}
-
-void HeapAllocatorAlignedPoolImplicitList::coalesce_chunk(char* p_chunk) const {
-    if (WBE_HAAPIL_GET_CHUNK_TYPE(p_chunk) != HeaderType::IDLE) {
-        return;
+    if (prev_idle != last_idle) {
+        throw std::runtime_error("Broken last idle flag.");
     }
-    // Coalesce is not really changing the internal data. So here it allows to be called in a const function.
-    size_t chunk_size = WBE_HAAPIL_GET_CHUNK_SIZE(p_chunk);
-    while (p_chunk + chunk_size < mem_chunk + size && WBE_HAAPIL_GET_CHUNK_TYPE(p_chunk + chunk_size) == HeaderType::IDLE) {
-        WBE_HAAPIL_SET_CHUNK_HEADER(p_chunk, HeaderType::IDLE, chunk_size + WBE_HAAPIL_GET_CHUNK_SIZE(p_chunk + chunk_size));
-        chunk_size = WBE_HAAPIL_GET_CHUNK_SIZE(p_chunk);
+    if (idle_size != free_size) {
+        throw std::runtime_error("Broken free size.");
     }
-    WBE_HAAPIL_UPDATE_POSIBLE_VALID(p_chunk);
 }
 
 HeapAllocatorAlignedPoolImplicitList::operator std::string() const {
@@ -297,6 +477,9 @@ HeapAllocatorAlignedPoolImplicitList::operator std::string() const {
     ss << "{";
     ss << "\"type\":\"HeapAllocatorAlignedPoolImplicitList\",";
     ss << "\"total_size\":" << get_total_size() << ",";
+    ss << "\"committed_size\":" << get_committed_size() << ",";
+    ss << "\"reserved_size\":" << get_reserved_size() << ",";
+    ss << "\"page_backing\":\"" << get_page_backing_name(get_page_backing()) << "\",";
     ss << "\"chunk_layout\":[";
     char* curr = mem_chunk;
     bool first = true;
@@ -30,45 +30,142 @@
 
 namespace WhiteBirdEngine {
 
-HeapAllocatorAtomicAlignedPool::HeapAllocatorAtomicAlignedPool(size_t p_size)
+HeapAllocatorAtomicAlignedPool::HeapAllocatorAtomicAlignedPool(size_t p_size, size_t p_reserve_size)
     : size(p_size) {
-    if (p_size > MAX_TOTAL_SIZE) {
-        throw std::runtime_error("Failed to create pool: size: " + std::to_string(p_size) + " exceeds maximum: " + std::to_string(MAX_TOTAL_SIZE) + ".");
+    if (std::max(p_size, p_reserve_size) > MAX_TOTAL_SIZE) {
+        throw std::runtime_error("Failed to create pool: size: " + std::to_string(std::max(p_size, p_reserve_size)) + " exceeds maximum: " + std::to_string(MAX_TOTAL_SIZE) + ".");
     }
-    mem_chunk = static_cast<char*>(malloc(p_size));
-    if (mem_chunk == nullptr) {
-        throw std::runtime_error("Failed to create pool: malloc failed.");
+    if (p_reserve_size != 0) {
+        if (p_reserve_size < p_size) {
+            throw std::runtime_error(std::format("Failed to create pool: reserve size: {} is less than size: {}.",
+                                                 p_reserve_size, p_size));
+        }
+        virtual_memory = std::make_unique<VirtualMemoryRange>(p_reserve_size, p_size);
+        mem_chunk = virtual_memory->get_data();
+        size = virtual_memory->get_committed_size();
+    }
+    else {
+        mem_chunk = static_cast<char*>(malloc(p_size));
+        if (mem_chunk == nullptr) {
+            throw std::runtime_error("Failed to create pool: malloc failed.");
+        }
     }
     idle_list_head = std::make_unique<IdleListNode>();
-    idle_list_head->size = p_size;
+    idle_list_head->size = size;
     idle_list_head->next = nullptr;
     idle_list_head->mem_start = mem_chunk;
     idle_chunks_count = 1;
+    free_size = size;
 }
 
 HeapAllocatorAtomicAlignedPool::~HeapAllocatorAtomicAlignedPool() {
     if (!is_empty()) {
         wbe_console_log(WBE_CHANNEL_GLOBAL)->warning("Non-empty allocator destructed.");
     }
-    free(mem_chunk);
+    if (virtual_memory == nullptr) {
+        free(mem_chunk);
+    }
     mem_chunk = nullptr;
 }
 
 MemID HeapAllocatorAtomicAlignedPool::allocate(size_t p_size, size_t p_alignment) {
+    check_alignment(p_alignment);
+    if (p_size == 0) {
+        return MEM_NULL;
+    }
+    // Clamp the padding size to the default alignment.
+    size_t aligned_size = get_align_size(p_size, WBE_DEFAULT_ALIGNMENT) + HEADER_SIZE;
+    boost::unique_lock lock(mutex, boost::defer_lock);
+    stats.on_lock_wait(lock_and_measure_wait(lock));
+    MemID result = unguard_allocate(aligned_size, p_alignment);
+    if (result != MEM_NULL) {
+        stats.on_allocate(aligned_size);
+    }
+    else {
+        stats.on_failed_allocation();
+        lock.unlock();
+        std::string err_msg = "Failed to allocate memory: not enough space for memory pool.\n"
+            "Trying to allocate: " + std::to_string(aligned_size) + " bytes.\n"
+            "Pool status: " + static_cast<std::string>(*this);
+        throw std::runtime_error(err_msg);
+    }
+    return result;
+}
+
+void HeapAllocatorAtomicAlignedPool::allocate_batch(size_t p_count, size_t p_size, size_t p_alignment, MemID* r_mem_ids) {
+    check_alignment(p_alignment);
+    if (p_size == 0 || p_count == 0) {
+        std::fill(r_mem_ids, r_mem_ids + p_count, MEM_NULL);
+        return;
+    }
+    size_t aligned_size = get_align_size(p_size, WBE_DEFAULT_ALIGNMENT) + HEADER_SIZE;
+    boost::unique_lock lock(mutex, boost::defer_lock);
+    stats.on_lock_wait(lock_and_measure_wait(lock));
+    // Carve the chunks from one block if every chunk stays aligned.
+    MemID block = aligned_size % p_alignment == 0 && p_count <= MAX_TOTAL_SIZE / aligned_size ?
+        unguard_allocate(aligned_size * p_count, p_alignment) : MEM_NULL;
+    if (block != MEM_NULL) {
+        for (size_t i = 0; i < p_count; ++i) {
+            *reinterpret_cast<Header*>(block - HEADER_SIZE + i * aligned_size) = aligned_size;
+            r_mem_ids[i] = block + i * aligned_size;
+        }
+        stats.on_allocate(aligned_size * p_count, p_count);
+        return;
+    }
+    for (size_t i = 0; i < p_count; ++i) {
+        r_mem_ids[i] = unguard_allocate(aligned_size, p_alignment);
+        if (r_mem_ids[i] == MEM_NULL) {
+            stats.on_failed_allocation();
+            // Roll back the chunks that are already allocated.
+            for (size_t j = 0; j < i; ++j) {
+                unguard_deallocate(r_mem_ids[j]);
+            }
+            lock.unlock();
+            std::string err_msg = "Failed to allocate memory: not enough space for memory pool.\n"
+                "Trying to allocate: " + std::to_string(p_count) + " chunks of " + std::to_string(aligned_size) + " bytes.\n"
+                "Pool status: " + static_cast<std::string>(*this);
+            throw std::runtime_error(err_msg);
+        }
+        stats.on_allocate(aligned_size);
+    }
+}
+
+void HeapAllocatorAtomicAlignedPool::deallocate(MemID p_mem) {
+    boost::unique_lock lock(mutex, boost::defer_lock);
+    stats.on_lock_wait(lock_and_measure_wait(lock));
+    unguard_deallocate(p_mem);
+}
+
+void HeapAllocatorAtomicAlignedPool::deallocate_batch(const MemID* p_mem_ids, size_t p_count) {
+    boost::unique_lock lock(mutex, boost::defer_lock);
+    stats.on_lock_wait(lock_and_measure_wait(lock));
+    for (size_t i = 0; i < p_count; ++i) {
+        if (p_mem_ids[i] != MEM_NULL) {
+            unguard_deallocate(p_mem_ids[i]);
+        }
+    }
+}
+
+void HeapAllocatorAtomicAlignedPool::check_alignment(size_t p_alignment) {
     if (p_alignment == 0) {
         throw std::runtime_error("Failed to allocate resource: allocation alignment must not be 0.");
     }
     if (p_alignment % alignof(Header) != 0) {
         throw std::runtime_error(std::format("Allocation alignment must be a multiple of {}", alignof(Header)));
     }
-    if (p_size == 0) {
-        return MEM_NULL;
+}
+
+MemID HeapAllocatorAtomicAlignedPool::unguard_allocate(size_t p_aligned_size, size_t p_alignment) {
+    MemID result = find_valid_chunk(p_aligned_size, p_alignment);
+    // The aligned start could be at most p_alignment after the start of an idle chunk.
+    if (result == MEM_NULL && is_growable() && grow(p_aligned_size + p_alignment)) {
+        result = find_valid_chunk(p_aligned_size, p_alignment);
     }
-    // Share lock this when finding valid space for allocation, then unique lock when found.
-    boost::upgrade_lock lock(mutex);
+    return result;
+}
+
+MemID HeapAllocatorAtomicAlignedPool::find_valid_chunk(size_t p_aligned_size, size_t p_alignment) {
     std::unique_ptr<IdleListNode>* valid_idle_node = &idle_list_head;
-    // Clamp the padding size to the default alignment.
-    size_t aligned_size = get_align_size(p_size, WBE_DEFAULT_ALIGNMENT) + HEADER_SIZE;
     while (*valid_idle_node != nullptr) {
         // Find the aligned starting point.
         uintptr_t proxy_mem_start_addr = reinterpret_cast<uintptr_t>((*valid_idle_node)->mem_start) + HEADER_SIZE;
@@ -77,33 +174,25 @@ MemID HeapAllocatorAtomicAlignedPool::allocate(size_t p_size, size_t p_alignment
                 proxy_mem_start_addr : (proxy_mem_start_addr / p_alignment + 1) * p_alignment
         ) - HEADER_SIZE;
         // If idle node valid, insert.
-        if (idle_node_mem_start + aligned_size <= (*valid_idle_node)->mem_start + (*valid_idle_node)->size) {
-            // Upgrade the shared lock to unique lock.
-            boost::upgrade_to_unique_lock unique_lock(lock);
-            void* result_loc = acquire_memory(*valid_idle_node, idle_node_mem_start, aligned_size);
+        if (idle_node_mem_start + p_aligned_size <= (*valid_idle_node)->mem_start + (*valid_idle_node)->size) {
+            void* result_loc = acquire_memory(*valid_idle_node, idle_node_mem_start, p_aligned_size);
             MemID result_id = reinterpret_cast<MemID>(result_loc) + HEADER_SIZE;
-            *static_cast<Header*>(result_loc) = aligned_size;
-            internal_fragmentation_tracker = std::max(internal_fragmentation_tracker, (size_t)result_loc + aligned_size - (size_t)mem_chunk);
+            *static_cast<Header*>(result_loc) = p_aligned_size;
+            internal_fragmentation_tracker = std::max(internal_fragmentation_tracker, (size_t)result_loc + p_aligned_size - (size_t)mem_chunk);
             return result_id;
         }
         valid_idle_node = &((*valid_idle_node)->next);
     }
-    std::string err_msg = "Failed to allocate memory: not enough space for memory pool.\n"
-        "Trying to allocate: " + std::to_string(aligned_size) + " bytes.\n"
-        "Pool status: " + static_cast<std::string>(*this);
-    throw std::runtime_error(err_msg);
+    return MEM_NULL;
 }
 
-void HeapAllocatorAtomicAlignedPool::deallocate(MemID p_mem) {
-    // Share lock this when finding valid space for allocation, then unique lock when found.
-    boost::upgrade_lock lock(mutex);
+void HeapAllocatorAtomicAlignedPool::unguard_deallocate(MemID p_mem) {
     WBE_DEBUG_ASSERT(unguard_is_in_pool(p_mem));
     // The first 64 bits are used to store the header.
     char* data_loc = reinterpret_cast<char*>(p_mem - HEADER_SIZE);
     size_t data_size = WBE_GET_ALLOCATED_DATA_SIZE(p_mem);
+    stats.on_deallocate(data_size);
     if (idle_list_head == nullptr || idle_list_head->mem_start > data_loc) {
-        // Unique lock when insert free memory.
-        boost::upgrade_to_unique_lock unique_lock(lock);
         insert_free_memory(nullptr, data_loc, data_size);
         return;
     }
@@ -114,6 +203,7 @@ void HeapAllocatorAtomicAlignedPool::deallocate(MemID p_mem) {
 void* HeapAllocatorAtomicAlignedPool::acquire_memory(std::unique_ptr<IdleListNode>& p_node, char* p_mem_start, size_t p_mem_size) {
     WBE_DEBUG_ASSERT(p_mem_start >= p_node->mem_start);
     WBE_DEBUG_ASSERT(p_mem_start + p_mem_size <= p_node->mem_start + p_node->size);
+    free_size -= p_mem_size;
     if (p_node->mem_start == p_mem_start) {
         p_node->size -= p_mem_size;
         void* node_mem_start = p_node->mem_start;
@@ -147,6 +237,7 @@ void* HeapAllocatorAtomicAlignedPool::acquire_memory(std::unique_ptr<IdleListNod
 }
 
 void HeapAllocatorAtomicAlignedPool::insert_free_memory(IdleListNode* p_node_before_insert, char* p_insert_start, size_t p_insert_size) {
+    free_size += p_insert_size;
     if (idle_list_head == nullptr) {
         idle_list_head = std::make_unique<IdleListNode>();
         ++idle_chunks_count;
@@ -187,6 +278,23 @@ bool HeapAllocatorAtomicAlignedPool::combine_idle_with_next(IdleListNode* p_node
     return true;
 }
 
+bool HeapAllocatorAtomicAlignedPool::grow(size_t p_size) {
+    size_t reserved_size = virtual_memory->get_reserved_size();
+    if (size >= reserved_size) {
+        return false;
+    }
+    // Grow by at least the current size to amortize the commits.
+    size_t new_size = std::min(size + std::max(p_size, size), reserved_size);
+    virtual_memory->commit(new_size);
+    new_size = std::min(virtual_memory->get_committed_size(), reserved_size);
+    char* new_chunk = mem_chunk + size;
+    size_t new_chunk_size = new_size - size;
+    size = new_size;
+    // Merged with the idle chunk at the end of the pool, if any.
+    insert_free_memory(idle_list_head == nullptr ? nullptr : get_idle_node_before(new_chunk).get(), new_chunk, new_chunk_size);
+    return true;
+}
+
 std::unique_ptr<HeapAllocatorAtomicAlignedPool::IdleListNode>& HeapAllocatorAtomicAlignedPool::get_idle_node_before(void* p_loc) {
     std::unique_ptr<IdleListNode>* curr = &idle_list_head;
     while (curr != nullptr) {
@@ -199,15 +307,26 @@ std::unique_ptr<HeapAllocatorAtomicAlignedPool::IdleListNode>& HeapAllocatorAtom
 }
 
 
-size_t HeapAllocatorAtomicAlignedPool::get_remain_size() const {
+AllocatorStats HeapAllocatorAtomicAlignedPool::get_stats() const {
     boost::shared_lock lock(mutex);
-    IdleListNode* node = idle_list_head.get();
-    size_t total = 0;
-    while (node != nullptr) {
-        total += node->size;
-        node = node->next.get();
+    AllocatorStats result;
+    stats.fill(result);
+    result.free_bytes = free_size;
+    return result;
+}
+
+size_t HeapAllocatorAtomicAlignedPool::get_largest_free_block() const {
+    boost::shared_lock lock(mutex);
+    size_t result = 0;
+    for (const IdleListNode* node = idle_list_head.get(); node != nullptr; node = node->next.get()) {
+        result = std::max(result, node->size);
     }
-    return total;
+    return result;
+}
+
+size_t HeapAllocatorAtomicAlignedPool::get_remain_size() const {
+    boost::shared_lock lock(mutex);
+    return free_size;
 }
 
 bool HeapAllocatorAtomicAlignedPool::unguard_is_in_pool(MemID p_mem_id) const {
@@ -238,7 +357,7 @@ HeapAllocatorAtomicAlignedPool::operator std::string() const {
     std::stringstream ss;
     ss << "{";
     ss << "\"type\":\"HeapAllocatorAtomicAlignedPool\",";
-    ss << "\"total_size\":" << get_total_size() << ",";
+    ss << "\"total_size\":" << size << ",";
     ss << "\"free_chunk_layout\":[";
     IdleListNode* node = idle_list_head.get();
     bool first = true;
@@ -49,58 +49,147 @@
 
 namespace WhiteBirdEngine {
 
-HeapAllocatorAtomicAlignedPoolImplicitList::HeapAllocatorAtomicAlignedPoolImplicitList(size_t p_size)
+HeapAllocatorAtomicAlignedPoolImplicitList::HeapAllocatorAtomicAlignedPoolImplicitList(size_t p_size, size_t p_reserve_size)
     : size(p_size) {
-    if (p_size > TOTAL_SIZE_MASK) {
-        throw std::runtime_error("Failed to create pool: size: " + std::to_string(p_size) + " exceeds maximum: " + std::to_string(TOTAL_SIZE_MASK) + ".");
+    if (std::max(p_size, p_reserve_size) > TOTAL_SIZE_MASK) {
+        throw std::runtime_error("Failed to create pool: size: " + std::to_string(std::max(p_size, p_reserve_size)) + " exceeds maximum: " + std::to_string(TOTAL_SIZE_MASK) + ".");
     }
-    mem_chunk = static_cast<char*>(aligned_alloc(HEADER_SIZE, p_size));
-    if (mem_chunk == nullptr) {
-        throw std::runtime_error("Failed to create pool: malloc failed.");
+    if (p_reserve_size != 0) {
+        if (p_reserve_size < p_size) {
+            throw std::runtime_error(std::format("Failed to create pool: reserve size: {} is less than size: {}.",
+                                                 p_reserve_size, p_size));
+        }
+        virtual_memory = std::make_unique<VirtualMemoryRange>(p_reserve_size, p_size);
+        mem_chunk = virtual_memory->get_data();
+        // The committed pages are zero filled, and only backed by physical memory when touched.
+        size = virtual_memory->get_committed_size();
+    }
+    else {
+        mem_chunk = static_cast<char*>(aligned_alloc(HEADER_SIZE, p_size));
+        if (mem_chunk == nullptr) {
+            throw std::runtime_error("Failed to create pool: malloc failed.");
+        }
+        memset(mem_chunk, 0, p_size);
     }
-    memset(mem_chunk, 0, p_size);
     WBE_HAAAPIL_SET_CHUNK_HEADER(mem_chunk, HeaderType::IDLE, size);
     possible_valid = mem_chunk;
+    free_size = size;
 }
 
 HeapAllocatorAtomicAlignedPoolImplicitList::~HeapAllocatorAtomicAlignedPoolImplicitList() {
     if (!is_empty()) {
         wbe_console_log(WBE_CHANNEL_GLOBAL)->warning("Non-empty allocator destructed. Allocator status: " + static_cast<std::string>(*this));
     }
-    free(mem_chunk);
+    if (virtual_memory == nullptr) {
+        free(mem_chunk);
+    }
     mem_chunk = nullptr;
 }
 
 MemID HeapAllocatorAtomicAlignedPoolImplicitList::allocate(size_t p_size, size_t p_alignment) {
     WBE_DEBUG_ASSERT(!(mutex.is_unique_locked_by_current_thread()));
-    if (p_alignment == 0) {
-        throw std::runtime_error("Allocation alignment must not be 0.");
-    }
+    check_alignment(p_alignment);
     if (p_size == 0) {
         return MEM_NULL;
     }
-    if (p_alignment % alignof(Header)) {
-        throw std::runtime_error(std::format("Allocation alignment must be a multiple of {}.", alignof(Header)));
-    }
     // Clamp the padding size to the default alignment.
     size_t aligned_size = get_align_size(p_size, HEADER_SIZE) + HEADER_SIZE;
-    boost::unique_lock lock(mutex);
-    MemID result = find_valid_chunk<false>(aligned_size, p_alignment);
-    if (result == MEM_NULL) {
-        result = find_valid_chunk<true>(aligned_size, p_alignment);
-        if (result != MEM_NULL) {
-            return result;
-        }
-    }
-    else {
+    boost::unique_lock lock(mutex, boost::defer_lock);
+    stats.on_lock_wait(lock_and_measure_wait(lock));
+    MemID result = unguarded_allocate(aligned_size, p_alignment);
+    if (result != MEM_NULL) {
+        free_size -= aligned_size;
+        stats.on_allocate(aligned_size);
         return result;
     }
+    stats.on_failed_allocation();
     std::string err_msg = "Failed to allocate memory: not enough space for memory pool.\n"
         "Trying to allocate: " + std::to_string(aligned_size) + " bytes.\n"
         "Pool status: " + unguarded_to_string();
     throw std::runtime_error(err_msg);
 }
 
+void HeapAllocatorAtomicAlignedPoolImplicitList::allocate_batch(size_t p_count, size_t p_size, size_t p_alignment, MemID* r_mem_ids) {
+    WBE_DEBUG_ASSERT(!(mutex.is_unique_locked_by_current_thread()));
+    check_alignment(p_alignment);
+    if (p_size == 0 || p_count == 0) {
+        std::fill(r_mem_ids, r_mem_ids + p_count, MEM_NULL);
+        return;
+    }
+    size_t aligned_size = get_align_size(p_size, HEADER_SIZE) + HEADER_SIZE;
+    boost::unique_lock lock(mutex, boost::defer_lock);
+    stats.on_lock_wait(lock_and_measure_wait(lock));
+    // Carve the chunks from one block if every chunk stays aligned.
+    MemID block = aligned_size % p_alignment == 0 && p_count <= TOTAL_SIZE_MASK / aligned_size ?
+        unguarded_allocate(aligned_size * p_count, p_alignment) : MEM_NULL;
+    if (block != MEM_NULL) {
+        for (size_t i = 0; i < p_count; ++i) {
+            WBE_HAAAPIL_SET_CHUNK_HEADER(block - HEADER_SIZE + i * aligned_size, HeaderType::OCCUPIED, aligned_size);
+            r_mem_ids[i] = block + i * aligned_size;
+        }
+        free_size -= aligned_size * p_count;
+        stats.on_allocate(aligned_size * p_count, p_count);
+        return;
+    }
+    for (size_t i = 0; i < p_count; ++i) {
+        r_mem_ids[i] = unguarded_allocate(aligned_size, p_alignment);
+        if (r_mem_ids[i] == MEM_NULL) {
+            stats.on_failed_allocation();
+            // Roll back the chunks that are already allocated.
+            for (size_t j = 0; j < i; ++j) {
+                unguarded_deallocate(r_mem_ids[j]);
+            }
+            std::string err_msg = "Failed to allocate memory: not enough space for memory pool.\n"
+                "Trying to allocate: " + std::to_string(p_count) + " chunks of " + std::to_string(aligned_size) + " bytes.\n"
+                "Pool status: " + unguarded_to_string();
+            throw std::runtime_error(err_msg);
+        }
+        free_size -= aligned_size;
+        stats.on_allocate(aligned_size);
+    }
+}
+
+void HeapAllocatorAtomicAlignedPoolImplicitList::check_alignment(size_t p_alignment) {
+    if (p_alignment == 0) {
+        throw std::runtime_error("Allocation alignment must not be 0.");
+    }
+    if (p_alignment % alignof(Header)) {
+        throw std::runtime_error(std::format("Allocation alignment must be a multiple of {}.", alignof(Header)));
+    }
+}
+
+MemID HeapAllocatorAtomicAlignedPoolImplicitList::unguarded_allocate(size_t p_aligned_size, size_t p_alignment) {
+    MemID result = find_valid_chunk<false>(p_aligned_size, p_alignment);
+    if (result == MEM_NULL) {
+        result = find_valid_chunk<true>(p_aligned_size, p_alignment);
+    }
+    // The aligned start could be at most p_alignment after the start of an idle chunk.
+    if (result == MEM_NULL && is_growable() && grow(p_aligned_size + p_alignment)) {
+        result = find_valid_chunk<true>(p_aligned_size, p_alignment);
+    }
+    return result;
+}
+
+bool HeapAllocatorAtomicAlignedPoolImplicitList::grow(size_t p_size) {
+    WBE_DEBUG_ASSERT(mutex.is_unique_locked_by_current_thread());
+    size_t reserved_size = virtual_memory->get_reserved_size();
+    if (size >= reserved_size) {
+        return false;
+    }
+    // Grow by at least the current size to amortize the commits.
+    size_t new_size = std::min(size + std::max(p_size, size), reserved_size);
+    virtual_memory->commit(new_size);
+    new_size = std::min(virtual_memory->get_committed_size(), reserved_size);
+    char* new_chunk = mem_chunk + size;
+    size_t new_chunk_size = new_size - size;
+    size = new_size;
+    // Coalesced lazily with the idle chunk before it, like the deallocated chunks.
+    WBE_HAAAPIL_SET_CHUNK_HEADER(new_chunk, HeaderType::IDLE, new_chunk_size);
+    free_size += new_chunk_size;
+    WBE_HAAAPIL_UPDATE_POSIBLE_VALID(new_chunk);
+    return true;
+}
+
 template <bool COALESCE_ENABLED>
 MemID HeapAllocatorAtomicAlignedPoolImplicitList::check_posible_free(size_t p_aligned_size, size_t p_alignment) {
     WBE_DEBUG_ASSERT(mutex.is_unique_locked_by_current_thread());
@@ -165,11 +254,29 @@ void HeapAllocatorAtomicAlignedPoolImplicitList::deallocate(MemID p_mem) {
     if (p_mem == MEM_NULL) {
         return;
     }
-    char* data_loc = reinterpret_cast<char*>(p_mem - HEADER_SIZE);
-    boost::unique_lock lock(mutex);
+    boost::unique_lock lock(mutex, boost::defer_lock);
+    stats.on_lock_wait(lock_and_measure_wait(lock));
+    unguarded_deallocate(p_mem);
+}
+
+void HeapAllocatorAtomicAlignedPoolImplicitList::deallocate_batch(const MemID* p_mem_ids, size_t p_count) {
+    WBE_DEBUG_ASSERT(!(mutex.is_unique_locked_by_current_thread()));
+    boost::unique_lock lock(mutex, boost::defer_lock);
+    stats.on_lock_wait(lock_and_measure_wait(lock));
+    for (size_t i = 0; i < p_count; ++i) {
+        if (p_mem_ids[i] != MEM_NULL) {
+            unguarded_deallocate(p_mem_ids[i]);
+        }
+    }
+}
+
+void HeapAllocatorAtomicAlignedPoolImplicitList::unguarded_deallocate(MemID p_mem) {
     WBE_DEBUG_ASSERT(unguarded_is_in_pool(p_mem));
+    char* data_loc = reinterpret_cast<char*>(p_mem - HEADER_SIZE);
     size_t data_size = WBE_HAAAPIL_GET_HEADER_SIZE(*reinterpret_cast<Header*>((p_mem - HEADER_SIZE)));
     insert_free_memory(data_loc, data_size);
+    free_size += data_size;
+    stats.on_deallocate(data_size);
 }
 
 template <bool CHECK_FIRST, bool COALESCE_ENABLED>
@@ -251,6 +358,31 @@ size_t HeapAllocatorAtomicAlignedPoolImplicitList::get_remain_size() const {
     return total;
 }
 
+AllocatorStats HeapAllocatorAtomicAlignedPoolImplicitList::get_stats() const {
+    boost::shared_lock lock(mutex);
+    AllocatorStats result;
+    stats.fill(result);
+    result.free_bytes = free_size;
+    return result;
+}
+
+size_t HeapAllocatorAtomicAlignedPoolImplicitList::get_largest_free_block() const {
+    boost::shared_lock lock(mutex);
+    // Idle chunks are coalesced lazily, so a run of adjacent idle chunks counts as one block.
+    size_t result = 0;
+    size_t idle_run_size = 0;
+    for (char* curr = mem_chunk; curr < mem_chunk + size; curr += WBE_HAAAPIL_GET_CHUNK_SIZE(curr)) {
+        if (WBE_HAAAPIL_GET_CHUNK_TYPE(curr) == HeaderType::IDLE) {
+            idle_run_size += WBE_HAAAPIL_GET_CHUNK_SIZE(curr);
+            result = std::max(result, idle_run_size);
+        }
+        else {
+            idle_run_size = 0;
+        }
+    }
+    return result;
+}
+
 bool HeapAllocatorAtomicAlignedPoolImplicitList::is_in_pool(MemID p_mem_id) const {
     boost::shared_lock lock(mutex);
     return unguarded_is_in_pool(p_mem_id);
@@ -261,15 +393,22 @@ void HeapAllocatorAtomicAlignedPoolImplicitList::unguarded_check_broken() const
     if (possible_valid != nullptr && WBE_HAAAPIL_GET_CHUNK_TYPE(possible_valid) != HeaderType::IDLE) {
         throw std::runtime_error("Broken possible_valid.");
     }
+    size_t idle_size = 0;
     while (curr < mem_chunk + size) {
         if (WBE_HAAAPIL_GET_CHUNK_SIZE(curr) == 0) {
             throw std::runtime_error("Size is 0.");
         }
+        if (WBE_HAAAPIL_GET_CHUNK_TYPE(curr) == HeaderType::IDLE) {
+            idle_size += WBE_HAAAPIL_GET_CHUNK_SIZE(curr);
+        }
         curr += WBE_HAAAPIL_GET_CHUNK_SIZE(curr);
     }
     if (curr != mem_chunk + size) {
         throw std::runtime_error("Bad pool.");
     }
+    if (idle_size != free_size) {
+        throw std::runtime_error("Broken free size.");
+    }
 }
 
 void HeapAllocatorAtomicAlignedPoolImplicitList::coalesce_all() const {
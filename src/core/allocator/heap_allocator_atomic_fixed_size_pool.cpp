@@ -0,0 +1,192 @@
+/* Copyright 2025 OppositeNor
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#include "core/allocator/heap_allocator_atomic_fixed_size_pool.hh"
+#include "core/logging/log.hh"
+#include "utils/utils.hh"
+#include <cstdint>
+#include <cstdlib>
+#include <format>
+#include <sstream>
+#include <stdexcept>
+
+namespace WhiteBirdEngine {
+
+HeapAllocatorAtomicFixedSizePool::HeapAllocatorAtomicFixedSizePool(size_t p_element_size, uint32_t p_max_obj)
+    : element_size(p_element_size),
+    slot_size(get_align_size(p_element_size == 0 ? 1 : p_element_size, SLOT_ALIGNMENT)),
+    max_obj(p_max_obj) {
+    if (p_max_obj > MAX_OBJ) {
+        throw std::runtime_error("Failed to create allocator: allocator only allows a maximum of " + std::to_string(MAX_OBJ) + " objects");
+    }
+    if (p_max_obj == 0) {
+        throw std::runtime_error("Failed to create allocator: maximum object count must not be 0.");
+    }
+    mem_chunk = static_cast<char*>(aligned_alloc(SLOT_ALIGNMENT, slot_size * max_obj));
+    if (mem_chunk == nullptr) {
+        throw std::runtime_error("Failed to create pool: malloc failed.");
+    }
+    next_indices = std::make_unique<std::atomic<SlotIndex>[]>(max_obj);
+    clear();
+}
+
+HeapAllocatorAtomicFixedSizePool::~HeapAllocatorAtomicFixedSizePool() {
+    if (obj_count() != 0) {
+        wbe_console_log(WBE_CHANNEL_GLOBAL)->warning("HeapAllocatorAtomicFixedSizePool not empty during destruction.");
+    }
+    free(mem_chunk);
+}
+
+MemID HeapAllocatorAtomicFixedSizePool::allocate(size_t p_size) {
+    if (p_size > element_size) {
+        throw std::runtime_error(std::format("Failed to allocate memory: size must not exceed: {}", element_size));
+    }
+    uint64_t head = idle_head.load(std::memory_order_acquire);
+    SlotIndex index;
+    do {
+        index = get_head_index(head);
+        if (index == NULL_INDEX) {
+            stats.on_failed_allocation();
+            throw std::runtime_error("Failed to allocate memory: not enough space for memory pool.");
+        }
+        // The slot might have been popped by another thread, in which case the tag has changed and
+        // the compare exchange fails.
+        SlotIndex next = next_indices[index - 1].load(std::memory_order_relaxed);
+        if (idle_head.compare_exchange_weak(head, make_head(get_head_tag(head) + 1, next),
+                                            std::memory_order_acquire, std::memory_order_acquire)) {
+            break;
+        }
+    } while (true);
+    alloc_obj_count.fetch_add(1, std::memory_order_relaxed);
+    stats.on_allocate(slot_size);
+    return get_slot_mem_id(index);
+}
+
+void HeapAllocatorAtomicFixedSizePool::allocate_batch(size_t p_count, MemID* r_mem_ids) {
+    if (p_count == 0) {
+        return;
+    }
+    uint64_t head = idle_head.load(std::memory_order_acquire);
+    while (true) {
+        // Every change to the stack bumps the tag of the head, so the slots walked here are
+        // still the top of the stack if the compare exchange succeeds.
+        SlotIndex index = get_head_index(head);
+        size_t taken = 0;
+        for (; taken < p_count && index != NULL_INDEX; ++taken) {
+            r_mem_ids[taken] = get_slot_mem_id(index);
+            index = next_indices[index - 1].load(std::memory_order_relaxed);
+        }
+        if (taken < p_count) {
+            uint64_t current = idle_head.load(std::memory_order_acquire);
+            if (current != head) {
+                // The walk could have read links changed by another thread.
+                head = current;
+                continue;
+            }
+            stats.on_failed_allocation();
+            throw std::runtime_error("Failed to allocate memory: not enough space for memory pool.");
+        }
+        if (idle_head.compare_exchange_weak(head, make_head(get_head_tag(head) + 1, index),
+                                            std::memory_order_acquire, std::memory_order_acquire)) {
+            break;
+        }
+    }
+    alloc_obj_count.fetch_add(static_cast<SlotIndex>(p_count), std::memory_order_relaxed);
+    stats.on_allocate(slot_size * p_count, p_count);
+}
+
+void HeapAllocatorAtomicFixedSizePool::deallocate_batch(const MemID* p_mem_ids, size_t p_count) {
+    // Link the slots into a chain first, then push the whole chain.
+    SlotIndex first = NULL_INDEX;
+    SlotIndex last = NULL_INDEX;
+    size_t count = 0;
+    for (size_t i = 0; i < p_count; ++i) {
+        if (p_mem_ids[i] == MEM_NULL) {
+            continue;
+        }
+        if (!is_in_pool(p_mem_ids[i])) {
+            throw std::runtime_error("Failed to deallocate memory: memory not allocated in this memory pool.");
+        }
+        SlotIndex index = get_slot_index(p_mem_ids[i]);
+        if (last == NULL_INDEX) {
+            first = index;
+        }
+        else {
+            next_indices[last - 1].store(index, std::memory_order_relaxed);
+        }
+        last = index;
+        ++count;
+    }
+    if (count == 0) {
+        return;
+    }
+    uint64_t head = idle_head.load(std::memory_order_relaxed);
+    do {
+        next_indices[last - 1].store(get_head_index(head), std::memory_order_relaxed);
+    } while (!idle_head.compare_exchange_weak(head, make_head(get_head_tag(head) + 1, first),
+                                              std::memory_order_release, std::memory_order_relaxed));
+    alloc_obj_count.fetch_sub(static_cast<SlotIndex>(count), std::memory_order_relaxed);
+    stats.on_deallocate(slot_size * count, count);
+}
+
+void HeapAllocatorAtomicFixedSizePool::deallocate(MemID p_mem) {
+    if (p_mem == MEM_NULL) {
+        return;
+    }
+    if (!is_in_pool(p_mem)) {
+        throw std::runtime_error("Failed to deallocate memory: memory not allocated in this memory pool.");
+    }
+    SlotIndex index = get_slot_index(p_mem);
+    uint64_t head = idle_head.load(std::memory_order_relaxed);
+    do {
+        next_indices[index - 1].store(get_head_index(head), std::memory_order_relaxed);
+    } while (!idle_head.compare_exchange_weak(head, make_head(get_head_tag(head) + 1, index),
+                                              std::memory_order_release, std::memory_order_relaxed));
+    alloc_obj_count.fetch_sub(1, std::memory_order_relaxed);
+    stats.on_deallocate(slot_size);
+}
+
+void HeapAllocatorAtomicFixedSizePool::clear() {
+    for (uint32_t i = 0; i < max_obj; ++i) {
+        // Slot i links to slot i + 1, the last one links to the end.
+        next_indices[i].store(i + 1 < max_obj ? i + 2 : NULL_INDEX, std::memory_order_relaxed);
+    }
+    uint64_t tag = get_head_tag(idle_head.load(std::memory_order_relaxed));
+    idle_head.store(make_head(tag + 1, 1), std::memory_order_release);
+    alloc_obj_count.store(0, std::memory_order_relaxed);
+    stats.on_clear();
+}
+
+AllocatorStats HeapAllocatorAtomicFixedSizePool::get_stats() const {
+    AllocatorStats result;
+    stats.fill(result);
+    result.free_bytes = static_cast<size_t>(max_obj - obj_count()) * slot_size;
+    // Every idle slot fits any allocation, so the idle slots are never fragmented.
+    result.largest_free_block = result.free_bytes;
+    result.largest_free_block_tracked = true;
+    return result;
+}
+
+HeapAllocatorAtomicFixedSizePool::operator std::string() const {
+    std::stringstream ss;
+    ss << "{";
+    ss << "\"type\":\"HeapAllocatorAtomicFixedSizePool\",";
+    ss << "\"size\":" << element_size << ",";
+    ss << "\"obj_count\":" << obj_count() << ",";
+    ss << "\"max_obj\":" << max_obj;
+    ss << "}";
+    return ss.str();
+}
+
+}
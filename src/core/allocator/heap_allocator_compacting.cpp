@@ -0,0 +1,250 @@
+/* Copyright 2025 OppositeNor
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#include "core/allocator/heap_allocator_compacting.hh"
+#include "core/allocator/allocator.hh"
+#include "core/logging/log.hh"
+#include "utils/defs.hh"
+#include "utils/utils.hh"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <format>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+namespace WhiteBirdEngine {
+
+HeapAllocatorCompacting::HeapAllocatorCompacting(size_t p_size)
+    : size(p_size - p_size % HEADER_SIZE), free_size(size) {
+    if (size < HEADER_SIZE) {
+        throw std::runtime_error(std::format("Failed to create pool: size: {} is less than minimum: {}.", p_size, HEADER_SIZE));
+    }
+    mem_chunk = static_cast<char*>(aligned_alloc(HEADER_SIZE, size));
+    if (mem_chunk == nullptr) {
+        throw std::runtime_error("Failed to create pool: malloc failed.");
+    }
+}
+
+HeapAllocatorCompacting::~HeapAllocatorCompacting() {
+    if (!is_empty()) {
+        wbe_console_log(WBE_CHANNEL_GLOBAL)->warning("Non-empty allocator destructed.");
+    }
+    free(mem_chunk);
+    mem_chunk = nullptr;
+}
+
+MemID HeapAllocatorCompacting::allocate(size_t p_size, size_t p_alignment) {
+    if (p_alignment == 0) {
+        throw std::runtime_error("Alignment should not be 0.");
+    }
+    if (HEADER_SIZE % p_alignment != 0) {
+        throw std::runtime_error(std::format("Failed to allocate memory: alignment must be a divisor of {}.", HEADER_SIZE));
+    }
+    if (p_size == 0) {
+        return MEM_NULL;
+    }
+    if (p_size > size) {
+        stats.on_failed_allocation();
+        throw std::runtime_error(std::format("Failed to allocate memory: size: {} exceeds pool size: {}.", p_size, size));
+    }
+    size_t chunk_size = get_align_size(p_size, HEADER_SIZE) + HEADER_SIZE;
+    // Bump from the end first, the gaps are closed by defragment.
+    if (size - top >= chunk_size) {
+        MemID result = acquire_handle(top);
+        write_chunk(top, chunk_size, result);
+        top += chunk_size;
+        ++obj_count;
+        free_size -= chunk_size;
+        stats.on_allocate(chunk_size);
+        return result;
+    }
+    // There is no gap before the compact cursor.
+    size_t offset = compact_cursor;
+    while (offset < top) {
+        ChunkHeader* header = get_chunk_header(offset);
+        if (header->handle != MEM_NULL) {
+            offset += header->size;
+            continue;
+        }
+        size_t idle_size = merge_idle(offset);
+        if (idle_size == 0) {
+            // The gaps before the top are merged into it.
+            break;
+        }
+        if (idle_size >= chunk_size) {
+            MemID result = acquire_handle(offset);
+            if (idle_size > chunk_size) {
+                write_chunk(offset + chunk_size, idle_size - chunk_size, MEM_NULL);
+            }
+            write_chunk(offset, chunk_size, result);
+            ++obj_count;
+            free_size -= chunk_size;
+            stats.on_allocate(chunk_size);
+            return result;
+        }
+        offset += idle_size;
+    }
+    if (size - top >= chunk_size) {
+        MemID result = acquire_handle(top);
+        write_chunk(top, chunk_size, result);
+        top += chunk_size;
+        ++obj_count;
+        free_size -= chunk_size;
+        stats.on_allocate(chunk_size);
+        return result;
+    }
+    stats.on_failed_allocation();
+    std::string err_msg = "Failed to allocate memory: not enough space for memory pool.\n"
+        "Trying to allocate: " + std::to_string(chunk_size) + " bytes.\n"
+        "Pool status: " + static_cast<std::string>(*this);
+    throw std::runtime_error(err_msg);
+}
+
+void HeapAllocatorCompacting::deallocate(MemID p_mem) {
+    if (!is_in_pool(p_mem)) {
+        throw std::runtime_error("Failed to deallocate memory: memory not allocated in this memory pool.");
+    }
+    size_t offset = handle_offsets[p_mem - 1];
+    ChunkHeader* header = get_chunk_header(offset);
+    stats.on_deallocate(header->size);
+    free_size += header->size;
+    header->handle = MEM_NULL;
+    handle_offsets[p_mem - 1] = NULL_OFFSET;
+    idle_handles.push_back(p_mem);
+    --obj_count;
+    if (obj_count == 0) {
+        // The gaps left before the chunk are not merged eagerly, drop them all at once.
+        top = 0;
+        compact_cursor = 0;
+        return;
+    }
+    compact_cursor = std::min(compact_cursor, offset);
+    merge_idle(offset);
+}
+
+void HeapAllocatorCompacting::clear() {
+    top = 0;
+    compact_cursor = 0;
+    obj_count = 0;
+    free_size = size;
+    handle_offsets.clear();
+    idle_handles.clear();
+    stats.on_clear();
+}
+
+size_t HeapAllocatorCompacting::defragment(size_t p_budget) {
+    size_t moved = 0;
+    if (p_budget == 0) {
+        return moved;
+    }
+    while (compact_cursor < top) {
+        ChunkHeader* header = get_chunk_header(compact_cursor);
+        if (header->handle != MEM_NULL) {
+            compact_cursor += header->size;
+            continue;
+        }
+        size_t gap_size = merge_idle(compact_cursor);
+        if (gap_size == 0) {
+            break;
+        }
+        // merge_idle stops at an allocated chunk.
+        size_t move_from = compact_cursor + gap_size;
+        size_t chunk_size = get_chunk_header(move_from)->size;
+        if (moved != 0 && moved + chunk_size > p_budget) {
+            break;
+        }
+        std::memmove(mem_chunk + compact_cursor, mem_chunk + move_from, chunk_size);
+        handle_offsets[get_chunk_header(compact_cursor)->handle - 1] = compact_cursor;
+        compact_cursor += chunk_size;
+        // The gap is now after the moved chunk.
+        write_chunk(compact_cursor, gap_size, MEM_NULL);
+        moved += chunk_size;
+    }
+    moved_bytes += moved;
+    return moved;
+}
+
+size_t HeapAllocatorCompacting::merge_idle(size_t p_offset) {
+    ChunkHeader* header = get_chunk_header(p_offset);
+    WBE_DEBUG_ASSERT(header->handle == MEM_NULL);
+    size_t end = p_offset + header->size;
+    while (end < top && get_chunk_header(end)->handle == MEM_NULL) {
+        end += get_chunk_header(end)->size;
+    }
+    if (end == top) {
+        top = p_offset;
+        return 0;
+    }
+    header->size = end - p_offset;
+    return header->size;
+}
+
+MemID HeapAllocatorCompacting::acquire_handle(size_t p_offset) {
+    if (idle_handles.empty()) {
+        handle_offsets.push_back(p_offset);
+        return handle_offsets.size();
+    }
+    MemID result = idle_handles.back();
+    idle_handles.pop_back();
+    handle_offsets[result - 1] = p_offset;
+    return result;
+}
+
+AllocatorStats HeapAllocatorCompacting::get_stats() const {
+    AllocatorStats result;
+    stats.fill(result);
+    result.free_bytes = free_size;
+    // There are no gaps before the top, all the idle memory is the tail.
+    if (is_compact()) {
+        result.largest_free_block = size - top;
+        result.largest_free_block_tracked = true;
+    }
+    return result;
+}
+
+size_t HeapAllocatorCompacting::get_largest_free_block() const {
+    // Neighbouring idle chunks are merged lazily, count them as one block.
+    size_t result = 0;
+    size_t idle_run = 0;
+    for (size_t offset = compact_cursor; offset < top; offset += get_chunk_header(offset)->size) {
+        if (get_chunk_header(offset)->handle == MEM_NULL) {
+            idle_run += get_chunk_header(offset)->size;
+            result = std::max(result, idle_run);
+        }
+        else {
+            idle_run = 0;
+        }
+    }
+    return std::max(result, idle_run + size - top);
+}
+
+HeapAllocatorCompacting::operator std::string() const {
+    std::stringstream ss;
+    ss << "{";
+    ss << "\"type\":\"HeapAllocatorCompacting\",";
+    ss << "\"total_size\":" << size << ",";
+    ss << "\"top\":" << top << ",";
+    ss << "\"compact_cursor\":" << compact_cursor << ",";
+    ss << "\"obj_count\":" << obj_count << ",";
+    ss << "\"handle_count\":" << handle_offsets.size() << ",";
+    ss << "\"moved_bytes\":" << moved_bytes;
+    ss << "}";
+    return ss.str();
+}
+
+}
@@ -17,6 +17,7 @@
 #include "utils/defs.hh"
 #include "core/allocator/heap_allocator_pool.hh"
 #include <cstdint>
+#include <algorithm>
 #include <cstring>
 #include <format>
 #include <sstream>
@@ -29,140 +30,218 @@ HeapAllocatorPool::~HeapAllocatorPool() {
     if (!is_empty()) {
         wbe_console_log(WBE_CHANNEL_GLOBAL)->warning("HeapAllocatorPool not empty during destruction.");
     }
-    free(mem_chunk);
+    if (virtual_memory == nullptr) {
+        free(mem_chunk);
+    }
     mem_chunk = nullptr;
 }
 
-HeapAllocatorPool::HeapAllocatorPool(size_t p_size)
+HeapAllocatorPool::HeapAllocatorPool(size_t p_size, size_t p_reserve_size)
     : size(p_size) {
-    if (p_size > MAX_TOTAL_SIZE) {
-        throw std::runtime_error(std::format("Failed to create pool: size: {} exceeds maximum: {}.", p_size, MAX_TOTAL_SIZE));
-    }
-    mem_chunk = static_cast<char*>(malloc(p_size));
-    if (mem_chunk == nullptr) {
-        throw std::runtime_error("Failed to create pool: malloc failed.");
-    }
-    idle_list_head = std::make_unique<IdleListNode>();
-    idle_list_head->size = p_size;
-    idle_list_head->next = nullptr;
-    idle_list_head->mem_start = mem_chunk;
-    idle_chunks_count = 1;
+    if (std::max(p_size, p_reserve_size) > MAX_TOTAL_SIZE) {
+        throw std::runtime_error(std::format("Failed to create pool: size: {} exceeds maximum: {}.",
+                                             std::max(p_size, p_reserve_size), MAX_TOTAL_SIZE));
+    }
+    if (p_size < MIN_IDLE_SIZE) {
+        throw std::runtime_error(std::format("Failed to create pool: size: {} is less than minimum: {}.", p_size, MIN_IDLE_SIZE));
+    }
+    if (p_reserve_size != 0) {
+        if (p_reserve_size < p_size) {
+            throw std::runtime_error(std::format("Failed to create pool: reserve size: {} is less than size: {}.",
+                                                 p_reserve_size, p_size));
+        }
+        virtual_memory = std::make_unique<VirtualMemoryRange>(p_reserve_size, p_size);
+        mem_chunk = virtual_memory->get_data();
+        size = std::min(virtual_memory->get_committed_size(), virtual_memory->get_reserved_size());
+    }
+    else {
+        mem_chunk = static_cast<char*>(malloc(p_size));
+        if (mem_chunk == nullptr) {
+            throw std::runtime_error("Failed to create pool: malloc failed.");
+        }
+    }
+    clear();
 }
 
 MemID HeapAllocatorPool::allocate(size_t p_size) {
     if (p_size == 0) {
         return MEM_NULL;
     }
-    std::unique_ptr<IdleListNode>* valid_idle_node = &idle_list_head;
     p_size += HEADER_SIZE;
-    while (*valid_idle_node != nullptr) {
-        if ((*valid_idle_node)->size >= p_size) {
-            void* result = acquire_memory(*valid_idle_node, p_size);
-            *reinterpret_cast<uint64_t*>(result) = p_size;
-            max_data_loc_tracker = std::max(max_data_loc_tracker, (size_t)result + p_size - (size_t)mem_chunk);
-            return reinterpret_cast<MemID>(result) + HEADER_SIZE;
-        }
-        if ((*valid_idle_node)->next == nullptr) {
-            break;
-        }
-        valid_idle_node = &((*valid_idle_node)->next);
+    MemID result = find_valid_chunk(p_size);
+    if (result == MEM_NULL && is_growable() && grow(p_size)) {
+        result = find_valid_chunk(p_size);
+    }
+    if (result != MEM_NULL) {
+        return result;
     }
+    stats.on_failed_allocation();
   throw std::runtime_error(std::format("Failed to allocate memory: not enough space for memory pool.\n"
                                        "Trying to allocate: {} bytes.", p_size));
 }
 
+void HeapAllocatorPool::allocate_batch(size_t p_count, size_t p_size, MemID* r_mem_ids) {
+    if (p_size == 0 || p_count == 0) {
+        std::fill(r_mem_ids, r_mem_ids + p_count, MEM_NULL);
+        return;
+    }
+    size_t chunk_size = p_size + HEADER_SIZE;
+    // Carve the chunks from one block, the chunks of this pool need no alignment.
+    MemID block = MEM_NULL;
+    if (p_count <= MAX_TOTAL_SIZE / chunk_size) {
+        block = find_valid_chunk(chunk_size * p_count, p_count);
+        if (block == MEM_NULL && is_growable() && grow(chunk_size * p_count)) {
+            block = find_valid_chunk(chunk_size * p_count, p_count);
+        }
+    }
+    if (block != MEM_NULL) {
+        // The last chunk keeps the rest of the block, if the block took a whole idle chunk.
+        uint64_t last_size = get_allocated_data_size(block) - chunk_size * (p_count - 1);
+        for (size_t i = 0; i < p_count; ++i) {
+            uint64_t header = i + 1 == p_count ? last_size : chunk_size;
+            std::memcpy(reinterpret_cast<char*>(block - HEADER_SIZE + i * chunk_size), &header, sizeof(header));
+            r_mem_ids[i] = block + i * chunk_size;
+        }
+        return;
+    }
+    for (size_t i = 0; i < p_count; ++i) {
+        try {
+            r_mem_ids[i] = allocate(p_size);
+        }
+        catch (...) {
+            // Roll back the chunks that are already allocated.
+            deallocate_batch(r_mem_ids, i);
+            throw;
+        }
+    }
+}
+
+void HeapAllocatorPool::deallocate_batch(const MemID* p_mem_ids, size_t p_count) {
+    for (size_t i = 0; i < p_count; ++i) {
+        if (p_mem_ids[i] != MEM_NULL) {
+            deallocate(p_mem_ids[i]);
+        }
+    }
+}
+
+MemID HeapAllocatorPool::find_valid_chunk(size_t p_chunk_size, uint64_t p_count) {
+    char* prev = nullptr;
+    char* curr = idle_list_head;
+    while (curr != nullptr) {
+        IdleListNode node = load_node(curr);
+        if (node.size >= p_chunk_size) {
+            // Take the whole chunk if the rest could not hold an idle node.
+            size_t acquire_size = node.size - p_chunk_size < MIN_IDLE_SIZE ? node.size : p_chunk_size;
+            void* result = acquire_memory(prev, curr, acquire_size);
+            uint64_t header = acquire_size;
+            std::memcpy(result, &header, sizeof(header));
+            max_data_loc_tracker = std::max(max_data_loc_tracker, (size_t)result + acquire_size - (size_t)mem_chunk);
+            stats.on_allocate(acquire_size, p_count);
+            return reinterpret_cast<MemID>(result) + HEADER_SIZE;
+        }
+        prev = curr;
+        curr = node.next;
+    }
+    return MEM_NULL;
+}
+
 void HeapAllocatorPool::deallocate(MemID p_mem) {
     char* data_loc = reinterpret_cast<char*>(p_mem - HEADER_SIZE);
     size_t data_size = get_allocated_data_size(p_mem);
-    if (idle_list_head == nullptr || idle_list_head->mem_start > data_loc) {
-        insert_free_memory(nullptr, data_loc, data_size);
+    insert_free_memory(data_loc, data_size);
+    stats.on_deallocate(data_size);
+}
+
+void HeapAllocatorPool::set_next(char* p_prev, char* p_next) {
+    if (p_prev == nullptr) {
+        idle_list_head = p_next;
         return;
     }
-    IdleListNode* insert_pos = get_idle_node_before(data_loc).get();
-    insert_free_memory(insert_pos, data_loc, data_size);
+    IdleListNode prev_node = load_node(p_prev);
+    prev_node.next = p_next;
+    store_node(p_prev, prev_node);
 }
 
-void* HeapAllocatorPool::acquire_memory(std::unique_ptr<IdleListNode>& p_node, size_t p_mem_size) {
-    WBE_DEBUG_ASSERT(p_node->size >= p_mem_size);
-    p_node->size -= p_mem_size;
-    void* mem_start = p_node->mem_start;
-    if (p_node->size == 0) {
+void* HeapAllocatorPool::acquire_memory(char* p_prev, char* p_chunk, size_t p_mem_size) {
+    IdleListNode node = load_node(p_chunk);
+    WBE_DEBUG_ASSERT(node.size >= p_mem_size);
+    free_size -= p_mem_size;
+    if (node.size == p_mem_size) {
         --idle_chunks_count;
-        if (p_node->next == nullptr) {
-            p_node = nullptr;
-            return mem_start;
-        }
-        p_node->size = p_node->next->size;
-        p_node->mem_start = p_node->next->mem_start;
-        p_node->next = std::move(p_node->next->next);
+        set_next(p_prev, node.next);
     }
     else {
-        p_node->mem_start += p_mem_size;
+        WBE_DEBUG_ASSERT(node.size - p_mem_size >= MIN_IDLE_SIZE);
+        char* remain = p_chunk + p_mem_size;
+        store_node(remain, IdleListNode { node.size - p_mem_size, node.next });
+        set_next(p_prev, remain);
     }
-    return mem_start;
+    return p_chunk;
 }
 
-void HeapAllocatorPool::insert_free_memory(IdleListNode* p_node_before_insert, char* p_insert_start, size_t p_insert_size) {
-    if (idle_list_head == nullptr) {
-        idle_list_head = std::make_unique<IdleListNode>();
-        ++idle_chunks_count;
-        idle_list_head->mem_start = p_insert_start;
-        idle_list_head->size = p_insert_size;
-        return;
+void HeapAllocatorPool::insert_free_memory(char* p_insert_start, size_t p_insert_size) {
+    // Find the idle chunks right before and after the inserted memory.
+    char* prev = nullptr;
+    char* next = idle_list_head;
+    while (next != nullptr && next < p_insert_start) {
+        prev = next;
+        next = load_node(next).next;
     }
-
-    std::unique_ptr<IdleListNode> insert_node = std::make_unique<IdleListNode>();
+    IdleListNode node { p_insert_size, next };
     ++idle_chunks_count;
-    insert_node->mem_start = p_insert_start;
-    insert_node->size = p_insert_size;
-    if (p_node_before_insert == nullptr) {
-        insert_node->next = std::move(idle_list_head);
-        idle_list_head = std::move(insert_node);
-        combine_idle_with_next(idle_list_head.get());
-        return;
-    }
-
-    insert_node->next = std::move(p_node_before_insert->next);
-    p_node_before_insert->next = std::move(insert_node);
-    if (combine_idle_with_next(p_node_before_insert)) {
-        combine_idle_with_next(p_node_before_insert);
+    free_size += p_insert_size;
+    if (next != nullptr && p_insert_start + p_insert_size == next) {
+        IdleListNode next_node = load_node(next);
+        node.size += next_node.size;
+        node.next = next_node.next;
+        --idle_chunks_count;
     }
-    else if (p_node_before_insert->next != nullptr) {
-        combine_idle_with_next(p_node_before_insert->next.get());
+    if (prev != nullptr) {
+        IdleListNode prev_node = load_node(prev);
+        if (prev + prev_node.size == p_insert_start) {
+            prev_node.size += node.size;
+            prev_node.next = node.next;
+            store_node(prev, prev_node);
+            --idle_chunks_count;
+            return;
+        }
     }
+    store_node(p_insert_start, node);
+    set_next(prev, p_insert_start);
 }
 
-bool HeapAllocatorPool::combine_idle_with_next(IdleListNode* p_node) {
-    WBE_DEBUG_ASSERT(p_node != nullptr);
-    if (p_node->next == nullptr || p_node->mem_start + p_node->size != p_node->next->mem_start) {
+bool HeapAllocatorPool::grow(size_t p_size) {
+    size_t reserved_size = std::min(virtual_memory->get_reserved_size(), MAX_TOTAL_SIZE);
+    if (size >= reserved_size) {
         return false;
     }
-    p_node->size += p_node->next->size;
-    p_node->next = std::move(p_node->next->next);
-    --idle_chunks_count;
+    // Grow by at least the current size to amortize the commits.
+    size_t new_size = std::min(size + std::max(p_size, size), reserved_size);
+    virtual_memory->commit(new_size);
+    new_size = std::min(virtual_memory->get_committed_size(), reserved_size);
+    char* new_chunk = mem_chunk + size;
+    size_t new_chunk_size = new_size - size;
+    size = new_size;
+    // Merged with the idle chunk at the end of the pool, if any.
+    insert_free_memory(new_chunk, new_chunk_size);
     return true;
 }
 
-std::unique_ptr<HeapAllocatorPool::IdleListNode>& HeapAllocatorPool::get_idle_node_before(void* p_loc) {
-    std::unique_ptr<IdleListNode>* curr = &idle_list_head;
-    while (curr != nullptr) {
-        if ((*curr)->next == nullptr || (*curr)->next->mem_start > p_loc) {
-            return *curr;
-        }
-        curr = &((*curr)->next);
-    }
-    throw std::runtime_error("Unreachable code.");
+AllocatorStats HeapAllocatorPool::get_stats() const {
+    AllocatorStats result;
+    stats.fill(result);
+    result.free_bytes = free_size;
+    return result;
 }
 
-
-size_t HeapAllocatorPool::get_remain_size() const {
-    IdleListNode* node = idle_list_head.get();
-    size_t total = 0;
-    while (node != nullptr) {
-        total += node->size;
-        node = node->next.get();
+size_t HeapAllocatorPool::get_largest_free_block() const {
+    size_t result = 0;
+    for (const char* curr = idle_list_head; curr != nullptr;) {
+        IdleListNode node = load_node(curr);
+        result = std::max(result, node.size);
+        curr = node.next;
     }
-    return total;
+    return result;
 }
 
 HeapAllocatorPool::operator std::string() const {
@@ -171,16 +250,17 @@ HeapAllocatorPool::operator std::string() const {
     ss << "\"type\":\"HeapAllocatorPool\",";
     ss << "\"total_size\":" << get_total_size() << ",";
     ss << "\"free_chunk_layout\":[";
-    IdleListNode* node = idle_list_head.get();
+    const char* curr = idle_list_head;
     bool first = true;
-    while (node != nullptr) {
+    while (curr != nullptr) {
+        IdleListNode node = load_node(curr);
         if (!first) ss << ",";
         first = false;
         ss << "{"
-           << "\"begin\":" << (node->mem_start - mem_chunk) << ","
-           << "\"size\":" << node->size
+           << "\"begin\":" << (curr - mem_chunk) << ","
+           << "\"size\":" << node.size
            << "}";
-        node = node->next.get();
+        curr = node.next;
     }
     ss << "]";
     ss << "}";
@@ -0,0 +1,282 @@
+/* Copyright 2025 OppositeNor
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#include "core/allocator/heap_allocator_thread_cache.hh"
+#include "core/allocator/allocator.hh"
+#include "core/logging/log.hh"
+#include "utils/defs.hh"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+namespace WhiteBirdEngine {
+
+thread_local HeapAllocatorThreadCache::ThreadCacheTable HeapAllocatorThreadCache::thread_cache_table;
+std::mutex HeapAllocatorThreadCache::registry_mutex;
+std::unordered_map<uint64_t, HeapAllocatorThreadCache*> HeapAllocatorThreadCache::live_instances;
+std::atomic<uint64_t> HeapAllocatorThreadCache::next_instance_id = 1;
+
+// Size class lookup table indexed by the size in units of WBE_DEFAULT_ALIGNMENT.
+static constexpr size_t SIZE_CLASS_LOOKUP_COUNT = HeapAllocatorThreadCache::MAX_CACHED_SIZE / WBE_DEFAULT_ALIGNMENT + 1;
+static constexpr std::array<uint8_t, SIZE_CLASS_LOOKUP_COUNT> SIZE_CLASS_LOOKUP = [] {
+    std::array<uint8_t, SIZE_CLASS_LOOKUP_COUNT> result {};
+    size_t size_class = 0;
+    for (size_t i = 0; i < SIZE_CLASS_LOOKUP_COUNT; ++i) {
+        while (HeapAllocatorThreadCache::SIZE_CLASSES[size_class] < i * WBE_DEFAULT_ALIGNMENT) {
+            ++size_class;
+        }
+        result[i] = size_class;
+    }
+    return result;
+}();
+
+HeapAllocatorThreadCache::HeapAllocatorThreadCache(HeapAllocatorAtomicAlignedPool* p_backing_pool)
+    : backing_pool(p_backing_pool), instance_id(next_instance_id.fetch_add(1, std::memory_order_relaxed)) {
+    if (p_backing_pool == nullptr) {
+        throw std::runtime_error("Failed to create thread cache: backing pool is null.");
+    }
+    std::lock_guard lock(registry_mutex);
+    live_instances[instance_id] = this;
+}
+
+HeapAllocatorThreadCache::~HeapAllocatorThreadCache() {
+    {
+        // After this, exiting threads will no longer release their caches to this instance.
+        std::lock_guard lock(registry_mutex);
+        live_instances.erase(instance_id);
+    }
+    if (!is_empty()) {
+        wbe_console_log(WBE_CHANNEL_GLOBAL)->warning("Non-empty allocator destructed.");
+    }
+    flush_all();
+    std::lock_guard lock(caches_mutex);
+    caches.clear();
+}
+
+MemID HeapAllocatorThreadCache::allocate(size_t p_size, size_t p_alignment) {
+    if (p_alignment == 0) {
+        throw std::runtime_error("Failed to allocate resource: allocation alignment must not be 0.");
+    }
+    if (p_alignment % alignof(HeapAllocatorAtomicAlignedPool::Header) != 0) {
+        throw std::runtime_error(std::format("Allocation alignment must be a multiple of {}", alignof(HeapAllocatorAtomicAlignedPool::Header)));
+    }
+    if (p_size == 0) {
+        return MEM_NULL;
+    }
+    ThreadCache* cache = get_thread_cache();
+    if (p_size > MAX_CACHED_SIZE || p_alignment > WBE_DEFAULT_ALIGNMENT) {
+        MemID result = backing_pool->allocate(p_size, p_alignment);
+        cache->allocated_count.store(cache->allocated_count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return result;
+    }
+    size_t size_class = get_size_class(p_size);
+    Bin& bin = cache->bins[size_class];
+    if (bin.head == nullptr) {
+        refill_bin(cache, size_class);
+    }
+    void* chunk = bin.head;
+    bin.head = *static_cast<void**>(chunk);
+    --bin.count;
+    cache->cached_size.store(cache->cached_size.load(std::memory_order_relaxed) - SIZE_CLASSES[size_class], std::memory_order_relaxed);
+    cache->allocated_count.store(cache->allocated_count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    return reinterpret_cast<MemID>(chunk);
+}
+
+void HeapAllocatorThreadCache::deallocate(MemID p_mem) {
+    if (p_mem == MEM_NULL) {
+        return;
+    }
+    ThreadCache* cache = get_thread_cache();
+    cache->allocated_count.store(cache->allocated_count.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+    size_t data_size = backing_pool->get_allocated_data_size(p_mem);
+    // Chunks that do not exactly match a size class are returned directly.
+    if (data_size > MAX_CACHED_SIZE || SIZE_CLASSES[get_size_class(data_size)] != data_size) {
+        backing_pool->deallocate(p_mem);
+        return;
+    }
+    size_t size_class = get_size_class(data_size);
+    Bin& bin = cache->bins[size_class];
+    void* chunk = reinterpret_cast<void*>(p_mem);
+    *static_cast<void**>(chunk) = bin.head;
+    bin.head = chunk;
+    ++bin.count;
+    cache->cached_size.store(cache->cached_size.load(std::memory_order_relaxed) + data_size, std::memory_order_relaxed);
+    size_t batch_count = get_batch_count(size_class);
+    if (bin.count > 2 * batch_count) {
+        flush_bin(cache, size_class, batch_count);
+    }
+}
+
+bool HeapAllocatorThreadCache::is_empty() const {
+    std::lock_guard lock(caches_mutex);
+    int64_t total = detached_allocated_count;
+    for (const auto& cache : caches) {
+        total += cache->allocated_count.load(std::memory_order_relaxed);
+    }
+    return total == 0;
+}
+
+void HeapAllocatorThreadCache::clear() {
+    std::lock_guard lock(caches_mutex);
+    for (auto& cache : caches) {
+        for (Bin& bin : cache->bins) {
+            bin = Bin();
+        }
+        cache->allocated_count.store(0, std::memory_order_relaxed);
+        cache->cached_size.store(0, std::memory_order_relaxed);
+    }
+    detached_allocated_count = 0;
+    backing_pool->clear();
+}
+
+void HeapAllocatorThreadCache::flush() {
+    flush_cache(get_thread_cache());
+}
+
+void HeapAllocatorThreadCache::flush_all() {
+    std::lock_guard lock(caches_mutex);
+    for (auto& cache : caches) {
+        flush_cache(cache.get());
+    }
+}
+
+size_t HeapAllocatorThreadCache::get_cached_size() const {
+    std::lock_guard lock(caches_mutex);
+    size_t total = 0;
+    for (const auto& cache : caches) {
+        total += cache->cached_size.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+size_t HeapAllocatorThreadCache::get_thread_cache_count() const {
+    std::lock_guard lock(caches_mutex);
+    return caches.size();
+}
+
+size_t HeapAllocatorThreadCache::get_size_class(size_t p_size) {
+    WBE_DEBUG_ASSERT(p_size <= MAX_CACHED_SIZE);
+    return SIZE_CLASS_LOOKUP[(p_size + WBE_DEFAULT_ALIGNMENT - 1) / WBE_DEFAULT_ALIGNMENT];
+}
+
+HeapAllocatorThreadCache::ThreadCache* HeapAllocatorThreadCache::find_thread_cache(ThreadCacheTable& p_table) {
+    for (auto& entry : p_table.entries) {
+        if (entry.first == instance_id) {
+            p_table.last_instance_id = entry.first;
+            p_table.last_cache = entry.second;
+            return entry.second;
+        }
+    }
+    {
+        // Drop the entries of the destructed instances.
+        std::lock_guard lock(registry_mutex);
+        std::erase_if(p_table.entries, [](const auto& p_entry) {
+            return !live_instances.contains(p_entry.first);
+        });
+    }
+    ThreadCache* result = nullptr;
+    {
+        std::lock_guard lock(caches_mutex);
+        caches.push_back(std::make_unique<ThreadCache>());
+        result = caches.back().get();
+    }
+    p_table.entries.emplace_back(instance_id, result);
+    p_table.last_instance_id = instance_id;
+    p_table.last_cache = result;
+    return result;
+}
+
+void HeapAllocatorThreadCache::refill_bin(ThreadCache* p_cache, size_t p_size_class) {
+    size_t chunk_size = SIZE_CLASSES[p_size_class];
+    size_t batch_count = get_batch_count(p_size_class);
+    MemID mem_ids[MAX_BATCH_COUNT];
+    try {
+        backing_pool->allocate_batch(batch_count, chunk_size, WBE_DEFAULT_ALIGNMENT, mem_ids);
+    }
+    catch (const std::runtime_error&) {
+        // The backing pool is running out, return the memory held by this thread then try a single chunk.
+        flush_cache(p_cache);
+        mem_ids[0] = backing_pool->allocate(chunk_size, WBE_DEFAULT_ALIGNMENT);
+        batch_count = 1;
+    }
+    Bin& bin = p_cache->bins[p_size_class];
+    // Push in reverse so that the chunks are handed out in address order.
+    for (size_t i = batch_count; i > 0; --i) {
+        void* chunk = reinterpret_cast<void*>(mem_ids[i - 1]);
+        *static_cast<void**>(chunk) = bin.head;
+        bin.head = chunk;
+    }
+    bin.count += batch_count;
+    p_cache->cached_size.store(p_cache->cached_size.load(std::memory_order_relaxed) + batch_count * chunk_size, std::memory_order_relaxed);
+}
+
+void HeapAllocatorThreadCache::flush_bin(ThreadCache* p_cache, size_t p_size_class, size_t p_count) {
+    Bin& bin = p_cache->bins[p_size_class];
+    MemID mem_ids[MAX_BATCH_COUNT];
+    while (p_count > 0 && bin.head != nullptr) {
+        size_t batch_count = 0;
+        while (batch_count < MAX_BATCH_COUNT && batch_count < p_count && bin.head != nullptr) {
+            mem_ids[batch_count++] = reinterpret_cast<MemID>(bin.head);
+            bin.head = *static_cast<void**>(bin.head);
+        }
+        bin.count -= batch_count;
+        p_count -= batch_count;
+        p_cache->cached_size.store(p_cache->cached_size.load(std::memory_order_relaxed) - batch_count * SIZE_CLASSES[p_size_class], std::memory_order_relaxed);
+        backing_pool->deallocate_batch(mem_ids, batch_count);
+    }
+}
+
+void HeapAllocatorThreadCache::flush_cache(ThreadCache* p_cache) {
+    for (size_t i = 0; i < SIZE_CLASS_COUNT; ++i) {
+        flush_bin(p_cache, i, p_cache->bins[i].count);
+    }
+}
+
+void HeapAllocatorThreadCache::release_thread_cache(ThreadCache* p_cache) {
+    flush_cache(p_cache);
+    std::lock_guard lock(caches_mutex);
+    detached_allocated_count += p_cache->allocated_count.load(std::memory_order_relaxed);
+    std::erase_if(caches, [p_cache](const auto& p_element) {
+        return p_element.get() == p_cache;
+    });
+}
+
+HeapAllocatorThreadCache::ThreadCacheTable::~ThreadCacheTable() {
+    std::lock_guard lock(registry_mutex);
+    for (auto& entry : entries) {
+        auto it = live_instances.find(entry.first);
+        if (it != live_instances.end()) {
+            it->second->release_thread_cache(entry.second);
+        }
+    }
+}
+
+HeapAllocatorThreadCache::operator std::string() const {
+    std::stringstream ss;
+    ss << "{";
+    ss << "\"type\":\"HeapAllocatorThreadCache\",";
+    ss << "\"thread_cache_count\":" << get_thread_cache_count() << ",";
+    ss << "\"cached_size\":" << get_cached_size() << ",";
+    ss << "\"backing_pool\":" << static_cast<std::string>(*backing_pool);
+    ss << "}";
+    return ss.str();
+}
+
+}
@@ -0,0 +1,503 @@
+/* Copyright 2025 OppositeNor
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#include "core/allocator/heap_allocator_tlsf.hh"
+#include "core/allocator/allocator.hh"
+#include "core/logging/log.hh"
+#include "utils/defs.hh"
+#include "utils/utils.hh"
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+namespace WhiteBirdEngine {
+
+HeapAllocatorTLSF::HeapAllocatorTLSF(size_t p_size, size_t p_reserve_size, bool p_huge_pages)
+    : size(p_size - p_size % HEADER_SIZE) {
+    if (std::max(p_size, p_reserve_size) > MAX_TOTAL_SIZE) {
+        throw std::runtime_error(std::format("Failed to create pool: size: {} exceeds maximum: {}.",
+                                             std::max(p_size, p_reserve_size), MAX_TOTAL_SIZE));
+    }
+    if (size < MIN_CHUNK_SIZE) {
+        throw std::runtime_error(std::format("Failed to create pool: size: {} is less than minimum: {}.", p_size, MIN_CHUNK_SIZE));
+    }
+    if (p_reserve_size != 0) {
+        if (p_reserve_size < p_size) {
+            throw std::runtime_error(std::format("Failed to create pool: reserve size: {} is less than size: {}.",
+                                                 p_reserve_size, p_size));
+        }
+        virtual_memory = std::make_unique<VirtualMemoryRange>(p_reserve_size, p_size, p_huge_pages);
+        growable = true;
+    }
+    else if (p_huge_pages) {
+        virtual_memory = std::make_unique<VirtualMemoryRange>(p_size, p_size, true);
+    }
+    if (virtual_memory != nullptr) {
+        mem_chunk = virtual_memory->get_data();
+        // The committed pages are zero filled, and only backed by physical memory when touched.
+        size = virtual_memory->get_committed_size();
+    }
+    else {
+        mem_chunk = static_cast<char*>(aligned_alloc(HEADER_SIZE, size));
+        if (mem_chunk == nullptr) {
+            throw std::runtime_error("Failed to create pool: malloc failed.");
+        }
+        // Trigger page fault to mmap from MMU.
+        memset(mem_chunk, 0, size);
+    }
+    clear();
+}
+
+HeapAllocatorTLSF::~HeapAllocatorTLSF() {
+    if (!is_empty()) {
+        wbe_console_log(WBE_CHANNEL_GLOBAL)->warning(std::format("Non-empty allocator destructed. Allocator status: {}",
+                                                                 static_cast<std::string>(*this)));
+    }
+    if (virtual_memory == nullptr) {
+        free(mem_chunk);
+    }
+    mem_chunk = nullptr;
+}
+
+MemID HeapAllocatorTLSF::allocate(size_t p_size, size_t p_alignment) {
+    WBE_DEBUG(check_broken();)
+    check_alignment(p_alignment);
+    if (p_size == 0) {
+        return MEM_NULL;
+    }
+    size_t chunk_size = get_chunk_size_for(p_size);
+    Chunk* chunk = acquire_chunk(chunk_size, std::lcm(p_alignment, HEADER_SIZE));
+    if (chunk == nullptr) {
+        stats.on_failed_allocation();
+        std::string err_msg = "Failed to allocate memory: not enough space for memory pool.\n"
+            "Trying to allocate: " + std::to_string(chunk_size) + " bytes.\n"
+            "Pool status: " + static_cast<std::string>(*this);
+        throw std::runtime_error(err_msg);
+    }
+    stats.on_allocate(get_chunk_size(chunk));
+    WBE_DEBUG(check_broken();)
+    return get_mem_id(chunk);
+}
+
+void HeapAllocatorTLSF::allocate_batch(size_t p_count, size_t p_size, size_t p_alignment, MemID* r_mem_ids) {
+    check_alignment(p_alignment);
+    if (p_size == 0 || p_count == 0) {
+        std::fill(r_mem_ids, r_mem_ids + p_count, MEM_NULL);
+        return;
+    }
+    size_t chunk_size = get_chunk_size_for(p_size);
+    size_t alignment = std::lcm(p_alignment, HEADER_SIZE);
+    // Carve the chunks from one block if every chunk stays aligned.
+    Chunk* chunk = chunk_size % alignment == 0 && p_count <= MAX_TOTAL_SIZE / chunk_size ?
+        acquire_chunk(chunk_size * p_count, alignment) : nullptr;
+    if (chunk == nullptr) {
+        HeapAllocatorAligned::allocate_batch(p_count, p_size, p_alignment, r_mem_ids);
+        return;
+    }
+    size_t block_size = get_chunk_size(chunk);
+    for (size_t i = 0; i + 1 < p_count; ++i) {
+        Chunk* next = split_chunk(chunk, chunk_size);
+        WBE_DEBUG_ASSERT(next != nullptr);
+        set_chunk(next, get_chunk_size(next), false);
+        r_mem_ids[i] = get_mem_id(chunk);
+        chunk = next;
+    }
+    // The last chunk keeps the tail that is too small to split off.
+    r_mem_ids[p_count - 1] = get_mem_id(chunk);
+    stats.on_allocate(block_size, p_count);
+    WBE_DEBUG(check_broken();)
+}
+
+void HeapAllocatorTLSF::check_alignment(size_t p_alignment) {
+    if (p_alignment == 0) {
+        throw std::runtime_error("Allocation alignment must not be 0.");
+    }
+    if (p_alignment % alignof(Chunk) != 0) {
+        throw std::runtime_error(std::format("Allocation alignment must be a multiple of {}.", alignof(Chunk)));
+    }
+}
+
+size_t HeapAllocatorTLSF::get_chunk_size_for(size_t p_size) {
+    return p_size > MAX_TOTAL_SIZE ? MAX_TOTAL_SIZE
+        : std::max(get_align_size(p_size, HEADER_SIZE) + HEADER_SIZE, MIN_CHUNK_SIZE);
+}
+
+HeapAllocatorTLSF::Chunk* HeapAllocatorTLSF::acquire_chunk(size_t p_chunk_size, size_t p_alignment) {
+    // Over-aligned allocations search for a chunk large enough to split off an idle gap in the front.
+    size_t search_size = p_alignment > HEADER_SIZE ? p_chunk_size + p_alignment + MIN_CHUNK_SIZE : p_chunk_size;
+    Chunk* chunk = find_free_chunk(search_size);
+    if (chunk == nullptr && is_growable() && grow(search_size)) {
+        chunk = find_free_chunk(search_size);
+    }
+    if (chunk == nullptr) {
+        return nullptr;
+    }
+    if (p_alignment > HEADER_SIZE) {
+        MemID mem_start = get_mem_id(chunk);
+        MemID aligned_start = get_align_size(mem_start, p_alignment);
+        // The gap in front has to be able to hold an idle chunk.
+        if (aligned_start != mem_start && aligned_start - mem_start < MIN_CHUNK_SIZE) {
+            aligned_start = get_align_size(mem_start + MIN_CHUNK_SIZE, p_alignment);
+        }
+        if (aligned_start != mem_start) {
+            Chunk* aligned_chunk = split_chunk(chunk, aligned_start - mem_start);
+            WBE_DEBUG_ASSERT(aligned_chunk != nullptr);
+            insert_free_chunk(chunk);
+            chunk = aligned_chunk;
+        }
+    }
+    Chunk* remain = split_chunk(chunk, p_chunk_size);
+    if (remain != nullptr) {
+        insert_free_chunk(remain);
+    }
+    set_chunk(chunk, get_chunk_size(chunk), false);
+    used_size += get_chunk_size(chunk);
+    return chunk;
+}
+
+void HeapAllocatorTLSF::deallocate(MemID p_mem) {
+    if (p_mem == MEM_NULL) {
+        return;
+    }
+    WBE_DEBUG_ASSERT(is_in_pool(p_mem));
+    Chunk* chunk = get_chunk(p_mem);
+    used_size -= get_chunk_size(chunk);
+    stats.on_deallocate(get_chunk_size(chunk));
+    set_chunk(chunk, get_chunk_size(chunk), true);
+    chunk = merge_with_prev(chunk);
+    merge_with_next(chunk);
+    insert_free_chunk(chunk);
+    WBE_DEBUG(check_broken();)
+}
+
+bool HeapAllocatorTLSF::try_expand(MemID p_mem, size_t p_new_size) {
+    WBE_DEBUG(check_broken();)
+    WBE_DEBUG_ASSERT(is_in_pool(p_mem));
+    if (p_new_size == 0 || p_new_size > MAX_TOTAL_SIZE) {
+        return false;
+    }
+    Chunk* chunk = get_chunk(p_mem);
+    size_t old_chunk_size = get_chunk_size(chunk);
+    size_t new_chunk_size = std::max(get_align_size(p_new_size, HEADER_SIZE) + HEADER_SIZE, MIN_CHUNK_SIZE);
+    if (new_chunk_size > old_chunk_size) {
+        Chunk* next = get_next_phys(chunk);
+        size_t available_size = old_chunk_size + (next != nullptr && is_chunk_idle(next) ? get_chunk_size(next) : 0);
+        // An allocation at the end of a growable pool could expand into the newly committed memory.
+        if (available_size < new_chunk_size && is_growable()
+            && reinterpret_cast<char*>(chunk) + available_size == mem_chunk + size
+            && grow(new_chunk_size - available_size)) {
+            next = get_next_phys(chunk);
+            available_size = old_chunk_size + get_chunk_size(next);
+        }
+        if (available_size < new_chunk_size) {
+            return false;
+        }
+        // Take the whole idle chunk after it, and split the remain off below.
+        merge_with_next(chunk);
+        set_chunk(chunk, get_chunk_size(chunk), false);
+    }
+    Chunk* remain = split_chunk(chunk, new_chunk_size);
+    if (remain != nullptr) {
+        merge_with_next(remain);
+        insert_free_chunk(remain);
+    }
+    used_size += get_chunk_size(chunk);
+    used_size -= old_chunk_size;
+    stats.on_resize(old_chunk_size, get_chunk_size(chunk));
+    WBE_DEBUG(check_broken();)
+    return true;
+}
+
+void HeapAllocatorTLSF::clear() {
+    fl_bitmap = 0;
+    memset(sl_bitmap, 0, sizeof(sl_bitmap));
+    memset(free_lists, 0, sizeof(free_lists));
+    Chunk* chunk = reinterpret_cast<Chunk*>(mem_chunk);
+    chunk->prev_phys = nullptr;
+    set_chunk(chunk, size, true);
+    insert_free_chunk(chunk);
+    last_phys = chunk;
+    used_size = 0;
+    stats.on_clear();
+}
+
+bool HeapAllocatorTLSF::grow(size_t p_size) {
+    size_t reserved_size = virtual_memory->get_reserved_size();
+    if (size >= reserved_size) {
+        return false;
+    }
+    // Free lists are searched by size class rounded up, so the new chunk needs to be large
+    // enough to land in that class. Grow by at least the current size to amortize the commits.
+    size_t required_size = p_size + (p_size >> SL_INDEX_COUNT_LOG2) + HEADER_SIZE;
+    size_t new_size = std::min(size + std::max(required_size, size), reserved_size);
+    virtual_memory->commit(new_size);
+    new_size = std::min(virtual_memory->get_committed_size(), reserved_size);
+    Chunk* chunk = reinterpret_cast<Chunk*>(mem_chunk + size);
+    chunk->prev_phys = last_phys;
+    set_chunk(chunk, new_size - size, true);
+    size = new_size;
+    last_phys = chunk;
+    chunk = merge_with_prev(chunk);
+    insert_free_chunk(chunk);
+    WBE_DEBUG(check_broken();)
+    return true;
+}
+
+void HeapAllocatorTLSF::mapping_insert(size_t p_size, size_t& r_fl, size_t& r_sl) {
+    if (p_size < SMALL_CHUNK_SIZE) {
+        // Small chunks are linearly subdivided.
+        r_fl = 0;
+        r_sl = p_size / (SMALL_CHUNK_SIZE / SL_INDEX_COUNT);
+        return;
+    }
+    size_t msb = std::bit_width(p_size) - 1;
+    r_sl = (p_size >> (msb - SL_INDEX_COUNT_LOG2)) ^ SL_INDEX_COUNT;
+    r_fl = msb - FL_INDEX_SHIFT + 1;
+}
+
+bool HeapAllocatorTLSF::mapping_search(size_t p_size, size_t& r_fl, size_t& r_sl) {
+    // Round up to the next size class, so that every chunk in the class found is large enough.
+    if (p_size >= SMALL_CHUNK_SIZE) {
+        p_size += (1ull << (std::bit_width(p_size) - 1 - SL_INDEX_COUNT_LOG2)) - 1;
+    }
+    if (p_size > MAX_TOTAL_SIZE) {
+        return false;
+    }
+    mapping_insert(p_size, r_fl, r_sl);
+    return true;
+}
+
+HeapAllocatorTLSF::Chunk* HeapAllocatorTLSF::find_free_chunk(size_t p_size) {
+    size_t fl, sl;
+    if (!mapping_search(p_size, fl, sl)) {
+        return nullptr;
+    }
+    uint32_t sl_map = sl_bitmap[fl] & (~0u << sl);
+    if (sl_map == 0) {
+        // No chunks in this first level that is large enough, try the larger first levels.
+        uint32_t fl_map = fl + 1 < FL_INDEX_COUNT ? fl_bitmap & (~0u << (fl + 1)) : 0;
+        if (fl_map == 0) {
+            return nullptr;
+        }
+        fl = std::countr_zero(fl_map);
+        sl_map = sl_bitmap[fl];
+    }
+    sl = std::countr_zero(sl_map);
+    Chunk* result = free_lists[fl][sl];
+    WBE_DEBUG_ASSERT(result != nullptr);
+    remove_free_chunk(result);
+    return result;
+}
+
+void HeapAllocatorTLSF::insert_free_chunk(Chunk* p_chunk) {
+    WBE_DEBUG_ASSERT(is_chunk_idle(p_chunk));
+    size_t fl, sl;
+    mapping_insert(get_chunk_size(p_chunk), fl, sl);
+    Chunk* head = free_lists[fl][sl];
+    p_chunk->prev_free = nullptr;
+    p_chunk->next_free = head;
+    if (head != nullptr) {
+        head->prev_free = p_chunk;
+    }
+    free_lists[fl][sl] = p_chunk;
+    fl_bitmap |= 1u << fl;
+    sl_bitmap[fl] |= 1u << sl;
+}
+
+void HeapAllocatorTLSF::remove_free_chunk(Chunk* p_chunk) {
+    size_t fl, sl;
+    mapping_insert(get_chunk_size(p_chunk), fl, sl);
+    if (p_chunk->prev_free != nullptr) {
+        p_chunk->prev_free->next_free = p_chunk->next_free;
+    }
+    if (p_chunk->next_free != nullptr) {
+        p_chunk->next_free->prev_free = p_chunk->prev_free;
+    }
+    if (free_lists[fl][sl] == p_chunk) {
+        free_lists[fl][sl] = p_chunk->next_free;
+        if (free_lists[fl][sl] == nullptr) {
+            sl_bitmap[fl] &= ~(1u << sl);
+            if (sl_bitmap[fl] == 0) {
+                fl_bitmap &= ~(1u << fl);
+            }
+        }
+    }
+    p_chunk->prev_free = nullptr;
+    p_chunk->next_free = nullptr;
+}
+
+HeapAllocatorTLSF::Chunk* HeapAllocatorTLSF::split_chunk(Chunk* p_chunk, size_t p_size) {
+    size_t chunk_size = get_chunk_size(p_chunk);
+    WBE_DEBUG_ASSERT(chunk_size >= p_size);
+    if (chunk_size - p_size < MIN_CHUNK_SIZE) {
+        return nullptr;
+    }
+    Chunk* remain = reinterpret_cast<Chunk*>(reinterpret_cast<char*>(p_chunk) + p_size);
+    remain->prev_phys = p_chunk;
+    set_chunk(remain, chunk_size - p_size, true);
+    Chunk* next = get_next_phys(remain);
+    if (next != nullptr) {
+        next->prev_phys = remain;
+    }
+    else {
+        last_phys = remain;
+    }
+    set_chunk(p_chunk, p_size, is_chunk_idle(p_chunk));
+    return remain;
+}
+
+HeapAllocatorTLSF::Chunk* HeapAllocatorTLSF::merge_with_prev(Chunk* p_chunk) {
+    Chunk* prev = p_chunk->prev_phys;
+    if (prev == nullptr || !is_chunk_idle(prev)) {
+        return p_chunk;
+    }
+    remove_free_chunk(prev);
+    set_chunk(prev, get_chunk_size(prev) + get_chunk_size(p_chunk), true);
+    Chunk* next = get_next_phys(prev);
+    if (next != nullptr) {
+        next->prev_phys = prev;
+    }
+    else {
+        last_phys = prev;
+    }
+    return prev;
+}
+
+void HeapAllocatorTLSF::merge_with_next(Chunk* p_chunk) {
+    Chunk* next = get_next_phys(p_chunk);
+    if (next == nullptr || !is_chunk_idle(next)) {
+        return;
+    }
+    remove_free_chunk(next);
+    set_chunk(p_chunk, get_chunk_size(p_chunk) + get_chunk_size(next), true);
+    Chunk* next_next = get_next_phys(p_chunk);
+    if (next_next != nullptr) {
+        next_next->prev_phys = p_chunk;
+    }
+    else {
+        last_phys = p_chunk;
+    }
+}
+
+size_t HeapAllocatorTLSF::get_max_free_size() const {
+    if (fl_bitmap == 0) {
+        return 0;
+    }
+    size_t fl = std::bit_width(fl_bitmap) - 1;
+    size_t sl = std::bit_width(sl_bitmap[fl]) - 1;
+    size_t result = 0;
+    // Chunks in the same size class could still have different sizes.
+    for (const Chunk* curr = free_lists[fl][sl]; curr != nullptr; curr = curr->next_free) {
+        result = std::max(result, get_chunk_size(curr));
+    }
+    return result - HEADER_SIZE;
+}
+
+AllocatorStats HeapAllocatorTLSF::get_stats() const {
+    AllocatorStats result;
+    stats.fill(result);
+    result.free_bytes = get_remain_size();
+    result.largest_free_block = fl_bitmap == 0 ? 0 : get_max_free_size() + HEADER_SIZE;
+    result.largest_free_block_tracked = true;
+    return result;
+}
+
+bool HeapAllocatorTLSF::is_in_pool(MemID p_mem_id) const {
+    const Chunk* curr = reinterpret_cast<const Chunk*>(mem_chunk);
+    while (curr != nullptr && get_mem_id(curr) <= p_mem_id) {
+        if (get_mem_id(curr) == p_mem_id) {
+            return !is_chunk_idle(curr);
+        }
+        curr = get_next_phys(curr);
+    }
+    return false;
+}
+
+void HeapAllocatorTLSF::check_broken() const {
+    const Chunk* prev = nullptr;
+    const Chunk* curr = reinterpret_cast<const Chunk*>(mem_chunk);
+    size_t total_used = 0;
+    size_t total_size = 0;
+    while (curr != nullptr) {
+        size_t chunk_size = get_chunk_size(curr);
+        if (chunk_size < MIN_CHUNK_SIZE || chunk_size % HEADER_SIZE != 0) {
+            throw std::runtime_error("Bad chunk size.");
+        }
+        if (curr->prev_phys != prev) {
+            throw std::runtime_error("Bad physical link.");
+        }
+        if (prev != nullptr && is_chunk_idle(prev) && is_chunk_idle(curr)) {
+            throw std::runtime_error("Idle chunks not coalesced.");
+        }
+        if (!is_chunk_idle(curr)) {
+            total_used += chunk_size;
+        }
+        total_size += chunk_size;
+        prev = curr;
+        curr = get_next_phys(curr);
+    }
+    if (total_size != size) {
+        throw std::runtime_error("Bad pool.");
+    }
+    if (prev != last_phys) {
+        throw std::runtime_error("Bad last chunk.");
+    }
+    if (total_used != used_size) {
+        throw std::runtime_error("Bad used size.");
+    }
+    for (size_t fl = 0; fl < FL_INDEX_COUNT; ++fl) {
+        for (size_t sl = 0; sl < SL_INDEX_COUNT; ++sl) {
+            bool has_chunk = free_lists[fl][sl] != nullptr;
+            if (has_chunk != bool(sl_bitmap[fl] & (1u << sl)) || (has_chunk && !(fl_bitmap & (1u << fl)))) {
+                throw std::runtime_error("Bad bitmap.");
+            }
+        }
+    }
+}
+
+HeapAllocatorTLSF::operator std::string() const {
+    std::stringstream ss;
+    ss << "{";
+    ss << "\"type\":\"HeapAllocatorTLSF\",";
+    ss << "\"total_size\":" << get_total_size() << ",";
+    ss << "\"remain_size\":" << get_remain_size() << ",";
+    ss << "\"committed_size\":" << get_committed_size() << ",";
+    ss << "\"reserved_size\":" << get_reserved_size() << ",";
+    ss << "\"page_backing\":\"" << get_page_backing_name(get_page_backing()) << "\",";
+    ss << "\"chunk_layout\":[";
+    const Chunk* curr = reinterpret_cast<const Chunk*>(mem_chunk);
+    bool first = true;
+    while (curr != nullptr) {
+        if (!first) ss << ",";
+        first = false;
+        ss << "{"
+            << "\"occupied\":" << std::to_string(!is_chunk_idle(curr)) << ","
+            << "\"begin\":" << (reinterpret_cast<const char*>(curr) - mem_chunk) << ","
+            << "\"size\":" << get_chunk_size(curr)
+            << "}";
+        curr = get_next_phys(curr);
+    }
+    ss << "]";
+    ss << "}";
+    return ss.str();
+}
+
+}
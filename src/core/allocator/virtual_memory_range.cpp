@@ -0,0 +1,125 @@
+/* Copyright 2025 OppositeNor
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#include "core/allocator/virtual_memory_range.hh"
+#include "platform/os/os.hh"
+#include "utils/utils.hh"
+#include <format>
+#include <sstream>
+#include <stdexcept>
+
+namespace WhiteBirdEngine {
+
+VirtualMemoryRange::VirtualMemoryRange(size_t p_reserve_size, size_t p_commit_size, bool p_huge_pages)
+    : reserved_size(get_align_size(p_reserve_size, p_huge_pages ? OS::get_huge_page_size() : OS::get_page_size())) {
+    if (reserved_size == 0) {
+        throw std::runtime_error("Failed to reserve virtual memory: reserve size must not be 0.");
+    }
+    if (p_commit_size > reserved_size) {
+        throw std::runtime_error(std::format("Failed to reserve virtual memory: commit size: {} exceeds reserve size: {}.",
+                                             p_commit_size, reserved_size));
+    }
+    // Explicit huge pages could not be committed page by page, so only used when fully committed.
+    if (p_huge_pages && p_commit_size == p_reserve_size && try_map_huge_tlb()) {
+        return;
+    }
+    map_aligned(p_huge_pages ? OS::get_huge_page_size() : OS::get_page_size());
+    if (p_huge_pages) {
+        try {
+            OS::memory_advise(data, reserved_size, OS::MemoryAdvice::HUGE_PAGE);
+            page_backing = PageBacking::TRANSPARENT_HUGE;
+        }
+        catch (const std::runtime_error&) {
+            // Transparent huge pages not supported, keep the regular pages.
+        }
+    }
+    try {
+        commit(p_commit_size == p_reserve_size ? reserved_size : p_commit_size);
+    }
+    catch (...) {
+        OS::memory_unmap(data, reserved_size);
+        throw;
+    }
+}
+
+VirtualMemoryRange::~VirtualMemoryRange() {
+    OS::memory_unmap(data, reserved_size);
+    data = nullptr;
+}
+
+bool VirtualMemoryRange::commit(size_t p_size) {
+    if (p_size <= committed_size) {
+        return true;
+    }
+    if (p_size > reserved_size) {
+        return false;
+    }
+    size_t new_committed_size = get_align_size(p_size, OS::get_page_size());
+    OS::MMapProt prot;
+    prot.set((int)OS::MMapProtBit::READ);
+    prot.set((int)OS::MMapProtBit::WRITE);
+    OS::memory_protect(data + committed_size, new_committed_size - committed_size, prot);
+    committed_size = new_committed_size;
+    return true;
+}
+
+bool VirtualMemoryRange::try_map_huge_tlb() {
+    OS::MMapProt prot;
+    prot.set((int)OS::MMapProtBit::READ);
+    prot.set((int)OS::MMapProtBit::WRITE);
+    OS::MMapFlags flags;
+    flags.set((int)OS::MMapFlagBit::PRIVATE);
+    flags.set((int)OS::MMapFlagBit::ANON);
+    flags.set((int)OS::MMapFlagBit::HUGETLB);
+    try {
+        data = static_cast<char*>(OS::memory_map(nullptr, reserved_size, prot, flags, -1, 0));
+    }
+    catch (const std::runtime_error&) {
+        // Usually the huge page pool is not large enough.
+        return false;
+    }
+    committed_size = reserved_size;
+    page_backing = PageBacking::HUGE_TLB;
+    return true;
+}
+
+void VirtualMemoryRange::map_aligned(size_t p_alignment) {
+    OS::MMapFlags flags;
+    flags.set((int)OS::MMapFlagBit::PRIVATE);
+    flags.set((int)OS::MMapFlagBit::ANON);
+    flags.set((int)OS::MMapFlagBit::NORESERVE);
+    // Map with extra space and trim both ends so that the start is aligned. No access until committed.
+    size_t extra_size = p_alignment > OS::get_page_size() ? p_alignment : 0;
+    char* mapped = static_cast<char*>(OS::memory_map(nullptr, reserved_size + extra_size, OS::MMapProt(), flags, -1, 0));
+    data = reinterpret_cast<char*>(get_align_size(reinterpret_cast<size_t>(mapped), p_alignment));
+    if (data != mapped) {
+        OS::memory_unmap(mapped, data - mapped);
+    }
+    if (data + reserved_size != mapped + reserved_size + extra_size) {
+        OS::memory_unmap(data + reserved_size, mapped + reserved_size + extra_size - (data + reserved_size));
+    }
+}
+
+VirtualMemoryRange::operator std::string() const {
+    std::stringstream ss;
+    ss << "{";
+    ss << "\"type\":\"VirtualMemoryRange\",";
+    ss << "\"committed_size\":" << committed_size << ",";
+    ss << "\"reserved_size\":" << reserved_size << ",";
+    ss << "\"page_backing\":\"" << get_page_backing_name(page_backing) << "\"";
+    ss << "}";
+    return ss.str();
+}
+
+}
@@ -16,19 +16,27 @@
 #include "core/allocator/heap_allocator_aligned_pool_impl_list.hh"
 #include "core/clock/clock.hh"
 #include "core/engine_config/engine_config.hh"
+#include "core/memory/ref_destruction_queue.hh"
 #include "core/profiling/profiling_manager.hh"
 #include "core/parser/parser_json.hh"
 #include "generated/label_manager.gen.hh"
 #include "generated/type_uuid.gen.hh"
+#include <chrono>
 #include <iostream>
 
 namespace WhiteBirdEngine {
 
 EngineCore::~EngineCore() {
+    // The deferred objects could live in the allocators below, destroy them before the
+    // allocators are, rather than when the thread exits.
+    RefDestructionQueue& destruction_queue = RefDestructionQueue::get_thread_queue();
+    destruction_queue.drain_all();
+    destruction_queue.set_deferred(false);
     delete type_uuid_manager;
     delete label_manager;
     delete profiling_manager;
     delete file_system;
+    delete single_tick_allocator;
     delete pool_allocator;
     delete stdio_logging_manager;
     delete engine_config;
@@ -50,6 +58,11 @@ EngineCore::EngineCore(int p_argc, char* p_argv[], const Directory& p_root_dir)
     initialize(p_argc, p_argv);
 }
 
+void EngineCore::end_tick() {
+    RefDestructionQueue::get_thread_queue().drain(std::chrono::microseconds(engine_config->get_config_options().ref_destruction_budget_us));
+    single_tick_allocator->end_frame();
+}
+
 void EngineCore::parse_metadata(const Path& p_metadata_config_path) {
     ParserJSON parser;
     parser.parse(p_metadata_config_path);
@@ -57,7 +70,11 @@ void EngineCore::parse_metadata(const Path& p_metadata_config_path) {
 
 void EngineCore::initialize(int p_argc, char* p_argv[]) {
     engine_config = new EngineConfig(Path(file_system->get_config_directory(), "engine_config.yaml"), p_argc, p_argv);
-    pool_allocator = new HeapAllocatorAlignedPoolImplicitList(engine_config->get_config_options().global_mem_pool_size);
+    pool_allocator = new HeapAllocatorDefault(engine_config->get_config_options().global_mem_pool_size,
+                                              engine_config->get_config_options().global_mem_pool_reserve_size,
+                                              engine_config->get_config_options().global_mem_pool_huge_pages);
+    single_tick_allocator = new FrameAllocator(engine_config->get_config_options().single_tick_stack_size,
+                                               engine_config->get_config_options().single_tick_frame_count);
     parse_metadata(Path(file_system->get_resource_directory(), "metadata.json"));
     stdio_logging_manager = new LoggingManager<LogStream, std::ostream>(std::cout);
     profiling_manager = new ProfilingManager();
@@ -0,0 +1,63 @@
+/* Copyright 2025 OppositeNor
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#include "core/memory/ref_destruction_queue.hh"
+
+namespace WhiteBirdEngine {
+
+thread_local RefDestructionQueue RefDestructionQueue::thread_queue;
+
+RefDestructionQueue::~RefDestructionQueue() {
+    drain_all();
+    deferred = false;
+}
+
+size_t RefDestructionQueue::drain(std::chrono::nanoseconds p_budget) {
+    auto deadline = std::chrono::steady_clock::now() + p_budget;
+    size_t result = 0;
+    do {
+        result += drain_batch();
+    } while (get_pending_count() != 0 && std::chrono::steady_clock::now() < deadline);
+    return result;
+}
+
+size_t RefDestructionQueue::drain_all() {
+    size_t result = 0;
+    while (get_pending_count() != 0) {
+        result += drain_batch();
+    }
+    return result;
+}
+
+size_t RefDestructionQueue::drain_batch() {
+    size_t count = 0;
+    while (count < DRAIN_BATCH_SIZE && head < entries.size()) {
+        // The destructor could queue more objects and reallocate the entries.
+        Entry entry = entries[head++];
+        entry.destroy(entry.obj);
+        ++count;
+    }
+    if (head == entries.size()) {
+        entries.clear();
+        head = 0;
+    }
+    else if (head * 2 >= entries.size()) {
+        // Drop the destroyed entries, so a queue that is never fully drained does not keep growing.
+        entries.erase(entries.begin(), entries.begin() + head);
+        head = 0;
+    }
+    return count;
+}
+
+}
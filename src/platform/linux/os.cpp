@@ -14,17 +14,22 @@
 */
 
 #include "platform/os/os.hh"
+#include <algorithm>
 #include <alloca.h>
 #include <cerrno>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <cxxabi.h>
+#include <execinfo.h>
 #include <fcntl.h>
+#include <format>
 #include <sched.h>
 #include <stdexcept>
 #include <string>
 #include <sys/wait.h>
 #include <unistd.h>
+#include <utility>
 #include <sys/mman.h>
 
 namespace WhiteBirdEngine {
@@ -32,7 +37,7 @@ namespace WhiteBirdEngine {
 int get_mmap_prot(OS::MMapProt p_prot) {
     int result = 0;
     if (p_prot.test((int)OS::MMapProtBit::READ)) {
-        result |= PROT_EXEC;
+        result |= PROT_READ;
     }
     if (p_prot.test((int)OS::MMapProtBit::WRITE)) {
         result |= PROT_WRITE;
@@ -54,6 +59,12 @@ int get_mmap_flags(OS::MMapFlags p_prot) {
     if (p_prot.test((int)OS::MMapFlagBit::ANON)) {
         result |= MAP_ANON;
     }
+    if (p_prot.test((int)OS::MMapFlagBit::NORESERVE)) {
+        result |= MAP_NORESERVE;
+    }
+    if (p_prot.test((int)OS::MMapFlagBit::HUGETLB)) {
+        result |= MAP_HUGETLB;
+    }
     return result;
 }
 
@@ -142,6 +153,53 @@ void* OS::memory_map(void* p_start, size_t p_length, MMapProt p_prot, MMapFlags
     return mapped;
 }
 
+void OS::memory_protect(void* p_start, size_t p_length, MMapProt p_prot) {
+    if (mprotect(p_start, p_length, get_mmap_prot(p_prot)) < 0) {
+        throw std::runtime_error("Failed to protect memory: " + std::string(strerror(errno)));
+    }
+}
+
+void OS::memory_advise(void* p_start, size_t p_length, MemoryAdvice p_advice) {
+    int advice = MADV_NORMAL;
+    switch (p_advice) {
+    case MemoryAdvice::NORMAL:
+        advice = MADV_NORMAL;
+        break;
+    case MemoryAdvice::HUGE_PAGE:
+        advice = MADV_HUGEPAGE;
+        break;
+    }
+    if (madvise(p_start, p_length, advice) < 0) {
+        throw std::runtime_error("Failed to advise memory: " + std::string(strerror(errno)));
+    }
+}
+
+size_t OS::get_page_size() {
+    static const size_t page_size = sysconf(_SC_PAGESIZE);
+    return page_size;
+}
+
+size_t OS::get_huge_page_size() {
+    static const size_t huge_page_size = [] {
+        size_t result = 2 * 1024 * 1024;
+        FILE* meminfo = fopen("/proc/meminfo", "r");
+        if (meminfo == nullptr) {
+            return result;
+        }
+        char line[256];
+        size_t size_kib;
+        while (fgets(line, sizeof(line), meminfo) != nullptr) {
+            if (sscanf(line, "Hugepagesize: %zu kB", &size_kib) == 1) {
+                result = size_kib * 1024;
+                break;
+            }
+        }
+        fclose(meminfo);
+        return result;
+    }();
+    return huge_page_size;
+}
+
 FileDescrip OS::open_file(const char* p_path, FileOpenFlags p_open_flags) {
     FileDescrip f = open("./test_file.txt", O_RDWR);
     if (f < 0) {
@@ -162,5 +220,47 @@ void OS::memory_unmap(void* p_start, size_t p_length) {
     }
 }
 
+size_t OS::capture_backtrace(void** r_frames, size_t p_max_frames, size_t p_skip) {
+    constexpr size_t MAX_CAPTURE_FRAMES = 128;
+    void* frames[MAX_CAPTURE_FRAMES];
+    // One more frame for this function.
+    int count = backtrace(frames, static_cast<int>(std::min(p_max_frames + p_skip + 1, MAX_CAPTURE_FRAMES)));
+    size_t skip = std::min(static_cast<size_t>(count), p_skip + 1);
+    size_t result = std::min(count - skip, p_max_frames);
+    std::memcpy(r_frames, frames + skip, result * sizeof(void*));
+    return result;
+}
+
+std::vector<std::string> OS::get_backtrace_symbols(void* const* p_frames, size_t p_frame_count) {
+    std::vector<std::string> result;
+    if (p_frame_count == 0) {
+        return result;
+    }
+    result.reserve(p_frame_count);
+    char** symbols = backtrace_symbols(p_frames, static_cast<int>(p_frame_count));
+    for (size_t i = 0; i < p_frame_count; ++i) {
+        if (symbols == nullptr) {
+            result.push_back(std::format("{}", p_frames[i]));
+            continue;
+        }
+        std::string symbol = symbols[i];
+        // Demangle the name in "module(name+offset) [address]".
+        size_t name_begin = symbol.find('(');
+        size_t name_end = symbol.find('+', name_begin);
+        if (name_begin != std::string::npos && name_end != std::string::npos && name_end > name_begin + 1) {
+            std::string mangled = symbol.substr(name_begin + 1, name_end - name_begin - 1);
+            int status = 0;
+            char* demangled = abi::__cxa_demangle(mangled.c_str(), nullptr, nullptr, &status);
+            if (status == 0 && demangled != nullptr) {
+                symbol = symbol.substr(0, name_begin + 1) + demangled + symbol.substr(name_end);
+            }
+            free(demangled);
+        }
+        result.push_back(std::move(symbol));
+    }
+    free(symbols);
+    return result;
+}
+
 }
 
@@ -0,0 +1,330 @@
+/* Copyright 2025 OppositeNor
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#include "core/allocator/allocator.hh"
+#include "core/allocator/allocator_stats.hh"
+#include "core/allocator/heap_allocator_aligned_pool.hh"
+#include "core/allocator/heap_allocator_aligned_pool_impl_list.hh"
+#include "core/allocator/heap_allocator_compacting.hh"
+#include "core/allocator/heap_allocator_fixed_size_pool.hh"
+#include "core/allocator/heap_allocator_tlsf.hh"
+#include "core/allocator/stack_allocator.hh"
+#include "global/global.hh"
+#include "utils/utils.hh"
+#include <benchmark/benchmark.h>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+namespace WBE = WhiteBirdEngine;
+
+namespace {
+
+constexpr size_t DIST_POOL_SIZE = WBE_MiB(64);
+constexpr size_t DIST_LIVE_WINDOW = 1024;
+constexpr size_t FRAG_POOL_SIZE = WBE_MiB(16);
+constexpr size_t FRAG_ITERATIONS = 2000000;
+constexpr size_t FRAG_DEFRAGMENT_PERIOD = 1024;
+constexpr size_t FRAG_DEFRAGMENT_BUDGET = WBE_KiB(64);
+constexpr size_t FIXED_SIZE_ELEMENT_SIZE = 64;
+constexpr size_t FIXED_SIZE_MAX_OBJ = 4096;
+constexpr size_t STACK_SIZE = WBE_MiB(4);
+constexpr size_t STACK_DEPTH = 64;
+
+/**
+ * @brief Adapts malloc to the interface of the heap allocators, as the baseline.
+ */
+struct MallocAllocator {
+    WBE::MemID allocate(size_t p_size, size_t p_alignment = WBE_DEFAULT_ALIGNMENT) {
+        if (p_alignment <= WBE_DEFAULT_ALIGNMENT) {
+            return reinterpret_cast<WBE::MemID>(malloc(p_size));
+        }
+        return reinterpret_cast<WBE::MemID>(aligned_alloc(p_alignment, WBE::get_align_size(p_size, p_alignment)));
+    }
+
+    void deallocate(WBE::MemID p_mem) {
+        free(reinterpret_cast<void*>(p_mem));
+    }
+
+    void* get(WBE::MemID p_mem) const {
+        return reinterpret_cast<void*>(p_mem);
+    }
+};
+
+// Mostly small allocations, with an occasional large one, like the allocations of a frame.
+size_t mixed_alloc_size(size_t p_counter) {
+    size_t hash = WBE::dynam_hash(p_counter);
+    if (hash % 16 == 0) {
+        return WBE_KiB(4) + (hash >> 4) % WBE_KiB(60);
+    }
+    return 16 + (hash >> 4) % 240;
+}
+
+// Keeps a window of live allocations, and replaces a random one on each iteration, so the
+// lifetimes of the allocations are random.
+template <typename AllocType>
+void run_mixed_window(benchmark::State& p_state, AllocType& p_allocator, size_t p_alignment = WBE_DEFAULT_ALIGNMENT) {
+    std::vector<WBE::MemID> window(DIST_LIVE_WINDOW, WBE::MEM_NULL);
+    size_t counter = 0;
+    size_t bytes = 0;
+    for (auto _ : p_state) {
+        size_t slot = WBE::dynam_hash(counter + DIST_LIVE_WINDOW) % DIST_LIVE_WINDOW;
+        if (window[slot] != WBE::MEM_NULL) {
+            p_allocator.deallocate(window[slot]);
+        }
+        size_t size = mixed_alloc_size(counter);
+        window[slot] = p_allocator.allocate(size, p_alignment);
+        memset(p_allocator.get(window[slot]), 0, 16);
+        bytes += size;
+        ++counter;
+    }
+    for (WBE::MemID mem : window) {
+        if (mem != WBE::MEM_NULL) {
+            p_allocator.deallocate(mem);
+        }
+    }
+    p_state.SetItemsProcessed(p_state.iterations());
+    p_state.SetBytesProcessed(bytes);
+}
+
+void set_stats_counters(benchmark::State& p_state, const WBE::AllocatorStats& p_stats) {
+    p_state.counters["peak_bytes"] = p_stats.peak_bytes;
+    p_state.counters["free_bytes"] = p_stats.free_bytes;
+    p_state.counters["largest_free_block"] = p_stats.largest_free_block;
+    p_state.counters["external_fragmentation"] = p_stats.get_external_fragmentation();
+    p_state.counters["failed_allocations"] = p_stats.failed_allocation_count;
+}
+
+// Runs the mixed distribution for a long time, and reports the fragmentation of the allocator
+// with the window still live. Allocations that do not fit are counted instead of aborting the run.
+template <typename AllocType, typename MaintainFunc>
+void run_fragmentation(benchmark::State& p_state, AllocType& p_allocator, MaintainFunc&& p_maintain) {
+    std::vector<WBE::MemID> window(DIST_LIVE_WINDOW, WBE::MEM_NULL);
+    size_t counter = 0;
+    for (auto _ : p_state) {
+        size_t slot = WBE::dynam_hash(counter + DIST_LIVE_WINDOW) % DIST_LIVE_WINDOW;
+        if (window[slot] != WBE::MEM_NULL) {
+            p_allocator.deallocate(window[slot]);
+            window[slot] = WBE::MEM_NULL;
+        }
+        try {
+            window[slot] = p_allocator.allocate(mixed_alloc_size(counter));
+        }
+        catch (const std::runtime_error&) {
+        }
+        ++counter;
+        if (counter % FRAG_DEFRAGMENT_PERIOD == 0) {
+            p_maintain();
+        }
+    }
+    WBE::AllocatorStats stats = p_allocator.get_stats();
+    // Not part of the snapshot of the list pools, walked once here.
+    if constexpr (requires { p_allocator.get_largest_free_block(); }) {
+        if (!stats.largest_free_block_tracked) {
+            stats.largest_free_block = p_allocator.get_largest_free_block();
+            stats.largest_free_block_tracked = true;
+        }
+    }
+    set_stats_counters(p_state, stats);
+    for (WBE::MemID mem : window) {
+        if (mem != WBE::MEM_NULL) {
+            p_allocator.deallocate(mem);
+        }
+    }
+    p_state.SetItemsProcessed(p_state.iterations());
+}
+
+}
+
+void malloc_mixed_size_benchmark(benchmark::State& p_state) {
+    MallocAllocator allocator;
+    run_mixed_window(p_state, allocator);
+}
+BENCHMARK(malloc_mixed_size_benchmark);
+
+void heap_allocator_aligned_pool_mixed_size_benchmark(benchmark::State& p_state) {
+    std::unique_ptr<WBE::Global> global = std::make_unique<WBE::Global>(0, nullptr, WBE::Directory({"test_env"}));
+    WBE::HeapAllocatorAlignedPool pool(DIST_POOL_SIZE);
+    run_mixed_window(p_state, pool);
+}
+BENCHMARK(heap_allocator_aligned_pool_mixed_size_benchmark);
+
+void heap_allocator_aligned_pool_impl_list_mixed_size_benchmark(benchmark::State& p_state) {
+    std::unique_ptr<WBE::Global> global = std::make_unique<WBE::Global>(0, nullptr, WBE::Directory({"test_env"}));
+    WBE::HeapAllocatorAlignedPoolImplicitList pool(DIST_POOL_SIZE);
+    run_mixed_window(p_state, pool);
+}
+BENCHMARK(heap_allocator_aligned_pool_impl_list_mixed_size_benchmark);
+
+void heap_allocator_tlsf_mixed_size_benchmark(benchmark::State& p_state) {
+    std::unique_ptr<WBE::Global> global = std::make_unique<WBE::Global>(0, nullptr, WBE::Directory({"test_env"}));
+    WBE::HeapAllocatorTLSF pool(DIST_POOL_SIZE);
+    run_mixed_window(p_state, pool);
+}
+BENCHMARK(heap_allocator_tlsf_mixed_size_benchmark);
+
+void heap_allocator_compacting_mixed_size_benchmark(benchmark::State& p_state) {
+    std::unique_ptr<WBE::Global> global = std::make_unique<WBE::Global>(0, nullptr, WBE::Directory({"test_env"}));
+    WBE::HeapAllocatorCompacting pool(DIST_POOL_SIZE);
+    run_mixed_window(p_state, pool);
+}
+BENCHMARK(heap_allocator_compacting_mixed_size_benchmark);
+
+// The argument is the alignment. The compacting allocator is left out, it only supports
+// alignments up to its header size.
+void malloc_aligned_benchmark(benchmark::State& p_state) {
+    MallocAllocator allocator;
+    run_mixed_window(p_state, allocator, p_state.range(0));
+}
+BENCHMARK(malloc_aligned_benchmark)->Arg(64)->Arg(256)->Arg(4096);
+
+void heap_allocator_aligned_pool_aligned_benchmark(benchmark::State& p_state) {
+    std::unique_ptr<WBE::Global> global = std::make_unique<WBE::Global>(0, nullptr, WBE::Directory({"test_env"}));
+    WBE::HeapAllocatorAlignedPool pool(DIST_POOL_SIZE);
+    run_mixed_window(p_state, pool, p_state.range(0));
+}
+BENCHMARK(heap_allocator_aligned_pool_aligned_benchmark)->Arg(64)->Arg(256)->Arg(4096);
+
+void heap_allocator_aligned_pool_impl_list_aligned_benchmark(benchmark::State& p_state) {
+    std::unique_ptr<WBE::Global> global = std::make_unique<WBE::Global>(0, nullptr, WBE::Directory({"test_env"}));
+    WBE::HeapAllocatorAlignedPoolImplicitList pool(DIST_POOL_SIZE);
+    run_mixed_window(p_state, pool, p_state.range(0));
+}
+BENCHMARK(heap_allocator_aligned_pool_impl_list_aligned_benchmark)->Arg(64)->Arg(256)->Arg(4096);
+
+void heap_allocator_tlsf_aligned_benchmark(benchmark::State& p_state) {
+    std::unique_ptr<WBE::Global> global = std::make_unique<WBE::Global>(0, nullptr, WBE::Directory({"test_env"}));
+    WBE::HeapAllocatorTLSF pool(DIST_POOL_SIZE);
+    run_mixed_window(p_state, pool, p_state.range(0));
+}
+BENCHMARK(heap_allocator_tlsf_aligned_benchmark)->Arg(64)->Arg(256)->Arg(4096);
+
+// Scoped allocations, pushed in a call chain and popped in reverse order.
+void malloc_scoped_benchmark(benchmark::State& p_state) {
+    void* frames[STACK_DEPTH];
+    size_t counter = 0;
+    for (auto _ : p_state) {
+        for (size_t i = 0; i < STACK_DEPTH; ++i) {
+            frames[i] = malloc(mixed_alloc_size(counter + i) % 1024 + 16);
+            memset(frames[i], 0, 16);
+        }
+        for (size_t i = STACK_DEPTH; i > 0; --i) {
+            free(frames[i - 1]);
+        }
+        ++counter;
+    }
+    p_state.SetItemsProcessed(p_state.iterations() * STACK_DEPTH);
+}
+BENCHMARK(malloc_scoped_benchmark);
+
+void stack_allocator_scoped_benchmark(benchmark::State& p_state) {
+    WBE::StackAllocator stack(STACK_SIZE);
+    size_t sizes[STACK_DEPTH];
+    size_t counter = 0;
+    for (auto _ : p_state) {
+        for (size_t i = 0; i < STACK_DEPTH; ++i) {
+            sizes[i] = mixed_alloc_size(counter + i) % 1024 + 16;
+            memset(stack.get(stack.allocate(sizes[i])), 0, 16);
+        }
+        for (size_t i = STACK_DEPTH; i > 0; --i) {
+            stack.pop_stack(sizes[i - 1]);
+        }
+        ++counter;
+    }
+    p_state.SetItemsProcessed(p_state.iterations() * STACK_DEPTH);
+}
+BENCHMARK(stack_allocator_scoped_benchmark);
+
+// Objects of the same size with random lifetimes, like the components of a system.
+template <typename AllocFunc, typename GetFunc, typename FreeFunc>
+void run_fixed_size_window(benchmark::State& p_state, AllocFunc&& p_alloc, GetFunc&& p_get, FreeFunc&& p_free) {
+    std::vector<WBE::MemID> window(FIXED_SIZE_MAX_OBJ / 2, WBE::MEM_NULL);
+    size_t counter = 0;
+    for (auto _ : p_state) {
+        size_t slot = WBE::dynam_hash(counter + FIXED_SIZE_MAX_OBJ) % window.size();
+        if (window[slot] != WBE::MEM_NULL) {
+            p_free(window[slot]);
+        }
+        window[slot] = p_alloc();
+        memset(p_get(window[slot]), 0, FIXED_SIZE_ELEMENT_SIZE);
+        ++counter;
+    }
+    for (WBE::MemID mem : window) {
+        if (mem != WBE::MEM_NULL) {
+            p_free(mem);
+        }
+    }
+    p_state.SetItemsProcessed(p_state.iterations());
+}
+
+void malloc_fixed_size_benchmark(benchmark::State& p_state) {
+    run_fixed_size_window(p_state,
+        []() { return reinterpret_cast<WBE::MemID>(malloc(FIXED_SIZE_ELEMENT_SIZE)); },
+        [](WBE::MemID p_mem) { return reinterpret_cast<void*>(p_mem); },
+        [](WBE::MemID p_mem) { free(reinterpret_cast<void*>(p_mem)); });
+}
+BENCHMARK(malloc_fixed_size_benchmark);
+
+void heap_allocator_aligned_pool_fixed_size_benchmark(benchmark::State& p_state) {
+    std::unique_ptr<WBE::Global> global = std::make_unique<WBE::Global>(0, nullptr, WBE::Directory({"test_env"}));
+    WBE::HeapAllocatorAlignedPool pool(DIST_POOL_SIZE);
+    run_fixed_size_window(p_state,
+        [&pool]() { return pool.allocate(FIXED_SIZE_ELEMENT_SIZE); },
+        [&pool](WBE::MemID p_mem) { return pool.get(p_mem); },
+        [&pool](WBE::MemID p_mem) { pool.deallocate(p_mem); });
+}
+BENCHMARK(heap_allocator_aligned_pool_fixed_size_benchmark);
+
+void heap_allocator_fixed_size_pool_benchmark(benchmark::State& p_state) {
+    std::unique_ptr<WBE::Global> global = std::make_unique<WBE::Global>(0, nullptr, WBE::Directory({"test_env"}));
+    WBE::HeapAllocatorFixedSizePool pool(FIXED_SIZE_ELEMENT_SIZE, FIXED_SIZE_MAX_OBJ);
+    run_fixed_size_window(p_state,
+        [&pool]() { return pool.allocate(); },
+        [&pool](WBE::MemID p_mem) { return pool.get(p_mem); },
+        [&pool](WBE::MemID p_mem) { pool.deallocate(p_mem); });
+}
+BENCHMARK(heap_allocator_fixed_size_pool_benchmark);
+
+// The fragmentation benchmarks run a fixed number of iterations, so the counters of the
+// allocators are comparable.
+void heap_allocator_aligned_pool_fragmentation_benchmark(benchmark::State& p_state) {
+    std::unique_ptr<WBE::Global> global = std::make_unique<WBE::Global>(0, nullptr, WBE::Directory({"test_env"}));
+    WBE::HeapAllocatorAlignedPool pool(FRAG_POOL_SIZE);
+    run_fragmentation(p_state, pool, []() {});
+}
+BENCHMARK(heap_allocator_aligned_pool_fragmentation_benchmark)->Iterations(FRAG_ITERATIONS);
+
+void heap_allocator_aligned_pool_impl_list_fragmentation_benchmark(benchmark::State& p_state) {
+    std::unique_ptr<WBE::Global> global = std::make_unique<WBE::Global>(0, nullptr, WBE::Directory({"test_env"}));
+    WBE::HeapAllocatorAlignedPoolImplicitList pool(FRAG_POOL_SIZE);
+    run_fragmentation(p_state, pool, []() {});
+}
+BENCHMARK(heap_allocator_aligned_pool_impl_list_fragmentation_benchmark)->Iterations(FRAG_ITERATIONS);
+
+void heap_allocator_tlsf_fragmentation_benchmark(benchmark::State& p_state) {
+    std::unique_ptr<WBE::Global> global = std::make_unique<WBE::Global>(0, nullptr, WBE::Directory({"test_env"}));
+    WBE::HeapAllocatorTLSF pool(FRAG_POOL_SIZE);
+    run_fragmentation(p_state, pool, []() {});
+}
+BENCHMARK(heap_allocator_tlsf_fragmentation_benchmark)->Iterations(FRAG_ITERATIONS);
+
+void heap_allocator_compacting_fragmentation_benchmark(benchmark::State& p_state) {
+    std::unique_ptr<WBE::Global> global = std::make_unique<WBE::Global>(0, nullptr, WBE::Directory({"test_env"}));
+    WBE::HeapAllocatorCompacting pool(FRAG_POOL_SIZE);
+    run_fragmentation(p_state, pool, [&pool]() { pool.defragment(FRAG_DEFRAGMENT_BUDGET); });
+}
+BENCHMARK(heap_allocator_compacting_fragmentation_benchmark)->Iterations(FRAG_ITERATIONS);
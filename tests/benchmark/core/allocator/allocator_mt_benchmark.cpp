@@ -0,0 +1,195 @@
+/* Copyright 2025 OppositeNor
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#include "core/allocator/allocator.hh"
+#include "core/allocator/heap_allocator_atomic_aligned_pool.hh"
+#include "core/allocator/heap_allocator_atomic_aligned_pool_impl_list.hh"
+#include "core/allocator/heap_allocator_thread_cache.hh"
+#include "global/global.hh"
+#include "utils/utils.hh"
+#include <array>
+#include <atomic>
+#include <benchmark/benchmark.h>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+
+namespace WBE = WhiteBirdEngine;
+
+namespace {
+
+// Each thread keeps a window of live allocations, and frees the oldest one on each allocation.
+constexpr size_t MT_LIVE_WINDOW = 64;
+constexpr size_t MT_POOL_SIZE = WBE_MiB(256);
+constexpr size_t MT_MAX_THREADS = 16;
+
+size_t mt_alloc_size(size_t p_counter) {
+    return 16 + WBE::dynam_hash(p_counter) % 496;
+}
+
+// Allocations are handed off through a shared array of slots. Each allocation replaces the
+// allocation in a random slot, which is then freed, so most of the frees are done by a thread
+// other than the one that allocated the memory.
+constexpr size_t MT_HANDOFF_SLOTS = 4096;
+
+std::unique_ptr<WBE::Global> mt_global;
+std::unique_ptr<WBE::HeapAllocatorAtomicAlignedPool> mt_pool;
+std::unique_ptr<WBE::HeapAllocatorAtomicAlignedPoolImplicitList> mt_impl_list_pool;
+std::unique_ptr<WBE::HeapAllocatorThreadCache> mt_thread_cache;
+std::array<std::atomic<WBE::MemID>, MT_HANDOFF_SLOTS> mt_handoff_slots;
+
+template <typename AllocFunc, typename FreeFunc>
+void run_mt_window(benchmark::State& p_state, AllocFunc&& p_alloc, FreeFunc&& p_free) {
+    WBE::MemID window[MT_LIVE_WINDOW] = {};
+    size_t counter = p_state.thread_index() * 7919;
+    for (auto _ : p_state) {
+        size_t slot = counter % MT_LIVE_WINDOW;
+        if (window[slot] != WBE::MEM_NULL) {
+            p_free(window[slot]);
+        }
+        size_t size = mt_alloc_size(counter);
+        window[slot] = p_alloc(size);
+        memset(reinterpret_cast<void*>(window[slot]), 0, 16);
+        ++counter;
+    }
+    for (WBE::MemID mem : window) {
+        if (mem != WBE::MEM_NULL) {
+            p_free(mem);
+        }
+    }
+    p_state.SetItemsProcessed(p_state.iterations());
+}
+
+template <typename AllocFunc, typename GetFunc, typename FreeFunc>
+void run_mt_handoff(benchmark::State& p_state, AllocFunc&& p_alloc, GetFunc&& p_get, FreeFunc&& p_free) {
+    size_t counter = p_state.thread_index() * 7919;
+    for (auto _ : p_state) {
+        WBE::MemID mem = p_alloc(mt_alloc_size(counter));
+        memset(p_get(mem), 0, 16);
+        size_t slot = WBE::dynam_hash(counter + MT_HANDOFF_SLOTS) % MT_HANDOFF_SLOTS;
+        WBE::MemID previous = mt_handoff_slots[slot].exchange(mem, std::memory_order_acq_rel);
+        if (previous != WBE::MEM_NULL) {
+            p_free(previous);
+        }
+        ++counter;
+    }
+    p_state.SetItemsProcessed(p_state.iterations());
+}
+
+template <typename FreeFunc>
+void free_mt_handoff_slots(FreeFunc&& p_free) {
+    for (auto& slot : mt_handoff_slots) {
+        WBE::MemID mem = slot.exchange(WBE::MEM_NULL, std::memory_order_acq_rel);
+        if (mem != WBE::MEM_NULL) {
+            p_free(mem);
+        }
+    }
+}
+
+}
+
+void mt_malloc_free_benchmark(benchmark::State& p_state) {
+    run_mt_window(p_state,
+        [](size_t p_size) { return reinterpret_cast<WBE::MemID>(malloc(p_size)); },
+        [](WBE::MemID p_mem) { free(reinterpret_cast<void*>(p_mem)); });
+}
+BENCHMARK(mt_malloc_free_benchmark)->ThreadRange(1, MT_MAX_THREADS)->UseRealTime();
+
+void mt_pool_setup(const benchmark::State&) {
+    mt_global = std::make_unique<WBE::Global>(0, nullptr, WBE::Directory({"test_env"}));
+    mt_pool = std::make_unique<WBE::HeapAllocatorAtomicAlignedPool>(MT_POOL_SIZE);
+    mt_thread_cache = std::make_unique<WBE::HeapAllocatorThreadCache>(mt_pool.get());
+}
+
+void mt_pool_teardown(const benchmark::State&) {
+    mt_thread_cache.reset();
+    mt_pool.reset();
+    mt_global.reset();
+}
+
+void mt_atomic_aligned_pool_benchmark(benchmark::State& p_state) {
+    run_mt_window(p_state,
+        [](size_t p_size) { return mt_pool->allocate(p_size); },
+        [](WBE::MemID p_mem) { mt_pool->deallocate(p_mem); });
+}
+BENCHMARK(mt_atomic_aligned_pool_benchmark)->Setup(mt_pool_setup)->Teardown(mt_pool_teardown)
+    ->ThreadRange(1, MT_MAX_THREADS)->UseRealTime();
+
+void mt_thread_cache_benchmark(benchmark::State& p_state) {
+    run_mt_window(p_state,
+        [](size_t p_size) { return mt_thread_cache->allocate(p_size); },
+        [](WBE::MemID p_mem) { mt_thread_cache->deallocate(p_mem); });
+}
+BENCHMARK(mt_thread_cache_benchmark)->Setup(mt_pool_setup)->Teardown(mt_pool_teardown)
+    ->ThreadRange(1, MT_MAX_THREADS)->UseRealTime();
+
+void mt_malloc_cross_thread_free_benchmark(benchmark::State& p_state) {
+    run_mt_handoff(p_state,
+        [](size_t p_size) { return reinterpret_cast<WBE::MemID>(malloc(p_size)); },
+        [](WBE::MemID p_mem) { return reinterpret_cast<void*>(p_mem); },
+        [](WBE::MemID p_mem) { free(reinterpret_cast<void*>(p_mem)); });
+}
+BENCHMARK(mt_malloc_cross_thread_free_benchmark)
+    ->Teardown([](const benchmark::State&) {
+        free_mt_handoff_slots([](WBE::MemID p_mem) { free(reinterpret_cast<void*>(p_mem)); });
+    })
+    ->ThreadRange(1, MT_MAX_THREADS)->UseRealTime();
+
+void mt_atomic_aligned_pool_cross_thread_free_benchmark(benchmark::State& p_state) {
+    run_mt_handoff(p_state,
+        [](size_t p_size) { return mt_pool->allocate(p_size); },
+        [](WBE::MemID p_mem) { return mt_pool->get(p_mem); },
+        [](WBE::MemID p_mem) { mt_pool->deallocate(p_mem); });
+}
+BENCHMARK(mt_atomic_aligned_pool_cross_thread_free_benchmark)->Setup(mt_pool_setup)
+    ->Teardown([](const benchmark::State& p_state) {
+        free_mt_handoff_slots([](WBE::MemID p_mem) { mt_pool->deallocate(p_mem); });
+        mt_pool_teardown(p_state);
+    })
+    ->ThreadRange(1, MT_MAX_THREADS)->UseRealTime();
+
+void mt_impl_list_pool_setup(const benchmark::State&) {
+    mt_global = std::make_unique<WBE::Global>(0, nullptr, WBE::Directory({"test_env"}));
+    mt_impl_list_pool = std::make_unique<WBE::HeapAllocatorAtomicAlignedPoolImplicitList>(MT_POOL_SIZE);
+}
+
+void mt_impl_list_pool_teardown(const benchmark::State&) {
+    free_mt_handoff_slots([](WBE::MemID p_mem) { mt_impl_list_pool->deallocate(p_mem); });
+    mt_impl_list_pool.reset();
+    mt_global.reset();
+}
+
+void mt_atomic_aligned_pool_impl_list_cross_thread_free_benchmark(benchmark::State& p_state) {
+    run_mt_handoff(p_state,
+        [](size_t p_size) { return mt_impl_list_pool->allocate(p_size); },
+        [](WBE::MemID p_mem) { return mt_impl_list_pool->get(p_mem); },
+        [](WBE::MemID p_mem) { mt_impl_list_pool->deallocate(p_mem); });
+}
+BENCHMARK(mt_atomic_aligned_pool_impl_list_cross_thread_free_benchmark)
+    ->Setup(mt_impl_list_pool_setup)->Teardown(mt_impl_list_pool_teardown)
+    ->ThreadRange(1, MT_MAX_THREADS)->UseRealTime();
+
+void mt_thread_cache_cross_thread_free_benchmark(benchmark::State& p_state) {
+    run_mt_handoff(p_state,
+        [](size_t p_size) { return mt_thread_cache->allocate(p_size); },
+        [](WBE::MemID p_mem) { return mt_thread_cache->get(p_mem); },
+        [](WBE::MemID p_mem) { mt_thread_cache->deallocate(p_mem); });
+}
+BENCHMARK(mt_thread_cache_cross_thread_free_benchmark)->Setup(mt_pool_setup)
+    ->Teardown([](const benchmark::State& p_state) {
+        free_mt_handoff_slots([](WBE::MemID p_mem) { mt_thread_cache->deallocate(p_mem); });
+        mt_pool_teardown(p_state);
+    })
+    ->ThreadRange(1, MT_MAX_THREADS)->UseRealTime();
@@ -0,0 +1,101 @@
+/* Copyright 2025 OppositeNor
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#include "core/allocator/heap_allocator_atomic_aligned_pool_impl_list.hh"
+#include "core/core_utils.hh"
+#include "core/job/job.hh"
+#include "core/job/job_buffer_ring_mpmc.hh"
+#include "core/memory/reference_strong.hh"
+#include "global/global.hh"
+#include "utils/utils.hh"
+#include <benchmark/benchmark.h>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+
+namespace WBE = WhiteBirdEngine;
+
+namespace {
+
+constexpr size_t MT_MAX_THREADS = 16;
+constexpr size_t BUFFER_SIZE = 1024;
+
+struct EmptyJob : public WBE::Job<EmptyJob> {
+    void perform() {}
+};
+
+using JobAllocator = WBE::HeapAllocatorAtomicAlignedPoolImplicitList;
+
+std::unique_ptr<WBE::Global> buffer_global;
+WBE::HeapAllocatorDefault* buffer_allocator = nullptr;
+JobAllocator* job_allocator = nullptr;
+WBE::JobBufferRingMPMC<EmptyJob>* ring_buffer = nullptr;
+std::mutex* deque_mutex = nullptr;
+std::deque<WBE::Ref<EmptyJob>>* locked_deque = nullptr;
+
+void buffer_setup(const benchmark::State&) {
+    buffer_global = std::make_unique<WBE::Global>(0, nullptr, WBE::Directory({"test_env"}));
+    buffer_allocator = new WBE::HeapAllocatorDefault(WBE_KiB(64));
+    job_allocator = new JobAllocator(WBE_KiB(64));
+    ring_buffer = new WBE::JobBufferRingMPMC<EmptyJob>(buffer_allocator, BUFFER_SIZE);
+    deque_mutex = new std::mutex();
+    locked_deque = new std::deque<WBE::Ref<EmptyJob>>();
+}
+
+void buffer_teardown(const benchmark::State&) {
+    delete locked_deque;
+    delete deque_mutex;
+    delete ring_buffer;
+    delete job_allocator;
+    delete buffer_allocator;
+    buffer_global.reset();
+}
+
+// Every thread adds a job and takes one, the buffer never holds more than the thread count.
+void job_buffer_ring_mpmc_benchmark(benchmark::State& p_state) {
+    WBE::Ref<EmptyJob> job = WBE::make_ref<EmptyJob>(job_allocator);
+    for (auto _ : p_state) {
+        ring_buffer->add_job(job);
+        WBE::Ref<EmptyJob> retrieved = ring_buffer->wait_retrieve_job();
+        benchmark::DoNotOptimize(retrieved);
+    }
+    p_state.SetItemsProcessed(p_state.iterations());
+}
+
+void job_buffer_locked_deque_benchmark(benchmark::State& p_state) {
+    WBE::Ref<EmptyJob> job = WBE::make_ref<EmptyJob>(job_allocator);
+    for (auto _ : p_state) {
+        {
+            std::lock_guard lock(*deque_mutex);
+            locked_deque->push_back(job);
+        }
+        WBE::Ref<EmptyJob> retrieved;
+        {
+            std::lock_guard lock(*deque_mutex);
+            retrieved = std::move(locked_deque->front());
+            locked_deque->pop_front();
+        }
+        benchmark::DoNotOptimize(retrieved);
+    }
+    p_state.SetItemsProcessed(p_state.iterations());
+}
+
+}
+
+// The ring only contends on the positions, the deque serializes every thread on the mutex.
+BENCHMARK(job_buffer_ring_mpmc_benchmark)->ThreadRange(1, MT_MAX_THREADS)->UseRealTime()
+    ->Setup(buffer_setup)->Teardown(buffer_teardown);
+BENCHMARK(job_buffer_locked_deque_benchmark)->ThreadRange(1, MT_MAX_THREADS)->UseRealTime()
+    ->Setup(buffer_setup)->Teardown(buffer_teardown);
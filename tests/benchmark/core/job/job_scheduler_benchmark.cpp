@@ -0,0 +1,141 @@
+/* Copyright 2025 OppositeNor
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#include "core/allocator/heap_allocator_atomic_aligned_pool_impl_list.hh"
+#include "core/core_utils.hh"
+#include "core/job/job.hh"
+#include "core/job/job_scheduler.hh"
+#include "core/memory/reference_strong.hh"
+#include "global/global.hh"
+#include "utils/utils.hh"
+#include <benchmark/benchmark.h>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace WBE = WhiteBirdEngine;
+
+namespace {
+
+// Jobs scheduled per iteration of the throughput benchmarks.
+constexpr size_t JOB_BATCH_SIZE = 1024;
+// Work of a job, in rounds of a cheap hash.
+constexpr size_t JOB_WORK = 256;
+constexpr int FORK_DEPTH = 10;
+
+using JobAllocator = WBE::HeapAllocatorAtomicAlignedPoolImplicitList;
+
+struct BenchmarkJob : public WBE::Job<BenchmarkJob> {
+    BenchmarkJob(WBE::JobScheduler<BenchmarkJob>* p_scheduler = nullptr, JobAllocator* p_allocator = nullptr, int p_depth = 0)
+        : scheduler(p_scheduler), allocator(p_allocator), depth(p_depth) {}
+
+    void perform() {
+        if (depth == 0) {
+            uint64_t value = 0;
+            for (size_t i = 0; i < JOB_WORK; ++i) {
+                value = value * 6364136223846793005ULL + 1442695040888963407ULL;
+            }
+            benchmark::DoNotOptimize(value);
+            return;
+        }
+        // Spawn the halves on this worker, the idle workers steal them.
+        WBE::JobCounter children;
+        for (int i = 0; i < 2; ++i) {
+            scheduler->schedule(WBE::make_ref<BenchmarkJob>(allocator, scheduler, allocator, depth - 1), &children);
+        }
+        scheduler->wait(children);
+    }
+
+    WBE::JobScheduler<BenchmarkJob>* scheduler;
+    JobAllocator* allocator;
+    int depth;
+};
+
+struct SchedulerEnv {
+    SchedulerEnv(size_t p_worker_count)
+        : global(std::make_unique<WBE::Global>(0, nullptr, WBE::Directory({"test_env"}))),
+        buffer_allocator(WBE_MiB(1)), job_allocator(WBE_MiB(16)), scheduler(&buffer_allocator, p_worker_count) {}
+    std::unique_ptr<WBE::Global> global;
+    WBE::HeapAllocatorDefault buffer_allocator;
+    JobAllocator job_allocator;
+    WBE::JobScheduler<BenchmarkJob> scheduler;
+};
+
+// The main thread schedules a batch of independent jobs and helps until they are done.
+void job_scheduler_batch_benchmark(benchmark::State& p_state) {
+    SchedulerEnv env(p_state.range(0));
+    // The jobs are scheduled again each iteration, so the allocator is not measured.
+    std::vector<WBE::Ref<BenchmarkJob>> jobs;
+    for (size_t i = 0; i < JOB_BATCH_SIZE; ++i) {
+        jobs.push_back(WBE::make_ref<BenchmarkJob>(&env.job_allocator));
+    }
+    for (auto _ : p_state) {
+        WBE::JobCounter counter;
+        for (WBE::Ref<BenchmarkJob>& job : jobs) {
+            env.scheduler.schedule(job, &counter);
+        }
+        env.scheduler.wait(counter);
+    }
+    p_state.SetItemsProcessed(p_state.iterations() * JOB_BATCH_SIZE);
+}
+
+// A tree of jobs spawned by the workers, spread by stealing.
+void job_scheduler_fork_join_benchmark(benchmark::State& p_state) {
+    SchedulerEnv env(p_state.range(0));
+    for (auto _ : p_state) {
+        WBE::JobCounter counter;
+        env.scheduler.schedule(WBE::make_ref<BenchmarkJob>(&env.job_allocator, &env.scheduler, &env.job_allocator, FORK_DEPTH), &counter);
+        env.scheduler.wait(counter);
+    }
+    p_state.SetItemsProcessed(p_state.iterations() * ((size_t(1) << (FORK_DEPTH + 1)) - 1));
+}
+
+// The time from scheduling a job until a worker finished it. The main thread does not help.
+void job_scheduler_latency_benchmark(benchmark::State& p_state, bool p_parked) {
+    SchedulerEnv env(1);
+    WBE::Ref<BenchmarkJob> job = WBE::make_ref<BenchmarkJob>(&env.job_allocator);
+    for (auto _ : p_state) {
+        if (p_parked) {
+            // Long enough for the worker to give up spinning and park.
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+        auto begin = std::chrono::steady_clock::now();
+        WBE::JobCounter counter;
+        env.scheduler.schedule(job, &counter);
+        while (!counter.is_done()) {
+            std::this_thread::yield();
+        }
+        auto end = std::chrono::steady_clock::now();
+        p_state.SetIterationTime(std::chrono::duration<double>(end - begin).count());
+    }
+}
+
+void job_scheduler_spinning_latency_benchmark(benchmark::State& p_state) {
+    job_scheduler_latency_benchmark(p_state, false);
+}
+
+void job_scheduler_parked_latency_benchmark(benchmark::State& p_state) {
+    job_scheduler_latency_benchmark(p_state, true);
+}
+
+}
+
+// Argument: the number of workers. With 0 the main thread runs every job itself.
+BENCHMARK(job_scheduler_batch_benchmark)->Arg(0)->RangeMultiplier(2)->Range(1, 16)->UseRealTime();
+BENCHMARK(job_scheduler_fork_join_benchmark)->Arg(0)->RangeMultiplier(2)->Range(1, 16)->UseRealTime();
+// A parked worker pays for the wake up on top of the scheduling.
+BENCHMARK(job_scheduler_spinning_latency_benchmark)->UseManualTime();
+BENCHMARK(job_scheduler_parked_latency_benchmark)->UseManualTime()->Iterations(200);
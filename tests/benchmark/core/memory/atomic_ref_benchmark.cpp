@@ -0,0 +1,108 @@
+/* Copyright 2025 OppositeNor
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#include "core/allocator/heap_allocator_atomic_aligned_pool_impl_list.hh"
+#include "core/memory/reference_atomic.hh"
+#include "core/memory/reference_strong.hh"
+#include "global/global.hh"
+#include "utils/utils.hh"
+#include <benchmark/benchmark.h>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+
+namespace WBE = WhiteBirdEngine;
+
+namespace {
+
+constexpr size_t MT_MAX_THREADS = 16;
+// The first thread publishes a new snapshot once every this many reads.
+constexpr size_t PUBLISH_INTERVAL = 1024;
+
+struct ConfigSnapshot {
+    int values[16];
+};
+
+using AllocType = WBE::HeapAllocatorAtomicAlignedPoolImplicitList;
+using SnapshotRef = WBE::Ref<ConfigSnapshot, AllocType>;
+
+std::unique_ptr<WBE::Global> snapshot_global;
+AllocType* snapshot_pool = nullptr;
+WBE::AtomicRef<ConfigSnapshot, AllocType>* atomic_snapshot = nullptr;
+std::mutex* snapshot_mutex = nullptr;
+SnapshotRef* locked_snapshot = nullptr;
+
+void snapshot_setup(const benchmark::State&) {
+    snapshot_global = std::make_unique<WBE::Global>(0, nullptr, WBE::Directory({"test_env"}));
+    snapshot_pool = new AllocType(WBE_MiB(4));
+    atomic_snapshot = new WBE::AtomicRef<ConfigSnapshot, AllocType>(WBE::make_ref<ConfigSnapshot>(snapshot_pool));
+    snapshot_mutex = new std::mutex();
+    locked_snapshot = new SnapshotRef(WBE::make_ref<ConfigSnapshot>(snapshot_pool));
+}
+
+void snapshot_teardown(const benchmark::State&) {
+    delete locked_snapshot;
+    delete snapshot_mutex;
+    delete atomic_snapshot;
+    delete snapshot_pool;
+    snapshot_global.reset();
+}
+
+SnapshotRef load_locked() {
+    std::lock_guard lock(*snapshot_mutex);
+    return *locked_snapshot;
+}
+
+void store_locked(SnapshotRef p_snapshot) {
+    SnapshotRef old;
+    {
+        std::lock_guard lock(*snapshot_mutex);
+        old = std::move(*locked_snapshot);
+        *locked_snapshot = std::move(p_snapshot);
+    }
+    // The old snapshot is released outside of the lock.
+}
+
+// Every thread reads the current snapshot, the first thread also publishes new ones.
+void atomic_ref_read_mostly_benchmark(benchmark::State& p_state) {
+    size_t count = 0;
+    for (auto _ : p_state) {
+        if (p_state.thread_index() == 0 && ++count % PUBLISH_INTERVAL == 0) {
+            atomic_snapshot->store(WBE::make_ref<ConfigSnapshot>(snapshot_pool));
+        }
+        SnapshotRef snapshot = atomic_snapshot->load();
+        benchmark::DoNotOptimize(snapshot->values[0]);
+    }
+    p_state.SetItemsProcessed(p_state.iterations());
+}
+
+void mutex_ref_read_mostly_benchmark(benchmark::State& p_state) {
+    size_t count = 0;
+    for (auto _ : p_state) {
+        if (p_state.thread_index() == 0 && ++count % PUBLISH_INTERVAL == 0) {
+            store_locked(WBE::make_ref<ConfigSnapshot>(snapshot_pool));
+        }
+        SnapshotRef snapshot = load_locked();
+        benchmark::DoNotOptimize(snapshot->values[0]);
+    }
+    p_state.SetItemsProcessed(p_state.iterations());
+}
+
+}
+
+// A load of AtomicRef only adds to the AtomicRef, the mutex serializes the readers.
+BENCHMARK(atomic_ref_read_mostly_benchmark)->ThreadRange(1, MT_MAX_THREADS)->UseRealTime()
+    ->Setup(snapshot_setup)->Teardown(snapshot_teardown);
+BENCHMARK(mutex_ref_read_mostly_benchmark)->ThreadRange(1, MT_MAX_THREADS)->UseRealTime()
+    ->Setup(snapshot_setup)->Teardown(snapshot_teardown);
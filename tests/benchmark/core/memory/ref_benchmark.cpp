@@ -0,0 +1,221 @@
+/* Copyright 2025 OppositeNor
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#include "core/allocator/heap_allocator.hh"
+#include "core/allocator/heap_allocator_tlsf.hh"
+#include "core/memory/reference_intrusive.hh"
+#include "core/memory/reference_raw.hh"
+#include "core/memory/reference_strong.hh"
+#include "core/memory/unique.hh"
+#include "global/global.hh"
+#include "utils/utils.hh"
+#include <benchmark/benchmark.h>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace WBE = WhiteBirdEngine;
+
+namespace {
+
+constexpr size_t REF_COUNT = 4096;
+constexpr size_t REF_POOL_SIZE = WBE_MiB(4);
+
+struct Particle {
+    float position;
+    float velocity;
+};
+
+// Dereferences every reference once per iteration, the hot loop of a system updating its objects.
+template <typename RefType>
+void run_deref(benchmark::State& p_state, std::vector<RefType>& p_refs) {
+    for (auto _ : p_state) {
+        for (RefType& ref : p_refs) {
+            ref->position += ref->velocity;
+        }
+        benchmark::ClobberMemory();
+    }
+    p_state.SetItemsProcessed(p_state.iterations() * p_refs.size());
+}
+
+// Refs are created from a memory ID, so the type erased ones could not cache the pointer.
+template <typename AllocType>
+void ref_deref_benchmark(benchmark::State& p_state) {
+    std::unique_ptr<WBE::Global> global = std::make_unique<WBE::Global>(0, nullptr, WBE::Directory({"test_env"}));
+    WBE::HeapAllocatorTLSF pool(REF_POOL_SIZE);
+    {
+        std::vector<WBE::Ref<Particle, AllocType>> refs;
+        refs.reserve(REF_COUNT);
+        for (size_t i = 0; i < REF_COUNT; ++i) {
+            refs.emplace_back(&pool, WBE::create_obj<Particle>(pool, 0.0f, 1.0f));
+        }
+        run_deref(p_state, refs);
+    }
+}
+
+template <typename AllocType>
+void unique_deref_benchmark(benchmark::State& p_state) {
+    std::unique_ptr<WBE::Global> global = std::make_unique<WBE::Global>(0, nullptr, WBE::Directory({"test_env"}));
+    WBE::HeapAllocatorTLSF pool(REF_POOL_SIZE);
+    {
+        std::vector<WBE::Unique<Particle, AllocType>> uniques;
+        uniques.reserve(REF_COUNT);
+        for (size_t i = 0; i < REF_COUNT; ++i) {
+            uniques.emplace_back(&pool, WBE::create_obj<Particle>(pool, 0.0f, 1.0f));
+        }
+        run_deref(p_state, uniques);
+    }
+}
+
+template <typename AllocType>
+void ref_raw_deref_benchmark(benchmark::State& p_state) {
+    std::unique_ptr<WBE::Global> global = std::make_unique<WBE::Global>(0, nullptr, WBE::Directory({"test_env"}));
+    WBE::HeapAllocatorTLSF pool(REF_POOL_SIZE);
+    std::vector<WBE::RefRaw<Particle, AllocType>> refs;
+    refs.reserve(REF_COUNT);
+    for (size_t i = 0; i < REF_COUNT; ++i) {
+        refs.emplace_back(WBE::create_obj<Particle>(pool, 0.0f, 1.0f), &pool);
+    }
+    run_deref(p_state, refs);
+    for (auto& ref : refs) {
+        WBE::delete_ref(std::move(ref));
+    }
+}
+
+struct CountedParticle : public WBE::RefCounted {
+    CountedParticle(float p_position, float p_velocity)
+        : position(p_position), velocity(p_velocity) {}
+    float position;
+    float velocity;
+};
+
+// Copies and releases every reference once per iteration, as when handing objects to a system.
+template <typename RefType>
+void run_copy(benchmark::State& p_state, std::vector<RefType>& p_refs) {
+    std::vector<RefType> copies(p_refs.size());
+    for (auto _ : p_state) {
+        for (size_t i = 0; i < p_refs.size(); ++i) {
+            copies[i] = p_refs[i];
+        }
+        for (RefType& copy : copies) {
+            copy = nullptr;
+        }
+        benchmark::ClobberMemory();
+    }
+    p_state.SetItemsProcessed(p_state.iterations() * p_refs.size());
+}
+
+template <typename ThreadPolicy>
+void ref_copy_benchmark(benchmark::State& p_state) {
+    std::unique_ptr<WBE::Global> global = std::make_unique<WBE::Global>(0, nullptr, WBE::Directory({"test_env"}));
+    WBE::HeapAllocatorTLSF pool(REF_POOL_SIZE);
+    {
+        std::vector<WBE::Ref<Particle, WBE::HeapAllocatorTLSF, ThreadPolicy>> refs;
+        refs.reserve(REF_COUNT);
+        for (size_t i = 0; i < REF_COUNT; ++i) {
+            refs.push_back(WBE::make_ref<Particle, WBE::HeapAllocatorTLSF, ThreadPolicy>(&pool, 0.0f, 1.0f));
+        }
+        run_copy(p_state, refs);
+    }
+}
+
+void shared_ptr_copy_benchmark(benchmark::State& p_state) {
+    std::vector<std::shared_ptr<Particle>> refs;
+    refs.reserve(REF_COUNT);
+    for (size_t i = 0; i < REF_COUNT; ++i) {
+        refs.push_back(std::make_shared<Particle>(0.0f, 1.0f));
+    }
+    run_copy(p_state, refs);
+}
+
+// Every thread copies and releases the same references, the counters are contended.
+template <typename RefType>
+void run_shared_copy(benchmark::State& p_state, const std::vector<RefType>& p_refs) {
+    RefType copy;
+    for (auto _ : p_state) {
+        for (const RefType& ref : p_refs) {
+            copy = ref;
+            benchmark::DoNotOptimize(copy);
+        }
+        copy = nullptr;
+    }
+    p_state.SetItemsProcessed(p_state.iterations() * p_refs.size());
+}
+
+constexpr size_t SHARED_REF_COUNT = 64;
+constexpr size_t MT_MAX_THREADS = 16;
+
+std::unique_ptr<WBE::Global> shared_global;
+WBE::HeapAllocatorTLSF* shared_pool = nullptr;
+std::vector<WBE::Ref<Particle, WBE::HeapAllocatorTLSF>>* shared_refs = nullptr;
+std::vector<std::shared_ptr<Particle>>* shared_std_refs = nullptr;
+
+void shared_copy_setup(const benchmark::State&) {
+    shared_global = std::make_unique<WBE::Global>(0, nullptr, WBE::Directory({"test_env"}));
+    shared_pool = new WBE::HeapAllocatorTLSF(REF_POOL_SIZE);
+    shared_refs = new std::vector<WBE::Ref<Particle, WBE::HeapAllocatorTLSF>>();
+    shared_std_refs = new std::vector<std::shared_ptr<Particle>>();
+    for (size_t i = 0; i < SHARED_REF_COUNT; ++i) {
+        shared_refs->push_back(WBE::make_ref<Particle>(shared_pool, 0.0f, 1.0f));
+        shared_std_refs->push_back(std::make_shared<Particle>(0.0f, 1.0f));
+    }
+}
+
+void shared_copy_teardown(const benchmark::State&) {
+    delete shared_refs;
+    delete shared_std_refs;
+    delete shared_pool;
+    shared_global.reset();
+}
+
+void ref_shared_copy_benchmark(benchmark::State& p_state) {
+    run_shared_copy(p_state, *shared_refs);
+}
+
+void shared_ptr_shared_copy_benchmark(benchmark::State& p_state) {
+    run_shared_copy(p_state, *shared_std_refs);
+}
+
+void ref_intrusive_copy_benchmark(benchmark::State& p_state) {
+    std::unique_ptr<WBE::Global> global = std::make_unique<WBE::Global>(0, nullptr, WBE::Directory({"test_env"}));
+    WBE::HeapAllocatorTLSF pool(REF_POOL_SIZE);
+    {
+        std::vector<WBE::RefIntrusive<CountedParticle>> refs;
+        refs.reserve(REF_COUNT);
+        for (size_t i = 0; i < REF_COUNT; ++i) {
+            refs.push_back(WBE::make_ref_intrusive<CountedParticle>(&pool, 0.0f, 1.0f));
+        }
+        run_copy(p_state, refs);
+    }
+}
+
+}
+
+// The type erased references call the virtual get of HeapAllocator on every access, the
+// concrete ones know from the trait of HeapAllocatorTLSF that the memory ID is the address.
+BENCHMARK(ref_deref_benchmark<WBE::HeapAllocator>);
+BENCHMARK(ref_deref_benchmark<WBE::HeapAllocatorTLSF>);
+BENCHMARK(unique_deref_benchmark<WBE::HeapAllocator>);
+BENCHMARK(unique_deref_benchmark<WBE::HeapAllocatorTLSF>);
+BENCHMARK(ref_raw_deref_benchmark<WBE::HeapAllocator>);
+BENCHMARK(ref_raw_deref_benchmark<WBE::HeapAllocatorTLSF>);
+
+// A strong copy and release only touch the strong counter, like std::shared_ptr. RefLocal
+// counts without atomics, RefIntrusive counts inside the object.
+BENCHMARK(ref_copy_benchmark<WBE::RefPolicyAtomic>);
+BENCHMARK(ref_copy_benchmark<WBE::RefPolicyNonAtomic>);
+BENCHMARK(shared_ptr_copy_benchmark);
+BENCHMARK(ref_intrusive_copy_benchmark);
+BENCHMARK(ref_shared_copy_benchmark)->ThreadRange(1, MT_MAX_THREADS)->UseRealTime()->Setup(shared_copy_setup)->Teardown(shared_copy_teardown);
+BENCHMARK(shared_ptr_shared_copy_benchmark)->ThreadRange(1, MT_MAX_THREADS)->UseRealTime()->Setup(shared_copy_setup)->Teardown(shared_copy_teardown);
@@ -0,0 +1,120 @@
+/* Copyright 2025 OppositeNor
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#include "core/allocator/heap_allocator_tlsf.hh"
+#include "core/memory/slot_map.hh"
+#include "global/global.hh"
+#include "utils/utils.hh"
+#include <benchmark/benchmark.h>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+namespace WBE = WhiteBirdEngine;
+
+namespace {
+
+constexpr size_t ENTITY_COUNT = 16384;
+constexpr size_t ENTITY_POOL_SIZE = WBE_MiB(4);
+
+struct Transform {
+    float position[3];
+    float velocity[3];
+};
+
+// Fills the table, then erases a third of it at random so the table has holes to skip or fill.
+template <typename InsertFunc, typename EraseFunc, typename HandleType>
+void churn(std::vector<HandleType>& r_handles, InsertFunc p_insert, EraseFunc p_erase) {
+    std::mt19937 random(42);
+    for (size_t i = 0; i < ENTITY_COUNT; ++i) {
+        r_handles.push_back(p_insert());
+    }
+    for (size_t i = 0; i < ENTITY_COUNT / 3; ++i) {
+        size_t index = random() % r_handles.size();
+        p_erase(r_handles[index]);
+        r_handles[index] = r_handles.back();
+        r_handles.pop_back();
+    }
+}
+
+void slot_map_iterate_benchmark(benchmark::State& p_state) {
+    std::unique_ptr<WBE::Global> global = std::make_unique<WBE::Global>(0, nullptr, WBE::Directory({"test_env"}));
+    WBE::HeapAllocatorTLSF pool(ENTITY_POOL_SIZE);
+    WBE::SlotMap<Transform, WBE::HeapAllocatorTLSF> map(&pool);
+    std::vector<WBE::SlotMapHandle> handles;
+    churn(handles, [&] { return map.insert(Transform{ {}, { 1.0f, 1.0f, 1.0f } }); }, [&](WBE::SlotMapHandle p_handle) { map.erase(p_handle); });
+    for (auto _ : p_state) {
+        for (Transform& transform : map) {
+            transform.position[0] += transform.velocity[0];
+        }
+        benchmark::ClobberMemory();
+    }
+    p_state.SetItemsProcessed(p_state.iterations() * map.size());
+}
+
+void unordered_map_iterate_benchmark(benchmark::State& p_state) {
+    std::unordered_map<uint64_t, Transform> map;
+    uint64_t next_id = 0;
+    std::vector<uint64_t> handles;
+    churn(handles, [&] { map.emplace(next_id, Transform{ {}, { 1.0f, 1.0f, 1.0f } }); return next_id++; }, [&](uint64_t p_handle) { map.erase(p_handle); });
+    for (auto _ : p_state) {
+        for (auto& [id, transform] : map) {
+            transform.position[0] += transform.velocity[0];
+        }
+        benchmark::ClobberMemory();
+    }
+    p_state.SetItemsProcessed(p_state.iterations() * map.size());
+}
+
+void slot_map_lookup_benchmark(benchmark::State& p_state) {
+    std::unique_ptr<WBE::Global> global = std::make_unique<WBE::Global>(0, nullptr, WBE::Directory({"test_env"}));
+    WBE::HeapAllocatorTLSF pool(ENTITY_POOL_SIZE);
+    WBE::SlotMap<Transform, WBE::HeapAllocatorTLSF> map(&pool);
+    std::vector<WBE::SlotMapHandle> handles;
+    churn(handles, [&] { return map.insert(Transform{ {}, { 1.0f, 1.0f, 1.0f } }); }, [&](WBE::SlotMapHandle p_handle) { map.erase(p_handle); });
+    for (auto _ : p_state) {
+        for (WBE::SlotMapHandle handle : handles) {
+            Transform* transform = map.get(handle);
+            transform->position[0] += transform->velocity[0];
+        }
+        benchmark::ClobberMemory();
+    }
+    p_state.SetItemsProcessed(p_state.iterations() * handles.size());
+}
+
+void unordered_map_lookup_benchmark(benchmark::State& p_state) {
+    std::unordered_map<uint64_t, Transform> map;
+    uint64_t next_id = 0;
+    std::vector<uint64_t> handles;
+    churn(handles, [&] { map.emplace(next_id, Transform{ {}, { 1.0f, 1.0f, 1.0f } }); return next_id++; }, [&](uint64_t p_handle) { map.erase(p_handle); });
+    for (auto _ : p_state) {
+        for (uint64_t handle : handles) {
+            Transform& transform = map.find(handle)->second;
+            transform.position[0] += transform.velocity[0];
+        }
+        benchmark::ClobberMemory();
+    }
+    p_state.SetItemsProcessed(p_state.iterations() * handles.size());
+}
+
+}
+
+// The slot map iterates a packed array, the hash map chases a node per element.
+BENCHMARK(slot_map_iterate_benchmark);
+BENCHMARK(unordered_map_iterate_benchmark);
+BENCHMARK(slot_map_lookup_benchmark);
+BENCHMARK(unordered_map_lookup_benchmark);
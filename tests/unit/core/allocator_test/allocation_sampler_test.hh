@@ -0,0 +1,140 @@
+/* Copyright 2025 OppositeNor
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef __WBE_ALLOCATION_SAMPLER_TEST_HH__
+#define __WBE_ALLOCATION_SAMPLER_TEST_HH__
+
+#include "core/allocator/allocation_sampler.hh"
+#include "core/allocator/heap_allocator_sampled.hh"
+#include "core/allocator/heap_allocator_tlsf.hh"
+#include "global/global.hh"
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace WBE = WhiteBirdEngine;
+
+class WBEAllocationSamplerTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        global = std::make_unique<WBE::Global>(0, nullptr, WBE::Directory({"test_env"}));
+    }
+
+    void TearDown() override {
+        global.reset();
+    }
+
+    std::unique_ptr<WBE::Global> global;
+};
+
+TEST_F(WBEAllocationSamplerTest, Trait) {
+    using Trait = WBE::AllocatorTrait<WBE::HeapAllocatorSampled<WBE::HeapAllocatorTLSF>>;
+    ASSERT_TRUE(Trait::IS_POOL);
+    ASSERT_FALSE(Trait::IS_ATOMIC);
+    ASSERT_FALSE(Trait::WILL_ADDR_MOVE);
+    ASSERT_THROW(WBE::AllocationSampler(0), std::runtime_error);
+}
+
+TEST_F(WBEAllocationSamplerTest, CallSites) {
+    WBE::HeapAllocatorTLSF pool(WBE_KiB(16));
+    // With an interval of 1 byte, every allocation of 64 bytes is sampled.
+    WBE::AllocationSampler sampler(1);
+    WBE::HeapAllocatorSampled<WBE::HeapAllocatorTLSF> allocator(&pool, &sampler);
+    std::vector<WBE::MemID> mems_a;
+    std::vector<WBE::MemID> mems_b;
+    for (int i = 0; i < 10; ++i) {
+        mems_a.push_back(allocator.allocate(64));
+    }
+    for (int i = 0; i < 5; ++i) {
+        mems_b.push_back(allocator.allocate(64));
+    }
+    for (int i = 0; i < 4; ++i) {
+        allocator.deallocate(mems_a[i]);
+    }
+    ASSERT_EQ(sampler.get_sample_count(), 15);
+    ASSERT_EQ(sampler.get_live_sample_count(), 11);
+    std::vector<WBE::AllocationSampler::CallSiteReport> report = sampler.get_report();
+    ASSERT_EQ(report.size(), 2);
+    // Sorted by the live bytes.
+    ASSERT_EQ(report[0].sample_count, 10);
+    ASSERT_EQ(report[0].live_sample_count, 6);
+    ASSERT_EQ(report[0].get_live_bytes(), 6 * 64);
+    ASSERT_EQ(report[0].freed_bytes, 4 * 64);
+    ASSERT_EQ(report[1].sample_count, 5);
+    ASSERT_EQ(report[1].get_live_bytes(), 5 * 64);
+    ASSERT_FALSE(report[0].backtrace.empty());
+    std::string json = sampler;
+    ASSERT_NE(json.find("\"live_bytes\":704"), std::string::npos);
+    for (int i = 4; i < 10; ++i) {
+        allocator.deallocate(mems_a[i]);
+    }
+    for (auto mem : mems_b) {
+        allocator.deallocate(mem);
+    }
+    ASSERT_EQ(sampler.get_live_sample_count(), 0);
+    ASSERT_TRUE(allocator.is_empty());
+}
+
+TEST_F(WBEAllocationSamplerTest, ByteWeightedEstimate) {
+    WBE::HeapAllocatorTLSF pool(WBE_KiB(16));
+    WBE::AllocationSampler sampler(4096);
+    WBE::HeapAllocatorSampled<WBE::HeapAllocatorTLSF> allocator(&pool, &sampler);
+    constexpr size_t COUNT = 20000;
+    for (size_t i = 0; i < COUNT; ++i) {
+        // Small and large allocations, the large ones are sampled more often.
+        size_t size = i % 4 == 0 ? 512 : 32;
+        allocator.deallocate(allocator.allocate(size));
+    }
+    size_t total = COUNT / 4 * 512 + COUNT / 4 * 3 * 32;
+    size_t allocated = 0;
+    for (const auto& call_site : sampler.get_report()) {
+        allocated += call_site.allocated_bytes;
+        ASSERT_EQ(call_site.get_live_bytes(), 0);
+    }
+    // About 780 samples, the estimate is well within 25%.
+    ASSERT_GT(allocated, total * 3 / 4);
+    ASSERT_LT(allocated, total * 5 / 4);
+    ASSERT_LT(sampler.get_sample_count(), COUNT / 10);
+    ASSERT_EQ(sampler.get_live_sample_count(), 0);
+}
+
+TEST_F(WBEAllocationSamplerTest, ClearAndReport) {
+    WBE::HeapAllocatorTLSF pool(WBE_KiB(16));
+    std::string path = (std::filesystem::temp_directory_path() / "wbe_allocation_sampler_test.json").string();
+    {
+        WBE::AllocationSampler sampler(1, path);
+        WBE::HeapAllocatorSampled<WBE::HeapAllocatorTLSF> allocator(&pool, &sampler);
+        WBE::MemID ids[4];
+        allocator.allocate_batch(4, 32, WBE_DEFAULT_ALIGNMENT, ids);
+        ASSERT_EQ(sampler.get_live_sample_count(), 4);
+        allocator.clear();
+        ASSERT_EQ(sampler.get_live_sample_count(), 0);
+        allocator.allocate(128);
+    }
+    // The report is written when the sampler is destructed.
+    std::ifstream file(path);
+    ASSERT_TRUE(file.is_open());
+    std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    ASSERT_NE(content.find("\"type\":\"AllocationSampler\""), std::string::npos);
+    ASSERT_NE(content.find("\"live_sample_count\":1"), std::string::npos);
+    file.close();
+    std::filesystem::remove(path);
+    pool.clear();
+}
+
+#endif
@@ -16,7 +16,14 @@
 #include "heap_allocator_align_pool_test.hh"
 #include "heap_allocator_aligned_pool_impl_list_test.hh"
 #include "heap_allocator_fixed_size_pool_test.hh"
+#include "heap_allocator_atomic_fixed_size_pool_test.hh"
 #include "heap_allocator_atomic_aligned_pool_test.hh"
 #include "heap_allocator_atomic_aligned_pool_impl_list_test.hh"
+#include "heap_allocator_tlsf_test.hh"
+#include "heap_allocator_compacting_test.hh"
+#include "heap_allocator_thread_cache_test.hh"
 #include "stack_allocator_test.hh"
+#include "frame_allocator_test.hh"
+#include "growable_buffer_test.hh"
+#include "allocation_sampler_test.hh"
 #include "core/allocator/heap_allocator_ram.hh"
@@ -0,0 +1,149 @@
+/* Copyright 2025 OppositeNor
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef __WBE_FRAME_ALLOCATOR_TEST_HH__
+#define __WBE_FRAME_ALLOCATOR_TEST_HH__
+
+#include "core/allocator/frame_allocator.hh"
+#include "global/global.hh"
+#include <cstring>
+#include <gtest/gtest.h>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace WBE = WhiteBirdEngine;
+
+class WBEFrameAllocatorTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        global = std::make_unique<WBE::Global>(0, nullptr, WBE::Directory({"test_env"}));
+    }
+
+    void TearDown() override {
+        global.reset();
+    }
+
+    std::unique_ptr<WBE::Global> global;
+};
+
+TEST_F(WBEFrameAllocatorTest, TraitTest) {
+    ASSERT_TRUE(WBE::AllocatorTrait<WBE::FrameAllocator>::IS_ATOMIC);
+    ASSERT_TRUE(WBE::AllocatorTrait<WBE::FrameAllocator>::IS_ALIGNABLE);
+    ASSERT_FALSE(WBE::AllocatorTrait<WBE::FrameAllocator>::WILL_ADDR_MOVE);
+}
+
+TEST_F(WBEFrameAllocatorTest, InvalidConstruction) {
+    ASSERT_THROW(WBE::FrameAllocator(0), std::runtime_error);
+    ASSERT_THROW(WBE::FrameAllocator(1024, 0), std::runtime_error);
+    ASSERT_THROW(WBE::FrameAllocator(1024, WBE::FrameAllocator::MAX_FRAME_COUNT + 1), std::runtime_error);
+}
+
+TEST_F(WBEFrameAllocatorTest, AllocateAligned) {
+    WBE::FrameAllocator allocator(1024);
+    ASSERT_EQ(allocator.allocate(0), WBE::MEM_NULL);
+    WBE::MemID mem1 = allocator.allocate(3);
+    WBE::MemID mem2 = allocator.allocate(8, 64);
+    WBE::MemID mem3 = allocator.allocate(16);
+    ASSERT_EQ(mem1 % WBE_DEFAULT_ALIGNMENT, 0);
+    ASSERT_EQ(mem2 % 64, 0);
+    ASSERT_GE(mem2, mem1 + 3);
+    ASSERT_GE(mem3, mem2 + 8);
+    memset(allocator.get(mem3), 0xFF, 16);
+    ASSERT_THROW(allocator.allocate(8, 0), std::runtime_error);
+    ASSERT_THROW(allocator.allocate(2048), std::runtime_error);
+}
+
+TEST_F(WBEFrameAllocatorTest, DataLivesForFrameCount) {
+    WBE::FrameAllocator allocator(256, 2);
+    int* value = allocator.get_obj<int>(WBE::create_frame_obj<int>(allocator, 42));
+    allocator.end_frame();
+    // The next frame uses the other buffer, so the data of the last frame is kept.
+    WBE::MemID other = allocator.allocate(sizeof(int));
+    ASSERT_NE(other, reinterpret_cast<WBE::MemID>(value));
+    ASSERT_EQ(*value, 42);
+    allocator.end_frame();
+    // Two frames later the buffer is reused from its start.
+    ASSERT_EQ(allocator.allocate(sizeof(int)), reinterpret_cast<WBE::MemID>(value));
+    ASSERT_EQ(allocator.get_frame_number(), 2);
+}
+
+TEST_F(WBEFrameAllocatorTest, TripleBuffering) {
+    WBE::FrameAllocator allocator(256, 3);
+    std::vector<WBE::MemID> mems;
+    for (int i = 0; i < 4; ++i) {
+        mems.push_back(allocator.allocate(32));
+        allocator.end_frame();
+    }
+    ASSERT_NE(mems[0], mems[1]);
+    ASSERT_NE(mems[1], mems[2]);
+    ASSERT_NE(mems[0], mems[2]);
+    ASSERT_EQ(mems[0], mems[3]);
+}
+
+TEST_F(WBEFrameAllocatorTest, HighWaterMark) {
+    WBE::FrameAllocator allocator(1024, 2);
+    allocator.allocate(100);
+    allocator.allocate(100);
+    allocator.end_frame();
+    ASSERT_GE(allocator.get_last_frame_size(), 200);
+    size_t peak = allocator.get_frame_high_water_mark();
+    ASSERT_EQ(peak, allocator.get_last_frame_size());
+    allocator.allocate(16);
+    allocator.end_frame();
+    ASSERT_LT(allocator.get_last_frame_size(), peak);
+    ASSERT_EQ(allocator.get_frame_high_water_mark(), peak);
+    ASSERT_EQ(allocator.get_slice_high_water_mark(), peak);
+    // A frame without any allocation.
+    allocator.end_frame();
+    ASSERT_EQ(allocator.get_last_frame_size(), 0);
+    ASSERT_NE(static_cast<std::string>(allocator).find("\"frame_high_water_mark\":" + std::to_string(peak)), std::string::npos);
+}
+
+TEST_F(WBEFrameAllocatorTest, ThreadSlices) {
+    constexpr int NUM_THREADS = 4;
+    constexpr int ALLOCS_PER_THREAD = 16;
+    // A thread could take over the slice of a thread that already exited in the same frame.
+    WBE::FrameAllocator allocator(NUM_THREADS * ALLOCS_PER_THREAD * 32, 2);
+    std::vector<std::vector<WBE::MemID>> results(NUM_THREADS);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < NUM_THREADS; ++t) {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < ALLOCS_PER_THREAD; ++i) {
+                WBE::MemID mem = allocator.allocate(32);
+                memset(allocator.get(mem), t, 32);
+                results[t].push_back(mem);
+            }
+        });
+    }
+    for (auto& th : threads) th.join();
+    std::set<WBE::MemID> unique;
+    for (int t = 0; t < NUM_THREADS; ++t) {
+        for (WBE::MemID mem : results[t]) {
+            ASSERT_EQ(*allocator.get_obj<char>(mem), static_cast<char>(t));
+            unique.insert(mem);
+        }
+    }
+    ASSERT_EQ(unique.size(), NUM_THREADS * ALLOCS_PER_THREAD);
+    allocator.end_frame();
+    ASSERT_EQ(allocator.get_last_frame_size(), NUM_THREADS * ALLOCS_PER_THREAD * 32);
+    // The slices of the exited threads are reused.
+    size_t slice_count = allocator.get_thread_slice_count();
+    ASSERT_LE(slice_count, NUM_THREADS);
+    std::thread([&]() { allocator.allocate(32); }).join();
+    ASSERT_EQ(allocator.get_thread_slice_count(), slice_count);
+}
+
+#endif
@@ -0,0 +1,165 @@
+/* Copyright 2025 OppositeNor
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef __WBE_GROWABLE_BUFFER_TEST_HH__
+#define __WBE_GROWABLE_BUFFER_TEST_HH__
+
+#include "core/allocator/growable_buffer.hh"
+#include "core/allocator/heap_allocator_aligned_pool_impl_list.hh"
+#include "core/allocator/heap_allocator_atomic_aligned_pool_impl_list.hh"
+#include "core/allocator/heap_allocator_tlsf.hh"
+#include "global/global.hh"
+#include <gtest/gtest.h>
+#include <string>
+#include <utility>
+
+namespace WBE = WhiteBirdEngine;
+
+class WBEGrowableBufferTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        global = std::make_unique<WBE::Global>(0, nullptr, WBE::Directory({"test_env"}));
+    }
+
+    void TearDown() override {
+        global.reset();
+    }
+
+    std::unique_ptr<WBE::Global> global;
+};
+
+TEST_F(WBEGrowableBufferTest, GrowInPlace) {
+    WBE::HeapAllocatorAlignedPoolImplicitList pool(WBE_KiB(64));
+    {
+        WBE::GrowableBuffer<int, WBE::HeapAllocatorAlignedPoolImplicitList> buffer(&pool);
+        ASSERT_TRUE(buffer.empty());
+        ASSERT_EQ(buffer.data(), nullptr);
+        for (int i = 0; i < 1000; ++i) {
+            buffer.push_back(i);
+        }
+        ASSERT_EQ(buffer.size(), 1000);
+        ASSERT_GE(buffer.get_capacity(), 1000);
+        for (int i = 0; i < 1000; ++i) {
+            ASSERT_EQ(buffer[i], i);
+        }
+        // Nothing else is allocated from the pool, so the memory after the buffer is always idle.
+        ASSERT_GT(buffer.get_in_place_resize_count(), 0);
+        ASSERT_EQ(buffer.get_moving_resize_count(), 0);
+        buffer.resize(10);
+        buffer.shrink_to_fit();
+        ASSERT_EQ(buffer.get_moving_resize_count(), 0);
+        ASSERT_LT(buffer.get_capacity(), 16);
+        ASSERT_EQ(buffer[9], 9);
+    }
+    ASSERT_TRUE(pool.is_empty());
+}
+
+TEST_F(WBEGrowableBufferTest, MoveWhenBlocked) {
+    WBE::HeapAllocatorTLSF pool(WBE_KiB(64));
+    {
+        WBE::GrowableBuffer<std::string, WBE::HeapAllocatorTLSF> buffer(&pool);
+        for (int i = 0; i < 100; ++i) {
+            buffer.emplace_back(std::to_string(i) + " a string long enough to be allocated on the heap");
+            // Blocks the memory after the buffer.
+            if (i % 16 == 0) {
+                pool.allocate(16);
+            }
+        }
+        ASSERT_GT(buffer.get_moving_resize_count(), 0);
+        for (int i = 0; i < 100; ++i) {
+            ASSERT_EQ(buffer[i], std::to_string(i) + " a string long enough to be allocated on the heap");
+        }
+        WBE::GrowableBuffer<std::string, WBE::HeapAllocatorTLSF> moved(std::move(buffer));
+        ASSERT_EQ(buffer.size(), 0);
+        ASSERT_EQ(moved.size(), 100);
+        moved.pop_back();
+        ASSERT_EQ(moved.size(), 99);
+        moved.clear();
+        ASSERT_TRUE(moved.empty());
+    }
+    pool.clear();
+}
+
+TEST_F(WBEGrowableBufferTest, AtomicPoolCapacity) {
+    WBE::HeapAllocatorAtomicAlignedPoolImplicitList pool(WBE_KiB(64));
+    {
+        WBE::GrowableBuffer<int, WBE::HeapAllocatorAtomicAlignedPoolImplicitList> buffer(&pool);
+        buffer.reserve(4);
+        // The capacity only covers the data of the allocation, not the header.
+        ASSERT_LE(buffer.get_capacity() * sizeof(int), pool.get_allocated_data_size(reinterpret_cast<WBE::MemID>(buffer.data())));
+        // The chunk after the buffer is used, filling the buffer must not reach its header.
+        WBE::MemID blocker = pool.allocate(16);
+        size_t capacity = buffer.get_capacity();
+        for (size_t i = 0; i < capacity; ++i) {
+            buffer.push_back(0x11111111);
+        }
+        ASSERT_EQ(buffer.get_moving_resize_count(), 0);
+        ASSERT_NO_THROW(pool.deallocate(blocker));
+        // Grows by moving, the copy only reads the data of the old allocation.
+        for (int i = 0; i < 100; ++i) {
+            buffer.push_back(i);
+        }
+        ASSERT_EQ(buffer[capacity + 99], 99);
+    }
+    ASSERT_TRUE(pool.is_empty());
+}
+
+TEST_F(WBEGrowableBufferTest, AtomicPoolReallocate) {
+    WBE::HeapAllocatorAtomicAlignedPoolImplicitList pool(WBE_KiB(64));
+    WBE::MemID mem_id = pool.allocate(32);
+    ASSERT_EQ(pool.get_allocated_data_size(mem_id), 32);
+    for (int i = 0; i < 8; ++i) {
+        static_cast<int*>(pool.get(mem_id))[i] = i;
+    }
+    WBE::MemID blocker = pool.allocate(16);
+    WBE::MemID moved = pool.reallocate(mem_id, 256);
+    ASSERT_GE(pool.get_allocated_data_size(moved), 256);
+    for (int i = 0; i < 8; ++i) {
+        ASSERT_EQ(static_cast<int*>(pool.get(moved))[i], i);
+    }
+    ASSERT_NO_THROW(pool.deallocate(blocker));
+    pool.deallocate(moved);
+    ASSERT_TRUE(pool.is_empty());
+}
+
+TEST_F(WBEGrowableBufferTest, SelfReferencePushBack) {
+    WBE::HeapAllocatorTLSF pool(WBE_KiB(64));
+    for (bool emplace : { false, true }) {
+        WBE::MemID blocker;
+        {
+            WBE::GrowableBuffer<std::string, WBE::HeapAllocatorTLSF> buffer(&pool);
+            buffer.reserve(4);
+            // Blocks the memory after the buffer, so growing has to move the elements.
+            blocker = pool.allocate(16);
+            size_t capacity = buffer.get_capacity();
+            for (size_t i = 0; i < capacity; ++i) {
+                buffer.emplace_back(std::to_string(i) + " a string long enough to be allocated on the heap");
+            }
+            // The argument is an element of the full buffer.
+            if (emplace) {
+                buffer.emplace_back(buffer[0]);
+            }
+            else {
+                buffer.push_back(buffer[0]);
+            }
+            ASSERT_EQ(buffer.get_moving_resize_count(), 1);
+            ASSERT_EQ(buffer[capacity], "0 a string long enough to be allocated on the heap");
+            ASSERT_EQ(buffer[0], buffer[capacity]);
+        }
+        pool.deallocate(blocker);
+        ASSERT_TRUE(pool.is_empty());
+    }
+}
+
+#endif
\ No newline at end of file
@@ -18,13 +18,18 @@
 #include "core/allocator/allocator.hh"
 #include "core/allocator/heap_allocator_aligned_pool.hh"
 #include "global/global.hh"
+#include "platform/os/os.hh"
 #include "test_utilities.hh"
 #include <bit>
 #include <cstddef>
 #include <cstdint>
+#include <algorithm>
+#include <cstring>
 #include <gtest/gtest.h>
+#include <random>
 #include <stdexcept>
 #include <string>
+#include <vector>
 
 namespace WBE = WhiteBirdEngine;
 
@@ -290,4 +295,140 @@ TEST_F(WBEAllocAlignedPoolTest, GetMemoryAddress) {
     allocator.deallocate(mem3);
 }
 
+TEST_F(WBEAllocAlignedPoolTest, HugePages) {
+    WBE::HeapAllocatorAlignedPool pool(WBE_KiB(64), 0, true);
+    ASSERT_EQ(pool.get_total_size() % WBE::OS::get_huge_page_size(), 0);
+    ASSERT_TRUE(pool.is_empty());
+    WBE::MemID mem = pool.allocate(WBE_KiB(128), 64);
+    ASSERT_EQ(mem % 64, 0);
+    memset(pool.get(mem), 0xFF, WBE_KiB(128));
+    pool.deallocate(mem);
+    ASSERT_TRUE(pool.is_empty());
+}
+
+TEST_F(WBEAllocAlignedPoolTest, GrowableCommitOnDemand) {
+    WBE::HeapAllocatorAlignedPool pool(WBE_KiB(4), WBE_MiB(64));
+    ASSERT_TRUE(pool.is_growable());
+    ASSERT_EQ(pool.get_committed_size(), WBE_KiB(4));
+    ASSERT_EQ(pool.get_reserved_size(), WBE_MiB(64));
+    std::vector<std::pair<WBE::MemID, uint8_t>> mems;
+    for (size_t i = 0; i < 2000; ++i) {
+        size_t alignment = (i % 4 == 0) ? 8 * AAPT_HEADER_SIZE : AAPT_HEADER_SIZE;
+        WBE::MemID mem = pool.allocate(1000, alignment);
+        ASSERT_EQ(mem % alignment, 0);
+        memset(pool.get(mem), i & 0xFF, 1000);
+        mems.emplace_back(mem, i & 0xFF);
+    }
+    ASSERT_GT(pool.get_committed_size(), WBE_KiB(4));
+    ASSERT_LE(pool.get_committed_size(), pool.get_reserved_size());
+    // Memory IDs are stable while the pool grows.
+    for (auto& mem : mems) {
+        ASSERT_TRUE(pool.is_in_pool(mem.first));
+        ASSERT_EQ(*static_cast<uint8_t*>(pool.get(mem.first)), mem.second);
+        pool.deallocate(mem.first);
+    }
+    ASSERT_TRUE(pool.is_empty());
+}
+
+TEST_F(WBEAllocAlignedPoolTest, GrowableThrowWhenReservationUsedUp) {
+    WBE::HeapAllocatorAlignedPool pool(WBE_KiB(4), WBE_KiB(64));
+    WBE::MemID mem = pool.allocate(WBE_KiB(32));
+    ASSERT_THROW(pool.allocate(WBE_KiB(64)), std::runtime_error);
+    ASSERT_EQ(pool.get_committed_size(), WBE_KiB(64));
+    pool.deallocate(mem);
+    ASSERT_TRUE(pool.is_empty());
+    mem = pool.allocate(WBE_KiB(60));
+    ASSERT_NE(mem, WBE::MEM_NULL);
+    pool.deallocate(mem);
+}
+
+TEST_F(WBEAllocAlignedPoolTest, GrowableTryExpandAtEnd) {
+    WBE::HeapAllocatorAlignedPool pool(WBE_KiB(4), WBE_MiB(1));
+    WBE::MemID mem = pool.allocate(pool.get_total_size() - AAPT_HEADER_SIZE);
+    ASSERT_EQ(pool.get_remain_size(), 0);
+    // The allocation is at the end of the pool, so the pool grows behind it.
+    ASSERT_TRUE(pool.try_expand(mem, WBE_KiB(64)));
+    ASSERT_GT(pool.get_committed_size(), WBE_KiB(64));
+    memset(pool.get(mem), 0xFF, WBE_KiB(64));
+    ASSERT_FALSE(pool.try_expand(mem, WBE_MiB(2)));
+    pool.deallocate(mem);
+    ASSERT_TRUE(pool.is_empty());
+}
+
+TEST_F(WBEAllocAlignedPoolTest, StressRandomAllocDealloc) {
+    WBE::HeapAllocatorAlignedPool pool(WBE_KiB(64));
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<size_t> size_dist(1, 300);
+    std::vector<size_t> alignments = {8, 16, 24, 64, 128};
+    std::vector<WBE::MemID> mems;
+    for (int i = 0; i < 5000; ++i) {
+        if (mems.empty() || rng() % 3 != 0) {
+            size_t alloc_size = size_dist(rng);
+            size_t alignment = alignments[rng() % alignments.size()];
+            WBE::MemID mem = WBE::MEM_NULL;
+            try {
+                mem = pool.allocate(alloc_size, alignment);
+            }
+            catch (const std::runtime_error&) {
+                continue;
+            }
+            ASSERT_EQ(mem % alignment, 0);
+            memset(pool.get(mem), i & 0xFF, alloc_size);
+            mems.push_back(mem);
+        }
+        else {
+            size_t idx = rng() % mems.size();
+            pool.deallocate(mems[idx]);
+            mems.erase(mems.begin() + idx);
+        }
+    }
+    std::shuffle(mems.begin(), mems.end(), rng);
+    for (WBE::MemID mem : mems) {
+        pool.deallocate(mem);
+    }
+    ASSERT_TRUE(pool.is_empty());
+    ASSERT_EQ(pool.get_remain_size(), WBE_KiB(64));
+}
+
+TEST_F(WBEAllocAlignedPoolTest, TryExpandInPlace) {
+    WBE::HeapAllocatorAlignedPool pool(1024);
+    WBE::MemID mem1 = pool.allocate(32);
+    WBE::MemID mem2 = pool.allocate(32);
+    memset(pool.get(mem1), 0xAB, 32);
+    pool.deallocate(mem2);
+    ASSERT_TRUE(pool.try_expand(mem1, 96));
+    ASSERT_EQ(pool.get_allocated_data_size(mem1), 96);
+    ASSERT_EQ(static_cast<unsigned char*>(pool.get(mem1))[31], 0xAB);
+    WBE::MemID mem3 = pool.allocate(32);
+    ASSERT_FALSE(pool.try_expand(mem1, 128));
+    ASSERT_TRUE(pool.try_expand(mem1, 16));
+    ASSERT_EQ(pool.get_allocated_data_size(mem1), 16);
+    ASSERT_EQ(pool.get_remain_size(), 1024 - 2 * WBE::HeapAllocatorAlignedPool::HEADER_SIZE - 16 - 32);
+    pool.deallocate(mem1);
+    pool.deallocate(mem3);
+    ASSERT_TRUE(pool.is_empty());
+}
+
+TEST_F(WBEAllocAlignedPoolTest, StatsFreeBytes) {
+    WBE::HeapAllocatorAlignedPool pool(1024);
+    std::vector<WBE::MemID> mems;
+    for (int i = 0; i < 8; ++i) {
+        mems.push_back(pool.allocate(16));
+    }
+    for (size_t i = 0; i < mems.size(); i += 2) {
+        pool.deallocate(mems[i]);
+    }
+    WBE::AllocatorStats stats = pool.get_stats();
+    ASSERT_EQ(stats.free_bytes, pool.get_total_size() - stats.live_bytes);
+    ASSERT_FALSE(stats.largest_free_block_tracked);
+    ASSERT_EQ(pool.get_largest_free_block(), pool.get_total_size() - 8 * (stats.live_bytes / 4));
+    ASSERT_TRUE(pool.try_expand(mems[1], 48));
+    ASSERT_EQ(pool.get_stats().free_bytes, pool.get_total_size() - pool.get_stats().live_bytes);
+    for (size_t i = 1; i < mems.size(); i += 2) {
+        pool.deallocate(mems[i]);
+    }
+    ASSERT_EQ(pool.get_stats().free_bytes, pool.get_total_size());
+    ASSERT_EQ(pool.get_largest_free_block(), pool.get_total_size());
+}
+
 #endif
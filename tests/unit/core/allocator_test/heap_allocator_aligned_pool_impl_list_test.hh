@@ -18,7 +18,9 @@
 #include "core/allocator/allocator.hh"
 #include "core/allocator/heap_allocator_aligned_pool_impl_list.hh"
 #include "global/global.hh"
+#include "platform/os/os.hh"
 #include <algorithm>
+#include <cmath>
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
@@ -194,6 +196,25 @@ TEST_F(WBEAllocAlignedPoolImplicitListTest, FragmentationAndCoalescing) {
     ASSERT_EQ(pool.get_remain_size(), 128);
 }
 
+TEST_F(WBEAllocAlignedPoolImplicitListTest, MergeBothNeighboursOnDeallocate) {
+    WBE::HeapAllocatorAlignedPoolImplicitList pool(1024);
+    WBE::MemID mem1 = pool.allocate(16);
+    WBE::MemID mem2 = pool.allocate(16);
+    WBE::MemID mem3 = pool.allocate(16);
+    WBE::MemID mem4 = pool.allocate(16);
+    pool.deallocate(mem1);
+    pool.deallocate(mem3);
+    pool.deallocate(mem2);
+    ASSERT_NO_THROW(pool.check_broken());
+    // The three chunks are merged into one, which fits an allocation of their total size.
+    WBE::MemID merged = pool.allocate(3 * (16 + AAPILT_HEADER_SIZE) - AAPILT_HEADER_SIZE);
+    ASSERT_EQ(merged, mem1);
+    pool.deallocate(merged);
+    pool.deallocate(mem4);
+    ASSERT_NO_THROW(pool.check_broken());
+    ASSERT_EQ(pool.get_remain_size(), 1024);
+}
+
 TEST_F(WBEAllocAlignedPoolImplicitListTest, StressRandomAllocDealloc) {
     WBE::HeapAllocatorAlignedPoolImplicitList pool(WBE_MiB(1));
     std::vector<WBE::MemID> mems;
@@ -328,4 +349,229 @@ TEST_F(WBEAllocAlignedPoolImplicitListTest, StressAllocateWithAlignTest) {
     }
 }
 
+TEST_F(WBEAllocAlignedPoolImplicitListTest, GrowableCommitOnDemand) {
+    WBE::HeapAllocatorAlignedPoolImplicitList pool(WBE_KiB(4), WBE_MiB(64));
+    ASSERT_TRUE(pool.is_growable());
+    ASSERT_EQ(pool.get_committed_size(), WBE_KiB(4));
+    ASSERT_EQ(pool.get_reserved_size(), WBE_MiB(64));
+    std::vector<std::pair<WBE::MemID, uint8_t>> mems;
+    for (size_t i = 0; i < 2000; ++i) {
+        size_t alignment = (i % 4 == 0) ? 8 * AAPILT_HEADER_SIZE : AAPILT_HEADER_SIZE;
+        WBE::MemID mem = pool.allocate(1000, alignment);
+        ASSERT_EQ(mem % alignment, 0);
+        memset(pool.get(mem), i & 0xFF, 1000);
+        mems.emplace_back(mem, i & 0xFF);
+    }
+    ASSERT_GT(pool.get_committed_size(), WBE_KiB(4));
+    ASSERT_LE(pool.get_committed_size(), pool.get_reserved_size());
+    ASSERT_NO_THROW(pool.check_broken());
+    // Memory IDs are stable while the pool grows.
+    for (auto& mem : mems) {
+        ASSERT_TRUE(pool.is_in_pool(mem.first));
+        ASSERT_EQ(*static_cast<uint8_t*>(pool.get(mem.first)), mem.second);
+        pool.deallocate(mem.first);
+    }
+    ASSERT_TRUE(pool.is_empty());
+}
+
+TEST_F(WBEAllocAlignedPoolImplicitListTest, GrowableThrowWhenReservationUsedUp) {
+    WBE::HeapAllocatorAlignedPoolImplicitList pool(WBE_KiB(4), WBE_KiB(64));
+    WBE::MemID mem = pool.allocate(WBE_KiB(32));
+    ASSERT_THROW(pool.allocate(WBE_KiB(64)), std::runtime_error);
+    ASSERT_EQ(pool.get_committed_size(), WBE_KiB(64));
+    pool.deallocate(mem);
+    ASSERT_TRUE(pool.is_empty());
+    mem = pool.allocate(WBE_KiB(60));
+    ASSERT_NE(mem, WBE::MEM_NULL);
+    pool.deallocate(mem);
+}
+
+TEST_F(WBEAllocAlignedPoolImplicitListTest, HugePages) {
+    WBE::HeapAllocatorAlignedPoolImplicitList pool(WBE_KiB(64), 0, true);
+    ASSERT_FALSE(pool.is_growable());
+    ASSERT_EQ(pool.get_total_size() % WBE::OS::get_huge_page_size(), 0);
+    ASSERT_EQ(pool.get_reserved_size(), pool.get_total_size());
+    WBE::MemID mem = pool.allocate(WBE_KiB(128), 64);
+    ASSERT_EQ(mem % 64, 0);
+    memset(pool.get(mem), 0xFF, WBE_KiB(128));
+    pool.deallocate(mem);
+    ASSERT_TRUE(pool.is_empty());
+    ASSERT_NE(static_cast<std::string>(pool).find(WBE::get_page_backing_name(pool.get_page_backing())), std::string::npos);
+}
+
+TEST_F(WBEAllocAlignedPoolImplicitListTest, GrowableHugePages) {
+    WBE::HeapAllocatorAlignedPoolImplicitList pool(WBE_KiB(4), WBE_MiB(16), true);
+    ASSERT_TRUE(pool.is_growable());
+    // Explicit huge pages could not be committed on demand.
+    ASSERT_NE(pool.get_page_backing(), WBE::PageBacking::HUGE_TLB);
+    ASSERT_EQ(pool.get_reserved_size() % WBE::OS::get_huge_page_size(), 0);
+    WBE::MemID mem = pool.allocate(WBE_MiB(4));
+    memset(pool.get(mem), 0xFF, WBE_MiB(4));
+    pool.deallocate(mem);
+    ASSERT_TRUE(pool.is_empty());
+}
+
+TEST_F(WBEAllocAlignedPoolImplicitListTest, StatsFragmentation) {
+    WBE::HeapAllocatorAlignedPoolImplicitList pool(1024);
+    std::vector<WBE::MemID> mems;
+    for (int i = 0; i < 8; ++i) {
+        mems.push_back(pool.allocate(16));
+    }
+    // Free every other chunk, so that the idle memory is split.
+    for (size_t i = 0; i < mems.size(); i += 2) {
+        pool.deallocate(mems[i]);
+    }
+    WBE::AllocatorStats stats = pool.get_stats();
+    ASSERT_EQ(stats.allocation_count, 8);
+    ASSERT_EQ(stats.deallocation_count, 4);
+    ASSERT_EQ(stats.live_bytes, 4 * (16 + AAPILT_HEADER_SIZE));
+    ASSERT_EQ(stats.peak_bytes, 8 * (16 + AAPILT_HEADER_SIZE));
+    ASSERT_EQ(stats.free_bytes, pool.get_remain_size());
+    // The largest idle block needs a walk, it is not part of the snapshot.
+    ASSERT_FALSE(stats.largest_free_block_tracked);
+    // Untracked is not reported as unfragmented.
+    ASSERT_TRUE(std::isnan(stats.get_external_fragmentation()));
+    stats.largest_free_block = pool.get_largest_free_block();
+    stats.largest_free_block_tracked = true;
+    ASSERT_EQ(stats.largest_free_block, 1024 - 8 * (16 + AAPILT_HEADER_SIZE));
+    ASSERT_GT(stats.get_external_fragmentation(), 0.0);
+    for (size_t i = 1; i < mems.size(); i += 2) {
+        pool.deallocate(mems[i]);
+    }
+    stats = pool.get_stats();
+    ASSERT_EQ(stats.live_bytes, 0);
+    ASSERT_EQ(stats.free_bytes, 1024);
+    ASSERT_EQ(pool.get_largest_free_block(), 1024);
+}
+
+TEST_F(WBEAllocAlignedPoolImplicitListTest, TryExpandInPlace) {
+    WBE::HeapAllocatorAlignedPoolImplicitList pool(1024);
+    WBE::MemID mem1 = pool.allocate(32);
+    WBE::MemID mem2 = pool.allocate(32);
+    memset(pool.get(mem1), 0xAB, 32);
+    pool.deallocate(mem2);
+    // The chunk after mem1 is idle.
+    ASSERT_TRUE(pool.try_expand(mem1, 96));
+    ASSERT_EQ(pool.get_allocated_data_size(mem1), 96);
+    ASSERT_EQ(static_cast<unsigned char*>(pool.get(mem1))[31], 0xAB);
+    pool.check_broken();
+    WBE::MemID mem3 = pool.allocate(32);
+    ASSERT_EQ(mem3, mem1 + 96 + AAPILT_HEADER_SIZE);
+    // The chunk after mem1 is occupied now.
+    ASSERT_FALSE(pool.try_expand(mem1, 128));
+    ASSERT_EQ(pool.get_allocated_data_size(mem1), 96);
+    // Shrinking releases the tail.
+    ASSERT_TRUE(pool.try_expand(mem1, 16));
+    ASSERT_EQ(pool.get_allocated_data_size(mem1), 16);
+    pool.check_broken();
+    ASSERT_EQ(pool.get_remain_size(), 1024 - 2 * AAPILT_HEADER_SIZE - 16 - 32);
+    WBE::AllocatorStats stats = pool.get_stats();
+    ASSERT_EQ(stats.live_bytes, 2 * AAPILT_HEADER_SIZE + 16 + 32);
+    ASSERT_EQ(stats.allocation_count, 3);
+    pool.deallocate(mem1);
+    pool.deallocate(mem3);
+    ASSERT_TRUE(pool.is_empty());
+}
+
+TEST_F(WBEAllocAlignedPoolImplicitListTest, Reallocate) {
+    WBE::HeapAllocatorAlignedPoolImplicitList pool(1024);
+    WBE::MemID mem1 = pool.allocate(32);
+    WBE::MemID mem2 = pool.allocate(32);
+    for (int i = 0; i < 32; ++i) {
+        static_cast<char*>(pool.get(mem1))[i] = static_cast<char>(i);
+    }
+    // Could not expand in place, the data is moved.
+    WBE::MemID moved = pool.reallocate(mem1, 128);
+    ASSERT_NE(moved, mem1);
+    ASSERT_FALSE(pool.is_in_pool(mem1));
+    for (int i = 0; i < 32; ++i) {
+        ASSERT_EQ(static_cast<char*>(pool.get(moved))[i], static_cast<char>(i));
+    }
+    // The memory after moved is idle, expanded in place.
+    ASSERT_EQ(pool.reallocate(moved, 256), moved);
+    ASSERT_EQ(pool.reallocate(moved, 0), WBE::MEM_NULL);
+    pool.deallocate(mem2);
+    ASSERT_TRUE(pool.is_empty());
+    WBE::MemID mem3 = pool.reallocate(WBE::MEM_NULL, 64);
+    ASSERT_TRUE(pool.is_in_pool(mem3));
+    pool.deallocate(mem3);
+}
+
+TEST_F(WBEAllocAlignedPoolImplicitListTest, GrowableTryExpandAtEnd) {
+    WBE::HeapAllocatorAlignedPoolImplicitList pool(WBE_KiB(4), WBE_MiB(1));
+    WBE::MemID mem = pool.allocate(pool.get_total_size() - AAPILT_HEADER_SIZE);
+    ASSERT_EQ(pool.get_remain_size(), 0);
+    // The allocation is at the end of the pool, so the pool grows behind it.
+    ASSERT_TRUE(pool.try_expand(mem, WBE_KiB(64)));
+    ASSERT_GT(pool.get_committed_size(), WBE_KiB(64));
+    memset(pool.get(mem), 0xFF, WBE_KiB(64));
+    pool.check_broken();
+    ASSERT_FALSE(pool.try_expand(mem, WBE_MiB(2)));
+    pool.deallocate(mem);
+    ASSERT_TRUE(pool.is_empty());
+}
+
+TEST_F(WBEAllocAlignedPoolImplicitListTest, AllocateBatchCarvesNeighbours) {
+    WBE::HeapAllocatorAlignedPoolImplicitList pool(1024);
+    WBE::MemID mems[8];
+    pool.allocate_batch(8, 24, 16, mems);
+    for (size_t i = 1; i < 8; ++i) {
+        ASSERT_EQ(mems[i] - mems[i - 1], 32 + AAPILT_HEADER_SIZE);
+        ASSERT_TRUE(pool.is_in_pool(mems[i]));
+    }
+    pool.check_broken();
+    WBE::AllocatorStats stats = pool.get_stats();
+    ASSERT_EQ(stats.allocation_count, 8);
+    ASSERT_EQ(stats.live_bytes, 8 * (32 + AAPILT_HEADER_SIZE));
+    // Each chunk of the batch could be deallocated on its own.
+    pool.deallocate(mems[3]);
+    pool.check_broken();
+    mems[3] = WBE::MEM_NULL;
+    pool.deallocate_batch(mems, 8);
+    ASSERT_TRUE(pool.is_empty());
+}
+
+TEST_F(WBEAllocAlignedPoolImplicitListTest, AllocateBatchFragmented) {
+    WBE::HeapAllocatorAlignedPoolImplicitList pool(1024);
+    std::vector<WBE::MemID> mems;
+    for (int i = 0; i < 16; ++i) {
+        mems.push_back(pool.allocate(48));
+    }
+    for (size_t i = 0; i < mems.size(); i += 2) {
+        pool.deallocate(mems[i]);
+    }
+    // No idle chunk holds the whole batch, so the chunks are allocated one by one.
+    WBE::MemID batch[8];
+    pool.allocate_batch(8, 48, 16, batch);
+    pool.check_broken();
+    WBE::MemID too_many[8];
+    ASSERT_THROW(pool.allocate_batch(8, 48, 16, too_many), std::runtime_error);
+    pool.check_broken();
+    pool.deallocate_batch(batch, 8);
+    for (size_t i = 1; i < mems.size(); i += 2) {
+        pool.deallocate(mems[i]);
+    }
+    ASSERT_TRUE(pool.is_empty());
+}
+
+TEST_F(WBEAllocAlignedPoolImplicitListTest, CreateObjBatch) {
+    struct Counted {
+        Counted(int* p_alive, int p_value) : alive(p_alive), value(p_value) { ++*alive; }
+        ~Counted() { --*alive; }
+        int* alive;
+        int value;
+    };
+    int alive = 0;
+    WBE::HeapAllocatorAlignedPoolImplicitList pool(WBE_KiB(4));
+    WBE::MemID objs[16];
+    WBE::create_obj_batch<Counted>(pool, 16, objs, &alive, 7);
+    ASSERT_EQ(alive, 16);
+    for (WBE::MemID obj : objs) {
+        ASSERT_EQ(pool.get_obj<Counted>(obj)->value, 7);
+    }
+    WBE::destroy_obj_batch<Counted>(pool, objs, 16);
+    ASSERT_EQ(alive, 0);
+    ASSERT_TRUE(pool.is_empty());
+}
+
 #endif
@@ -19,9 +19,11 @@
 #include "core/allocator/heap_allocator_atomic_aligned_pool_impl_list.hh"
 #include "global/global.hh"
 #include <algorithm>
+#include <cmath>
 #include <barrier>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <gtest/gtest.h>
 #include <vector>
 #include <random>
@@ -575,4 +577,86 @@ TEST_F(WBEHeapAllocAtomicAlignedPoolImplicitListTest, ConcurrentStressWithAlignm
     ASSERT_GT(allocation_count.load(), 0);
 }
 
+TEST_F(WBEHeapAllocAtomicAlignedPoolImplicitListTest, AllocateBatch) {
+    WBE::HeapAllocatorAtomicAlignedPoolImplicitList pool(1024);
+    WBE::MemID mems[8];
+    pool.allocate_batch(8, 48, 16, mems);
+    for (size_t i = 1; i < 8; ++i) {
+        ASSERT_EQ(mems[i] - mems[i - 1], 48 + WBE::HeapAllocatorAtomicAlignedPoolImplicitList::HEADER_SIZE);
+    }
+    pool.check_broken();
+    ASSERT_EQ(pool.get_stats().allocation_count, 8);
+    WBE::MemID too_many[32];
+    ASSERT_THROW(pool.allocate_batch(32, 48, 16, too_many), std::runtime_error);
+    ASSERT_EQ(pool.get_remain_size(), 1024 - 8 * 64);
+    pool.deallocate_batch(mems, 8);
+    ASSERT_TRUE(pool.is_empty());
+}
+
+TEST_F(WBEHeapAllocAtomicAlignedPoolImplicitListTest, StatsFreeBytes) {
+    constexpr size_t HEADER_SIZE = WBE::HeapAllocatorAtomicAlignedPoolImplicitList::HEADER_SIZE;
+    WBE::HeapAllocatorAtomicAlignedPoolImplicitList pool(1024);
+    std::vector<WBE::MemID> mems;
+    for (int i = 0; i < 8; ++i) {
+        mems.push_back(pool.allocate(48));
+    }
+    for (size_t i = 0; i < mems.size(); i += 2) {
+        pool.deallocate(mems[i]);
+    }
+    WBE::AllocatorStats stats = pool.get_stats();
+    ASSERT_EQ(stats.free_bytes, pool.get_remain_size());
+    ASSERT_EQ(stats.free_bytes, 1024 - 4 * (48 + HEADER_SIZE));
+    // The largest idle block needs a walk, it is not part of the snapshot.
+    ASSERT_FALSE(stats.largest_free_block_tracked);
+    ASSERT_TRUE(std::isnan(stats.get_external_fragmentation()));
+    ASSERT_EQ(pool.get_largest_free_block(), 1024 - 8 * (48 + HEADER_SIZE));
+    WBE::MemID batch[4];
+    pool.allocate_batch(4, 48, 16, batch);
+    ASSERT_EQ(pool.get_stats().free_bytes, pool.get_remain_size());
+    pool.check_broken();
+    pool.deallocate_batch(batch, 4);
+    for (size_t i = 1; i < mems.size(); i += 2) {
+        pool.deallocate(mems[i]);
+    }
+    // The idle chunks are not coalesced yet, but they form one block.
+    ASSERT_EQ(pool.get_stats().free_bytes, 1024);
+    ASSERT_EQ(pool.get_largest_free_block(), 1024);
+    ASSERT_TRUE(pool.is_empty());
+}
+
+TEST_F(WBEHeapAllocAtomicAlignedPoolImplicitListTest, GrowableMultiThread) {
+    constexpr int NUM_THREADS = 4;
+    constexpr int ALLOCS_PER_THREAD = 512;
+    WBE::HeapAllocatorAtomicAlignedPoolImplicitList pool(WBE_KiB(4), WBE_MiB(16));
+    ASSERT_TRUE(pool.is_growable());
+    ASSERT_EQ(pool.get_committed_size(), WBE_KiB(4));
+    ASSERT_EQ(pool.get_reserved_size(), WBE_MiB(16));
+    std::vector<std::thread> threads;
+    std::vector<std::vector<WBE::MemID>> mems(NUM_THREADS);
+    for (int t = 0; t < NUM_THREADS; ++t) {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < ALLOCS_PER_THREAD; ++i) {
+                WBE::MemID mem = pool.allocate(200, 64);
+                memset(pool.get(mem), t, 200);
+                mems[t].push_back(mem);
+            }
+        });
+    }
+    for (auto& th : threads) th.join();
+    ASSERT_GT(pool.get_committed_size(), WBE_KiB(4));
+    ASSERT_LE(pool.get_committed_size(), pool.get_reserved_size());
+    pool.check_broken();
+    // Memory IDs are stable while the pool grows.
+    for (int t = 0; t < NUM_THREADS; ++t) {
+        for (WBE::MemID mem : mems[t]) {
+            ASSERT_EQ(mem % 64, 0);
+            ASSERT_EQ(*static_cast<uint8_t*>(pool.get(mem)), t);
+            pool.deallocate(mem);
+        }
+    }
+    ASSERT_TRUE(pool.is_empty());
+    ASSERT_THROW(pool.allocate(WBE_MiB(16)), std::runtime_error);
+    ASSERT_EQ(pool.get_committed_size(), WBE_MiB(16));
+}
+
 #endif
@@ -18,6 +18,7 @@
 #include "core/allocator/heap_allocator_atomic_aligned_pool.hh"
 #include "global/global.hh"
 #include <cstdlib>
+#include <cstring>
 #include <gtest/gtest.h>
 #include <thread>
 #include <vector>
@@ -224,4 +225,62 @@ TEST_F(WBEAllocAtomicAlignedPoolTest, SynchronizationDeallocationTest) {
     ASSERT_EQ(allocator.get_remain_size(), pool_size);
 }
 
+TEST_F(WBEAllocAtomicAlignedPoolTest, StatsMultiThread) {
+    constexpr int NUM_THREADS = 4;
+    constexpr int ALLOCS_PER_THREAD = 256;
+    WBE::HeapAllocatorAtomicAlignedPool allocator(WBE_MiB(1));
+    std::vector<std::thread> threads;
+    for (int t = 0; t < NUM_THREADS; ++t) {
+        threads.emplace_back([&]() {
+            for (int i = 0; i < ALLOCS_PER_THREAD; ++i) {
+                allocator.deallocate(allocator.allocate(32));
+            }
+        });
+    }
+    for (auto& th : threads) th.join();
+    WBE::AllocatorStats stats = allocator.get_stats();
+    ASSERT_EQ(stats.allocation_count, NUM_THREADS * ALLOCS_PER_THREAD);
+    ASSERT_EQ(stats.deallocation_count, NUM_THREADS * ALLOCS_PER_THREAD);
+    ASSERT_EQ(stats.live_bytes, 0);
+    ASSERT_GE(stats.peak_bytes, 32 + AAAPT_HEADER_SIZE);
+    ASSERT_EQ(stats.free_bytes, WBE_MiB(1));
+    ASSERT_EQ(stats.free_bytes, allocator.get_remain_size());
+    ASSERT_FALSE(stats.largest_free_block_tracked);
+    ASSERT_EQ(allocator.get_largest_free_block(), WBE_MiB(1));
+}
+
+TEST_F(WBEAllocAtomicAlignedPoolTest, GrowableMultiThread) {
+    constexpr int NUM_THREADS = 4;
+    constexpr int ALLOCS_PER_THREAD = 512;
+    WBE::HeapAllocatorAtomicAlignedPool pool(WBE_KiB(4), WBE_MiB(16));
+    ASSERT_TRUE(pool.is_growable());
+    ASSERT_EQ(pool.get_committed_size(), WBE_KiB(4));
+    ASSERT_EQ(pool.get_reserved_size(), WBE_MiB(16));
+    std::vector<std::thread> threads;
+    std::vector<std::vector<WBE::MemID>> mems(NUM_THREADS);
+    for (int t = 0; t < NUM_THREADS; ++t) {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < ALLOCS_PER_THREAD; ++i) {
+                WBE::MemID mem = pool.allocate(200, 64);
+                memset(pool.get(mem), t, 200);
+                mems[t].push_back(mem);
+            }
+        });
+    }
+    for (auto& th : threads) th.join();
+    ASSERT_GT(pool.get_committed_size(), WBE_KiB(4));
+    ASSERT_LE(pool.get_committed_size(), pool.get_reserved_size());
+    // Memory IDs are stable while the pool grows.
+    for (int t = 0; t < NUM_THREADS; ++t) {
+        for (WBE::MemID mem : mems[t]) {
+            ASSERT_EQ(mem % 64, 0);
+            ASSERT_EQ(*static_cast<uint8_t*>(pool.get(mem)), t);
+            pool.deallocate(mem);
+        }
+    }
+    ASSERT_TRUE(pool.is_empty());
+    ASSERT_THROW(pool.allocate(WBE_MiB(16)), std::runtime_error);
+    ASSERT_EQ(pool.get_committed_size(), WBE_MiB(16));
+}
+
 #endif
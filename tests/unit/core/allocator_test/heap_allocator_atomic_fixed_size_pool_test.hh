@@ -0,0 +1,233 @@
+/* Copyright 2025 OppositeNor
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef __WBE_HEAP_ALLOCATOR_ATOMIC_FIXED_SIZE_POOL_TEST_HH__
+#define __WBE_HEAP_ALLOCATOR_ATOMIC_FIXED_SIZE_POOL_TEST_HH__
+
+#include "core/allocator/heap_allocator_atomic_fixed_size_pool.hh"
+#include "core/memory/reference_strong.hh"
+#include "global/global.hh"
+#include "global/stl_allocator.hh"
+#include <atomic>
+#include <cstdint>
+#include <gtest/gtest.h>
+#include <list>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace WBE = WhiteBirdEngine;
+
+class WBEAllocAtomicFSPTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        global = std::make_unique<WBE::Global>(0, nullptr, WBE::Directory({"test_env"}));
+    }
+
+    void TearDown() override {
+        global.reset();
+    }
+
+    std::unique_ptr<WBE::Global> global;
+};
+
+TEST_F(WBEAllocAtomicFSPTest, Trait) {
+    ASSERT_TRUE(WBE::AllocatorTrait<WBE::HeapAllocatorAtomicFixedSizePool>::IS_POOL);
+    ASSERT_TRUE(WBE::AllocatorTrait<WBE::HeapAllocatorAtomicFixedSizePool>::IS_ALLOC_FIXED_SIZE);
+    ASSERT_TRUE(WBE::AllocatorTrait<WBE::HeapAllocatorAtomicFixedSizePool>::IS_ATOMIC);
+    ASSERT_FALSE(WBE::AllocatorTrait<WBE::HeapAllocatorAtomicFixedSizePool>::WILL_ADDR_MOVE);
+}
+
+TEST_F(WBEAllocAtomicFSPTest, AllocateAndDeallocate) {
+    WBE::HeapAllocatorAtomicFixedSizePool pool(24, 4);
+    ASSERT_EQ(static_cast<std::string>(pool), R"({"type":"HeapAllocatorAtomicFixedSizePool","size":24,"obj_count":0,"max_obj":4})");
+    WBE::MemID mems[4];
+    std::set<WBE::MemID> distinct;
+    for (auto& mem : mems) {
+        mem = pool.allocate();
+        ASSERT_TRUE(pool.is_in_pool(mem));
+        ASSERT_EQ(mem, reinterpret_cast<WBE::MemID>(pool.get(mem)));
+        ASSERT_EQ(mem % WBE::HeapAllocatorAtomicFixedSizePool::SLOT_ALIGNMENT, 0);
+        distinct.insert(mem);
+    }
+    ASSERT_EQ(distinct.size(), 4);
+    ASSERT_EQ(pool.obj_count(), 4);
+    ASSERT_THROW(pool.allocate(), std::runtime_error);
+    pool.deallocate(mems[2]);
+    // The address of the other objects does not change.
+    ASSERT_EQ(pool.allocate(), mems[2]);
+    for (auto mem : mems) {
+        pool.deallocate(mem);
+    }
+    ASSERT_TRUE(pool.is_empty());
+}
+
+TEST_F(WBEAllocAtomicFSPTest, InvalidArguments) {
+    ASSERT_THROW(WBE::HeapAllocatorAtomicFixedSizePool(8, 0), std::runtime_error);
+    WBE::HeapAllocatorAtomicFixedSizePool pool(8, 4);
+    ASSERT_THROW(pool.allocate(9), std::runtime_error);
+    WBE::MemID mem = pool.allocate(4);
+    ASSERT_THROW(pool.deallocate(mem + 1), std::runtime_error);
+    pool.deallocate(mem);
+}
+
+TEST_F(WBEAllocAtomicFSPTest, Clear) {
+    WBE::HeapAllocatorAtomicFixedSizePool pool(8, 8);
+    for (int i = 0; i < 8; ++i) {
+        pool.allocate();
+    }
+    pool.clear();
+    ASSERT_TRUE(pool.is_empty());
+    for (int i = 0; i < 8; ++i) {
+        pool.allocate();
+    }
+    ASSERT_EQ(pool.obj_count(), 8);
+    pool.clear();
+}
+
+TEST_F(WBEAllocAtomicFSPTest, BackSTLAllocator) {
+    WBE::HeapAllocatorAtomicFixedSizePool pool(64, 128);
+    using Alloc = WBE::STLAllocator<int, WBE::HeapAllocatorAtomicFixedSizePool, false, true, false>;
+    {
+        std::list<int, Alloc> list{Alloc(&pool)};
+        for (int i = 0; i < 100; ++i) {
+            list.push_back(i);
+        }
+        ASSERT_EQ(pool.obj_count(), 100);
+        int expected = 0;
+        for (int value : list) {
+            ASSERT_EQ(value, expected++);
+        }
+    }
+    ASSERT_TRUE(pool.is_empty());
+}
+
+TEST_F(WBEAllocAtomicFSPTest, BackRef) {
+    WBE::HeapAllocatorAtomicFixedSizePool pool(64, 1024);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&pool, t]() {
+            for (int i = 0; i < 1000; ++i) {
+                WBE::Ref<int, WBE::HeapAllocatorAtomicFixedSizePool> ref = WBE::make_ref<int>(&pool, t * 1000 + i);
+                WBE::Ref<int, WBE::HeapAllocatorAtomicFixedSizePool> copy = ref;
+                EXPECT_EQ(*copy, t * 1000 + i);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    ASSERT_TRUE(pool.is_empty());
+}
+
+TEST_F(WBEAllocAtomicFSPTest, Batch) {
+    WBE::HeapAllocatorAtomicFixedSizePool pool(8, 6);
+    WBE::MemID mems[6] = {};
+    pool.allocate_batch(4, mems);
+    std::set<WBE::MemID> distinct(mems, mems + 4);
+    ASSERT_EQ(distinct.size(), 4);
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_TRUE(pool.is_in_pool(mems[i]));
+    }
+    ASSERT_EQ(pool.obj_count(), 4);
+    // All or nothing.
+    WBE::MemID more[3];
+    ASSERT_THROW(pool.allocate_batch(3, more), std::runtime_error);
+    ASSERT_EQ(pool.obj_count(), 4);
+    mems[1] = WBE::MEM_NULL;
+    pool.deallocate_batch(mems, 4);
+    ASSERT_EQ(pool.obj_count(), 1);
+    ASSERT_EQ(pool.get_stats().deallocation_count, 3);
+    pool.allocate_batch(5, more);
+    ASSERT_EQ(pool.obj_count(), 6);
+    ASSERT_THROW(pool.allocate(), std::runtime_error);
+    pool.clear();
+}
+
+TEST_F(WBEAllocAtomicFSPTest, BatchMultiThread) {
+    constexpr int THREAD_COUNT = 4;
+    constexpr int ITERATIONS = 5000;
+    constexpr int BATCH_SIZE = 8;
+    WBE::HeapAllocatorAtomicFixedSizePool pool(sizeof(uint64_t), THREAD_COUNT * BATCH_SIZE);
+    std::atomic<bool> corrupted = false;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREAD_COUNT; ++t) {
+        threads.emplace_back([&, t]() {
+            WBE::MemID mems[BATCH_SIZE];
+            for (int i = 0; i < ITERATIONS; ++i) {
+                pool.allocate_batch(BATCH_SIZE, mems);
+                for (auto mem : mems) {
+                    *pool.get_obj<uint64_t>(mem) = t;
+                }
+                // No other thread should have been handed the same slots.
+                for (auto mem : mems) {
+                    if (*pool.get_obj<uint64_t>(mem) != static_cast<uint64_t>(t)) {
+                        corrupted = true;
+                    }
+                }
+                pool.deallocate_batch(mems, BATCH_SIZE);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    ASSERT_FALSE(corrupted);
+    ASSERT_TRUE(pool.is_empty());
+}
+
+TEST_F(WBEAllocAtomicFSPTest, MultiThreadStress) {
+    constexpr int THREAD_COUNT = 8;
+    constexpr int ITERATIONS = 20000;
+    constexpr int LIVE_COUNT = 16;
+    WBE::HeapAllocatorAtomicFixedSizePool pool(sizeof(uint64_t), THREAD_COUNT * LIVE_COUNT);
+    std::atomic<bool> corrupted = false;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREAD_COUNT; ++t) {
+        threads.emplace_back([&, t]() {
+            WBE::MemID live[LIVE_COUNT] = {};
+            for (int i = 0; i < ITERATIONS; ++i) {
+                int slot = i % LIVE_COUNT;
+                if (live[slot] != WBE::MEM_NULL) {
+                    // No other thread should have been handed the same slot.
+                    if (*pool.get_obj<uint64_t>(live[slot]) != static_cast<uint64_t>(t * ITERATIONS + i - LIVE_COUNT)) {
+                        corrupted = true;
+                    }
+                    pool.deallocate(live[slot]);
+                }
+                live[slot] = pool.allocate();
+                *pool.get_obj<uint64_t>(live[slot]) = t * ITERATIONS + i;
+            }
+            for (auto mem : live) {
+                pool.deallocate(mem);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    ASSERT_FALSE(corrupted);
+    ASSERT_TRUE(pool.is_empty());
+    // All the slots are back in the idle stack.
+    std::set<WBE::MemID> distinct;
+    for (int i = 0; i < THREAD_COUNT * LIVE_COUNT; ++i) {
+        distinct.insert(pool.allocate());
+    }
+    ASSERT_EQ(distinct.size(), THREAD_COUNT * LIVE_COUNT);
+    ASSERT_THROW(pool.allocate(), std::runtime_error);
+    pool.clear();
+}
+
+#endif
@@ -0,0 +1,206 @@
+/* Copyright 2025 OppositeNor
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef __WBE_HEAP_ALLOCATOR_COMPACTING_TEST_HH__
+#define __WBE_HEAP_ALLOCATOR_COMPACTING_TEST_HH__
+
+#include "core/allocator/allocator.hh"
+#include "core/allocator/growable_buffer.hh"
+#include "core/allocator/heap_allocator_compacting.hh"
+#include "global/global.hh"
+#include <cstdint>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <vector>
+
+namespace WBE = WhiteBirdEngine;
+
+class WBEAllocCompactingTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        global = std::make_unique<WBE::Global>(0, nullptr, WBE::Directory({"test_env"}));
+    }
+
+    void TearDown() override {
+        global.reset();
+    }
+
+    static void fill(WBE::HeapAllocatorCompacting& p_pool, WBE::MemID p_mem, size_t p_size, uint8_t p_value) {
+        std::memset(p_pool.get(p_mem), p_value, p_size);
+    }
+
+    static bool check(const WBE::HeapAllocatorCompacting& p_pool, WBE::MemID p_mem, size_t p_size, uint8_t p_value) {
+        const uint8_t* data = static_cast<const uint8_t*>(p_pool.get(p_mem));
+        for (size_t i = 0; i < p_size; ++i) {
+            if (data[i] != p_value) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    std::unique_ptr<WBE::Global> global;
+    static constexpr size_t HEADER_SIZE = WBE::HeapAllocatorCompacting::HEADER_SIZE;
+};
+
+TEST_F(WBEAllocCompactingTest, Trait) {
+    using Trait = WBE::AllocatorTrait<WBE::HeapAllocatorCompacting>;
+    ASSERT_TRUE(Trait::IS_POOL);
+    ASSERT_FALSE(Trait::IS_ATOMIC);
+    ASSERT_TRUE(Trait::WILL_ADDR_MOVE);
+    ASSERT_FALSE(Trait::IS_ALLOC_FIXED_SIZE);
+}
+
+TEST_F(WBEAllocCompactingTest, AllocateDeallocate) {
+    WBE::HeapAllocatorCompacting pool(1024);
+    ASSERT_EQ(pool.allocate(0), WBE::MEM_NULL);
+    ASSERT_THROW(pool.allocate(16, 32), std::runtime_error);
+    WBE::MemID mem1 = pool.allocate(10);
+    WBE::MemID mem2 = pool.allocate(32);
+    ASSERT_NE(mem1, mem2);
+    ASSERT_EQ(pool.get_allocated_data_size(mem1), 16);
+    ASSERT_EQ(pool.get_allocated_data_size(mem2), 32);
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(pool.get(mem1)) % HEADER_SIZE, 0);
+    ASSERT_EQ(pool.get_tail_size(), 1024 - 16 - 32 - 2 * HEADER_SIZE);
+    pool.deallocate(mem1);
+    ASSERT_FALSE(pool.is_in_pool(mem1));
+    ASSERT_THROW(pool.deallocate(mem1), std::runtime_error);
+    pool.deallocate(mem2);
+    ASSERT_TRUE(pool.is_empty());
+    ASSERT_TRUE(pool.is_compact());
+    ASSERT_EQ(pool.get_tail_size(), 1024);
+    ASSERT_THROW(pool.allocate(1024), std::runtime_error);
+}
+
+TEST_F(WBEAllocCompactingTest, AllocateFromGap) {
+    constexpr size_t CHUNK_SIZE = 48 + HEADER_SIZE;
+    WBE::HeapAllocatorCompacting pool(CHUNK_SIZE * 4);
+    std::vector<WBE::MemID> mems;
+    for (int i = 0; i < 4; ++i) {
+        mems.push_back(pool.allocate(48));
+    }
+    ASSERT_THROW(pool.allocate(48), std::runtime_error);
+    pool.deallocate(mems[1]);
+    pool.deallocate(mems[2]);
+    ASSERT_FALSE(pool.is_compact());
+    // The two neighbouring gaps are merged.
+    WBE::MemID large = pool.allocate(48 * 2 + HEADER_SIZE);
+    ASSERT_EQ(pool.get_allocated_data_size(large), 48 * 2 + HEADER_SIZE);
+    pool.deallocate(large);
+    pool.deallocate(mems[0]);
+    pool.deallocate(mems[3]);
+    ASSERT_TRUE(pool.is_empty());
+}
+
+TEST_F(WBEAllocCompactingTest, Defragment) {
+    WBE::HeapAllocatorCompacting pool(WBE_KiB(4));
+    std::vector<WBE::MemID> mems;
+    for (int i = 0; i < 16; ++i) {
+        mems.push_back(pool.allocate(64));
+        fill(pool, mems.back(), 64, static_cast<uint8_t>(i));
+    }
+    for (int i = 0; i < 16; i += 2) {
+        pool.deallocate(mems[i]);
+    }
+    ASSERT_FALSE(pool.is_compact());
+    WBE::AllocatorStats stats = pool.get_stats();
+    ASSERT_EQ(stats.free_bytes, WBE_KiB(4) - 8 * (64 + HEADER_SIZE));
+    // The gaps would need a walk.
+    ASSERT_FALSE(stats.largest_free_block_tracked);
+    stats.largest_free_block = pool.get_largest_free_block();
+    stats.largest_free_block_tracked = true;
+    ASSERT_EQ(stats.largest_free_block, WBE_KiB(4) - 16 * (64 + HEADER_SIZE));
+    ASSERT_GT(stats.get_external_fragmentation(), 0.0);
+    size_t moved = pool.defragment(WBE_KiB(4));
+    ASSERT_EQ(moved, 8 * (64 + HEADER_SIZE));
+    ASSERT_TRUE(pool.is_compact());
+    ASSERT_EQ(pool.get_tail_size(), WBE_KiB(4) - 8 * (64 + HEADER_SIZE));
+    stats = pool.get_stats();
+    ASSERT_EQ(stats.free_bytes, pool.get_tail_size());
+    ASSERT_TRUE(stats.largest_free_block_tracked);
+    ASSERT_EQ(stats.get_external_fragmentation(), 0.0);
+    ASSERT_EQ(stats.largest_free_block, pool.get_tail_size());
+    for (int i = 1; i < 16; i += 2) {
+        ASSERT_TRUE(check(pool, mems[i], 64, static_cast<uint8_t>(i)));
+    }
+    // Nothing left to move.
+    ASSERT_EQ(pool.defragment(WBE_KiB(4)), 0);
+    for (int i = 1; i < 16; i += 2) {
+        pool.deallocate(mems[i]);
+    }
+    ASSERT_TRUE(pool.is_empty());
+}
+
+TEST_F(WBEAllocCompactingTest, DefragmentBudget) {
+    constexpr size_t CHUNK_SIZE = 64 + HEADER_SIZE;
+    WBE::HeapAllocatorCompacting pool(WBE_KiB(4));
+    std::vector<WBE::MemID> mems;
+    for (int i = 0; i < 16; ++i) {
+        mems.push_back(pool.allocate(64));
+        fill(pool, mems.back(), 64, static_cast<uint8_t>(i));
+    }
+    for (int i = 0; i < 16; i += 2) {
+        pool.deallocate(mems[i]);
+    }
+    ASSERT_EQ(pool.defragment(0), 0);
+    size_t steps = 0;
+    while (!pool.is_compact()) {
+        size_t moved = pool.defragment(CHUNK_SIZE * 2);
+        ASSERT_LE(moved, CHUNK_SIZE * 2);
+        ++steps;
+        // The data stays valid between the steps.
+        for (int i = 1; i < 16; i += 2) {
+            ASSERT_TRUE(check(pool, mems[i], 64, static_cast<uint8_t>(i)));
+        }
+        // New allocations could be made between the steps.
+        WBE::MemID temp = pool.allocate(16);
+        pool.deallocate(temp);
+    }
+    ASSERT_GT(steps, 1);
+    ASSERT_EQ(pool.get_moved_bytes(), pool.get_moved_bytes() / CHUNK_SIZE * CHUNK_SIZE);
+    // A chunk larger than the budget is still moved alone.
+    WBE::MemID first = mems[1];
+    pool.deallocate(first);
+    ASSERT_EQ(pool.defragment(1), CHUNK_SIZE);
+    for (int i = 3; i < 16; i += 2) {
+        pool.deallocate(mems[i]);
+    }
+    ASSERT_TRUE(pool.is_empty());
+}
+
+TEST_F(WBEAllocCompactingTest, GrowableBuffer) {
+    WBE::HeapAllocatorCompacting pool(WBE_KiB(16));
+    {
+        WBE::GrowableBuffer<int, WBE::HeapAllocatorCompacting> buffer(&pool);
+        std::vector<WBE::MemID> blockers;
+        for (int i = 0; i < 256; ++i) {
+            buffer.push_back(i);
+            if (i % 32 == 0) {
+                blockers.push_back(pool.allocate(16));
+            }
+        }
+        for (auto blocker : blockers) {
+            pool.deallocate(blocker);
+        }
+        pool.defragment(WBE_KiB(16));
+        ASSERT_TRUE(pool.is_compact());
+        for (int i = 0; i < 256; ++i) {
+            ASSERT_EQ(buffer[i], i);
+        }
+    }
+    ASSERT_TRUE(pool.is_empty());
+}
+
+#endif
@@ -19,6 +19,8 @@
 #include "global/global.hh"
 #include <cstddef>
 #include <gtest/gtest.h>
+#include <stdexcept>
+#include <vector>
 
 namespace WBE = WhiteBirdEngine;
 
@@ -114,4 +116,59 @@ TEST(WBEAllocFSPTest, MemContinuity) {
 }
 
 
+TEST(WBEAllocFSPTest, DoubleDeallocateThrow) {
+    std::unique_ptr<WBE::Global> global = std::make_unique<WBE::Global>(0, nullptr, WBE::Directory({"test_env"}));
+    WBE::HeapAllocatorFixedSizePool pool(8, 4);
+    WBE::MemID mem_1 = pool.allocate();
+    WBE::MemID mem_2 = pool.allocate();
+    pool.deallocate(mem_1);
+    ASSERT_THROW(pool.deallocate(mem_1), std::runtime_error);
+    ASSERT_THROW(pool.deallocate(WBE::MEM_NULL), std::runtime_error);
+    ASSERT_THROW(pool.deallocate(5), std::runtime_error);
+    // The freed ID is reused.
+    ASSERT_EQ(pool.allocate(), mem_1);
+    pool.deallocate(mem_1);
+    pool.deallocate(mem_2);
+    ASSERT_TRUE(pool.is_empty());
+}
+
+TEST(WBEAllocFSPTest, LargePool32) {
+    std::unique_ptr<WBE::Global> global = std::make_unique<WBE::Global>(0, nullptr, WBE::Directory({"test_env"}));
+    constexpr uint32_t OBJ_COUNT = 300000;
+    ASSERT_THROW(WBE::HeapAllocatorFixedSizePool(4, OBJ_COUNT), std::runtime_error);
+    WBE::HeapAllocatorFixedSizePool32 pool(sizeof(uint32_t), OBJ_COUNT);
+    std::vector<WBE::MemID> mems;
+    mems.reserve(OBJ_COUNT);
+    for (uint32_t i = 0; i < OBJ_COUNT; ++i) {
+        mems.push_back(pool.allocate());
+        *pool.get_obj<uint32_t>(mems.back()) = i;
+    }
+    ASSERT_EQ(pool.obj_count(), OBJ_COUNT);
+    ASSERT_THROW(pool.allocate(), std::runtime_error);
+    // Free every third object, the rest should be kept dense and keep their values.
+    for (uint32_t i = 0; i < OBJ_COUNT; i += 3) {
+        pool.deallocate(mems[i]);
+    }
+    uint32_t remain = OBJ_COUNT - (OBJ_COUNT + 2) / 3;
+    ASSERT_EQ(pool.obj_count(), remain);
+    for (uint32_t i = 0; i < OBJ_COUNT; ++i) {
+        if (i % 3 != 0) {
+            ASSERT_EQ(*pool.get_obj<uint32_t>(mems[i]), i);
+            ASSERT_LT(static_cast<const char*>(pool.get(mems[i])),
+                      static_cast<const char*>(pool.get_mem_start()) + remain * sizeof(uint32_t));
+        }
+    }
+    for (uint32_t i = 0; i < OBJ_COUNT; i += 3) {
+        mems[i] = pool.allocate();
+        *pool.get_obj<uint32_t>(mems[i]) = i;
+    }
+    ASSERT_EQ(pool.obj_count(), OBJ_COUNT);
+    for (uint32_t i = 0; i < OBJ_COUNT; ++i) {
+        ASSERT_EQ(*pool.get_obj<uint32_t>(mems[i]), i);
+    }
+    pool.clear();
+    ASSERT_TRUE(pool.is_empty());
+}
+
+
 #endif
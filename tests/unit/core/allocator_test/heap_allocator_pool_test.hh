@@ -18,7 +18,12 @@
 #include "core/allocator/heap_allocator_pool.hh"
 #include "global/global.hh"
 #include "test_utilities.hh"
+#include <algorithm>
+#include <cstring>
 #include <gtest/gtest.h>
+#include <random>
+#include <stdexcept>
+#include <vector>
 
 namespace WBE = WhiteBirdEngine;
 
@@ -246,6 +251,54 @@ TEST(WBEAllocPoolTest, RemainSize) {
     ASSERT_EQ(pool.get_remain_size(), 1024);
 }
 
+TEST(WBEAllocPoolTest, GrowableCommitOnDemand) {
+    std::unique_ptr<WBE::Global> global = std::make_unique<WBE::Global>(0, nullptr, WBE::Directory({"test_env"}));
+    WBE::HeapAllocatorPool pool(WBE_KiB(4), WBE_MiB(16));
+    ASSERT_TRUE(pool.is_growable());
+    ASSERT_EQ(pool.get_committed_size(), WBE_KiB(4));
+    ASSERT_EQ(pool.get_reserved_size(), WBE_MiB(16));
+    std::vector<std::pair<WBE::MemID, uint8_t>> mems;
+    for (size_t i = 0; i < 2000; ++i) {
+        WBE::MemID mem = pool.allocate(999);
+        memset(pool.get(mem), i & 0xFF, 999);
+        mems.emplace_back(mem, i & 0xFF);
+    }
+    ASSERT_GT(pool.get_committed_size(), WBE_KiB(4));
+    ASSERT_LE(pool.get_committed_size(), pool.get_reserved_size());
+    // Memory IDs are stable while the pool grows.
+    for (auto& mem : mems) {
+        ASSERT_EQ(*static_cast<uint8_t*>(pool.get(mem.first)), mem.second);
+        pool.deallocate(mem.first);
+    }
+    ASSERT_TRUE(pool.is_empty());
+    ASSERT_THROW(pool.allocate(WBE_MiB(16)), std::runtime_error);
+    ASSERT_EQ(pool.get_committed_size(), WBE_MiB(16));
+}
+
+TEST(WBEAllocPoolTest, Batch) {
+    std::unique_ptr<WBE::Global> global = std::make_unique<WBE::Global>(0, nullptr, WBE::Directory({"test_env"}));
+    WBE::HeapAllocatorPool pool(1024);
+    WBE::MemID mems[4];
+    pool.allocate_batch(4, 40, mems);
+    // Carved next to each other.
+    for (int i = 1; i < 4; ++i) {
+        ASSERT_EQ(mems[i], mems[i - 1] + 40 + APT_HEADER_SIZE);
+    }
+    ASSERT_EQ(pool.get_remain_size(), 1024 - 4 * (40 + APT_HEADER_SIZE));
+    ASSERT_EQ(pool.get_stats().allocation_count, 4);
+    WBE::MemID too_many[16];
+    ASSERT_THROW(pool.allocate_batch(16, 100, too_many), std::runtime_error);
+    ASSERT_EQ(pool.get_remain_size(), 1024 - 4 * (40 + APT_HEADER_SIZE));
+    pool.deallocate_batch(mems, 4);
+    ASSERT_TRUE(pool.is_empty());
+    // The rest of the pool is too small for an idle chunk, the last chunk keeps it.
+    pool.allocate_batch(4, 238, mems);
+    ASSERT_EQ(pool.get_remain_size(), 0);
+    ASSERT_EQ(pool.get_allocated_data_size(mems[3]), 1024 - 3 * (238 + APT_HEADER_SIZE));
+    pool.deallocate_batch(mems, 4);
+    ASSERT_TRUE(pool.is_empty());
+}
+
 TEST(WBEAllocPoolTest, ConstructDestructCall) {
     std::unique_ptr<WBE::Global> global = std::make_unique<WBE::Global>(0, nullptr, WBE::Directory({"test_env"}));
     uint32_t test_val = 0;
@@ -357,4 +410,38 @@ TEST(WBEAllocPoolTest, MaxDataSizeTracker) {
     ASSERT_EQ(allocator.get_max_data_size(), 300 + 2 * APT_HEADER_SIZE);
 }
 
+TEST(WBEAllocPoolTest, StressRandomAllocDealloc) {
+    std::unique_ptr<WBE::Global> global = std::make_unique<WBE::Global>(0, nullptr, WBE::Directory({"test_env"}));
+    WBE::HeapAllocatorPool pool(WBE_KiB(64));
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<size_t> size_dist(1, 300);
+    std::vector<std::pair<WBE::MemID, size_t>> mems;
+    for (int i = 0; i < 5000; ++i) {
+        if (mems.empty() || rng() % 3 != 0) {
+            size_t alloc_size = size_dist(rng);
+            WBE::MemID mem = WBE::MEM_NULL;
+            try {
+                mem = pool.allocate(alloc_size);
+            }
+            catch (const std::runtime_error&) {
+                continue;
+            }
+            memset(pool.get(mem), i & 0xFF, alloc_size);
+            mems.emplace_back(mem, alloc_size);
+        }
+        else {
+            size_t idx = rng() % mems.size();
+            ASSERT_GE(pool.get_allocated_data_size(mems[idx].first), mems[idx].second + APT_HEADER_SIZE);
+            pool.deallocate(mems[idx].first);
+            mems.erase(mems.begin() + idx);
+        }
+    }
+    std::shuffle(mems.begin(), mems.end(), rng);
+    for (auto& mem : mems) {
+        pool.deallocate(mem.first);
+    }
+    ASSERT_TRUE(pool.is_empty());
+    ASSERT_EQ(pool.get_remain_size(), WBE_KiB(64));
+}
+
 #endif
@@ -0,0 +1,222 @@
+/* Copyright 2025 OppositeNor
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef __WBE_HEAP_ALLOCATOR_THREAD_CACHE_TEST_HH__
+#define __WBE_HEAP_ALLOCATOR_THREAD_CACHE_TEST_HH__
+
+#include "core/allocator/heap_allocator_atomic_aligned_pool.hh"
+#include "core/allocator/heap_allocator_thread_cache.hh"
+#include "global/global.hh"
+#include <cstring>
+#include <gtest/gtest.h>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace WBE = WhiteBirdEngine;
+
+class WBEAllocThreadCacheTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        global = std::make_unique<WBE::Global>(0, nullptr, WBE::Directory({"test_env"}));
+    }
+
+    void TearDown() override {
+        global.reset();
+    }
+
+    std::unique_ptr<WBE::Global> global;
+};
+
+TEST_F(WBEAllocThreadCacheTest, TraitTest) {
+    ASSERT_TRUE(WBE::AllocatorTrait<WBE::HeapAllocatorThreadCache>::IS_POOL);
+    ASSERT_TRUE(WBE::AllocatorTrait<WBE::HeapAllocatorThreadCache>::IS_ATOMIC);
+    ASSERT_FALSE(WBE::AllocatorTrait<WBE::HeapAllocatorThreadCache>::WILL_ADDR_MOVE);
+}
+
+TEST_F(WBEAllocThreadCacheTest, SizeClass) {
+    using Cache = WBE::HeapAllocatorThreadCache;
+    ASSERT_EQ(Cache::get_size_class(1), 0);
+    ASSERT_EQ(Cache::get_size_class(16), 0);
+    ASSERT_EQ(Cache::get_size_class(17), 1);
+    ASSERT_EQ(Cache::get_size_class(129), 8);
+    ASSERT_EQ(Cache::get_size_class(Cache::MAX_CACHED_SIZE), Cache::SIZE_CLASS_COUNT - 1);
+    for (size_t size = 1; size <= Cache::MAX_CACHED_SIZE; ++size) {
+        size_t size_class = Cache::get_size_class(size);
+        ASSERT_GE(Cache::SIZE_CLASSES[size_class], size);
+        if (size_class > 0) {
+            ASSERT_LT(Cache::SIZE_CLASSES[size_class - 1], size);
+        }
+    }
+}
+
+TEST_F(WBEAllocThreadCacheTest, AllocateFromCache) {
+    WBE::HeapAllocatorAtomicAlignedPool pool(WBE_MiB(1));
+    WBE::HeapAllocatorThreadCache cache(&pool);
+    WBE::MemID mem1 = cache.allocate(24);
+    ASSERT_NE(mem1, WBE::MEM_NULL);
+    ASSERT_EQ(mem1 % WBE_DEFAULT_ALIGNMENT, 0);
+    ASSERT_EQ(cache.get_allocated_data_size(mem1), 32);
+    // The refill took a whole batch from the pool.
+    size_t batch_count = WBE::HeapAllocatorThreadCache::get_batch_count(1);
+    ASSERT_EQ(cache.get_cached_size(), (batch_count - 1) * 32);
+    WBE::MemID mem2 = cache.allocate(32);
+    ASSERT_EQ(cache.get_cached_size(), (batch_count - 2) * 32);
+    memset(cache.get(mem1), 0xFF, 24);
+    memset(cache.get(mem2), 0xFF, 32);
+    ASSERT_FALSE(cache.is_empty());
+    cache.deallocate(mem1);
+    cache.deallocate(mem2);
+    ASSERT_TRUE(cache.is_empty());
+    ASSERT_EQ(cache.get_cached_size(), batch_count * 32);
+    ASSERT_EQ(cache.allocate(32), mem2);
+    cache.deallocate(mem2);
+    cache.flush();
+    ASSERT_EQ(cache.get_cached_size(), 0);
+    ASSERT_EQ(pool.get_remain_size(), WBE_MiB(1));
+}
+
+TEST_F(WBEAllocThreadCacheTest, DirectAllocation) {
+    WBE::HeapAllocatorAtomicAlignedPool pool(WBE_MiB(1));
+    WBE::HeapAllocatorThreadCache cache(&pool);
+    WBE::MemID large = cache.allocate(WBE::HeapAllocatorThreadCache::MAX_CACHED_SIZE + 1);
+    WBE::MemID aligned = cache.allocate(40, 64);
+    ASSERT_EQ(aligned % 64, 0);
+    ASSERT_EQ(cache.get_cached_size(), 0);
+    cache.deallocate(large);
+    ASSERT_EQ(cache.get_cached_size(), 0);
+    // The aligned chunk matches a size class, so it goes to the cache.
+    cache.deallocate(aligned);
+    ASSERT_TRUE(cache.is_empty());
+    cache.flush();
+    ASSERT_EQ(pool.get_remain_size(), WBE_MiB(1));
+    ASSERT_THROW(cache.allocate(8, 0), std::runtime_error);
+    ASSERT_THROW(cache.allocate(8, 12), std::runtime_error);
+}
+
+TEST_F(WBEAllocThreadCacheTest, BinOverflowFlush) {
+    WBE::HeapAllocatorAtomicAlignedPool pool(WBE_MiB(1));
+    WBE::HeapAllocatorThreadCache cache(&pool);
+    constexpr size_t SIZE_CLASS = 3;
+    constexpr size_t CHUNK_SIZE = WBE::HeapAllocatorThreadCache::SIZE_CLASSES[SIZE_CLASS];
+    size_t batch_count = WBE::HeapAllocatorThreadCache::get_batch_count(SIZE_CLASS);
+    std::vector<WBE::MemID> mems;
+    for (size_t i = 0; i < 4 * batch_count; ++i) {
+        mems.push_back(cache.allocate(CHUNK_SIZE));
+    }
+    for (auto mem : mems) {
+        cache.deallocate(mem);
+    }
+    // The bin never holds more than twice the batch count.
+    ASSERT_LE(cache.get_cached_size(), 2 * batch_count * CHUNK_SIZE);
+    cache.flush();
+    ASSERT_EQ(pool.get_remain_size(), WBE_MiB(1));
+}
+
+TEST_F(WBEAllocThreadCacheTest, RefillWhenPoolNearlyFull) {
+    WBE::HeapAllocatorAtomicAlignedPool pool(WBE_KiB(1));
+    WBE::HeapAllocatorThreadCache cache(&pool);
+    // Cache a batch of small chunks, then ask for a larger size class with little space left.
+    WBE::MemID small = cache.allocate(16);
+    WBE::MemID large = cache.allocate(256);
+    ASSERT_NE(large, WBE::MEM_NULL);
+    cache.deallocate(small);
+    cache.deallocate(large);
+    std::vector<WBE::MemID> mems;
+    ASSERT_THROW(while (true) { mems.push_back(cache.allocate(512)); }, std::runtime_error);
+    for (auto mem : mems) {
+        cache.deallocate(mem);
+    }
+    cache.flush();
+    ASSERT_EQ(pool.get_remain_size(), WBE_KiB(1));
+}
+
+TEST_F(WBEAllocThreadCacheTest, CrossThreadDeallocate) {
+    WBE::HeapAllocatorAtomicAlignedPool pool(WBE_MiB(1));
+    WBE::HeapAllocatorThreadCache cache(&pool);
+    std::vector<WBE::MemID> mems;
+    std::thread producer([&]() {
+        for (size_t i = 0; i < 256; ++i) {
+            mems.push_back(cache.allocate(64));
+        }
+    });
+    producer.join();
+    // The cache of the exited thread is returned to the pool.
+    ASSERT_EQ(cache.get_thread_cache_count(), 0);
+    ASSERT_FALSE(cache.is_empty());
+    for (auto mem : mems) {
+        cache.deallocate(mem);
+    }
+    ASSERT_TRUE(cache.is_empty());
+    cache.flush_all();
+    ASSERT_EQ(pool.get_remain_size(), WBE_MiB(1));
+}
+
+TEST_F(WBEAllocThreadCacheTest, MultiThreadStress) {
+    WBE::HeapAllocatorAtomicAlignedPool pool(WBE_MiB(32));
+    WBE::HeapAllocatorThreadCache cache(&pool);
+    constexpr int THREAD_COUNT = 8;
+    constexpr int ITERATIONS = 2000;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREAD_COUNT; ++t) {
+        threads.emplace_back([&, t]() {
+            std::mt19937 rng(t);
+            std::uniform_int_distribution<size_t> size_dist(1, 1536);
+            std::vector<std::pair<WBE::MemID, size_t>> mems;
+            for (int i = 0; i < ITERATIONS; ++i) {
+                size_t size = size_dist(rng);
+                WBE::MemID mem = cache.allocate(size);
+                memset(cache.get(mem), t, size);
+                mems.emplace_back(mem, size);
+                if (i % 3 != 0) {
+                    size_t idx = rng() % mems.size();
+                    auto [freed, freed_size] = mems[idx];
+                    auto* data = static_cast<unsigned char*>(cache.get(freed));
+                    EXPECT_EQ(data[0], t);
+                    EXPECT_EQ(data[freed_size - 1], t);
+                    cache.deallocate(freed);
+                    mems[idx] = mems.back();
+                    mems.pop_back();
+                }
+            }
+            for (auto& mem : mems) {
+                cache.deallocate(mem.first);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    ASSERT_TRUE(cache.is_empty());
+    ASSERT_EQ(cache.get_cached_size(), 0);
+    ASSERT_EQ(pool.get_remain_size(), WBE_MiB(32));
+}
+
+TEST_F(WBEAllocThreadCacheTest, BackingPoolBatch) {
+    WBE::HeapAllocatorAtomicAlignedPool pool(WBE_KiB(1));
+    WBE::MemID mems[8];
+    pool.allocate_batch(8, 48, WBE_DEFAULT_ALIGNMENT, mems);
+    for (size_t i = 1; i < 8; ++i) {
+        // Chunks of a batch are adjacent.
+        ASSERT_EQ(mems[i] - mems[i - 1], 48 + WBE::HeapAllocatorAtomicAlignedPool::HEADER_SIZE);
+    }
+    WBE::MemID too_many[32];
+    ASSERT_THROW(pool.allocate_batch(32, 48, WBE_DEFAULT_ALIGNMENT, too_many), std::runtime_error);
+    ASSERT_EQ(pool.get_remain_size(), WBE_KiB(1) - 8 * 64);
+    pool.deallocate_batch(mems, 8);
+    ASSERT_EQ(pool.get_remain_size(), WBE_KiB(1));
+}
+
+#endif
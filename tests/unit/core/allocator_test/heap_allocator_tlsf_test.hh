@@ -0,0 +1,387 @@
+/* Copyright 2025 OppositeNor
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef __WBE_HEAP_ALLOCATOR_TLSF_TEST_HH__
+#define __WBE_HEAP_ALLOCATOR_TLSF_TEST_HH__
+
+#include "core/allocator/allocator.hh"
+#include "core/allocator/heap_allocator_tlsf.hh"
+#include "global/global.hh"
+#include "platform/os/os.hh"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <vector>
+#include <random>
+
+namespace WBE = WhiteBirdEngine;
+
+class WBEAllocTLSFTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        global = std::make_unique<WBE::Global>(0, nullptr, WBE::Directory({"test_env"}));
+    }
+
+    void TearDown() override {
+        global.reset();
+    }
+
+    std::unique_ptr<WBE::Global> global;
+    static constexpr size_t TLSFT_HEADER_SIZE = WBE::HeapAllocatorTLSF::HEADER_SIZE;
+};
+
+TEST_F(WBEAllocTLSFTest, Trait) {
+    using Trait = WBE::AllocatorTrait<WBE::HeapAllocatorTLSF>;
+    ASSERT_TRUE(Trait::IS_POOL);
+    ASSERT_FALSE(Trait::IS_ATOMIC);
+    ASSERT_FALSE(Trait::WILL_ADDR_MOVE);
+    ASSERT_FALSE(Trait::IS_ALLOC_FIXED_SIZE);
+    ASSERT_TRUE(Trait::IS_ALIGNABLE);
+}
+
+TEST_F(WBEAllocTLSFTest, IsInPoolAllocatedAndDeallocated) {
+    WBE::HeapAllocatorTLSF pool(1024);
+    ASSERT_EQ(pool.get_total_size(), 1024);
+    WBE::MemID mem1 = pool.allocate(16);
+    WBE::MemID mem2 = pool.allocate(16);
+    ASSERT_TRUE(pool.is_in_pool(mem1));
+    ASSERT_TRUE(pool.is_in_pool(mem2));
+    ASSERT_GE(pool.get_allocated_data_size(mem1), 16);
+    ASSERT_GE(pool.get_allocated_data_size(mem2), 16);
+    pool.deallocate(mem1);
+    ASSERT_FALSE(pool.is_in_pool(mem1));
+    ASSERT_TRUE(pool.is_in_pool(mem2));
+    pool.deallocate(mem2);
+    ASSERT_FALSE(pool.is_in_pool(mem2));
+    ASSERT_TRUE(pool.is_empty());
+}
+
+TEST_F(WBEAllocTLSFTest, InvalidPoolSizeThrow) {
+    ASSERT_THROW(WBE::HeapAllocatorTLSF pool(WBE::HeapAllocatorTLSF::MAX_TOTAL_SIZE + 1), std::runtime_error);
+    ASSERT_THROW(WBE::HeapAllocatorTLSF pool(UINT64_MAX), std::runtime_error);
+    ASSERT_THROW(WBE::HeapAllocatorTLSF pool(WBE::HeapAllocatorTLSF::MIN_CHUNK_SIZE - 1), std::runtime_error);
+}
+
+TEST_F(WBEAllocTLSFTest, ZeroSizeAllocation) {
+    WBE::HeapAllocatorTLSF pool(128);
+    WBE::MemID mem = pool.allocate(0);
+    ASSERT_EQ(mem, WBE::MEM_NULL);
+    ASSERT_EQ(pool.get_remain_size(), 128);
+}
+
+TEST_F(WBEAllocTLSFTest, AlignmentTest) {
+    WBE::HeapAllocatorTLSF allocator(WBE_MiB(0.5));
+    constexpr size_t ALIGN_REQ = 8;
+    std::vector<WBE::MemID> mems;
+    for (size_t i = 1; i <= 10; ++i) {
+        WBE::MemID mem = allocator.allocate(1, ALIGN_REQ * i);
+        ASSERT_EQ(mem % (ALIGN_REQ * i), 0);
+        mems.push_back(mem);
+    }
+
+    // False alignments
+    ASSERT_THROW(allocator.allocate(3, 0), std::runtime_error);
+    ASSERT_THROW(allocator.allocate(3, ALIGN_REQ * 2 + 1), std::runtime_error);
+
+    for (WBE::MemID mem : mems) {
+        allocator.deallocate(mem);
+    }
+    ASSERT_EQ(allocator.get_remain_size(), WBE_MiB(0.5));
+    ASSERT_NO_THROW(allocator.check_broken());
+}
+
+TEST_F(WBEAllocTLSFTest, MaxAlignmentAllocation) {
+    WBE::HeapAllocatorTLSF pool(512);
+    WBE::MemID mem = pool.allocate(8, 128);
+    ASSERT_NE(mem, WBE::MEM_NULL);
+    ASSERT_EQ(mem % 128, 0);
+    pool.deallocate(mem);
+    ASSERT_EQ(pool.get_remain_size(), 512);
+    ASSERT_EQ(pool.get_max_free_size(), 512 - TLSFT_HEADER_SIZE);
+}
+
+TEST_F(WBEAllocTLSFTest, ShouldThrowIfNoMoreSpaceLeft) {
+    WBE::HeapAllocatorTLSF pool(256);
+    std::vector<WBE::MemID> allocated;
+    while (pool.get_max_free_size() >= 8) {
+        allocated.push_back(pool.allocate(8));
+    }
+    ASSERT_THROW(pool.allocate(8), std::runtime_error);
+    while (!allocated.empty()) {
+        pool.deallocate(allocated.back());
+        allocated.pop_back();
+    }
+    ASSERT_EQ(pool.get_remain_size(), 256);
+}
+
+TEST_F(WBEAllocTLSFTest, FragmentationAndCoalescing) {
+    WBE::HeapAllocatorTLSF pool(1024);
+    WBE::MemID mem1 = pool.allocate(16);
+    WBE::MemID mem2 = pool.allocate(16);
+    WBE::MemID mem3 = pool.allocate(16);
+    pool.deallocate(mem2);
+    ASSERT_LT(pool.get_remain_size(), 1024);
+    pool.deallocate(mem1);
+    ASSERT_NO_THROW(pool.check_broken());
+    pool.deallocate(mem3);
+    ASSERT_EQ(pool.get_remain_size(), 1024);
+    // All chunks should be merged back into one.
+    ASSERT_EQ(pool.get_max_free_size(), 1024 - TLSFT_HEADER_SIZE);
+}
+
+TEST_F(WBEAllocTLSFTest, SmallAllocationThenBigAllocation) {
+    WBE::HeapAllocatorTLSF pool(1024);
+    std::vector<WBE::MemID> allocated;
+    while (pool.get_max_free_size() >= 8) {
+        allocated.push_back(pool.allocate(8));
+    }
+    // Free every other chunk first, so no neighbours are merged.
+    for (size_t i = 0; i < allocated.size(); i += 2) {
+        pool.deallocate(allocated[i]);
+    }
+    ASSERT_THROW(pool.allocate(128), std::runtime_error);
+    for (size_t i = 1; i < allocated.size(); i += 2) {
+        pool.deallocate(allocated[i]);
+    }
+    WBE::MemID mem = pool.allocate(512);
+    memset(pool.get(mem), 0, 512);
+    pool.deallocate(mem);
+    ASSERT_NO_THROW(pool.check_broken());
+}
+
+TEST_F(WBEAllocTLSFTest, PoolReuseAfterClear) {
+    WBE::HeapAllocatorTLSF pool(128);
+    pool.allocate(32);
+    pool.clear();
+    ASSERT_EQ(pool.get_remain_size(), 128);
+    WBE::MemID mem = pool.allocate(64);
+    ASSERT_NE(mem, WBE::MEM_NULL);
+    pool.deallocate(mem);
+    ASSERT_EQ(pool.get_remain_size(), 128);
+}
+
+TEST_F(WBEAllocTLSFTest, LargeSizeClasses) {
+    WBE::HeapAllocatorTLSF pool(WBE_MiB(4));
+    WBE::MemID mem1 = pool.allocate(WBE_MiB(1));
+    WBE::MemID mem2 = pool.allocate(WBE_KiB(300));
+    WBE::MemID mem3 = pool.allocate(WBE_MiB(2));
+    ASSERT_GE(pool.get_allocated_data_size(mem1), WBE_MiB(1));
+    ASSERT_GE(pool.get_allocated_data_size(mem2), WBE_KiB(300));
+    ASSERT_GE(pool.get_allocated_data_size(mem3), WBE_MiB(2));
+    pool.deallocate(mem1);
+    WBE::MemID mem4 = pool.allocate(WBE_KiB(900));
+    ASSERT_EQ(mem4, mem1);
+    pool.deallocate(mem2);
+    pool.deallocate(mem3);
+    pool.deallocate(mem4);
+    ASSERT_EQ(pool.get_remain_size(), WBE_MiB(4));
+}
+
+TEST_F(WBEAllocTLSFTest, StressAllocateWithAlignTest) {
+    WBE::HeapAllocatorTLSF pool(WBE_MiB(4));
+    constexpr int STRESS_ITERATIONS = 2000;
+    std::mt19937 rng(300);
+    std::uniform_int_distribution<int> size_dist(1, 4096);
+    std::vector<size_t> alignments = {1, 2, 4, 8, 16, 32, 64};
+    std::uniform_int_distribution<size_t> align_dist(0, alignments.size() - 1);
+
+    std::vector<std::pair<WBE::MemID, int>> mems;
+    for (int j = 0; j < STRESS_ITERATIONS; ++j) {
+        int size = size_dist(rng);
+        size_t alignment = alignments[align_dist(rng)] * 8;
+        WBE::MemID mem = pool.allocate(size, alignment);
+        ASSERT_NE(mem, WBE::MEM_NULL);
+        ASSERT_EQ(mem % alignment, 0);
+        ASSERT_GE(pool.get_allocated_data_size(mem), size);
+        memset(pool.get(mem), j & 0xFF, size);
+        mems.emplace_back(mem, size);
+
+        if (j % 3 == 0) {
+            std::uniform_int_distribution<size_t> idx_dist(0, mems.size() - 1);
+            size_t idx = idx_dist(rng);
+            pool.deallocate(mems[idx].first);
+            mems.erase(mems.begin() + idx);
+        }
+    }
+    ASSERT_NO_THROW(pool.check_broken());
+    std::shuffle(mems.begin(), mems.end(), rng);
+    for (auto& mem : mems) {
+        pool.deallocate(mem.first);
+    }
+    ASSERT_EQ(pool.get_remain_size(), WBE_MiB(4));
+    ASSERT_EQ(pool.get_max_free_size(), WBE_MiB(4) - TLSFT_HEADER_SIZE);
+}
+
+TEST_F(WBEAllocTLSFTest, GrowableCommitOnDemand) {
+    WBE::HeapAllocatorTLSF pool(WBE_KiB(4), WBE_MiB(64));
+    ASSERT_TRUE(pool.is_growable());
+    ASSERT_EQ(pool.get_committed_size(), WBE_KiB(4));
+    ASSERT_EQ(pool.get_reserved_size(), WBE_MiB(64));
+    std::vector<std::pair<WBE::MemID, uint8_t>> mems;
+    for (size_t i = 0; i < 2000; ++i) {
+        WBE::MemID mem = pool.allocate(1000);
+        memset(pool.get(mem), i & 0xFF, 1000);
+        mems.emplace_back(mem, i & 0xFF);
+    }
+    ASSERT_GT(pool.get_committed_size(), WBE_KiB(4));
+    ASSERT_LE(pool.get_committed_size(), pool.get_reserved_size());
+    ASSERT_EQ(pool.get_total_size(), pool.get_committed_size());
+    ASSERT_NO_THROW(pool.check_broken());
+    // Memory IDs are stable while the pool grows.
+    for (auto& mem : mems) {
+        ASSERT_EQ(*static_cast<uint8_t*>(pool.get(mem.first)), mem.second);
+        pool.deallocate(mem.first);
+    }
+    ASSERT_TRUE(pool.is_empty());
+    ASSERT_EQ(pool.get_max_free_size(), pool.get_committed_size() - TLSFT_HEADER_SIZE);
+}
+
+TEST_F(WBEAllocTLSFTest, GrowableThrowWhenReservationUsedUp) {
+    WBE::HeapAllocatorTLSF pool(WBE_KiB(4), WBE_KiB(64));
+    WBE::MemID mem = pool.allocate(WBE_KiB(32), 128);
+    ASSERT_EQ(mem % 128, 0);
+    ASSERT_THROW(pool.allocate(WBE_KiB(64)), std::runtime_error);
+    ASSERT_EQ(pool.get_committed_size(), WBE_KiB(64));
+    pool.deallocate(mem);
+    ASSERT_TRUE(pool.is_empty());
+    mem = pool.allocate(WBE_KiB(60));
+    ASSERT_NE(mem, WBE::MEM_NULL);
+    pool.deallocate(mem);
+    ASSERT_NO_THROW(pool.check_broken());
+}
+
+TEST_F(WBEAllocTLSFTest, GrowableInvalidReserveThrow) {
+    ASSERT_THROW(WBE::HeapAllocatorTLSF(WBE_KiB(64), WBE_KiB(4)), std::runtime_error);
+}
+
+TEST_F(WBEAllocTLSFTest, HugePages) {
+    WBE::HeapAllocatorTLSF pool(WBE_KiB(64), 0, true);
+    ASSERT_FALSE(pool.is_growable());
+    ASSERT_EQ(pool.get_total_size() % WBE::OS::get_huge_page_size(), 0);
+    WBE::MemID mem = pool.allocate(WBE_KiB(128), 64);
+    ASSERT_EQ(mem % 64, 0);
+    memset(pool.get(mem), 0xFF, WBE_KiB(128));
+    pool.deallocate(mem);
+    ASSERT_EQ(pool.get_max_free_size(), pool.get_total_size() - TLSFT_HEADER_SIZE);
+    ASSERT_NE(static_cast<std::string>(pool).find(WBE::get_page_backing_name(pool.get_page_backing())), std::string::npos);
+}
+
+TEST_F(WBEAllocTLSFTest, Stats) {
+    WBE::HeapAllocatorTLSF pool(WBE_KiB(4));
+    WBE::MemID mem1 = pool.allocate(64);
+    WBE::MemID mem2 = pool.allocate(64);
+    WBE::AllocatorStats stats = pool.get_stats();
+    ASSERT_EQ(stats.allocation_count, 2);
+    ASSERT_EQ(stats.deallocation_count, 0);
+    ASSERT_EQ(stats.live_bytes, pool.get_total_size() - pool.get_remain_size());
+    ASSERT_EQ(stats.free_bytes, pool.get_remain_size());
+    ASSERT_TRUE(stats.largest_free_block_tracked);
+    ASSERT_EQ(stats.largest_free_block, pool.get_max_free_size() + TLSFT_HEADER_SIZE);
+    ASSERT_THROW(pool.allocate(WBE_KiB(8)), std::runtime_error);
+    pool.deallocate(mem1);
+    pool.deallocate(mem2);
+    stats = pool.get_stats();
+    ASSERT_EQ(stats.deallocation_count, 2);
+    ASSERT_EQ(stats.failed_allocation_count, 1);
+    ASSERT_EQ(stats.live_bytes, 0);
+    ASSERT_GT(stats.peak_bytes, 128);
+    ASSERT_EQ(stats.get_external_fragmentation(), 0.0);
+    ASSERT_NE(static_cast<std::string>(stats).find("\"peak_bytes\":" + std::to_string(stats.peak_bytes)), std::string::npos);
+}
+
+TEST_F(WBEAllocTLSFTest, TryExpandInPlace) {
+    WBE::HeapAllocatorTLSF pool(WBE_KiB(4));
+    WBE::MemID mem1 = pool.allocate(32);
+    WBE::MemID mem2 = pool.allocate(32);
+    memset(pool.get(mem1), 0xAB, 32);
+    pool.deallocate(mem2);
+    ASSERT_TRUE(pool.try_expand(mem1, 512));
+    ASSERT_GE(pool.get_allocated_data_size(mem1), 512);
+    ASSERT_EQ(static_cast<unsigned char*>(pool.get(mem1))[31], 0xAB);
+    pool.check_broken();
+    WBE::MemID mem3 = pool.allocate(32);
+    ASSERT_FALSE(pool.try_expand(mem1, 1024));
+    size_t remain_size = pool.get_remain_size();
+    // Shrinking releases the tail.
+    ASSERT_TRUE(pool.try_expand(mem1, 64));
+    ASSERT_EQ(pool.get_allocated_data_size(mem1), 64);
+    ASSERT_EQ(pool.get_remain_size(), remain_size + 512 - 64);
+    pool.check_broken();
+    WBE::AllocatorStats stats = pool.get_stats();
+    ASSERT_EQ(stats.live_bytes, pool.get_total_size() - pool.get_remain_size());
+    // Too small a tail to form a chunk is kept.
+    ASSERT_TRUE(pool.try_expand(mem1, 48));
+    ASSERT_EQ(pool.get_allocated_data_size(mem1), 64);
+    pool.deallocate(mem1);
+    pool.deallocate(mem3);
+    ASSERT_TRUE(pool.is_empty());
+}
+
+TEST_F(WBEAllocTLSFTest, Reallocate) {
+    WBE::HeapAllocatorTLSF pool(WBE_KiB(4));
+    WBE::MemID mem1 = pool.allocate(32);
+    WBE::MemID mem2 = pool.allocate(32);
+    for (int i = 0; i < 32; ++i) {
+        static_cast<char*>(pool.get(mem1))[i] = static_cast<char>(i);
+    }
+    WBE::MemID moved = pool.reallocate(mem1, 256);
+    ASSERT_NE(moved, mem1);
+    for (int i = 0; i < 32; ++i) {
+        ASSERT_EQ(static_cast<char*>(pool.get(moved))[i], static_cast<char>(i));
+    }
+    ASSERT_EQ(pool.reallocate(moved, 1024), moved);
+    pool.deallocate(moved);
+    pool.deallocate(mem2);
+    ASSERT_TRUE(pool.is_empty());
+}
+
+TEST_F(WBEAllocTLSFTest, GrowableTryExpandAtEnd) {
+    WBE::HeapAllocatorTLSF pool(WBE_KiB(4), WBE_MiB(1));
+    WBE::MemID mem = pool.allocate(pool.get_max_free_size());
+    ASSERT_TRUE(pool.try_expand(mem, WBE_KiB(64)));
+    ASSERT_GT(pool.get_committed_size(), WBE_KiB(64));
+    memset(pool.get(mem), 0xFF, WBE_KiB(64));
+    pool.check_broken();
+    ASSERT_FALSE(pool.try_expand(mem, WBE_MiB(2)));
+    pool.deallocate(mem);
+    ASSERT_TRUE(pool.is_empty());
+}
+
+TEST_F(WBEAllocTLSFTest, AllocateBatchCarvesNeighbours) {
+    WBE::HeapAllocatorTLSF pool(WBE_KiB(4));
+    WBE::MemID mems[8];
+    pool.allocate_batch(8, 48, 64, mems);
+    for (size_t i = 0; i < 8; ++i) {
+        ASSERT_EQ(mems[i] % 64, 0);
+        if (i > 0) {
+            ASSERT_EQ(mems[i] - mems[i - 1], 64);
+        }
+    }
+    pool.check_broken();
+    WBE::AllocatorStats stats = pool.get_stats();
+    ASSERT_EQ(stats.allocation_count, 8);
+    ASSERT_EQ(stats.live_bytes, pool.get_total_size() - pool.get_remain_size());
+    pool.deallocate(mems[0]);
+    mems[0] = WBE::MEM_NULL;
+    pool.deallocate_batch(mems, 8);
+    ASSERT_TRUE(pool.is_empty());
+    WBE::MemID too_many[128];
+    ASSERT_THROW(pool.allocate_batch(128, 48, 16, too_many), std::runtime_error);
+    ASSERT_TRUE(pool.is_empty());
+}
+
+#endif
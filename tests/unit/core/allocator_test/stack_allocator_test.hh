@@ -16,6 +16,9 @@
 #define __WBE_STACK_ALLOCATOR_TEST_HH__
 
 #include "core/allocator/stack_allocator.hh"
+#include "platform/os/os.hh"
+#include <cstring>
+#include <string>
 #include <gtest/gtest.h>
 
 namespace WBE = WhiteBirdEngine;
@@ -292,4 +295,15 @@ TEST(StackAllocator, EdgeCases) {
     ASSERT_GE(allocator.get_alloc_size(), allocator.get_total_size());
 }
 
+TEST(StackAllocator, HugePages) {
+    WBE::StackAllocator allocator(WBE_KiB(64), true);
+    ASSERT_GE(allocator.get_total_size(), WBE_KiB(64));
+    ASSERT_EQ(allocator.get_total_size() % WBE::OS::get_huge_page_size(), 0);
+    WBE::MemID mem = allocator.allocate(WBE_KiB(64));
+    ASSERT_EQ(mem % WBE::OS::get_huge_page_size(), 0);
+    memset(allocator.get(mem), 0xFF, WBE_KiB(64));
+    allocator.pop_stack(WBE_KiB(64));
+    ASSERT_NE(static_cast<std::string>(allocator).find(WBE::get_page_backing_name(allocator.get_page_backing())), std::string::npos);
+}
+
 #endif
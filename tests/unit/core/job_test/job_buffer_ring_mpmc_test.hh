@@ -0,0 +1,186 @@
+/* Copyright 2025 OppositeNor
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef __WBE_JOB_BUFFER_RING_MPMC_TEST_HH__
+#define __WBE_JOB_BUFFER_RING_MPMC_TEST_HH__
+
+#include "core/allocator/heap_allocator_atomic_aligned_pool_impl_list.hh"
+#include "core/job/job.hh"
+#include "core/job/job_buffer_ring_mpmc.hh"
+#include "global/global.hh"
+#include "platform/file_system/directory.hh"
+#include "utils/utils.hh"
+#include <atomic>
+#include <chrono>
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+namespace WBE = WhiteBirdEngine;
+
+class WBEJobBufferRingMPMCTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        global = std::make_unique<WBE::Global>(0, nullptr, WBE::Directory({"test_env"}));
+    }
+
+    void TearDown() override {
+        global.reset();
+    }
+
+    std::unique_ptr<WBE::Global> global;
+
+    WBE::HeapAllocatorDefault* get_allocator() {
+        return global->engine_core->pool_allocator;
+    }
+};
+
+using JobBufferRingMPMC = WBE::JobBufferRingMPMC<MockJob>;
+
+TEST_F(WBEJobBufferRingMPMCTest, General) {
+    ASSERT_THROW(JobBufferRingMPMC(get_allocator(), 0), std::runtime_error);
+    ASSERT_THROW(JobBufferRingMPMC(get_allocator(), 1), std::runtime_error);
+    JobBufferRingMPMC buffer(get_allocator(), 3);
+    ASSERT_EQ(buffer.get_capacity(), 4);
+    ASSERT_EQ(buffer.try_retrieve(), WBE::MEM_NULL);
+    ASSERT_EQ(buffer.retrieve_job(), WBE::MEM_NULL);
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_TRUE(buffer.try_add(WBE::make_ref<MockJob>(get_allocator(), i)));
+    }
+    // Full, the job stays with the caller.
+    WBE::Ref<MockJob> rejected = WBE::make_ref<MockJob>(get_allocator(), 4);
+    ASSERT_FALSE(buffer.try_add(rejected));
+    ASSERT_EQ(rejected->job_id, 4);
+
+    // FIFO, across the wrap around.
+    ASSERT_EQ(buffer.try_retrieve()->job_id, 0);
+    ASSERT_EQ(buffer.retrieve_job()->job_id, 1);
+    buffer.add_job(rejected);
+    ASSERT_TRUE(buffer.try_add(WBE::make_ref<MockJob>(get_allocator(), 5)));
+    for (int id : { 2, 3, 4, 5 }) {
+        ASSERT_EQ(buffer.try_retrieve()->job_id, id);
+    }
+    ASSERT_EQ(buffer.try_retrieve(), WBE::MEM_NULL);
+}
+
+TEST_F(WBEJobBufferRingMPMCTest, ReleaseRemaining) {
+    WBE::RefWeak<MockJob> weak;
+    {
+        JobBufferRingMPMC buffer(get_allocator(), 4);
+        WBE::Ref<MockJob> job = WBE::make_ref<MockJob>(get_allocator(), 1);
+        weak = job;
+        buffer.add_job(job);
+        job = WBE::MEM_NULL;
+        // Kept by the buffer.
+        ASSERT_TRUE(weak.is_valid());
+    }
+    ASSERT_FALSE(weak.is_valid());
+}
+
+TEST_F(WBEJobBufferRingMPMCTest, Blocking) {
+    WBE::HeapAllocatorAtomicAlignedPoolImplicitList job_allocator(WBE_KiB(64));
+    {
+        JobBufferRingMPMC buffer(get_allocator(), 2);
+        buffer.add_job(WBE::make_ref<MockJob>(&job_allocator, 0));
+        buffer.add_job(WBE::make_ref<MockJob>(&job_allocator, 1));
+        std::atomic<bool> added = false;
+        std::thread producer([&] {
+            // Waits for room instead of throwing.
+            buffer.add_job(WBE::make_ref<MockJob>(&job_allocator, 2));
+            added.store(true);
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        ASSERT_FALSE(added.load());
+        ASSERT_EQ(buffer.try_retrieve()->job_id, 0);
+        producer.join();
+        ASSERT_TRUE(added.load());
+
+        ASSERT_EQ(buffer.wait_retrieve_job()->job_id, 1);
+        ASSERT_EQ(buffer.wait_retrieve_job()->job_id, 2);
+        std::thread consumer([&] {
+            // Waits for a job.
+            ASSERT_EQ(buffer.wait_retrieve_job()->job_id, 3);
+            // Returns once closed.
+            ASSERT_EQ(buffer.wait_retrieve_job(), WBE::MEM_NULL);
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        buffer.add_job(WBE::make_ref<MockJob>(&job_allocator, 3));
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        buffer.close();
+        consumer.join();
+    }
+    ASSERT_TRUE(job_allocator.is_empty());
+}
+
+TEST_F(WBEJobBufferRingMPMCTest, ConcurrentProducersConsumers) {
+    constexpr int PRODUCER_COUNT = 4;
+    constexpr int CONSUMER_COUNT = 4;
+    constexpr int JOB_COUNT_PER_PRODUCER = 5000;
+    constexpr int JOB_COUNT = PRODUCER_COUNT * JOB_COUNT_PER_PRODUCER;
+    WBE::HeapAllocatorAtomicAlignedPoolImplicitList job_allocator(WBE_MiB(4));
+    std::vector<std::atomic<int>> taken(JOB_COUNT);
+    {
+        JobBufferRingMPMC buffer(get_allocator(), 64);
+        std::atomic<bool> done = false;
+        std::vector<std::thread> consumers;
+        for (int i = 0; i < CONSUMER_COUNT; ++i) {
+            consumers.emplace_back([&, i] {
+                // Half of the consumers poll, the others wait.
+                bool poll = i % 2 == 0;
+                while (true) {
+                    WBE::Ref<MockJob> job = poll ? buffer.try_retrieve() : buffer.wait_retrieve_job();
+                    if (!job.is_null()) {
+                        taken[job->job_id].fetch_add(1, std::memory_order_relaxed);
+                    }
+                    else if (!poll || done.load()) {
+                        // The waiting consumers take what is left after the close.
+                        return;
+                    }
+                }
+            });
+        }
+        std::vector<std::thread> producers;
+        for (int i = 0; i < PRODUCER_COUNT; ++i) {
+            producers.emplace_back([&, i] {
+                for (int j = 0; j < JOB_COUNT_PER_PRODUCER; ++j) {
+                    WBE::Ref<MockJob> job = WBE::make_ref<MockJob>(&job_allocator, i * JOB_COUNT_PER_PRODUCER + j);
+                    // Half of the producers poll, the others wait.
+                    if (i % 2 == 0) {
+                        while (!buffer.try_add(job)) {
+                            std::this_thread::yield();
+                        }
+                    }
+                    else {
+                        buffer.add_job(job);
+                    }
+                }
+            });
+        }
+        for (std::thread& producer : producers) {
+            producer.join();
+        }
+        buffer.close();
+        done.store(true);
+        for (std::thread& consumer : consumers) {
+            consumer.join();
+        }
+    }
+    // Every job is taken exactly once.
+    for (int i = 0; i < JOB_COUNT; ++i) {
+        ASSERT_EQ(taken[i].load(), 1) << "Job " << i;
+    }
+    ASSERT_TRUE(job_allocator.is_empty());
+}
+
+#endif
@@ -0,0 +1,136 @@
+/* Copyright 2025 OppositeNor
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef __WBE_JOB_BUFFER_WORK_STEALING_TEST_HH__
+#define __WBE_JOB_BUFFER_WORK_STEALING_TEST_HH__
+
+#include "core/allocator/heap_allocator_atomic_aligned_pool_impl_list.hh"
+#include "core/job/job.hh"
+#include "core/job/job_buffer_work_stealing.hh"
+#include "global/global.hh"
+#include "platform/file_system/directory.hh"
+#include "utils/utils.hh"
+#include <atomic>
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+namespace WBE = WhiteBirdEngine;
+
+class WBEJobBufferWorkStealingTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        global = std::make_unique<WBE::Global>(0, nullptr, WBE::Directory({"test_env"}));
+    }
+
+    void TearDown() override {
+        global.reset();
+    }
+
+    std::unique_ptr<WBE::Global> global;
+
+    WBE::HeapAllocatorDefault* get_allocator() {
+        return global->engine_core->pool_allocator;
+    }
+};
+
+using JobBufferWorkStealing = WBE::JobBufferWorkStealing<MockJob>;
+
+TEST_F(WBEJobBufferWorkStealingTest, General) {
+    ASSERT_THROW(JobBufferWorkStealing(get_allocator(), 0), std::runtime_error);
+    JobBufferWorkStealing buffer(get_allocator(), 3);
+    ASSERT_TRUE(buffer.is_empty());
+    ASSERT_EQ(buffer.retrieve_job(), WBE::MEM_NULL);
+    ASSERT_EQ(buffer.steal_job(), WBE::MEM_NULL);
+    // Rounded up to 4.
+    for (int i = 0; i < 4; ++i) {
+        buffer.add_job(WBE::make_ref<MockJob>(get_allocator(), i));
+    }
+    ASSERT_TRUE(buffer.is_full());
+    ASSERT_THROW(buffer.add_job(WBE::make_ref<MockJob>(get_allocator(), 4)), std::runtime_error);
+
+    // The owner takes the newest job, the thieves the oldest.
+    ASSERT_EQ(buffer.retrieve_job()->job_id, 3);
+    ASSERT_EQ(buffer.steal_job()->job_id, 0);
+    ASSERT_FALSE(buffer.is_full());
+    buffer.add_job(WBE::make_ref<MockJob>(get_allocator(), 5));
+    buffer.add_job(WBE::make_ref<MockJob>(get_allocator(), 6));
+    ASSERT_EQ(buffer.steal_job()->job_id, 1);
+    ASSERT_EQ(buffer.retrieve_job()->job_id, 6);
+    ASSERT_EQ(buffer.retrieve_job()->job_id, 5);
+    ASSERT_EQ(buffer.retrieve_job()->job_id, 2);
+    ASSERT_EQ(buffer.retrieve_job(), WBE::MEM_NULL);
+    ASSERT_TRUE(buffer.is_empty());
+}
+
+TEST_F(WBEJobBufferWorkStealingTest, ReleaseRemaining) {
+    WBE::RefWeak<MockJob> weak;
+    {
+        JobBufferWorkStealing buffer(get_allocator(), 4);
+        WBE::Ref<MockJob> job = WBE::make_ref<MockJob>(get_allocator(), 1);
+        weak = job;
+        buffer.add_job(job);
+        buffer.add_job(WBE::make_ref<MockJob>(get_allocator(), 2));
+        job = WBE::MEM_NULL;
+        // Kept by the buffer.
+        ASSERT_TRUE(weak.is_valid());
+    }
+    ASSERT_FALSE(weak.is_valid());
+}
+
+TEST_F(WBEJobBufferWorkStealingTest, ConcurrentSteal) {
+    constexpr int JOB_COUNT = 20000;
+    constexpr int THIEF_COUNT = 3;
+    WBE::HeapAllocatorAtomicAlignedPoolImplicitList job_allocator(WBE_MiB(16));
+    std::vector<std::atomic<int>> taken(JOB_COUNT);
+    {
+        JobBufferWorkStealing buffer(get_allocator(), 64);
+        std::atomic<bool> done = false;
+        std::vector<std::thread> thieves;
+        for (int i = 0; i < THIEF_COUNT; ++i) {
+            thieves.emplace_back([&] {
+                while (!done.load(std::memory_order_acquire) || !buffer.is_empty()) {
+                    WBE::Ref<MockJob> job = buffer.steal_job();
+                    if (!job.is_null()) {
+                        taken[job->job_id].fetch_add(1, std::memory_order_relaxed);
+                    }
+                }
+            });
+        }
+        for (int i = 0; i < JOB_COUNT; ++i) {
+            while (buffer.is_full()) {
+                std::this_thread::yield();
+            }
+            buffer.add_job(WBE::make_ref<MockJob>(&job_allocator, i));
+            // Race the thieves for the bottom job now and then.
+            if (i % 3 == 0) {
+                WBE::Ref<MockJob> job = buffer.retrieve_job();
+                if (!job.is_null()) {
+                    taken[job->job_id].fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        }
+        done.store(true, std::memory_order_release);
+        for (std::thread& thief : thieves) {
+            thief.join();
+        }
+    }
+    // Every job is taken exactly once.
+    for (int i = 0; i < JOB_COUNT; ++i) {
+        ASSERT_EQ(taken[i].load(), 1) << "Job " << i;
+    }
+    ASSERT_TRUE(job_allocator.is_empty());
+}
+
+#endif
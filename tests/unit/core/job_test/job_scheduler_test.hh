@@ -0,0 +1,229 @@
+/* Copyright 2025 OppositeNor
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef __WBE_JOB_SCHEDULER_TEST_HH__
+#define __WBE_JOB_SCHEDULER_TEST_HH__
+
+#include "core/allocator/heap_allocator_atomic_aligned_pool_impl_list.hh"
+#include "core/job/job.hh"
+#include "core/job/job_scheduler.hh"
+#include "core/memory/ref_destruction_queue.hh"
+#include "global/global.hh"
+#include "platform/file_system/directory.hh"
+#include "utils/utils.hh"
+#include <atomic>
+#include <chrono>
+#include <gtest/gtest.h>
+#include <thread>
+
+namespace WBE = WhiteBirdEngine;
+
+class WBEJobSchedulerTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        global = std::make_unique<WBE::Global>(0, nullptr, WBE::Directory({"test_env"}));
+        MockJob::perform_count.store(0);
+    }
+
+    void TearDown() override {
+        global.reset();
+    }
+
+    std::unique_ptr<WBE::Global> global;
+
+    WBE::HeapAllocatorDefault* get_allocator() {
+        return global->engine_core->pool_allocator;
+    }
+};
+
+namespace {
+
+using JobAllocator = WBE::HeapAllocatorAtomicAlignedPoolImplicitList;
+
+// Splits itself in two until the depth runs out, and waits for the halves on the worker.
+struct SchedulerForkJob : public WBE::Job<SchedulerForkJob> {
+    SchedulerForkJob(WBE::JobScheduler<SchedulerForkJob>* p_scheduler, JobAllocator* p_allocator, int p_depth, std::atomic<int>* r_leaf_count)
+        : scheduler(p_scheduler), allocator(p_allocator), depth(p_depth), leaf_count(r_leaf_count) {}
+
+    void perform() {
+        if (depth == 0) {
+            leaf_count->fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        WBE::JobCounter children;
+        for (int i = 0; i < 2; ++i) {
+            scheduler->schedule(WBE::make_ref<SchedulerForkJob>(allocator, scheduler, allocator, depth - 1, leaf_count), &children);
+        }
+        scheduler->wait(children);
+    }
+
+    WBE::JobScheduler<SchedulerForkJob>* scheduler;
+    JobAllocator* allocator;
+    int depth;
+    std::atomic<int>* leaf_count;
+};
+
+struct SchedulerThreadJob : public WBE::Job<SchedulerThreadJob> {
+    void perform() {
+        thread_id = std::this_thread::get_id();
+    }
+    std::thread::id thread_id;
+};
+
+struct DeferredObject {
+    DeferredObject(std::atomic<bool>* r_destroyed)
+        : destroyed(r_destroyed) {}
+    ~DeferredObject() {
+        destroyed->store(true);
+    }
+    std::atomic<bool>* destroyed;
+};
+
+// Turns deferring on for the worker, and releases the last reference of an object.
+struct SchedulerDeferJob : public WBE::Job<SchedulerDeferJob> {
+    void perform() {
+        WBE::RefDestructionQueue::get_thread_queue().set_deferred(true);
+        obj = WBE::MEM_NULL;
+    }
+    WBE::Ref<DeferredObject> obj;
+};
+
+}
+
+TEST_F(WBEJobSchedulerTest, General) {
+    constexpr int JOB_COUNT = 10000;
+    JobAllocator job_allocator(WBE_MiB(8));
+    {
+        WBE::JobScheduler<MockJob> scheduler(get_allocator(), 4);
+        ASSERT_EQ(scheduler.get_worker_count(), 4);
+        WBE::JobCounter counter;
+        ASSERT_TRUE(counter.is_done());
+        for (int i = 0; i < JOB_COUNT; ++i) {
+            scheduler.schedule(WBE::make_ref<MockJob>(&job_allocator, i), &counter);
+        }
+        scheduler.wait(counter);
+        ASSERT_TRUE(counter.is_done());
+        ASSERT_EQ(MockJob::perform_count.load(), JOB_COUNT);
+    }
+    ASSERT_TRUE(job_allocator.is_empty());
+    ASSERT_GE(WBE::JobScheduler<MockJob>::get_default_worker_count(), 1);
+}
+
+TEST_F(WBEJobSchedulerTest, HelpWhileWaiting) {
+    JobAllocator job_allocator(WBE_MiB(1));
+    {
+        // Without workers, only the waiting thread runs the jobs.
+        WBE::JobScheduler<SchedulerThreadJob> scheduler(get_allocator(), 0);
+        WBE::Ref<SchedulerThreadJob> job = WBE::make_ref<SchedulerThreadJob>(&job_allocator);
+        WBE::JobCounter counter;
+        scheduler.schedule(job, &counter);
+        ASSERT_FALSE(counter.is_done());
+        scheduler.wait(counter);
+        ASSERT_EQ(job->thread_id, std::this_thread::get_id());
+    }
+    ASSERT_TRUE(job_allocator.is_empty());
+}
+
+TEST_F(WBEJobSchedulerTest, DestroyWithPendingJobs) {
+    constexpr int JOB_COUNT = 1000;
+    JobAllocator job_allocator(WBE_MiB(1));
+    for (size_t worker_count : { 0, 2 }) {
+        MockJob::perform_count.store(0);
+        WBE::JobCounter counter;
+        {
+            WBE::JobScheduler<MockJob> scheduler(get_allocator(), worker_count);
+            for (int i = 0; i < JOB_COUNT; ++i) {
+                scheduler.schedule(WBE::make_ref<MockJob>(&job_allocator, i), &counter);
+            }
+        }
+        // No job is dropped, so nothing waits on the counter forever.
+        ASSERT_TRUE(counter.is_done());
+        ASSERT_EQ(MockJob::perform_count.load(), JOB_COUNT);
+    }
+    ASSERT_TRUE(job_allocator.is_empty());
+}
+
+TEST_F(WBEJobSchedulerTest, DestroyWithPendingNestedJobs) {
+    constexpr int DEPTH = 8;
+    JobAllocator job_allocator(WBE_MiB(1));
+    std::atomic<int> leaf_count = 0;
+    WBE::JobCounter counter;
+    {
+        WBE::JobScheduler<SchedulerForkJob> scheduler(get_allocator(), 0);
+        scheduler.schedule(WBE::make_ref<SchedulerForkJob>(&job_allocator, &scheduler, &job_allocator, DEPTH, &leaf_count), &counter);
+    }
+    ASSERT_TRUE(counter.is_done());
+    ASSERT_EQ(leaf_count.load(), 1 << DEPTH);
+    ASSERT_TRUE(job_allocator.is_empty());
+}
+
+TEST_F(WBEJobSchedulerTest, WakeParkedWorker) {
+    JobAllocator job_allocator(WBE_MiB(1));
+    {
+        WBE::JobScheduler<SchedulerThreadJob> scheduler(get_allocator(), 2);
+        for (int round = 0; round < 3; ++round) {
+            // Let the workers park.
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            WBE::Ref<SchedulerThreadJob> job = WBE::make_ref<SchedulerThreadJob>(&job_allocator);
+            WBE::JobCounter counter;
+            scheduler.schedule(job, &counter);
+            // Not waiting with the scheduler, so a worker has to wake up for the job.
+            while (!counter.is_done()) {
+                std::this_thread::yield();
+            }
+            ASSERT_NE(job->thread_id, std::this_thread::get_id());
+        }
+    }
+    ASSERT_TRUE(job_allocator.is_empty());
+}
+
+TEST_F(WBEJobSchedulerTest, WorkerDrainsDestructionQueue) {
+    JobAllocator job_allocator(WBE_MiB(1));
+    std::atomic<bool> destroyed = false;
+    {
+        WBE::JobScheduler<SchedulerDeferJob> scheduler(get_allocator(), 1);
+        WBE::JobCounter counter;
+        {
+            WBE::Ref<SchedulerDeferJob> job = WBE::make_ref<SchedulerDeferJob>(&job_allocator);
+            job->obj = WBE::make_ref<DeferredObject>(&job_allocator, &destroyed);
+            scheduler.schedule(std::move(job), &counter);
+        }
+        while (!counter.is_done()) {
+            std::this_thread::yield();
+        }
+        // The worker destroys the object once it runs out of jobs, not only when its thread exits.
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (!destroyed.load() && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        ASSERT_TRUE(destroyed.load());
+    }
+    ASSERT_TRUE(job_allocator.is_empty());
+}
+
+TEST_F(WBEJobSchedulerTest, NestedJobs) {
+    constexpr int DEPTH = 12;
+    JobAllocator job_allocator(WBE_MiB(16));
+    std::atomic<int> leaf_count = 0;
+    {
+        WBE::JobScheduler<SchedulerForkJob> scheduler(get_allocator(), 4);
+        WBE::JobCounter counter;
+        scheduler.schedule(WBE::make_ref<SchedulerForkJob>(&job_allocator, &scheduler, &job_allocator, DEPTH, &leaf_count), &counter);
+        scheduler.wait(counter);
+    }
+    ASSERT_EQ(leaf_count.load(), 1 << DEPTH);
+    ASSERT_TRUE(job_allocator.is_empty());
+}
+
+#endif
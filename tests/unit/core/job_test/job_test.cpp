@@ -14,3 +14,6 @@
 */
 
 #include "job_buffer_ring_spsc_test.hh"
+#include "job_buffer_work_stealing_test.hh"
+#include "job_scheduler_test.hh"
+#include "job_buffer_ring_mpmc_test.hh"
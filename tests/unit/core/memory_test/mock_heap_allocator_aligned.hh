@@ -21,7 +21,7 @@
 
 namespace WhiteBirdEngine {
 
-class MockHeapAllocatorAligned final : public HeapAllocatorAligned {
+class MockHeapAllocatorAligned : public HeapAllocatorAligned {
 public:
     MockHeapAllocatorAligned(size_t max_size = 4096)
         : max_size(max_size), used_size(0) {}
@@ -99,6 +99,21 @@ private:
     mutable std::stringstream call_log;
 };
 
+template <>
+struct AllocatorTrait<class MockHeapAllocatorAlignedAddrStable> final : public AllocatorTrait<HeapAllocatorAligned> {
+    WBE_TRAIT(AllocatorTrait<MockHeapAllocatorAlignedAddrStable>);
+    static constexpr bool WILL_ADDR_MOVE = false;
+};
+
+/**
+ * @brief The mock allocator, declaring that the allocated memory never moves. The memory ID
+ * is still the address, so the raw pointer could be kept.
+ */
+class MockHeapAllocatorAlignedAddrStable final : public MockHeapAllocatorAligned {
+public:
+    using MockHeapAllocatorAligned::MockHeapAllocatorAligned;
+};
+
 }
 
 #endif
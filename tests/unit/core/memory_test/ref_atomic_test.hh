@@ -0,0 +1,156 @@
+/* Copyright 2025 OppositeNor
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef __WBE_REF_ATOMIC_TEST_HH__
+#define __WBE_REF_ATOMIC_TEST_HH__
+
+#include "core/allocator/heap_allocator_atomic_aligned_pool_impl_list.hh"
+#include "core/allocator/heap_allocator_tlsf.hh"
+#include "core/memory/reference_atomic.hh"
+#include "core/memory/reference_strong.hh"
+#include "core/memory/reference_weak.hh"
+#include "global/global.hh"
+#include "utils/utils.hh"
+#include <atomic>
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+namespace WBE = WhiteBirdEngine;
+
+class WBEAtomicRefTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        global = std::make_unique<WBE::Global>(0, nullptr, WBE::Directory({"test_env"}));
+    }
+
+    void TearDown() override {
+        global.reset();
+    }
+
+    std::unique_ptr<WBE::Global> global;
+};
+
+namespace {
+
+struct AtomicRefTestObj {
+    AtomicRefTestObj(int p_value, std::atomic<int>* r_destroyed)
+        : value(p_value), destroyed(r_destroyed) {}
+    ~AtomicRefTestObj() {
+        destroyed->fetch_add(1, std::memory_order_relaxed);
+    }
+    int value;
+    std::atomic<int>* destroyed;
+};
+
+}
+
+TEST_F(WBEAtomicRefTest, General) {
+    using RefType = WBE::Ref<AtomicRefTestObj, WBE::HeapAllocatorTLSF>;
+    WBE::HeapAllocatorTLSF allocator(WBE_KiB(16));
+    std::atomic<int> destroyed = 0;
+    {
+        WBE::AtomicRef<AtomicRefTestObj, WBE::HeapAllocatorTLSF> atomic_ref;
+        ASSERT_TRUE(atomic_ref.load().is_null());
+        atomic_ref.store(WBE::make_ref<AtomicRefTestObj>(&allocator, 1, &destroyed));
+        RefType first = atomic_ref.load();
+        ASSERT_EQ(first->value, 1);
+        RefType old = atomic_ref.exchange(WBE::make_ref<AtomicRefTestObj>(&allocator, 2, &destroyed));
+        ASSERT_EQ(old, first);
+        old = nullptr;
+        ASSERT_EQ(destroyed, 0);
+        first = nullptr;
+        ASSERT_EQ(destroyed, 1);
+
+        RefType expected = first;
+        RefType third = WBE::make_ref<AtomicRefTestObj>(&allocator, 3, &destroyed);
+        ASSERT_FALSE(atomic_ref.compare_exchange(expected, third));
+        ASSERT_EQ(expected->value, 2);
+        ASSERT_TRUE(atomic_ref.compare_exchange(expected, third));
+        ASSERT_EQ(static_cast<RefType>(atomic_ref), third);
+        expected = nullptr;
+        ASSERT_EQ(destroyed, 2);
+        WBE::RefWeak<AtomicRefTestObj, WBE::HeapAllocatorTLSF> weak = third;
+        third = nullptr;
+        // Kept by the atomic reference.
+        ASSERT_TRUE(weak.is_valid());
+        atomic_ref = RefType();
+        ASSERT_FALSE(weak.is_valid());
+        ASSERT_EQ(destroyed, 3);
+    }
+    ASSERT_TRUE(allocator.is_empty());
+}
+
+TEST_F(WBEAtomicRefTest, ManyLoads) {
+    using RefType = WBE::Ref<AtomicRefTestObj, WBE::HeapAllocatorTLSF>;
+    WBE::HeapAllocatorTLSF allocator(WBE_MiB(4));
+    std::atomic<int> destroyed = 0;
+    {
+        WBE::AtomicRef<AtomicRefTestObj, WBE::HeapAllocatorTLSF> atomic_ref(WBE::make_ref<AtomicRefTestObj>(&allocator, 1, &destroyed));
+        // More loads than the local count could hold, the reserve is refilled on the way.
+        std::vector<RefType> refs;
+        for (int i = 0; i < 100000; ++i) {
+            refs.push_back(atomic_ref.load());
+        }
+        RefType last = atomic_ref.exchange(RefType());
+        refs.clear();
+        ASSERT_EQ(destroyed, 0);
+        last = nullptr;
+        ASSERT_EQ(destroyed, 1);
+    }
+    ASSERT_TRUE(allocator.is_empty());
+}
+
+TEST_F(WBEAtomicRefTest, ConcurrentReadWrite) {
+    using AllocType = WBE::HeapAllocatorAtomicAlignedPoolImplicitList;
+    using RefType = WBE::Ref<AtomicRefTestObj, AllocType>;
+    constexpr int READER_COUNT = 4;
+    constexpr int STORE_COUNT = 20000;
+    AllocType allocator(WBE_MiB(4));
+    std::atomic<int> destroyed = 0;
+    {
+        WBE::AtomicRef<AtomicRefTestObj, AllocType> atomic_ref(WBE::make_ref<AtomicRefTestObj>(&allocator, 0, &destroyed));
+        std::atomic<bool> done = false;
+        std::vector<std::thread> readers;
+        for (int i = 0; i < READER_COUNT; ++i) {
+            readers.emplace_back([&] {
+                int last_value = 0;
+                while (!done.load(std::memory_order_acquire)) {
+                    RefType ref = atomic_ref.load();
+                    // A loaded object is alive, and the values are published in order.
+                    ASSERT_GE(ref->value, last_value);
+                    last_value = ref->value;
+                }
+            });
+        }
+        for (int i = 1; i <= STORE_COUNT; ++i) {
+            if (i % 2 == 0) {
+                atomic_ref.store(WBE::make_ref<AtomicRefTestObj>(&allocator, i, &destroyed));
+            }
+            else {
+                RefType expected = atomic_ref.load();
+                ASSERT_TRUE(atomic_ref.compare_exchange(expected, WBE::make_ref<AtomicRefTestObj>(&allocator, i, &destroyed)));
+            }
+        }
+        done.store(true, std::memory_order_release);
+        for (std::thread& reader : readers) {
+            reader.join();
+        }
+        ASSERT_EQ(destroyed, STORE_COUNT);
+    }
+    ASSERT_EQ(destroyed, STORE_COUNT + 1);
+    ASSERT_TRUE(allocator.is_empty());
+}
+
+#endif
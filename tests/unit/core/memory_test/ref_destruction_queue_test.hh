@@ -0,0 +1,151 @@
+/* Copyright 2025 OppositeNor
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef __WBE_REF_DESTRUCTION_QUEUE_TEST_HH__
+#define __WBE_REF_DESTRUCTION_QUEUE_TEST_HH__
+
+#include "core/allocator/heap_allocator_tlsf.hh"
+#include "core/memory/ref_destruction_queue.hh"
+#include "core/memory/reference_strong.hh"
+#include "core/memory/reference_weak.hh"
+#include "global/global.hh"
+#include "utils/utils.hh"
+#include <chrono>
+#include <gtest/gtest.h>
+#include <thread>
+
+namespace WBE = WhiteBirdEngine;
+
+class WBERefDestructionQueueTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        global = std::make_unique<WBE::Global>(0, nullptr, WBE::Directory({"test_env"}));
+    }
+
+    void TearDown() override {
+        WBE::RefDestructionQueue::get_thread_queue().drain_all();
+        WBE::RefDestructionQueue::get_thread_queue().set_deferred(false);
+        global.reset();
+    }
+
+    std::unique_ptr<WBE::Global> global;
+};
+
+namespace {
+
+struct DeferredNode {
+    DeferredNode(int* r_destroyed)
+        : destroyed(r_destroyed) {}
+    ~DeferredNode() {
+        ++*destroyed;
+    }
+    int* destroyed;
+    WBE::Ref<DeferredNode, WBE::HeapAllocatorTLSF> next;
+};
+
+}
+
+TEST_F(WBERefDestructionQueueTest, Immediate) {
+    WBE::HeapAllocatorTLSF allocator(WBE_KiB(16));
+    int destroyed = 0;
+    ASSERT_FALSE(WBE::RefDestructionQueue::is_thread_deferred());
+    WBE::Ref<DeferredNode, WBE::HeapAllocatorTLSF> ref = WBE::make_ref<DeferredNode>(&allocator, &destroyed);
+    ref = nullptr;
+    ASSERT_EQ(destroyed, 1);
+    ASSERT_EQ(WBE::RefDestructionQueue::get_thread_queue().get_pending_count(), 0);
+    ASSERT_TRUE(allocator.is_empty());
+}
+
+TEST_F(WBERefDestructionQueueTest, Deferred) {
+    WBE::HeapAllocatorTLSF allocator(WBE_KiB(16));
+    WBE::RefDestructionQueue& queue = WBE::RefDestructionQueue::get_thread_queue();
+    queue.set_deferred(true);
+    int destroyed = 0;
+    {
+        WBE::Ref<DeferredNode, WBE::HeapAllocatorTLSF> ref = WBE::make_ref<DeferredNode>(&allocator, &destroyed);
+        WBE::RefWeak<DeferredNode, WBE::HeapAllocatorTLSF> weak = ref;
+        WBE::Ref<DeferredNode, WBE::HeapAllocatorTLSF> separate(&allocator, WBE::create_obj<DeferredNode>(allocator, &destroyed));
+        ref = nullptr;
+        separate = nullptr;
+        ASSERT_EQ(destroyed, 0);
+        ASSERT_EQ(queue.get_pending_count(), 2);
+        ASSERT_FALSE(weak.is_valid());
+        ASSERT_TRUE(weak.lock().is_null());
+        ASSERT_EQ(queue.drain_all(), 2);
+        ASSERT_EQ(destroyed, 2);
+    }
+    ASSERT_TRUE(allocator.is_empty());
+}
+
+TEST_F(WBERefDestructionQueueTest, Cascade) {
+    constexpr int NODE_COUNT = 200;
+    WBE::HeapAllocatorTLSF allocator(WBE_KiB(64));
+    WBE::RefDestructionQueue& queue = WBE::RefDestructionQueue::get_thread_queue();
+    queue.set_deferred(true);
+    int destroyed = 0;
+    {
+        WBE::Ref<DeferredNode, WBE::HeapAllocatorTLSF> head = WBE::make_ref<DeferredNode>(&allocator, &destroyed);
+        WBE::Ref<DeferredNode, WBE::HeapAllocatorTLSF> tail = head;
+        for (int i = 1; i < NODE_COUNT; ++i) {
+            tail->next = WBE::make_ref<DeferredNode>(&allocator, &destroyed);
+            tail = tail->next;
+        }
+        tail = nullptr;
+        head = nullptr;
+    }
+    ASSERT_EQ(queue.get_pending_count(), 1);
+    // Every node queues the next one when destroyed, a drain without budget still destroys a batch.
+    size_t drained = queue.drain(std::chrono::nanoseconds(0));
+    ASSERT_GT(drained, 0);
+    ASSERT_LT(drained, NODE_COUNT);
+    ASSERT_EQ(destroyed, drained);
+    ASSERT_EQ(queue.get_pending_count(), 1);
+    queue.drain(std::chrono::seconds(10));
+    ASSERT_EQ(destroyed, NODE_COUNT);
+    ASSERT_EQ(queue.get_pending_count(), 0);
+    ASSERT_TRUE(allocator.is_empty());
+}
+
+TEST_F(WBERefDestructionQueueTest, PerThread) {
+    WBE::HeapAllocatorTLSF allocator(WBE_KiB(16));
+    WBE::RefDestructionQueue::get_thread_queue().set_deferred(true);
+    int destroyed = 0;
+    WBE::Ref<DeferredNode, WBE::HeapAllocatorTLSF> ref = WBE::make_ref<DeferredNode>(&allocator, &destroyed);
+    std::thread releaser([&] {
+        // Deferring is not turned on for this thread.
+        ref = nullptr;
+    });
+    releaser.join();
+    ASSERT_EQ(destroyed, 1);
+    ASSERT_EQ(WBE::RefDestructionQueue::get_thread_queue().get_pending_count(), 0);
+    ASSERT_TRUE(allocator.is_empty());
+}
+
+TEST_F(WBERefDestructionQueueTest, ShutdownWithPending) {
+    WBE::RefDestructionQueue& queue = WBE::RefDestructionQueue::get_thread_queue();
+    queue.set_deferred(true);
+    int destroyed = 0;
+    {
+        auto ref = WBE::make_ref<DeferredNode>(WBE::global_allocator(), &destroyed);
+        auto other = WBE::make_ref<DeferredNode>(WBE::global_allocator(), &destroyed);
+    }
+    ASSERT_EQ(queue.get_pending_count(), 2);
+    // The objects live in the global allocator, they are destroyed before it is.
+    global.reset();
+    ASSERT_EQ(destroyed, 2);
+    ASSERT_EQ(queue.get_pending_count(), 0);
+    ASSERT_FALSE(WBE::RefDestructionQueue::is_thread_deferred());
+}
+
+#endif
@@ -0,0 +1,187 @@
+/* Copyright 2025 OppositeNor
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef __WBE_REF_DEVIRTUALIZE_TEST_HH__
+#define __WBE_REF_DEVIRTUALIZE_TEST_HH__
+
+#include "core/allocator/allocator.hh"
+#include "core/allocator/heap_allocator_aligned.hh"
+#include "core/memory/reference_raw.hh"
+#include "core/memory/reference_strong.hh"
+#include "core/memory/reference_weak.hh"
+#include "core/memory/unique.hh"
+#include "global/global.hh"
+#include "mock_heap_allocator_aligned.hh"
+#include "utils/defs.hh"
+#include "utils/utils.hh"
+#include <concepts>
+#include <cstdlib>
+#include <gtest/gtest.h>
+#include <unordered_set>
+
+namespace WhiteBirdEngine {
+
+template <>
+struct AllocatorTrait<class MockAddrStableHeapAllocator> final : public AllocatorTrait<HeapAllocatorAligned> {
+    WBE_TRAIT(AllocatorTrait<MockAddrStableHeapAllocator>);
+    static constexpr bool IS_POOL = false;
+    static constexpr bool IS_GURANTEED_CONTINUOUS = false;
+    static constexpr bool IS_LIMITED_SIZE = false;
+    static constexpr bool IS_ALLOC_FIXED_SIZE = false;
+    static constexpr bool IS_ATOMIC = false;
+    static constexpr bool WILL_ADDR_MOVE = false;
+
+    WBE_TRAIT_REQUIRES(AllocatorTraitConcept);
+};
+
+/**
+ * @brief Allocator whose memory IDs are the addresses, counting the calls to get.
+ */
+class MockAddrStableHeapAllocator final : public HeapAllocatorAligned {
+public:
+    MockAddrStableHeapAllocator() = default;
+    virtual ~MockAddrStableHeapAllocator() override {
+        clear();
+    }
+
+    virtual MemID allocate(size_t p_size, size_t p_alignment = WBE_DEFAULT_ALIGNMENT) override {
+        void* ptr = aligned_alloc(p_alignment, get_align_size(p_size, p_alignment));
+        allocations.insert(reinterpret_cast<MemID>(ptr));
+        return reinterpret_cast<MemID>(ptr);
+    }
+
+    virtual void deallocate(MemID p_mem) override {
+        allocations.erase(p_mem);
+        free(reinterpret_cast<void*>(p_mem));
+    }
+
+    virtual void* get(MemID p_id) const override {
+        ++get_count;
+        return reinterpret_cast<void*>(p_id);
+    }
+
+    virtual bool is_empty() const override {
+        return allocations.empty();
+    }
+
+    virtual void clear() override {
+        for (MemID mem : allocations) {
+            free(reinterpret_cast<void*>(mem));
+        }
+        allocations.clear();
+    }
+
+    virtual size_t get_allocated_data_size(MemID) const override {
+        return 0;
+    }
+
+    size_t get_get_count() const {
+        return get_count;
+    }
+
+private:
+    std::unordered_set<MemID> allocations;
+    mutable size_t get_count = 0;
+};
+
+}
+
+namespace WBE = WhiteBirdEngine;
+
+class WBERefDevirtualizeTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        global = std::make_unique<WBE::Global>(0, nullptr, WBE::Directory({"test_env"}));
+    }
+
+    void TearDown() override {
+        global.reset();
+    }
+
+    std::unique_ptr<WBE::Global> global;
+};
+
+TEST_F(WBERefDevirtualizeTest, AccessObj) {
+    WBE::MockAddrStableHeapAllocator stable_allocator;
+    WBE::MemID mem = stable_allocator.allocate(sizeof(int));
+    ASSERT_EQ(WBE::access_obj<int>(stable_allocator, mem), reinterpret_cast<int*>(mem));
+    ASSERT_EQ(WBE::access_obj<int>(stable_allocator, WBE::MEM_NULL), nullptr);
+    // Through the base class the trait is unknown, so the allocator is asked.
+    ASSERT_EQ(WBE::access_obj<int>(static_cast<WBE::HeapAllocator&>(stable_allocator), mem), reinterpret_cast<int*>(mem));
+    ASSERT_EQ(stable_allocator.get_get_count(), 1);
+    stable_allocator.deallocate(mem);
+}
+
+TEST_F(WBERefDevirtualizeTest, RefSkipsAllocator) {
+    WBE::MockAddrStableHeapAllocator allocator;
+    {
+        WBE::Ref<int, WBE::MockAddrStableHeapAllocator> fused = WBE::make_ref<int>(&allocator, 1);
+        WBE::Ref<int, WBE::MockAddrStableHeapAllocator> ref(&allocator, WBE::create_obj<int>(allocator, 2));
+        WBE::Ref<int, WBE::MockAddrStableHeapAllocator> null_ref(&allocator, WBE::MEM_NULL);
+        for (int i = 0; i < 10; ++i) {
+            ASSERT_EQ(*fused, 1);
+            ASSERT_EQ(*ref, 2);
+        }
+        ASSERT_EQ(null_ref.get(), nullptr);
+        WBE::RefWeak<int, WBE::MockAddrStableHeapAllocator> weak = ref;
+        WBE::Ref<int, WBE::MockAddrStableHeapAllocator> locked = weak.lock();
+        ASSERT_EQ(*locked, 2);
+        const WBE::RefWeak<int, WBE::MockAddrStableHeapAllocator>& const_weak = weak;
+        ASSERT_EQ(*const_weak.lock(), 2);
+        // Erasing the allocator type keeps working.
+        WBE::Ref<int> erased = ref;
+        ASSERT_EQ(*erased, 2);
+        ASSERT_EQ(allocator.get_get_count(), 0);
+    }
+    ASSERT_TRUE(allocator.is_empty());
+}
+
+TEST_F(WBERefDevirtualizeTest, UniqueSkipsAllocator) {
+    WBE::MockAddrStableHeapAllocator allocator;
+    {
+        auto unique = WBE::make_unique<int>(&allocator, 3);
+        static_assert(std::same_as<decltype(unique), WBE::Unique<int, WBE::MockAddrStableHeapAllocator>>);
+        for (int i = 0; i < 10; ++i) {
+            ASSERT_EQ(*unique, 3);
+        }
+        ASSERT_EQ(*unique.get(), 3);
+        ASSERT_EQ(allocator.get_get_count(), 0);
+    }
+    ASSERT_TRUE(allocator.is_empty());
+}
+
+TEST_F(WBERefDevirtualizeTest, RefRawSkipsAllocator) {
+    WBE::MockAddrStableHeapAllocator allocator;
+    auto ref = WBE::new_ref<int>(&allocator, 4);
+    for (int i = 0; i < 10; ++i) {
+        ASSERT_EQ(*ref, 4);
+    }
+    ASSERT_EQ(*ref.get(), 4);
+    ASSERT_EQ(allocator.get_get_count(), 0);
+    WBE::delete_ref(std::move(ref));
+    ASSERT_TRUE(allocator.is_empty());
+}
+
+TEST_F(WBERefDevirtualizeTest, MovingAllocatorAsked) {
+    WBE::MockHeapAllocatorAligned allocator(1024);
+    {
+        auto unique = WBE::make_unique<int>(&allocator, 5);
+        allocator.clear_call_log();
+        ASSERT_EQ(*unique, 5);
+        ASSERT_NE(allocator.get_call_log().find("get("), std::string::npos);
+    }
+    ASSERT_TRUE(allocator.is_empty());
+}
+
+#endif
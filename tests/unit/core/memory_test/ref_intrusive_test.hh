@@ -0,0 +1,193 @@
+/* Copyright 2025 OppositeNor
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef __WBE_REF_INTRUSIVE_TEST_HH__
+#define __WBE_REF_INTRUSIVE_TEST_HH__
+
+#include "core/allocator/heap_allocator_tlsf.hh"
+#include "core/core_utils.hh"
+#include "core/memory/reference_intrusive.hh"
+#include "global/global.hh"
+#include "utils/utils.hh"
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <unordered_set>
+
+namespace WBE = WhiteBirdEngine;
+
+class WBERefIntrusiveTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        global = std::make_unique<WBE::Global>(0, nullptr, WBE::Directory({"test_env"}));
+    }
+
+    void TearDown() override {
+        global.reset();
+    }
+
+    std::unique_ptr<WBE::Global> global;
+};
+
+namespace {
+
+struct IntrusiveBase : public WBE::RefCounted {
+    IntrusiveBase(int p_value, int* r_destroyed)
+        : value(p_value), destroyed(r_destroyed) {}
+    virtual ~IntrusiveBase() override {
+        ++*destroyed;
+    }
+    int value;
+    int* destroyed;
+};
+
+struct IntrusiveDerived : public IntrusiveBase {
+    IntrusiveDerived(int p_value, int* r_destroyed)
+        : IntrusiveBase(p_value, r_destroyed) {}
+    alignas(64) int extra = 0;
+};
+
+struct IntrusiveWeakObj : public WBE::RefCountedWeak {
+    IntrusiveWeakObj(int p_value)
+        : value(p_value) {}
+    int value;
+};
+
+struct IntrusiveThis : public WBE::RefCounted, public WBE::ThisRef<IntrusiveThis> {
+    int value = 7;
+};
+
+struct IntrusiveThrows : public WBE::RefCounted {
+    IntrusiveThrows() {
+        throw std::runtime_error("Constructor failed.");
+    }
+};
+
+}
+
+TEST_F(WBERefIntrusiveTest, Count) {
+    WBE::HeapAllocatorTLSF allocator(WBE_KiB(64));
+    int destroyed = 0;
+    {
+        WBE::RefIntrusive<IntrusiveBase> ref = WBE::make_ref_intrusive<IntrusiveBase>(&allocator, 1, &destroyed);
+        static_assert(sizeof(ref) == sizeof(void*));
+        ASSERT_EQ(ref->get_ref_count(), 1);
+        ASSERT_EQ(ref->value, 1);
+        {
+            WBE::RefIntrusive<IntrusiveBase> copy = ref;
+            ASSERT_EQ(ref->get_ref_count(), 2);
+            ASSERT_EQ(copy, ref);
+            WBE::RefIntrusive<IntrusiveBase> moved = std::move(copy);
+            ASSERT_TRUE(copy.is_null());
+            ASSERT_EQ(ref->get_ref_count(), 2);
+            moved = ref;
+            ASSERT_EQ(ref->get_ref_count(), 2);
+        }
+        ASSERT_EQ(ref->get_ref_count(), 1);
+        std::unordered_set<WBE::RefIntrusive<IntrusiveBase>> set;
+        set.insert(ref);
+        ASSERT_TRUE(set.contains(ref));
+        set.clear();
+        ASSERT_EQ(destroyed, 0);
+        ASSERT_FALSE(allocator.is_empty());
+        ref = nullptr;
+        ASSERT_EQ(ref, nullptr);
+        ASSERT_EQ(destroyed, 1);
+    }
+    ASSERT_EQ(destroyed, 1);
+    ASSERT_TRUE(allocator.is_empty());
+}
+
+TEST_F(WBERefIntrusiveTest, Derived) {
+    WBE::HeapAllocatorTLSF allocator(WBE_KiB(64));
+    int destroyed = 0;
+    {
+        WBE::RefIntrusive<IntrusiveDerived> derived = WBE::make_ref_intrusive<IntrusiveDerived>(&allocator, 2, &destroyed);
+        ASSERT_EQ(reinterpret_cast<uintptr_t>(&derived->extra) % 64, 0);
+        WBE::RefIntrusive<IntrusiveBase> base = derived;
+        ASSERT_EQ(base->get_ref_count(), 2);
+        derived = nullptr;
+        ASSERT_EQ(destroyed, 0);
+        WBE::RefIntrusive<IntrusiveDerived> casted = base.dynamic_cast_ref<IntrusiveDerived>();
+        ASSERT_FALSE(casted.is_null());
+        ASSERT_EQ(casted->value, 2);
+        ASSERT_TRUE(base.dynamic_cast_ref<IntrusiveWeakObj>().is_null());
+    }
+    // Destroyed through the base, and the memory of the whole object is freed.
+    ASSERT_EQ(destroyed, 1);
+    ASSERT_TRUE(allocator.is_empty());
+}
+
+TEST_F(WBERefIntrusiveTest, Weak) {
+    WBE::HeapAllocatorTLSF allocator(WBE_KiB(64));
+    WBE::RefIntrusiveWeak<IntrusiveWeakObj> weak;
+    ASSERT_TRUE(weak.lock().is_null());
+    {
+        WBE::RefIntrusive<IntrusiveWeakObj> ref = WBE::make_ref_intrusive<IntrusiveWeakObj>(&allocator, 3);
+        weak = ref;
+        WBE::RefIntrusiveWeak<IntrusiveWeakObj> weak_copy = weak;
+        ASSERT_EQ(ref->get_ref_count(), 1);
+        ASSERT_TRUE(weak.is_valid());
+        WBE::RefIntrusive<IntrusiveWeakObj> locked = weak_copy.lock();
+        ASSERT_EQ(locked, ref);
+        ASSERT_EQ(locked->value, 3);
+        ASSERT_EQ(ref->get_ref_count(), 2);
+    }
+    ASSERT_FALSE(weak.is_valid());
+    ASSERT_TRUE(weak.lock().is_null());
+    // The flag is kept by the weak reference.
+    ASSERT_FALSE(allocator.is_empty());
+    weak = WBE::RefIntrusiveWeak<IntrusiveWeakObj>();
+    ASSERT_TRUE(allocator.is_empty());
+}
+
+TEST_F(WBERefIntrusiveTest, ThisRef) {
+    WBE::HeapAllocatorTLSF allocator(WBE_KiB(64));
+    {
+        WBE::RefIntrusive<IntrusiveThis> ref = WBE::make_ref_intrusive<IntrusiveThis>(&allocator);
+        WBE::RefIntrusive<IntrusiveThis> this_ref = ref->get_this_ref();
+        ASSERT_EQ(this_ref, ref);
+        ASSERT_EQ(ref->get_ref_count(), 2);
+        ASSERT_EQ(this_ref->value, 7);
+    }
+    ASSERT_TRUE(allocator.is_empty());
+}
+
+TEST_F(WBERefIntrusiveTest, NotOwned) {
+    int destroyed = 0;
+    {
+        IntrusiveBase obj(4, &destroyed);
+        {
+            WBE::RefIntrusive<IntrusiveBase> ref(&obj);
+            WBE::RefIntrusive<IntrusiveBase> copy = ref;
+            ASSERT_EQ(obj.get_ref_count(), 2);
+        }
+        ASSERT_EQ(obj.get_ref_count(), 0);
+        ASSERT_EQ(destroyed, 0);
+        // The count is not copied.
+        IntrusiveBase copy = obj;
+        ASSERT_EQ(copy.get_ref_count(), 0);
+        IntrusiveWeakObj weak_obj(5);
+        WBE::RefIntrusive<IntrusiveWeakObj> weak_obj_ref(&weak_obj);
+        ASSERT_THROW(WBE::RefIntrusiveWeak<IntrusiveWeakObj>{weak_obj_ref}, std::runtime_error);
+    }
+    ASSERT_EQ(destroyed, 2);
+}
+
+TEST_F(WBERefIntrusiveTest, ConstructorThrows) {
+    WBE::HeapAllocatorTLSF allocator(WBE_KiB(64));
+    ASSERT_THROW(WBE::make_ref_intrusive<IntrusiveThrows>(&allocator), std::runtime_error);
+    ASSERT_TRUE(allocator.is_empty());
+}
+
+#endif
@@ -0,0 +1,144 @@
+/* Copyright 2025 OppositeNor
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef __WBE_REF_POLICY_TEST_HH__
+#define __WBE_REF_POLICY_TEST_HH__
+
+#include "core/allocator/heap_allocator_tlsf.hh"
+#include "core/core_utils.hh"
+#include "core/memory/reference_strong.hh"
+#include "core/memory/reference_weak.hh"
+#include "global/global.hh"
+#include "utils/utils.hh"
+#include <atomic>
+#include <concepts>
+#include <gtest/gtest.h>
+#include <thread>
+
+namespace WBE = WhiteBirdEngine;
+
+namespace {
+
+struct PolicyTestObj {
+    PolicyTestObj(int p_value, int* r_destroyed)
+        : value(p_value), destroyed(r_destroyed) {}
+    ~PolicyTestObj() {
+        ++*destroyed;
+    }
+    int value;
+    int* destroyed;
+};
+
+struct PolicyTestThis : public WBE::ThisRef<PolicyTestThis> {};
+
+}
+
+template <typename ThreadPolicy>
+class WBERefPolicyTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        global = std::make_unique<WBE::Global>(0, nullptr, WBE::Directory({"test_env"}));
+    }
+
+    void TearDown() override {
+        global.reset();
+    }
+
+    std::unique_ptr<WBE::Global> global;
+};
+
+using RefPolicies = ::testing::Types<WBE::RefPolicyAtomic, WBE::RefPolicyNonAtomic>;
+TYPED_TEST_SUITE(WBERefPolicyTest, RefPolicies);
+
+TYPED_TEST(WBERefPolicyTest, StrongAndWeak) {
+    using RefType = WBE::Ref<PolicyTestObj, WBE::HeapAllocatorTLSF, TypeParam>;
+    using RefWeakType = WBE::RefWeak<PolicyTestObj, WBE::HeapAllocatorTLSF, TypeParam>;
+    WBE::HeapAllocatorTLSF allocator(WBE_KiB(16));
+    int destroyed = 0;
+    {
+        RefWeakType weak;
+        {
+            RefType ref = WBE::make_ref<PolicyTestObj, WBE::HeapAllocatorTLSF, TypeParam>(&allocator, 1, &destroyed);
+            RefType copy = ref;
+            weak = copy;
+            ASSERT_TRUE(weak.is_valid());
+            ASSERT_EQ(weak.lock()->value, 1);
+            copy = nullptr;
+            ASSERT_EQ(destroyed, 0);
+            ASSERT_EQ(weak.lock(), ref);
+        }
+        ASSERT_EQ(destroyed, 1);
+        ASSERT_FALSE(weak.is_valid());
+        ASSERT_TRUE(weak.lock().is_null());
+        // The control block is kept by the weak reference.
+        ASSERT_FALSE(allocator.is_empty());
+    }
+    ASSERT_TRUE(allocator.is_empty());
+}
+
+TYPED_TEST(WBERefPolicyTest, SeparateObject) {
+    using RefType = WBE::Ref<PolicyTestObj, WBE::HeapAllocatorTLSF, TypeParam>;
+    WBE::HeapAllocatorTLSF allocator(WBE_KiB(16));
+    int destroyed = 0;
+    {
+        RefType ref(&allocator, WBE::create_obj<PolicyTestObj>(allocator, 2, &destroyed));
+        WBE::RefWeak<PolicyTestObj, WBE::HeapAllocatorTLSF, TypeParam> weak = ref;
+        ref = nullptr;
+        ASSERT_EQ(destroyed, 1);
+        ASSERT_TRUE(weak.lock().is_null());
+    }
+    ASSERT_TRUE(allocator.is_empty());
+}
+
+TYPED_TEST(WBERefPolicyTest, ThisRef) {
+    WBE::HeapAllocatorTLSF allocator(WBE_KiB(16));
+    {
+        WBE::Ref<PolicyTestThis, WBE::HeapAllocatorTLSF, TypeParam> ref = WBE::make_ref<PolicyTestThis, WBE::HeapAllocatorTLSF, TypeParam>(&allocator);
+        // ThisRef holds an atomic reference, it is only set if the reference could be converted to it.
+        if constexpr (std::same_as<TypeParam, WBE::RefPolicyAtomic>) {
+            ASSERT_FALSE(ref->get_this_ref().is_null());
+        }
+        else {
+            ASSERT_TRUE(ref->get_this_ref().is_null());
+        }
+    }
+    ASSERT_TRUE(allocator.is_empty());
+}
+
+TEST(WBERefPolicyAtomicTest, LockWhileReleasing) {
+    std::unique_ptr<WBE::Global> global = std::make_unique<WBE::Global>(0, nullptr, WBE::Directory({"test_env"}));
+    WBE::HeapAllocatorTLSF allocator(WBE_MiB(1));
+    constexpr int ROUNDS = 1000;
+    for (int round = 0; round < ROUNDS; ++round) {
+        int destroyed = 0;
+        WBE::Ref<PolicyTestObj, WBE::HeapAllocatorTLSF> ref = WBE::make_ref<PolicyTestObj>(&allocator, round, &destroyed);
+        WBE::RefWeak<PolicyTestObj, WBE::HeapAllocatorTLSF> weak = ref;
+        std::atomic<bool> start = false;
+        std::thread locker([&] {
+            while (!start.load(std::memory_order_acquire)) {}
+            WBE::Ref<PolicyTestObj, WBE::HeapAllocatorTLSF> locked = weak.lock();
+            if (!locked.is_null()) {
+                // A locked reference always sees a live object.
+                ASSERT_EQ(locked->value, round);
+                ASSERT_EQ(destroyed, 0);
+            }
+        });
+        start.store(true, std::memory_order_release);
+        ref = nullptr;
+        locker.join();
+        ASSERT_EQ(destroyed, 1);
+    }
+}
+
+#endif
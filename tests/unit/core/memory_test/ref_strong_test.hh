@@ -15,12 +15,19 @@
 #ifndef __WBE_REF_STRONG_TEST_HH__
 #define __WBE_REF_STRONG_TEST_HH__
 
+#include "core/allocator/heap_allocator_compacting.hh"
+#include "core/allocator/heap_allocator_fixed_size_pool.hh"
+#include "core/allocator/heap_allocator_tlsf.hh"
 #include "core/memory/reference_strong.hh"
+#include "core/memory/reference_weak.hh"
 #include "mock_heap_allocator_aligned.hh"
 #include "global/global.hh"
 #include <cstdint>
 #include <gtest/gtest.h>
+#include <stdexcept>
+#include <string>
 #include <thread>
+#include <type_traits>
 
 namespace WBE = WhiteBirdEngine;
 
@@ -397,4 +404,127 @@ TEST_F(WBERefStrongTest, IsNullMethod_MoveAndLifetime) {
     ASSERT_TRUE(allocator.is_empty());
 }
 
+static size_t count_occurrence(const std::string& p_str, const std::string& p_sub) {
+    size_t result = 0;
+    for (size_t pos = p_str.find(p_sub); pos != std::string::npos; pos = p_str.find(p_sub, pos + 1)) {
+        ++result;
+    }
+    return result;
+}
+
+TEST_F(WBERefStrongTest, FusedAllocation) {
+    using RefType = WBE::Ref<int, WBE::MockHeapAllocatorAlignedAddrStable>;
+    WBE::MockHeapAllocatorAlignedAddrStable allocator(1024);
+    {
+        allocator.clear_call_log();
+        RefType ref = RefType::make_ref(&allocator, 3);
+        // The control block and the object share one allocation.
+        ASSERT_EQ(count_occurrence(allocator.get_call_log(), "allocate("), 1);
+        allocator.clear_call_log();
+        ASSERT_EQ(*ref, 3);
+        *ref = 4;
+        ASSERT_EQ(*ref.get(), 4);
+        // The object is accessed without going through the allocator.
+        ASSERT_EQ(count_occurrence(allocator.get_call_log(), "get("), 0);
+        allocator.clear_call_log();
+    }
+    ASSERT_EQ(count_occurrence(allocator.get_call_log(), "deallocate("), 1);
+    ASSERT_TRUE(allocator.is_empty());
+}
+
+TEST_F(WBERefStrongTest, FusedWeakOutlivesObject) {
+    struct TestClass {
+        TestClass(int* p_alive)
+            : alive(p_alive) {
+            ++(*alive);
+        }
+        ~TestClass() {
+            --(*alive);
+        }
+        int* alive;
+    };
+    WBE::MockHeapAllocatorAlignedAddrStable allocator(1024);
+    int alive = 0;
+    {
+        WBE::RefWeak<TestClass, WBE::MockHeapAllocatorAlignedAddrStable> weak;
+        {
+            WBE::Ref<TestClass, WBE::MockHeapAllocatorAlignedAddrStable> ref = WBE::make_ref<TestClass>(&allocator, &alive);
+            weak = ref;
+            ASSERT_EQ(alive, 1);
+            ASSERT_TRUE(weak.is_valid());
+        }
+        // The object is destroyed, but the block is kept for the weak reference.
+        ASSERT_EQ(alive, 0);
+        ASSERT_FALSE(weak.is_valid());
+        ASSERT_FALSE(allocator.is_empty());
+    }
+    ASSERT_TRUE(allocator.is_empty());
+}
+
+TEST_F(WBERefStrongTest, FusedConstructorThrows) {
+    struct TestClass {
+        TestClass() {
+            throw std::runtime_error("Constructor failed.");
+        }
+    };
+    WBE::MockHeapAllocatorAlignedAddrStable allocator(1024);
+    ASSERT_THROW((WBE::Ref<TestClass, WBE::MockHeapAllocatorAlignedAddrStable>::make_ref(&allocator)), std::runtime_error);
+    ASSERT_TRUE(allocator.is_empty());
+    // Same when the object is allocated apart from the control block.
+    WBE::MockHeapAllocatorAligned unstable_allocator(1024);
+    ASSERT_THROW(WBE::Ref<TestClass>::make_ref(&unstable_allocator), std::runtime_error);
+    ASSERT_TRUE(unstable_allocator.is_empty());
+}
+
+TEST_F(WBERefStrongTest, AddrStableAllocator) {
+    static_assert(WBE::AllocatorAddrStable<WBE::HeapAllocatorTLSF>);
+    static_assert(!WBE::AllocatorAddrStable<WBE::HeapAllocatorFixedSizePool>);
+    // Allocators that do not declare WILL_ADDR_MOVE are treated as moving.
+    static_assert(!WBE::AllocatorAddrStable<WBE::MockHeapAllocatorAligned>);
+    WBE::HeapAllocatorTLSF allocator(WBE_KiB(4));
+    {
+        WBE::Ref<int, WBE::HeapAllocatorTLSF> ref(&allocator, WBE::create_obj<int>(allocator, 5));
+        ASSERT_EQ(*ref, 5);
+        WBE::Ref<int, WBE::HeapAllocatorTLSF> fused = WBE::Ref<int, WBE::HeapAllocatorTLSF>::make_ref(&allocator, 6);
+        ASSERT_EQ(*fused, 6);
+    }
+    ASSERT_TRUE(allocator.is_empty());
+}
+
+// Whether a reference could be made with an allocator, checked without instantiating the failing call.
+template <typename AllocType>
+concept RefMakeableWith = requires(AllocType* p_allocator) {
+    WBE::make_ref<int>(p_allocator, 1);
+    WBE::Ref<int, AllocType>::make_ref(p_allocator, 1);
+};
+
+TEST_F(WBERefStrongTest, UnstableAllocatorNotFused) {
+    WBE::MockHeapAllocatorAligned allocator(1024);
+    {
+        allocator.clear_call_log();
+        // Through the base type, the allocator is not known to keep its addresses.
+        WBE::Ref<int> ref = WBE::Ref<int>::make_ref(&allocator, 3);
+        ASSERT_EQ(count_occurrence(allocator.get_call_log(), "allocate("), 2);
+        allocator.clear_call_log();
+        ASSERT_EQ(*ref, 3);
+        // The object pointer is not kept, every access goes through the allocator.
+        ASSERT_EQ(count_occurrence(allocator.get_call_log(), "get("), 1);
+        allocator.clear_call_log();
+    }
+    ASSERT_EQ(count_occurrence(allocator.get_call_log(), "deallocate("), 2);
+    ASSERT_TRUE(allocator.is_empty());
+}
+
+TEST_F(WBERefStrongTest, MovingAllocatorRejected) {
+    static_assert(WBE::AllocatorAddrMoves<WBE::HeapAllocatorCompacting>);
+    static_assert(WBE::AllocatorAddrMoves<WBE::HeapAllocatorFixedSizePool>);
+    static_assert(!WBE::AllocatorAddrMoves<WBE::HeapAllocatorTLSF>);
+    static_assert(!WBE::AllocatorAddrMoves<WBE::MockHeapAllocatorAligned>);
+    // A compacting heap moves the control block and the object, a reference to them would dangle.
+    static_assert(!RefMakeableWith<WBE::HeapAllocatorCompacting>);
+    static_assert(RefMakeableWith<WBE::HeapAllocatorTLSF>);
+    static_assert(!std::is_constructible_v<WBE::Ref<int, WBE::HeapAllocatorCompacting>, WBE::HeapAllocatorCompacting*, WBE::MemID>);
+    static_assert(std::is_constructible_v<WBE::Ref<int, WBE::HeapAllocatorTLSF>, WBE::HeapAllocatorTLSF*, WBE::MemID>);
+}
+
 #endif
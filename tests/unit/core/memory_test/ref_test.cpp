@@ -12,8 +12,14 @@
    See the License for the specific language governing permissions and
    limitations under the License.
 */
+#include "ref_atomic_test.hh"
+#include "ref_destruction_queue_test.hh"
+#include "ref_devirtualize_test.hh"
+#include "ref_intrusive_test.hh"
+#include "ref_policy_test.hh"
 #include "ref_raw_test.hh"
 #include "ref_strong_exceptions_test.hh"
 #include "ref_strong_test.hh"
 #include "ref_weak_test.hh"
+#include "slot_map_test.hh"
 #include "unique_test.hh"
@@ -0,0 +1,156 @@
+/* Copyright 2025 OppositeNor
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef __WBE_SLOT_MAP_TEST_HH__
+#define __WBE_SLOT_MAP_TEST_HH__
+
+#include "core/allocator/heap_allocator_tlsf.hh"
+#include "core/memory/slot_map.hh"
+#include "global/global.hh"
+#include "utils/utils.hh"
+#include <gtest/gtest.h>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace WBE = WhiteBirdEngine;
+
+class WBESlotMapTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        global = std::make_unique<WBE::Global>(0, nullptr, WBE::Directory({"test_env"}));
+    }
+
+    void TearDown() override {
+        global.reset();
+    }
+
+    std::unique_ptr<WBE::Global> global;
+};
+
+namespace {
+
+struct SlotMapThrows {
+    SlotMapThrows(bool p_throw) {
+        if (p_throw) {
+            throw std::runtime_error("Constructor failed.");
+        }
+    }
+};
+
+}
+
+TEST_F(WBESlotMapTest, General) {
+    WBE::HeapAllocatorTLSF allocator(WBE_KiB(64));
+    {
+        WBE::SlotMap<std::string, WBE::HeapAllocatorTLSF> map(&allocator);
+        ASSERT_TRUE(map.empty());
+        WBE::SlotMapHandle a = map.insert("a");
+        WBE::SlotMapHandle b = map.emplace(2, 'b');
+        WBE::SlotMapHandle c = map.insert(std::string("c"));
+        ASSERT_EQ(map.size(), 3);
+        ASSERT_EQ(*map.get(a), "a");
+        ASSERT_EQ(map[b], "bb");
+        ASSERT_EQ(map[c], "c");
+        ASSERT_TRUE(WBE::SlotMapHandle().is_null());
+        ASSERT_FALSE(map.contains(WBE::SlotMapHandle()));
+        ASSERT_EQ(map.get(WBE::SlotMapHandle()), nullptr);
+
+        // The last element is moved into the place of the erased one.
+        ASSERT_TRUE(map.erase(a));
+        ASSERT_FALSE(map.erase(a));
+        ASSERT_EQ(map.size(), 2);
+        ASSERT_EQ(map.get(a), nullptr);
+        ASSERT_EQ(map.get_data()[0], "c");
+        ASSERT_EQ(map.get_handle_by_index(0), c);
+        ASSERT_EQ(map[c], "c");
+        ASSERT_EQ(map[b], "bb");
+
+        // The slot is reused with a new generation, the stale handle does not reach the new element.
+        WBE::SlotMapHandle d = map.insert("d");
+        ASSERT_EQ(d.index, a.index);
+        ASSERT_NE(d.generation, a.generation);
+        ASSERT_FALSE(map.contains(a));
+        ASSERT_EQ(map[d], "d");
+
+        std::string joined;
+        for (const std::string& str : map) {
+            joined += str;
+        }
+        ASSERT_EQ(joined, "cbbd");
+
+        map.clear();
+        ASSERT_TRUE(map.empty());
+        ASSERT_FALSE(map.contains(b));
+        ASSERT_FALSE(map.contains(c));
+        ASSERT_FALSE(map.contains(d));
+        WBE::SlotMapHandle e = map.insert("e");
+        ASSERT_EQ(map[e], "e");
+    }
+    ASSERT_TRUE(allocator.is_empty());
+}
+
+TEST_F(WBESlotMapTest, ConstructorThrows) {
+    WBE::HeapAllocatorTLSF allocator(WBE_KiB(16));
+    {
+        WBE::SlotMap<SlotMapThrows, WBE::HeapAllocatorTLSF> map(&allocator);
+        WBE::SlotMapHandle first = map.emplace(false);
+        ASSERT_THROW(map.emplace(true), std::runtime_error);
+        ASSERT_EQ(map.size(), 1);
+        ASSERT_TRUE(map.erase(first));
+        ASSERT_THROW(map.emplace(true), std::runtime_error);
+        // The free slot is still free, and reused with the generation never handed out.
+        WBE::SlotMapHandle second = map.emplace(false);
+        ASSERT_EQ(second.index, first.index);
+        ASSERT_FALSE(map.contains(first));
+        ASSERT_TRUE(map.contains(second));
+    }
+    ASSERT_TRUE(allocator.is_empty());
+}
+
+TEST_F(WBESlotMapTest, Random) {
+    WBE::HeapAllocatorTLSF allocator(WBE_MiB(1));
+    {
+        WBE::SlotMap<int, WBE::HeapAllocatorTLSF> map(&allocator);
+        std::unordered_map<WBE::SlotMapHandle, int> expected;
+        std::vector<WBE::SlotMapHandle> erased;
+        std::mt19937 random(42);
+        for (int i = 0; i < 10000; ++i) {
+            if (expected.empty() || random() % 3 != 0) {
+                expected.emplace(map.insert(i), i);
+                continue;
+            }
+            auto it = expected.begin();
+            std::advance(it, random() % expected.size());
+            ASSERT_TRUE(map.erase(it->first));
+            erased.push_back(it->first);
+            expected.erase(it);
+        }
+        ASSERT_EQ(map.size(), expected.size());
+        for (const auto& [handle, value] : expected) {
+            ASSERT_EQ(map[handle], value);
+        }
+        for (WBE::SlotMapHandle handle : erased) {
+            ASSERT_FALSE(map.contains(handle));
+        }
+        for (size_t i = 0; i < map.size(); ++i) {
+            ASSERT_EQ(map[map.get_handle_by_index(i)], map.get_data()[i]);
+        }
+    }
+    ASSERT_TRUE(allocator.is_empty());
+}
+
+#endif
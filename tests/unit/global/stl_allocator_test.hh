@@ -15,12 +15,91 @@
 #ifndef __WBE_STL_ALLOCATOR_TEST_HH__
 #define __WBE_STL_ALLOCATOR_TEST_HH__
 
+#include "core/allocator/frame_allocator.hh"
+#include "core/allocator/heap_allocator_tlsf.hh"
 #include "global/global.hh"
 #include "global/stl_allocator.hh"
+#include <cstdint>
 #include <gtest/gtest.h>
 #include <memory>
+#include <stdexcept>
 #include <string>
+#include <string_view>
 
 namespace WBE = WhiteBirdEngine;
 
+class WBESTLAllocatorTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        global = std::make_unique<WBE::Global>(0, nullptr, WBE::Directory({"test_env"}));
+    }
+
+    void TearDown() override {
+        global.reset();
+    }
+
+    std::unique_ptr<WBE::Global> global;
+};
+
+TEST_F(WBESTLAllocatorTest, Containers) {
+    WBE::HeapAllocatorTLSF pool(WBE_KiB(64));
+    {
+        WBE::map<int, int, WBE::HeapAllocatorTLSF> map(&pool);
+        WBE::unordered_map<int, int, WBE::HeapAllocatorTLSF> unordered_map(&pool);
+        WBE::list<int, WBE::HeapAllocatorTLSF> list(&pool);
+        for (int i = 0; i < 100; ++i) {
+            map[i] = i * 2;
+            unordered_map[i] = i * 3;
+            list.push_back(i);
+        }
+        ASSERT_EQ(map[50], 100);
+        ASSERT_EQ(unordered_map[50], 150);
+        ASSERT_EQ(list.size(), 100);
+        ASSERT_FALSE(pool.is_empty());
+    }
+    ASSERT_TRUE(pool.is_empty());
+}
+
+TEST_F(WBESTLAllocatorTest, MemoryResource) {
+    WBE::HeapAllocatorTLSF pool(WBE_KiB(64));
+    WBE::STLMemoryResource<WBE::HeapAllocatorTLSF> resource(&pool);
+    ASSERT_EQ(resource.get_allocator(), &pool);
+    {
+        WBE::pmr::unordered_map<int, WBE::pmr::string> map(&resource);
+        WBE::pmr::vector<int> vector(&resource);
+        for (int i = 0; i < 100; ++i) {
+            // The nested strings use the resource of the map.
+            map.try_emplace(i, 64, static_cast<char>('a' + i % 26));
+            vector.push_back(i);
+        }
+        ASSERT_EQ(std::string_view(map[25]), std::string(64, 'z'));
+        ASSERT_EQ(map[25].get_allocator().resource(), &resource);
+        ASSERT_EQ(vector[99], 99);
+        ASSERT_GT(pool.get_stats().live_bytes, 100 * 64);
+    }
+    ASSERT_TRUE(pool.is_empty());
+    void* aligned = resource.allocate(100, 256);
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(aligned) % 256, 0);
+    resource.deallocate(aligned, 100, 256);
+    ASSERT_TRUE(pool.is_empty());
+    WBE::STLMemoryResource<WBE::HeapAllocatorTLSF> other_resource(&pool);
+    ASSERT_TRUE(resource.is_equal(resource));
+    ASSERT_FALSE(resource.is_equal(other_resource));
+    ASSERT_THROW(static_cast<void>(resource.allocate(WBE_KiB(128))), std::runtime_error);
+}
+
+TEST_F(WBESTLAllocatorTest, FrameMemoryResource) {
+    WBE::FrameAllocator frame_allocator(WBE_KiB(16), 1);
+    WBE::STLMemoryResource<WBE::FrameAllocator> resource(&frame_allocator);
+    {
+        WBE::pmr::vector<int> vector(&resource);
+        for (int i = 0; i < 100; ++i) {
+            vector.push_back(i);
+        }
+        ASSERT_EQ(vector[42], 42);
+    }
+    // The memory is reclaimed when the frame ends.
+    frame_allocator.end_frame();
+}
+
 #endif